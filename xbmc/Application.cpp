@@ -3031,6 +3031,9 @@ void CApplication::Stop(int exitCode)
 
   cleanup_emu_environ();
 
+  // the log is written by its own thread, make sure nothing logged while stopping is lost
+  CLog::Flush();
+
   Sleep(200);
 }
 
@@ -29,6 +29,7 @@
 #include "playlists/PlayListFactory.h"
 #include "utils/Crc32.h"
 #include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
 #include "filesystem/File.h"
 #include "filesystem/StackDirectory.h"
 #include "filesystem/CurlFile.h"
@@ -1814,10 +1815,13 @@ void CFileItemList::ClearItems()
   for (unsigned int i = 0; i < m_items.size(); i++)
   {
     CFileItemPtr item = m_items[i];
-    item->FreeMemory();
+    // shared items never made it into the gui, they belong to the other list
+    if (m_shared.find(item.get()) == m_shared.end())
+      item->FreeMemory();
   }
   m_items.clear();
   m_map.clear();
+  m_shared.clear();
 }
 
 void CFileItemList::Add(CFileItemPtr pItem)
@@ -1863,6 +1867,7 @@ void CFileItemList::Remove(CFileItem* pItem)
   {
     if (pItem == it->get())
     {
+      m_shared.erase(pItem);
       m_items.erase(it);
       if (m_fastLookup)
       {
@@ -1884,6 +1889,7 @@ void CFileItemList::Remove(int iItem)
     {
       m_map.erase(m_ignoreURLOptions ? CURL(pItem->GetPath()).GetWithoutOptions() : pItem->GetPath());
     }
+    m_shared.erase(pItem.get());
     m_items.erase(m_items.begin() + iItem);
   }
 }
@@ -1928,10 +1934,12 @@ bool CFileItemList::Copy(const CFileItemList& items, bool copyItems /* = true */
 
   if (copyItems)
   {
+    CSingleLock lock(items.m_lock);
+
     // make a copy of each item
-    for (int i = 0; i < items.Size(); i++)
+    for (unsigned int i = 0; i < items.m_items.size(); i++)
     {
-      CFileItemPtr newItem(new CFileItem(*items[i]));
+      CFileItemPtr newItem(new CFileItem(*items.m_items[i]));
       Add(newItem);
     }
   }
@@ -1939,12 +1947,54 @@ bool CFileItemList::Copy(const CFileItemList& items, bool copyItems /* = true */
   return true;
 }
 
+void CFileItemList::Share(const CFileItemList& items)
+{
+  CSingleLock lock(m_lock);
+  Copy(items, false);
+
+  CSingleLock itemsLock(items.m_lock);
+  m_items.reserve(m_items.size() + items.m_items.size());
+  m_shared.reserve(m_shared.size() + items.m_items.size());
+  for (unsigned int i = 0; i < items.m_items.size(); i++)
+  {
+    Add(items.m_items[i]);
+    m_shared.insert(items.m_items[i].get());
+  }
+}
+
+void CFileItemList::Detach(CFileItemPtr& item) const
+{
+  if (m_shared.empty() || m_shared.erase(item.get()) == 0)
+    return;
+
+#ifdef _DEBUG
+  g_directoryCache.OnSharedItemCopied(*item);
+#endif
+  CFileItemPtr copy(new CFileItem(*item));
+  if (m_fastLookup)
+  {
+    IMAPFILEITEMS it = m_map.find(m_ignoreURLOptions ? CURL(item->GetPath()).GetWithoutOptions() : item->GetPath());
+    if (it != m_map.end() && it->second == item)
+      it->second = copy;
+  }
+  item = copy;
+}
+
+void CFileItemList::DetachItems() const
+{
+  for (unsigned int i = 0; i < m_items.size() && !m_shared.empty(); i++)
+    Detach(m_items[i]);
+}
+
 CFileItemPtr CFileItemList::Get(int iItem)
 {
   CSingleLock lock(m_lock);
 
   if (iItem > -1 && iItem < (int)m_items.size())
+  {
+    Detach(m_items[iItem]);
     return m_items[iItem];
+  }
 
   return CFileItemPtr();
 }
@@ -1954,7 +2004,10 @@ const CFileItemPtr CFileItemList::Get(int iItem) const
   CSingleLock lock(m_lock);
 
   if (iItem > -1 && iItem < (int)m_items.size())
+  {
+    Detach(m_items[iItem]);
     return m_items[iItem];
+  }
 
   return CFileItemPtr();
 }
@@ -1967,16 +2020,23 @@ CFileItemPtr CFileItemList::Get(const std::string& strPath)
   {
     IMAPFILEITEMS it = m_map.find(m_ignoreURLOptions ? CURL(strPath).GetWithoutOptions() : strPath);
     if (it != m_map.end())
+    {
+      // the map doesn't know where the item is in the list
+      if (m_shared.find(it->second.get()) != m_shared.end())
+        DetachItems();
       return it->second;
+    }
 
     return CFileItemPtr();
   }
   // slow method...
   for (unsigned int i = 0; i < m_items.size(); i++)
   {
-    CFileItemPtr pItem = m_items[i];
-    if (pItem->IsPath(m_ignoreURLOptions ? CURL(strPath).GetWithoutOptions() : strPath))
-      return pItem;
+    if (m_items[i]->IsPath(m_ignoreURLOptions ? CURL(strPath).GetWithoutOptions() : strPath))
+    {
+      Detach(m_items[i]);
+      return m_items[i];
+    }
   }
 
   return CFileItemPtr();
@@ -1990,21 +2050,45 @@ const CFileItemPtr CFileItemList::Get(const std::string& strPath) const
   {
     std::map<std::string, CFileItemPtr>::const_iterator it = m_map.find(m_ignoreURLOptions ? CURL(strPath).GetWithoutOptions() : strPath);
     if (it != m_map.end())
+    {
+      // the map doesn't know where the item is in the list
+      if (m_shared.find(it->second.get()) != m_shared.end())
+        DetachItems();
       return it->second;
+    }
 
     return CFileItemPtr();
   }
   // slow method...
   for (unsigned int i = 0; i < m_items.size(); i++)
   {
-    CFileItemPtr pItem = m_items[i];
-    if (pItem->IsPath(m_ignoreURLOptions ? CURL(strPath).GetWithoutOptions() : strPath))
-      return pItem;
+    if (m_items[i]->IsPath(m_ignoreURLOptions ? CURL(strPath).GetWithoutOptions() : strPath))
+    {
+      Detach(m_items[i]);
+      return m_items[i];
+    }
   }
 
   return CFileItemPtr();
 }
 
+std::shared_ptr<const CFileItem> CFileItemList::Peek(int iItem) const
+{
+  CSingleLock lock(m_lock);
+
+  if (iItem > -1 && iItem < (int)m_items.size())
+    return m_items[iItem];
+
+  return std::shared_ptr<const CFileItem>();
+}
+
+const VECFILEITEMS CFileItemList::GetList() const
+{
+  CSingleLock lock(m_lock);
+  DetachItems();
+  return m_items;
+}
+
 int CFileItemList::Size() const
 {
   CSingleLock lock(m_lock);
@@ -2032,6 +2116,7 @@ void CFileItemList::Sort(FILEITEMLISTCOMPARISONFUNC func)
 void CFileItemList::FillSortFields(FILEITEMFILLFUNC func)
 {
   CSingleLock lock(m_lock);
+  DetachItems();
   std::for_each(m_items.begin(), m_items.end(), func);
 }
 
@@ -2088,9 +2173,15 @@ void CFileItemList::Sort(SortDescription sortDescription)
   sortedFileItems.reserve(Size());
   for (SortItems::const_iterator it = sortItems.begin(); it != sortItems.end(); it++)
   {
-    CFileItemPtr item = m_items[(int)(*it)->at(FieldId).asInteger()];
-    // Set the sort label in the CFileItem
-    item->SetSortLabel((*it)->at(FieldSort).asWideString());
+    CFileItemPtr &item = m_items[(int)(*it)->at(FieldId).asInteger()];
+    // Set the sort label in the CFileItem, shared items are only copied if it
+    // changes, it is the label itself when sorting by label
+    std::wstring sortLabel = (*it)->at(FieldSort).asWideString();
+    if (item->GetSortLabel() != sortLabel)
+    {
+      Detach(item);
+      item->SetSortLabel(sortLabel);
+    }
 
     sortedFileItems.push_back(item);
   }
@@ -2234,8 +2325,12 @@ void CFileItemList::FillInDefaultIcons()
   CSingleLock lock(m_lock);
   for (int i = 0; i < (int)m_items.size(); ++i)
   {
-    CFileItemPtr pItem = m_items[i];
-    pItem->FillInDefaultIcon();
+    // shared items come from the directory cache, which filled in their icons already
+    if (m_shared.find(m_items[i].get()) != m_shared.end() && !m_items[i]->GetIconImage().empty())
+      continue;
+
+    Detach(m_items[i]);
+    m_items[i]->FillInDefaultIcon();
   }
 }
 
@@ -2356,9 +2451,11 @@ void CFileItemList::FilterCueItems()
               // apply CUE for later processing
               for (int j = 0; j < (int)m_items.size(); j++)
               {
-                CFileItemPtr pItem = m_items[j];
-                if (stricmp(pItem->GetPath().c_str(), strMediaFile.c_str()) == 0)
-                  pItem->SetCueDocument(cuesheet);
+                if (stricmp(m_items[j]->GetPath().c_str(), strMediaFile.c_str()) == 0)
+                {
+                  Detach(m_items[j]);
+                  m_items[j]->SetCueDocument(cuesheet);
+                }
               }
             }
           }
@@ -2375,6 +2472,7 @@ void CFileItemList::FilterCueItems()
       CFileItemPtr pItem = m_items[j];
       if (stricmp(pItem->GetPath().c_str(), itemstodelete[i].c_str()) == 0)
       { // delete this item
+        m_shared.erase(pItem.get());
         m_items.erase(m_items.begin() + j);
         break;
       }
@@ -2387,7 +2485,19 @@ void CFileItemList::RemoveExtensions()
 {
   CSingleLock lock(m_lock);
   for (int i = 0; i < Size(); ++i)
-    m_items[i]->RemoveExtension();
+  {
+    if (m_items[i]->m_bIsFolder)
+      continue;
+
+    // shared items are only copied if they have an extension to remove
+    std::string label = m_items[i]->GetLabel();
+    URIUtils::RemoveExtension(label);
+    if (label != m_items[i]->GetLabel())
+    {
+      Detach(m_items[i]);
+      m_items[i]->RemoveExtension();
+    }
+  }
 }
 
 void CFileItemList::Stack(bool stackFiles /* = true */)
@@ -2439,7 +2549,8 @@ void CFileItemList::StackFolders()
   // stack folders
   for (int i = 0; i < Size(); i++)
   {
-    CFileItemPtr item = Get(i);
+    // only the items that are changed are copied if they are shared
+    std::shared_ptr<const CFileItem> item = Peek(i);
     // combined the folder checks
     if (item->m_bIsFolder)
     {
@@ -2484,7 +2595,7 @@ void CFileItemList::StackFolders()
             }
 
             if (nFiles == 1)
-              *item = *items[index];
+              *Get(i) = *items[index];
           }
           expr++;
         }
@@ -2497,10 +2608,11 @@ void CFileItemList::StackFolders()
           if (!dvdPath.empty())
           {
             // NOTE: should this be done for the CD# folders too?
-            item->m_bIsFolder = false;
-            item->SetPath(dvdPath);
-            item->SetLabel2("");
-            item->SetLabelPreformated(true);
+            CFileItemPtr folder = Get(i);
+            folder->m_bIsFolder = false;
+            folder->SetPath(dvdPath);
+            folder->SetLabel2("");
+            folder->SetLabelPreformated(true);
             m_sortDescription.sortBy = SortByNone; /* sorting is now broken */
           }
         }
@@ -2532,7 +2644,7 @@ void CFileItemList::StackFiles()
   int i = 0;
   while (i < Size())
   {
-    CFileItemPtr item1 = Get(i);
+    std::shared_ptr<const CFileItem> item1 = Peek(i);
 
     // skip folders, nfo files, playlists
     if (item1->m_bIsFolder
@@ -2572,7 +2684,7 @@ void CFileItemList::StackFiles()
         j = i + 1;
         while (j < Size())
         {
-          CFileItemPtr item2 = Get(j);
+          std::shared_ptr<const CFileItem> item2 = Peek(j);
 
           // skip folders, nfo files, playlists
           if (item2->m_bIsFolder
@@ -2662,14 +2774,15 @@ void CFileItemList::StackFiles()
         // have a stack, remove the items and add the stacked item
         // dont actually stack a multipart rar set, just remove all items but the first
         std::string stackPath;
-        if (Get(stack[0])->IsRAR())
-          stackPath = Get(stack[0])->GetPath();
+        if (Peek(stack[0])->IsRAR())
+          stackPath = Peek(stack[0])->GetPath();
         else
         {
           CStackDirectory dir;
           stackPath = dir.ConstructStackPath(*this, stack);
         }
-        item1->SetPath(stackPath);
+        CFileItemPtr stacked = Get(i);
+        stacked->SetPath(stackPath);
         // clean up list
         for (unsigned k = 1; k < stack.size(); k++)
           Remove(i+1);
@@ -2679,8 +2792,8 @@ void CFileItemList::StackFiles()
         if (!CSettings::GetInstance().GetBool(CSettings::SETTING_FILELISTS_SHOWEXTENSIONS))
           URIUtils::RemoveExtension(stackName);
 
-        item1->SetLabel(stackName);
-        item1->m_dwSize = size;
+        stacked->SetLabel(stackName);
+        stacked->m_dwSize = size;
         break;
       }
     }
@@ -3212,10 +3325,10 @@ bool CFileItemList::UpdateItem(const CFileItem *item)
   CSingleLock lock(m_lock);
   for (unsigned int i = 0; i < m_items.size(); i++)
   {
-    CFileItemPtr pItem = m_items[i];
-    if (pItem->IsSamePath(item))
+    if (m_items[i]->IsSamePath(item))
     {
-      pItem->UpdateInfo(*item);
+      Detach(m_items[i]);
+      m_items[i]->UpdateInfo(*item);
       return true;
     }
   }
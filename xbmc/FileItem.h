@@ -25,6 +25,7 @@
  */
 
 #include <memory>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -618,7 +619,12 @@ public:
   void Remove(int iItem);
   CFileItemPtr Get(int iItem);
   const CFileItemPtr Get(int iItem) const;
-  const VECFILEITEMS GetList() const { return m_items; }
+  /*! \brief Read only access to an item
+   Unlike Get() this doesn't copy an item shared with another list.
+   \sa Share
+   */
+  std::shared_ptr<const CFileItem> Peek(int iItem) const;
+  const VECFILEITEMS GetList() const;
   CFileItemPtr Get(const std::string& strPath);
   const CFileItemPtr Get(const std::string& strPath) const;
   int Size() const;
@@ -626,6 +632,13 @@ public:
   void Append(const CFileItemList& itemlist);
   void Assign(const CFileItemList& itemlist, bool append = false);
   bool Copy  (const CFileItemList& item, bool copyItems = true);
+  /*! \brief Share the items of another list instead of copying them
+   The items are copied the first time they are handed out by this list, so
+   changes never reach the other list. The other list must not change the items
+   it shares, the directory cache uses this to answer hits.
+   \param items list to share the items of.
+   */
+  void Share(const CFileItemList& items);
   void Reserve(int iCount);
   void Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute sortAttributes = SortAttributeNone);
   /* \brief Sorts the items based on the given sorting options
@@ -740,8 +753,16 @@ private:
    */
   void StackFolders();
 
-  VECFILEITEMS m_items;
-  MAPFILEITEMS m_map;
+  /*! \brief Replace an item that is still shared with another list by a copy of it
+   \sa Share
+   */
+  void Detach(CFileItemPtr& item) const;
+  void DetachItems() const;
+
+  // items shared with another list are replaced in place on first access, also by the const accessors
+  mutable VECFILEITEMS m_items;
+  mutable MAPFILEITEMS m_map;
+  mutable std::unordered_set<const CFileItem*> m_shared;
   bool m_ignoreURLOptions;
   bool m_fastLookup;
   SortDescription m_sortDescription;
@@ -21,16 +21,15 @@
 #include "InfoScanner.h"
 #include "URL.h"
 #include "Util.h"
-#include "filesystem/File.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 
 CInfoScanner::~CInfoScanner() {}
 
-bool CInfoScanner::HasNoMedia(const std::string &strDirectory) const
+bool CInfoScanner::HasNoMedia(const std::string &strDirectory)
 {
   std::string noMediaFile = URIUtils::AddFileToFolder(strDirectory, ".nomedia");
-  return XFILE::CFile::Exists(noMediaFile);
+  return m_prefetcher.Exists(noMediaFile);
 }
 
 bool CInfoScanner::IsExcluded(const std::string& strDirectory, const std::vector<std::string> &regexps)
@@ -45,3 +44,15 @@ bool CInfoScanner::IsExcluded(const std::string& strDirectory, const std::vector
   }
   return false;
 }
+
+void CInfoScanner::PrefetchFolders(const std::vector<std::string> &folders, size_t first, const std::string &mask)
+{
+  if (!mask.empty())
+    m_prefetcher.PrefetchDirectories(folders, first, mask);
+
+  // queued last so they are fetched first, they are needed first
+  std::vector<std::string> noMediaFiles;
+  for (size_t i = first; i < folders.size() && i < first + m_prefetcher.GetLookahead(); ++i)
+    noMediaFiles.push_back(URIUtils::AddFileToFolder(folders[i], ".nomedia"));
+  m_prefetcher.PrefetchExists(noMediaFiles, 0);
+}
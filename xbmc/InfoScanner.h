@@ -21,6 +21,8 @@
 #include <string>
 #include <vector>
 
+#include "filesystem/DirectoryPrefetcher.h"
+
 class CInfoScanner
 {
 public:
@@ -32,6 +34,15 @@ public:
    \return true if there is a .nomedia file or one of the regexps is a match
    */
   bool IsExcluded(const std::string& strDirectory, const std::vector<std::string> &regexps);
+
+  /*! \brief Prefetch what IsExcluded() and the scan of the folders need
+   \param folders folders in the order they are scanned
+   \param first index of the folder that is scanned next
+   \param mask mask to fetch the listings with, if empty only the .nomedia files are checked
+   */
+  void PrefetchFolders(const std::vector<std::string> &folders, size_t first, const std::string &mask);
+protected:
+  XFILE::CDirectoryPrefetcher m_prefetcher;
 private:
-  bool HasNoMedia(const std::string& strDirectory) const;
+  bool HasNoMedia(const std::string& strDirectory);
 };
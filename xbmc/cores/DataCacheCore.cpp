@@ -25,6 +25,9 @@
 CDataCacheCore::CDataCacheCore()
 {
   m_hasAVInfoChanges = false;
+  m_demuxPoolInfo.hits = 0;
+  m_demuxPoolInfo.misses = 0;
+  m_demuxPoolInfo.peakBytes = 0;
 }
 
 CDataCacheCore& GetInstance()
@@ -235,3 +238,34 @@ bool CDataCacheCore::CDataCacheCore::IsSeeking()
 
   return m_stateInfo.m_stateSeeking;
 }
+
+// demux packet pool
+void CDataCacheCore::SetDemuxPacketPoolStats(uint64_t hits, uint64_t misses, uint64_t peakBytes)
+{
+  CSingleLock lock(m_demuxPoolSection);
+
+  m_demuxPoolInfo.hits = hits;
+  m_demuxPoolInfo.misses = misses;
+  m_demuxPoolInfo.peakBytes = peakBytes;
+}
+
+uint64_t CDataCacheCore::GetDemuxPacketPoolHits()
+{
+  CSingleLock lock(m_demuxPoolSection);
+
+  return m_demuxPoolInfo.hits;
+}
+
+uint64_t CDataCacheCore::GetDemuxPacketPoolMisses()
+{
+  CSingleLock lock(m_demuxPoolSection);
+
+  return m_demuxPoolInfo.misses;
+}
+
+uint64_t CDataCacheCore::GetDemuxPacketPoolPeakBytes()
+{
+  CSingleLock lock(m_demuxPoolSection);
+
+  return m_demuxPoolInfo.peakBytes;
+}
@@ -21,6 +21,7 @@
 */
 
 #include <atomic>
+#include <cstdint>
 #include <string>
 #include "threads/CriticalSection.h"
 
@@ -67,6 +68,12 @@ public:
   void SetStateSeeking(bool active);
   bool IsSeeking();
 
+  // demux packet pool
+  void SetDemuxPacketPoolStats(uint64_t hits, uint64_t misses, uint64_t peakBytes);
+  uint64_t GetDemuxPacketPoolHits();
+  uint64_t GetDemuxPacketPoolMisses();
+  uint64_t GetDemuxPacketPoolPeakBytes();
+
 protected:
   std::atomic_bool m_hasAVInfoChanges;
 
@@ -103,4 +110,12 @@ protected:
   {
     bool m_stateSeeking;
   } m_stateInfo;
+
+  CCriticalSection m_demuxPoolSection;
+  struct SDemuxPoolInfo
+  {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t peakBytes;
+  } m_demuxPoolInfo;
 };
@@ -51,6 +51,7 @@ class CDVDMediaCodecInfo;
 class CDVDVideoCodecIMXBuffer;
 class CMMALBuffer;
 class CDVDAmlogicInfo;
+class CFFmpegRenderPicture;
 
 
 // should be entirely filled by all codecs
@@ -125,6 +126,8 @@ struct DVDVideoPicture
   unsigned int iDisplayHeight;          //< height of the picture without black bars
 
   ERenderFormat format;
+
+  CFFmpegRenderPicture *frameRef;       //< decoded frame data[] points into, renderers may keep a reference instead of copying
 };
 
 struct DVDVideoUserData
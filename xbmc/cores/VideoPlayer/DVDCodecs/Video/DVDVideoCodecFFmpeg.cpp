@@ -263,6 +263,29 @@ enum AVPixelFormat CDVDVideoCodecFFmpeg::GetFormat(struct AVCodecContext * avctx
   return avcodec_default_get_format(avctx, fmt);
 }
 
+CFFmpegRenderPicture* CFFmpegRenderPicture::Create(AVFrame *frame)
+{
+  // only frames backed by refcounted buffers can outlive the decoder's next call
+  if (!frame->buf[0])
+    return nullptr;
+
+  AVFrame *ref = av_frame_alloc();
+  if (!ref)
+    return nullptr;
+
+  if (av_frame_ref(ref, frame) < 0)
+  {
+    av_frame_free(&ref);
+    return nullptr;
+  }
+  return new CFFmpegRenderPicture(ref);
+}
+
+CFFmpegRenderPicture::~CFFmpegRenderPicture()
+{
+  av_frame_free(&m_frame);
+}
+
 CDVDVideoCodecFFmpeg::CDVDVideoCodecFFmpeg(CProcessInfo &processInfo) : CDVDVideoCodec(processInfo)
 {
   m_pCodecContext = nullptr;
@@ -283,6 +306,7 @@ CDVDVideoCodecFFmpeg::CDVDVideoCodecFFmpeg(CProcessInfo &processInfo) : CDVDVide
   m_iOrientation = 0;
   m_decoderState = STATE_NONE;
   m_pHardware = nullptr;
+  m_renderPicture = nullptr;
   m_iLastKeyframe = 0;
   m_dts = DVD_NOPTS_VALUE;
   m_started = false;
@@ -463,6 +487,7 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
 
 void CDVDVideoCodecFFmpeg::Dispose()
 {
+  SAFE_RELEASE(m_renderPicture);
   av_frame_free(&m_pFrame);
   av_frame_free(&m_pDecodedFrame);
   av_frame_free(&m_pFilterFrame);
@@ -957,11 +982,20 @@ bool CDVDVideoCodecFFmpeg::GetPicture(DVDVideoPicture* pDvdVideoPicture)
 
   pDvdVideoPicture->format = CDVDCodecUtils::EFormatFromPixfmt(pix_fmt);
 
+  // the previous picture is either copied or referenced by the renderer by now
+  SAFE_RELEASE(m_renderPicture);
+  if (pDvdVideoPicture->data[0])
+    m_renderPicture = CFFmpegRenderPicture::Create(m_pFrame);
+  pDvdVideoPicture->frameRef = m_renderPicture;
+
   if (CMediaSettings::GetInstance().GetCurrentVideoSettings().m_PostProcess)
   {
     m_postProc.SetType(g_advancedSettings.m_videoPPFFmpegPostProc, false);
     if (m_postProc.Process(pDvdVideoPicture))
+    {
       m_postProc.GetPicture(pDvdVideoPicture);
+      pDvdVideoPicture->frameRef = nullptr;
+    }
   }
 
   return true;
@@ -39,6 +39,26 @@ extern "C" {
 
 class CCriticalSection;
 
+/*!
+ * \brief Reference to a decoded frame, handed to the renderer along with the
+ * picture so it can upload straight from the decoder's buffers. Those come from
+ * the refcounted pool of avcodec's get_buffer2, a frame goes back to the pool
+ * once the codec and the renderer released it.
+ */
+class CFFmpegRenderPicture : public IDVDResourceCounted<CFFmpegRenderPicture>
+{
+public:
+  static CFFmpegRenderPicture* Create(AVFrame *frame);
+  virtual ~CFFmpegRenderPicture();
+
+  uint8_t* GetData(int plane) const { return m_frame->data[plane]; }
+  int GetLineSize(int plane) const { return m_frame->linesize[plane]; }
+
+private:
+  CFFmpegRenderPicture(AVFrame *frame) : m_frame(frame) {}
+  AVFrame *m_frame;
+};
+
 class CDVDVideoCodecFFmpeg : public CDVDVideoCodec
 {
 public:
@@ -112,6 +132,7 @@ protected:
   std::string m_name;
   int m_decoderState;
   IHardwareDecoder *m_pHardware;
+  CFFmpegRenderPicture *m_renderPicture;
   int m_iLastKeyframe;
   double m_dts;
   bool   m_started;
@@ -27,6 +27,7 @@
 #include "cores/FFmpeg.h"
 #include "DVDClock.h" // for DVD_TIME_BASE
 #include "DVDDemuxUtils.h"
+#include "DemuxProbeCache.h"
 #include "DVDInputStreams/DVDInputStream.h"
 #include "DVDInputStreams/DVDInputStreamFFmpeg.h"
 #include "filesystem/CurlFile.h"
@@ -79,6 +80,8 @@ static const struct StereoModeConversionMap WmvToInternalStereoModeMap[] =
 };
 
 #define FF_MAX_EXTRADATA_SIZE ((1 << 28) - FF_INPUT_BUFFER_PADDING_SIZE)
+// how much is read to find the start times of streams restored from the probe cache
+#define FF_PROBE_CACHE_PROBESIZE (32 * 1024)
 
 std::string CDemuxStreamAudioFFmpeg::GetStreamName()
 {
@@ -457,8 +460,32 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
     if(m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD))
       av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
 
+    std::string probeKey;
+    if (g_advancedSettings.m_videoProbeCache)
+      probeKey = CDemuxProbeCache::GetKey(m_pInput);
+
+    bool probeCached = !probeKey.empty() &&
+                       CDemuxProbeCache::GetInstance().Restore(probeKey, m_pFormatContext, m_pInput->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER));
+    unsigned int nbStreams = m_pFormatContext->nb_streams;
+    if (probeCached)
+    {
+      // the codec parameters are known, only read the first packets for the start times
+      CLog::Log(LOGDEBUG, "%s - restored streams from probe cache", __FUNCTION__);
+      av_opt_set_int(m_pFormatContext, "probesize", FF_PROBE_CACHE_PROBESIZE, 0);
+      av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
+    }
+
     CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
     int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+
+    if (probeCached && (iErr < 0 || m_pFormatContext->nb_streams != nbStreams))
+    {
+      // the cached streams are out of date, probe again the next time
+      CDemuxProbeCache::GetInstance().Remove(probeKey);
+    }
+    else if (!probeCached && iErr >= 0 && !probeKey.empty())
+      CDemuxProbeCache::GetInstance().Store(probeKey, m_pFormatContext);
+
     if (iErr < 0)
     {
       CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
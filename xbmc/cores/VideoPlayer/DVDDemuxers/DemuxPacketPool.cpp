@@ -0,0 +1,251 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined TARGET_WINDOWS)
+  #include "config.h"
+#endif
+#include "DemuxPacketPool.h"
+#include "DVDClock.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "system.h"
+
+#include <cstring>
+#include <new>
+
+#ifdef TARGET_POSIX
+#include "linux/XMemUtils.h"
+#endif
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+#define DEMUX_PACKET_ALIGNMENT 64
+
+// DemuxPacket has to stay the first member, FreeDemuxPacket casts back to
+// the pooled packet from the pointer handed out to the demuxers
+struct CDemuxPacketPool::SPooledPacket
+{
+  DemuxPacket packet;
+  SPooledPacket* next;
+  uint8_t* buffer;   // payload owned by the pool, pData points here
+  int sizeClass;     // -1 if the packet is not pooled
+  size_t capacity;   // payload bytes available including padding
+};
+
+CDemuxPacketPool::CDemuxPacketPool(size_t maxIdleBytes)
+  : m_maxIdleBytes(maxIdleBytes)
+  , m_hits(0)
+  , m_misses(0)
+  , m_bytes(0)
+  , m_idleBytes(0)
+  , m_peakBytes(0)
+{
+}
+
+CDemuxPacketPool::~CDemuxPacketPool()
+{
+  Trim();
+}
+
+CDemuxPacketPool& CDemuxPacketPool::GetInstance()
+{
+  static CDemuxPacketPool pool;
+  return pool;
+}
+
+int CDemuxPacketPool::GetSizeClass(size_t size)
+{
+  if (size == 0)
+    return 0;
+
+  for (int sizeClass = 1; sizeClass <= NUM_CLASSES; sizeClass++)
+  {
+    if (size <= GetClassCapacity(sizeClass))
+      return sizeClass;
+  }
+  return -1;
+}
+
+size_t CDemuxPacketPool::GetClassCapacity(int sizeClass)
+{
+  if (sizeClass <= 0)
+    return 0;
+  return static_cast<size_t>(1) << (MIN_CLASS_SHIFT + sizeClass - 1);
+}
+
+void CDemuxPacketPool::AddBytes(uint64_t bytes)
+{
+  uint64_t current = (m_bytes += bytes);
+  uint64_t peak = m_peakBytes;
+  while (current > peak && !m_peakBytes.compare_exchange_weak(peak, current))
+    ;
+}
+
+bool CDemuxPacketPool::ReserveIdleBytes(uint64_t bytes)
+{
+  // frees from several threads must not push the idle bytes over the limit
+  uint64_t idle = m_idleBytes;
+  do
+  {
+    if (idle + bytes > m_maxIdleBytes)
+      return false;
+  } while (!m_idleBytes.compare_exchange_weak(idle, idle + bytes));
+
+  return true;
+}
+
+DemuxPacket* CDemuxPacketPool::Allocate(int iDataSize)
+{
+  if (iDataSize < 0)
+    iDataSize = 0;
+
+  // need to allocate a few bytes more.
+  // From avcodec.h (ffmpeg)
+  /**
+    * Required number of additionally allocated bytes at the end of the input bitstream for decoding.
+    * this is mainly needed because some optimized bitstream readers read
+    * 32 or 64 bit at once and could read over the end<br>
+    * Note, if the first 23 bits of the additional bytes are not 0 then damaged
+    * MPEG bitstreams could cause overread and segfault
+    */
+  size_t required = iDataSize > 0 ? iDataSize + FF_INPUT_BUFFER_PADDING_SIZE : 0;
+  int sizeClass = GetSizeClass(required);
+
+  SPooledPacket* pooled = nullptr;
+  if (sizeClass >= 0)
+  {
+    SFreeList& list = m_freeLists[sizeClass];
+    CSingleLock lock(list.lock);
+    pooled = list.head;
+    if (pooled)
+      list.head = pooled->next;
+  }
+
+  if (pooled)
+  {
+    m_hits++;
+    m_idleBytes -= sizeof(SPooledPacket) + pooled->capacity;
+  }
+  else
+  {
+    m_misses++;
+
+    pooled = new (std::nothrow) SPooledPacket;
+    if (!pooled)
+      return NULL;
+
+    pooled->sizeClass = sizeClass;
+    pooled->capacity = sizeClass >= 0 ? GetClassCapacity(sizeClass) : required;
+    pooled->buffer = NULL;
+    if (pooled->capacity > 0)
+    {
+      pooled->buffer = static_cast<uint8_t*>(_aligned_malloc(pooled->capacity, DEMUX_PACKET_ALIGNMENT));
+      if (!pooled->buffer)
+      {
+        CLog::Log(LOGERROR, "%s - failed to allocate %d bytes", __FUNCTION__, iDataSize);
+        delete pooled;
+        return NULL;
+      }
+    }
+    AddBytes(sizeof(SPooledPacket) + pooled->capacity);
+  }
+
+  pooled->next = nullptr;
+
+  DemuxPacket* pPacket = &pooled->packet;
+  memset(pPacket, 0, sizeof(DemuxPacket));
+
+  if (iDataSize > 0)
+  {
+    pPacket->pData = pooled->buffer;
+    // reset the padding to 0
+    memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+  }
+
+  // setup defaults
+  pPacket->dts       = DVD_NOPTS_VALUE;
+  pPacket->pts       = DVD_NOPTS_VALUE;
+  pPacket->iStreamId = -1;
+  pPacket->dispTime  = 0;
+
+  return pPacket;
+}
+
+void CDemuxPacketPool::Free(DemuxPacket* pPacket)
+{
+  if (!pPacket)
+    return;
+
+  SPooledPacket* pooled = reinterpret_cast<SPooledPacket*>(pPacket);
+  size_t bytes = sizeof(SPooledPacket) + pooled->capacity;
+
+  if (pooled->sizeClass >= 0 && ReserveIdleBytes(bytes))
+  {
+    SFreeList& list = m_freeLists[pooled->sizeClass];
+    CSingleLock lock(list.lock);
+    pooled->next = list.head;
+    list.head = pooled;
+    return;
+  }
+
+  Release(pooled);
+}
+
+void CDemuxPacketPool::Release(SPooledPacket* pooled)
+{
+  m_bytes -= sizeof(SPooledPacket) + pooled->capacity;
+  if (pooled->buffer)
+    _aligned_free(pooled->buffer);
+  delete pooled;
+}
+
+void CDemuxPacketPool::Trim()
+{
+  for (SFreeList& list : m_freeLists)
+  {
+    SPooledPacket* head;
+    {
+      CSingleLock lock(list.lock);
+      head = list.head;
+      list.head = nullptr;
+    }
+
+    while (head)
+    {
+      SPooledPacket* next = head->next;
+      m_idleBytes -= sizeof(SPooledPacket) + head->capacity;
+      Release(head);
+      head = next;
+    }
+  }
+}
+
+CDemuxPacketPool::SStats CDemuxPacketPool::GetStats() const
+{
+  SStats stats;
+  stats.hits = m_hits;
+  stats.misses = m_misses;
+  stats.bytes = m_bytes;
+  stats.idleBytes = m_idleBytes;
+  stats.peakBytes = m_peakBytes;
+  return stats;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "DVDDemuxPacket.h"
+#include "threads/CriticalSection.h"
+
+/*!
+ * \brief Recycles DemuxPacket structures together with their payload buffers.
+ *
+ * Payloads are rounded up to power of two size classes. A freed packet is put
+ * on the free list of its class and handed out again by the next allocation
+ * that falls into the same class, so steady state playback does not touch the
+ * heap. Payloads larger than the biggest class are not pooled.
+ */
+class CDemuxPacketPool
+{
+public:
+  struct SStats
+  {
+    uint64_t hits;        //!< allocations served from a free list
+    uint64_t misses;      //!< allocations that had to go to the heap
+    uint64_t bytes;       //!< bytes currently owned by the pool (in use and idle)
+    uint64_t idleBytes;   //!< bytes sitting on the free lists
+    uint64_t peakBytes;   //!< high water mark of bytes
+  };
+
+  CDemuxPacketPool(size_t maxIdleBytes = DEFAULT_MAX_IDLE_BYTES);
+  ~CDemuxPacketPool();
+
+  static CDemuxPacketPool& GetInstance();
+
+  DemuxPacket* Allocate(int iDataSize);
+  void Free(DemuxPacket* pPacket);
+
+  /*!
+   * \brief Release all idle packets back to the heap
+   */
+  void Trim();
+
+  SStats GetStats() const;
+
+  static const size_t DEFAULT_MAX_IDLE_BYTES = 64 * 1024 * 1024;
+  static const int MIN_CLASS_SHIFT = 8;   // 256 bytes
+  static const int NUM_CLASSES = 17;      // up to 16 MB
+
+private:
+  CDemuxPacketPool(const CDemuxPacketPool&) = delete;
+  CDemuxPacketPool& operator=(const CDemuxPacketPool&) = delete;
+
+  struct SPooledPacket;
+
+  static int GetSizeClass(size_t size);
+  static size_t GetClassCapacity(int sizeClass);
+  void Release(SPooledPacket* pooled);
+  void AddBytes(uint64_t bytes);
+  bool ReserveIdleBytes(uint64_t bytes);
+
+  struct SFreeList
+  {
+    CCriticalSection lock;
+    SPooledPacket* head = nullptr;
+  };
+
+  // the first free list holds packets without payload
+  SFreeList m_freeLists[NUM_CLASSES + 1];
+  const size_t m_maxIdleBytes;
+
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+  std::atomic<uint64_t> m_bytes;
+  std::atomic<uint64_t> m_idleBytes;
+  std::atomic<uint64_t> m_peakBytes;
+};
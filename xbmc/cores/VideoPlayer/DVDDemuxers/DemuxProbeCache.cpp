@@ -0,0 +1,314 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DemuxProbeCache.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include "DVDInputStreams/DVDInputStream.h"
+#include "FileItem.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "URL.h"
+#include "utils/auto_buffer.h"
+#include "utils/Base64.h"
+#include "utils/Crc32.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#define PROBE_CACHE_FOLDER "special://temp/probecache/"
+
+CDemuxProbeCache& CDemuxProbeCache::GetInstance()
+{
+  static CDemuxProbeCache probeCache;
+  return probeCache;
+}
+
+std::string CDemuxProbeCache::GetKey(CDVDInputStream *input)
+{
+  const std::string fileName = input->GetFileName();
+
+  // a channel keeps its streams, whatever is shown on it
+  if (input->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER))
+    return fileName;
+
+  if (!input->IsStreamType(DVDSTREAM_TYPE_FILE))
+    return "";
+
+  struct __stat64 buffer;
+  if (XFILE::CFile::Stat(fileName, &buffer) != 0 || buffer.st_size <= 0)
+    return "";
+
+  return StringUtils::Format("%s|%" PRId64 "|%" PRId64, fileName.c_str(), (int64_t)buffer.st_size, (int64_t)buffer.st_mtime);
+}
+
+std::string CDemuxProbeCache::GetPath(const std::string &key)
+{
+  return StringUtils::Format(PROBE_CACHE_FOLDER "%08x.json", (uint32_t)Crc32::Compute(key));
+}
+
+bool CDemuxProbeCache::Restore(const std::string &key, AVFormatContext *context, bool live)
+{
+  CVariant entry;
+  {
+    CSingleLock lock(m_critSection);
+    XFILE::CFile file;
+    XUTILS::auto_buffer buffer;
+    if (file.LoadFile(GetPath(key), buffer) <= 0)
+      return false;
+    entry = CJSONVariantParser::Parse(reinterpret_cast<const unsigned char*>(buffer.get()), buffer.size());
+  }
+
+  // the file name is only a hash of the key
+  if (!entry.isObject() || entry["version"].asInteger() != VERSION || entry["key"].asString() != key)
+    return false;
+
+  if (!Matches(entry, context))
+  {
+    CLog::Log(LOGDEBUG, "CDemuxProbeCache: streams of %s changed", CURL::GetRedacted(key).c_str());
+    return false;
+  }
+
+  const CVariant &streams = entry["streams"];
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+    RestoreStream(streams[i], context->streams[i], live);
+
+  context->bit_rate = entry["bitrate"].asInteger();
+
+  return true;
+}
+
+void CDemuxProbeCache::Store(const std::string &key, const AVFormatContext *context)
+{
+  CVariant entry(CVariant::VariantTypeObject);
+  entry["version"] = VERSION;
+  entry["key"] = key;
+  entry["format"] = context->iformat->name;
+  entry["bitrate"] = (int64_t)context->bit_rate;
+  entry["streams"] = CVariant(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+    entry["streams"].push_back(SerializeStream(context->streams[i]));
+
+  const std::string json = CJSONVariantWriter::Write(entry, true);
+  const std::string path = GetPath(key);
+
+  CSingleLock lock(m_critSection);
+  bool bNew = !XFILE::CFile::Exists(path);
+  if (bNew)
+    XFILE::CDirectory::Create(PROBE_CACHE_FOLDER);
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(path, true) || file.Write(json.c_str(), json.size()) != (ssize_t)json.size())
+  {
+    CLog::Log(LOGWARNING, "CDemuxProbeCache: unable to write %s", path.c_str());
+    file.Close();
+    XFILE::CFile::Delete(path);
+    return;
+  }
+  file.Close();
+
+  if (bNew)
+    Trim();
+}
+
+void CDemuxProbeCache::Remove(const std::string &key)
+{
+  CSingleLock lock(m_critSection);
+  XFILE::CFile::Delete(GetPath(key));
+}
+
+void CDemuxProbeCache::Trim()
+{
+  CFileItemList items;
+  if (!XFILE::CDirectory::GetDirectory(PROBE_CACHE_FOLDER, items, ".json", DIR_FLAG_NO_FILE_DIRS) ||
+      items.Size() <= (int)MAX_ENTRIES)
+    return;
+
+  // drop the entries that were written longest ago, down to 90% of the limit
+  std::vector<std::pair<CDateTime, std::string> > entries;
+  for (int i = 0; i < items.Size(); i++)
+    entries.push_back(std::make_pair(items[i]->m_dateTime, items[i]->GetPath()));
+  std::sort(entries.begin(), entries.end());
+
+  size_t remove = entries.size() - MAX_ENTRIES * 9 / 10;
+  for (size_t i = 0; i < remove; i++)
+    XFILE::CFile::Delete(entries[i].second);
+}
+
+bool CDemuxProbeCache::Matches(const CVariant &entry, const AVFormatContext *context)
+{
+  if (entry["format"].asString() != context->iformat->name)
+    return false;
+
+  const CVariant &streams = entry["streams"];
+  if (!streams.isArray() || streams.size() != context->nb_streams)
+    return false;
+
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+  {
+    const AVCodecParameters *codecpar = context->streams[i]->codecpar;
+    if (streams[i]["type"].asInteger() != codecpar->codec_type ||
+        streams[i]["codec"].asInteger() != codecpar->codec_id)
+      return false;
+  }
+
+  return true;
+}
+
+CVariant CDemuxProbeCache::SerializeStream(const AVStream *stream)
+{
+  const AVCodecParameters *codecpar = stream->codecpar;
+  CVariant entry(CVariant::VariantTypeObject);
+
+  entry["type"] = codecpar->codec_type;
+  entry["codec"] = codecpar->codec_id;
+  entry["tag"] = codecpar->codec_tag;
+  entry["format"] = codecpar->format;
+  entry["bitrate"] = (int64_t)codecpar->bit_rate;
+  entry["bitspercodedsample"] = codecpar->bits_per_coded_sample;
+  entry["bitsperrawsample"] = codecpar->bits_per_raw_sample;
+  entry["profile"] = codecpar->profile;
+  entry["level"] = codecpar->level;
+  if (codecpar->extradata && codecpar->extradata_size > 0)
+    entry["extradata"] = Base64::Encode(reinterpret_cast<const char*>(codecpar->extradata), codecpar->extradata_size);
+
+  if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+  {
+    entry["width"] = codecpar->width;
+    entry["height"] = codecpar->height;
+    entry["sar"].push_back(codecpar->sample_aspect_ratio.num);
+    entry["sar"].push_back(codecpar->sample_aspect_ratio.den);
+    entry["fieldorder"] = codecpar->field_order;
+    entry["colorrange"] = codecpar->color_range;
+    entry["colorprimaries"] = codecpar->color_primaries;
+    entry["colortrc"] = codecpar->color_trc;
+    entry["colorspace"] = codecpar->color_space;
+    entry["chromalocation"] = codecpar->chroma_location;
+    entry["videodelay"] = codecpar->video_delay;
+  }
+  else if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+  {
+    entry["channellayout"] = (int64_t)codecpar->channel_layout;
+    entry["channels"] = codecpar->channels;
+    entry["samplerate"] = codecpar->sample_rate;
+    entry["blockalign"] = codecpar->block_align;
+    entry["framesize"] = codecpar->frame_size;
+  }
+
+  // the stream properties that are filled in by probing
+#if defined(AVFORMAT_HAS_STREAM_GET_R_FRAME_RATE)
+  AVRational r_frame_rate = av_stream_get_r_frame_rate(stream);
+#else
+  AVRational r_frame_rate = stream->r_frame_rate;
+#endif
+  entry["streamsar"].push_back(stream->sample_aspect_ratio.num);
+  entry["streamsar"].push_back(stream->sample_aspect_ratio.den);
+  entry["rframerate"].push_back(r_frame_rate.num);
+  entry["rframerate"].push_back(r_frame_rate.den);
+  entry["avgframerate"].push_back(stream->avg_frame_rate.num);
+  entry["avgframerate"].push_back(stream->avg_frame_rate.den);
+
+  return entry;
+}
+
+static AVRational GetRational(const CVariant &value)
+{
+  AVRational rational = { 0, 1 };
+  if (value.isArray() && value.size() == 2)
+  {
+    rational.num = (int)value[0].asInteger();
+    rational.den = (int)value[1].asInteger();
+  }
+  return rational;
+}
+
+void CDemuxProbeCache::RestoreStream(const CVariant &entry, AVStream *stream, bool live)
+{
+  AVCodecParameters *codecpar = stream->codecpar;
+
+  codecpar->codec_tag = (unsigned int)entry["tag"].asInteger();
+  codecpar->format = (int)entry["format"].asInteger(-1);
+  codecpar->bit_rate = entry["bitrate"].asInteger();
+  codecpar->bits_per_coded_sample = (int)entry["bitspercodedsample"].asInteger();
+  codecpar->bits_per_raw_sample = (int)entry["bitsperrawsample"].asInteger();
+  codecpar->profile = (int)entry["profile"].asInteger(FF_PROFILE_UNKNOWN);
+  codecpar->level = (int)entry["level"].asInteger(FF_LEVEL_UNKNOWN);
+
+  if (entry.isMember("extradata") && !live)
+  {
+    std::string extradata = Base64::Decode(entry["extradata"].asString());
+    uint8_t *data = (uint8_t*)av_mallocz(extradata.size() + FF_INPUT_BUFFER_PADDING_SIZE);
+    if (data)
+    {
+      memcpy(data, extradata.c_str(), extradata.size());
+      av_freep(&codecpar->extradata);
+      codecpar->extradata = data;
+      codecpar->extradata_size = extradata.size();
+    }
+  }
+
+  if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+  {
+    if (!live)
+    {
+      codecpar->width = (int)entry["width"].asInteger();
+      codecpar->height = (int)entry["height"].asInteger();
+      codecpar->sample_aspect_ratio = GetRational(entry["sar"]);
+    }
+    codecpar->field_order = (AVFieldOrder)entry["fieldorder"].asInteger();
+    codecpar->color_range = (AVColorRange)entry["colorrange"].asInteger();
+    codecpar->color_primaries = (AVColorPrimaries)entry["colorprimaries"].asInteger();
+    codecpar->color_trc = (AVColorTransferCharacteristic)entry["colortrc"].asInteger();
+    codecpar->color_space = (AVColorSpace)entry["colorspace"].asInteger();
+    codecpar->chroma_location = (AVChromaLocation)entry["chromalocation"].asInteger();
+    codecpar->video_delay = (int)entry["videodelay"].asInteger();
+  }
+  else if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+  {
+    if (!live)
+    {
+      codecpar->channel_layout = (uint64_t)entry["channellayout"].asInteger();
+      codecpar->channels = (int)entry["channels"].asInteger();
+      codecpar->sample_rate = (int)entry["samplerate"].asInteger();
+    }
+    codecpar->block_align = (int)entry["blockalign"].asInteger();
+    codecpar->frame_size = (int)entry["framesize"].asInteger();
+  }
+
+  if (!live)
+    stream->sample_aspect_ratio = GetRational(entry["streamsar"]);
+#if defined(AVFORMAT_HAS_STREAM_GET_R_FRAME_RATE)
+  av_stream_set_r_frame_rate(stream, GetRational(entry["rframerate"]));
+#else
+  stream->r_frame_rate = GetRational(entry["rframerate"]);
+#endif
+  stream->avg_frame_rate = GetRational(entry["avgframerate"]);
+
+  // the rest of the player still reads the parameters from the codec context
+  avcodec_parameters_to_context(stream->codec, codecpar);
+}
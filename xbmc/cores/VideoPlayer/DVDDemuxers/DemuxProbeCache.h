@@ -0,0 +1,99 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include "threads/CriticalSection.h"
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+class CDVDInputStream;
+class CVariant;
+
+/*!
+ * \brief Remembers what avformat_find_stream_info() found out about a file.
+ *
+ * Probing the streams of a file reads up to several MB, which takes seconds
+ * for mkv and ts files on network shares and for live tv. The results (the
+ * stream layout, codec parameters including extradata and frame rates) are
+ * stored in special://temp/probecache/, keyed by the path, size and
+ * modification time of a file or by the channel for pvr streams. When the
+ * same input is opened again the streams are seeded from the cache, so only
+ * a few KB have to be read before playback starts.
+ *
+ * Start times and durations are not cached: they are different every time a
+ * channel is tuned, and the short probe that still runs finds them anyway.
+ * For the same reason the picture size, the audio channels and sample rate
+ * and the extradata of a channel aren't restored, they change with what is
+ * broadcast. The short probe and the parsers of the demuxer find them.
+ *
+ * An entry is only used if the streams found while opening the input match
+ * the cached ones. An entry that doesn't match is replaced by the results of
+ * the full probe that runs instead.
+ */
+class CDemuxProbeCache
+{
+public:
+  CDemuxProbeCache() = default;
+
+  static CDemuxProbeCache& GetInstance();
+
+  /*!
+   * \brief Get the key of the cache entry for the given input
+   * \return the key or an empty string if the probe results of the input can't be cached
+   */
+  static std::string GetKey(CDVDInputStream *input);
+
+  /*!
+   * \brief Seed the streams of a freshly opened format context from the cache
+   * \param live whether the input is a channel, see above
+   * \return true if the streams were seeded and don't need to be probed fully
+   */
+  bool Restore(const std::string &key, AVFormatContext *context, bool live);
+
+  /*!
+   * \brief Store the results of avformat_find_stream_info()
+   */
+  void Store(const std::string &key, const AVFormatContext *context);
+
+  /*!
+   * \brief Remove an entry that was found to be out of date
+   */
+  void Remove(const std::string &key);
+
+  static const int VERSION = 2;
+  static const unsigned int MAX_ENTRIES = 1000;
+
+private:
+  friend class TestDemuxProbeCache;
+
+  CDemuxProbeCache(const CDemuxProbeCache&) = delete;
+  CDemuxProbeCache& operator=(const CDemuxProbeCache&) = delete;
+
+  static std::string GetPath(const std::string &key);
+  static bool Matches(const CVariant &entry, const AVFormatContext *context);
+  static void RestoreStream(const CVariant &entry, AVStream *stream, bool live);
+  static CVariant SerializeStream(const AVStream *stream);
+  void Trim();
+
+  CCriticalSection m_critSection;
+};
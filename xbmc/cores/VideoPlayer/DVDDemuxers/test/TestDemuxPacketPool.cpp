@@ -0,0 +1,172 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDDemuxers/DemuxPacketPool.h"
+#include "cores/VideoPlayer/DVDClock.h"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+TEST(TestDemuxPacketPool, Reuse)
+{
+  CDemuxPacketPool pool;
+
+  DemuxPacket* pPacket = pool.Allocate(1500);
+  ASSERT_TRUE(pPacket != NULL);
+  pool.Free(pPacket);
+
+  // same size class
+  DemuxPacket* pReused = pool.Allocate(1200);
+  EXPECT_EQ(pPacket, pReused);
+
+  // a different size class comes from the heap
+  DemuxPacket* pOther = pool.Allocate(100000);
+  EXPECT_NE(pReused, pOther);
+
+  pool.Free(pReused);
+  pool.Free(pOther);
+}
+
+TEST(TestDemuxPacketPool, Defaults)
+{
+  CDemuxPacketPool pool;
+
+  DemuxPacket* pPacket = pool.Allocate(100);
+  pPacket->pts = 1.0;
+  pPacket->iStreamId = 3;
+  pool.Free(pPacket);
+
+  pPacket = pool.Allocate(100);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pPacket->pts);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pPacket->dts);
+  EXPECT_EQ(-1, pPacket->iStreamId);
+  EXPECT_EQ(0, pPacket->iSize);
+  pool.Free(pPacket);
+
+  pPacket = pool.Allocate(0);
+  EXPECT_TRUE(pPacket->pData == NULL);
+  pool.Free(pPacket);
+}
+
+TEST(TestDemuxPacketPool, Padding)
+{
+  CDemuxPacketPool pool;
+
+  // dirty the whole buffer so a reused packet has to clear its padding again
+  const int maxSize = 1500;
+  DemuxPacket* pPacket = pool.Allocate(maxSize);
+  memset(pPacket->pData, 0xff, maxSize + FF_INPUT_BUFFER_PADDING_SIZE);
+  pool.Free(pPacket);
+
+  // all of the same size class
+  for (int size : { 1200, 1400, maxSize })
+  {
+    pPacket = pool.Allocate(size);
+    ASSERT_TRUE(pPacket->pData != NULL);
+    EXPECT_EQ(0U, (uintptr_t)pPacket->pData % 64);
+    for (int i = 0; i < FF_INPUT_BUFFER_PADDING_SIZE; i++)
+      EXPECT_EQ(0, pPacket->pData[size + i]);
+    memset(pPacket->pData, 0xff, maxSize + FF_INPUT_BUFFER_PADDING_SIZE);
+    pool.Free(pPacket);
+  }
+
+  // payloads too large to pool are aligned and padded as well
+  pPacket = pool.Allocate(20 * 1024 * 1024);
+  ASSERT_TRUE(pPacket->pData != NULL);
+  EXPECT_EQ(0U, (uintptr_t)pPacket->pData % 64);
+  EXPECT_EQ(0, pPacket->pData[20 * 1024 * 1024 + FF_INPUT_BUFFER_PADDING_SIZE - 1]);
+  pool.Free(pPacket);
+}
+
+TEST(TestDemuxPacketPool, Stats)
+{
+  CDemuxPacketPool pool;
+
+  DemuxPacket* pFirst = pool.Allocate(1000);
+  DemuxPacket* pSecond = pool.Allocate(1000);
+  CDemuxPacketPool::SStats stats = pool.GetStats();
+  EXPECT_EQ(0U, stats.hits);
+  EXPECT_EQ(2U, stats.misses);
+  EXPECT_GE(stats.bytes, 2U * 1024);
+  EXPECT_EQ(0U, stats.idleBytes);
+  EXPECT_EQ(stats.bytes, stats.peakBytes);
+
+  pool.Free(pFirst);
+  pool.Free(pSecond);
+  stats = pool.GetStats();
+  EXPECT_EQ(stats.bytes, stats.idleBytes);
+
+  pool.Free(pool.Allocate(1000));
+  stats = pool.GetStats();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(2U, stats.misses);
+
+  // a packet too large to pool is released right away
+  uint64_t peak = stats.peakBytes;
+  pool.Free(pool.Allocate(20 * 1024 * 1024));
+  stats = pool.GetStats();
+  EXPECT_EQ(stats.bytes, stats.idleBytes);
+  EXPECT_GT(stats.peakBytes, peak + 20 * 1024 * 1024);
+
+  pool.Trim();
+  stats = pool.GetStats();
+  EXPECT_EQ(0U, stats.bytes);
+  EXPECT_EQ(0U, stats.idleBytes);
+}
+
+TEST(TestDemuxPacketPool, IdleLimit)
+{
+  const size_t maxIdleBytes = 256 * 1024;
+  const int threads = 4;
+  const int packets = 100;
+  CDemuxPacketPool pool(maxIdleBytes);
+
+  std::vector<std::vector<DemuxPacket*>> allocated(threads);
+  for (auto &list : allocated)
+  {
+    for (int i = 0; i < packets; i++)
+      list.push_back(pool.Allocate(4000));
+  }
+
+  // free from several threads at once, together they hold more than the limit
+  std::vector<std::thread> freeing;
+  for (auto &list : allocated)
+  {
+    freeing.push_back(std::thread([&pool, &list]()
+    {
+      for (DemuxPacket* pPacket : list)
+        pool.Free(pPacket);
+    }));
+  }
+  for (auto &thread : freeing)
+    thread.join();
+
+  CDemuxPacketPool::SStats stats = pool.GetStats();
+  EXPECT_LE(stats.idleBytes, maxIdleBytes);
+  EXPECT_GT(stats.idleBytes, maxIdleBytes / 2);
+  EXPECT_EQ(stats.bytes, stats.idleBytes);
+}
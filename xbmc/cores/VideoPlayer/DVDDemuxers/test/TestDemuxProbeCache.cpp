@@ -0,0 +1,184 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDDemuxers/DemuxProbeCache.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+class TestDemuxProbeCache : public ::testing::Test
+{
+protected:
+  AVInputFormat format;
+  AVFormatContext *probed = nullptr;
+  AVFormatContext *opened = nullptr;
+
+  void SetUp() override
+  {
+    memset(&format, 0, sizeof(format));
+    format.name = "probecachetest";
+
+    // what avformat_find_stream_info() found out
+    probed = CreateContext();
+    AVStream *video = probed->streams[0];
+    video->codecpar->codec_tag = 0x31637661;
+    video->codecpar->profile = FF_PROFILE_H264_HIGH;
+    video->codecpar->level = 41;
+    video->codecpar->width = 1920;
+    video->codecpar->height = 1080;
+    video->codecpar->sample_aspect_ratio = { 1, 1 };
+    video->codecpar->extradata = (uint8_t*)av_mallocz(4 + FF_INPUT_BUFFER_PADDING_SIZE);
+    memcpy(video->codecpar->extradata, "\x01\x64\x00\x29", 4);
+    video->codecpar->extradata_size = 4;
+    video->avg_frame_rate = { 25, 1 };
+    video->start_time = 900000;
+    video->duration = 2700000;
+
+    AVStream *audio = probed->streams[1];
+    audio->codecpar->channel_layout = AV_CH_LAYOUT_STEREO;
+    audio->codecpar->channels = 2;
+    audio->codecpar->sample_rate = 48000;
+    audio->codecpar->frame_size = 1152;
+    audio->start_time = 900360;
+    audio->duration = 2700000;
+
+    probed->start_time = 10000000;
+    probed->duration = 30000000;
+
+    // the same streams right after avformat_open_input()
+    opened = CreateContext();
+  }
+
+  void TearDown() override
+  {
+    CDemuxProbeCache::GetInstance().Remove("pvr://test/channel/1");
+    CDemuxProbeCache::GetInstance().Remove("special://temp/test.ts|1000|0");
+    FreeContext(probed);
+    FreeContext(opened);
+  }
+
+  AVFormatContext* CreateContext()
+  {
+    AVFormatContext *context = avformat_alloc_context();
+    context->iformat = &format;
+
+    AVStream *video = avformat_new_stream(context, nullptr);
+    video->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    video->codecpar->codec_id = AV_CODEC_ID_H264;
+
+    AVStream *audio = avformat_new_stream(context, nullptr);
+    audio->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
+    audio->codecpar->codec_id = AV_CODEC_ID_MP2;
+    return context;
+  }
+
+  void FreeContext(AVFormatContext *context)
+  {
+    context->iformat = nullptr;
+    avformat_free_context(context);
+  }
+
+  static CVariant SerializeStream(const AVStream *stream) { return CDemuxProbeCache::SerializeStream(stream); }
+  static void RestoreStream(const CVariant &entry, AVStream *stream) { CDemuxProbeCache::RestoreStream(entry, stream, false); }
+};
+
+TEST_F(TestDemuxProbeCache, RoundTripStreams)
+{
+  for (unsigned int i = 0; i < probed->nb_streams; i++)
+    RestoreStream(SerializeStream(probed->streams[i]), opened->streams[i]);
+
+  const AVCodecParameters *video = opened->streams[0]->codecpar;
+  EXPECT_EQ(0x31637661u, video->codec_tag);
+  EXPECT_EQ(FF_PROFILE_H264_HIGH, video->profile);
+  EXPECT_EQ(41, video->level);
+  EXPECT_EQ(1920, video->width);
+  EXPECT_EQ(1080, video->height);
+  EXPECT_EQ(1, video->sample_aspect_ratio.num);
+  EXPECT_EQ(1, video->sample_aspect_ratio.den);
+  ASSERT_EQ(4, video->extradata_size);
+  EXPECT_EQ(0, memcmp(video->extradata, "\x01\x64\x00\x29", 4));
+  EXPECT_EQ(25, opened->streams[0]->avg_frame_rate.num);
+  EXPECT_EQ(1, opened->streams[0]->avg_frame_rate.den);
+
+  const AVCodecParameters *audio = opened->streams[1]->codecpar;
+  EXPECT_EQ(AV_CH_LAYOUT_STEREO, audio->channel_layout);
+  EXPECT_EQ(2, audio->channels);
+  EXPECT_EQ(48000, audio->sample_rate);
+  EXPECT_EQ(1152, audio->frame_size);
+
+  // the codec context is still read by the rest of the player
+  EXPECT_EQ(1920, opened->streams[0]->codec->width);
+  EXPECT_EQ(48000, opened->streams[1]->codec->sample_rate);
+
+  // the start times are found again by the probe that still runs
+  for (unsigned int i = 0; i < opened->nb_streams; i++)
+  {
+    EXPECT_EQ(AV_NOPTS_VALUE, opened->streams[i]->start_time);
+    EXPECT_EQ(AV_NOPTS_VALUE, opened->streams[i]->duration);
+  }
+}
+
+TEST_F(TestDemuxProbeCache, StoreRestore)
+{
+  CDemuxProbeCache &cache = CDemuxProbeCache::GetInstance();
+  cache.Store("special://temp/test.ts|1000|0", probed);
+
+  ASSERT_TRUE(cache.Restore("special://temp/test.ts|1000|0", opened, false));
+  EXPECT_EQ(1920, opened->streams[0]->codecpar->width);
+  EXPECT_EQ(48000, opened->streams[1]->codecpar->sample_rate);
+
+  // the start times are found again by the probe that still runs
+  EXPECT_EQ(AV_NOPTS_VALUE, opened->start_time);
+  EXPECT_EQ(AV_NOPTS_VALUE, opened->duration);
+  EXPECT_EQ(AV_NOPTS_VALUE, opened->streams[0]->start_time);
+
+  // another key or other streams don't match
+  EXPECT_FALSE(cache.Restore("special://temp/test.ts|1000|1", opened, false));
+  opened->streams[1]->codecpar->codec_id = AV_CODEC_ID_AC3;
+  EXPECT_FALSE(cache.Restore("special://temp/test.ts|1000|0", opened, false));
+}
+
+TEST_F(TestDemuxProbeCache, RestoreChannel)
+{
+  CDemuxProbeCache &cache = CDemuxProbeCache::GetInstance();
+  cache.Store("pvr://test/channel/1", probed);
+
+  // the channel now shows a programme in 5.1 and 720p, which the short probe has to find
+  ASSERT_TRUE(cache.Restore("pvr://test/channel/1", opened, true));
+  const AVCodecParameters *video = opened->streams[0]->codecpar;
+  EXPECT_EQ(0x31637661u, video->codec_tag);
+  EXPECT_EQ(FF_PROFILE_H264_HIGH, video->profile);
+  EXPECT_EQ(0, video->width);
+  EXPECT_EQ(0, video->height);
+  EXPECT_EQ(0, video->extradata_size);
+  EXPECT_EQ(nullptr, video->extradata);
+
+  const AVCodecParameters *audio = opened->streams[1]->codecpar;
+  EXPECT_EQ(1152, audio->frame_size);
+  EXPECT_EQ(0u, audio->channel_layout);
+  EXPECT_EQ(0, audio->channels);
+  EXPECT_EQ(0, audio->sample_rate);
+}
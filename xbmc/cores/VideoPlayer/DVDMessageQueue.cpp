@@ -30,11 +30,22 @@ CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized = false;
+  m_drain = false;
 
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
   m_TimeSize = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize = 0;
+
+  m_sequence = 0;
+  m_frontSequence = 0;
+  m_ringMask = 0;
+  m_ringHead = 0;
+  m_ringTail = 0;
+  m_ringProducer = std::thread::id();
+  m_consumerWaiting = false;
+  m_ringPutting = false;
+  m_ringClosed = false;
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
@@ -43,6 +54,20 @@ CDVDMessageQueue::~CDVDMessageQueue()
   Flush(CDVDMsg::NONE);
 }
 
+void CDVDMessageQueue::EnablePacketRing(unsigned int size)
+{
+  CSingleLock lock(m_section);
+
+  ClearRing();
+
+  size_t capacity = 1;
+  while (capacity < size)
+    capacity <<= 1;
+
+  m_ring.assign(capacity, SRingItem{nullptr, 0});
+  m_ringMask = capacity - 1;
+}
+
 void CDVDMessageQueue::Init()
 {
   m_iDataSize = 0;
@@ -51,6 +76,7 @@ void CDVDMessageQueue::Init()
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
   m_drain = false;
+  m_ringProducer = std::thread::id();
 }
 
 void CDVDMessageQueue::Flush(CDVDMsg::Message type)
@@ -67,6 +93,10 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
+    CloseRing();
+    ClearRing();
+    m_ringClosed = false;
+
     m_iDataSize = 0;
     m_TimeBack = DVD_NOPTS_VALUE;
     m_TimeFront = DVD_NOPTS_VALUE;
@@ -87,15 +117,23 @@ void CDVDMessageQueue::End()
 {
   CSingleLock lock(m_section);
 
+  // before the flush, a producer that gets into the ring afterwards has to see it
+  m_bInitialized = false;
   Flush(CDVDMsg::NONE);
 
-  m_bInitialized = false;
   m_iDataSize = 0;
   m_bAbortRequest = false;
 }
 
 MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front)
 {
+  // demuxer packets of the producer thread bypass the lock
+  if (pMsg && priority == 0 && front && pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+  {
+    if (PutRing(pMsg))
+      return MSGQ_OK;
+  }
+
   CSingleLock lock(m_section);
 
   if (!m_bInitialized)
@@ -125,26 +163,13 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
   else
   {
     if (front)
-      m_messages.emplace_front(pMsg, priority);
+      m_messages.emplace_front(pMsg, priority, ++m_sequence);
     else
-      m_messages.emplace_back(pMsg, priority);
+      m_messages.emplace_back(pMsg, priority, --m_frontSequence);
   }
 
   if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
-  {
-    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
-    if (packet)
-    {
-      m_iDataSize += packet->iSize;
-      if (packet->dts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->dts;
-      else if (packet->pts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->pts;
-
-      if (m_TimeBack == DVD_NOPTS_VALUE)
-        m_TimeBack = m_TimeFront;
-    }
-  }
+    AddPacket(((CDVDMsgDemuxerPacket*)pMsg)->GetPacket());
 
   pMsg->Release();
 
@@ -172,23 +197,25 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
   {
     std::list<DVDMessageListItem> &msgs = (priority > 0 || !m_prioMessages.empty()) ? m_prioMessages : m_messages;
 
-    if (!msgs.empty() && (msgs.back().priority >= priority || m_drain))
+    // the list has to be looked at before the ring, anything the producer
+    // put to the ring before a list message is visible by then
+    int64_t ringSequence;
+    if (&msgs == &m_messages && PeekRing(ringSequence) &&
+        (msgs.empty() || ringSequence < msgs.back().sequence))
+    {
+      priority = 0;
+      *pMsg = PopRing();
+
+      ret = MSGQ_OK;
+      break;
+    }
+    else if (!msgs.empty() && (msgs.back().priority >= priority || m_drain))
     {
       DVDMessageListItem& item(msgs.back());
       priority = item.priority;
 
       if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
-      {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
-        if (packet)
-        {
-          m_iDataSize -= packet->iSize;
-          if (packet->dts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->dts;
-          else if (packet->pts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->pts;
-        }
-      }
+        RemovePacket(((CDVDMsgDemuxerPacket*)item.message)->GetPacket());
 
       *pMsg = item.message->Acquire();
       msgs.pop_back();
@@ -204,10 +231,21 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     else
     {
       m_hEvent.Reset();
+      m_consumerWaiting = true;
+
+      // the producer might have filled the ring before it saw us waiting
+      if (priority <= 0 && m_prioMessages.empty() && PeekRing(ringSequence))
+      {
+        m_consumerWaiting = false;
+        continue;
+      }
+
       lock.Leave();
 
       // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
+      bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
+      m_consumerWaiting = false;
+      if (!signaled)
         return MSGQ_TIMEOUT;
 
       lock.Enter();
@@ -239,6 +277,9 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
       count++;
   }
 
+  if (type == CDVDMsg::DEMUXER_PACKET)
+    count += m_ringHead - m_ringTail;
+
   return count;
 }
 
@@ -265,18 +306,19 @@ int CDVDMessageQueue::GetLevel() const
 {
   CSingleLock lock(m_section);
 
-  if (m_iDataSize > m_iMaxDataSize)
+  int dataSize = m_iDataSize;
+  if (dataSize > m_iMaxDataSize)
     return 100;
-  if (m_iDataSize == 0)
+  if (dataSize == 0)
     return 0;
 
   if (IsDataBased())
-    return std::min(100, 100 * m_iDataSize / m_iMaxDataSize);
+    return std::min(100, 100 * dataSize / m_iMaxDataSize);
 
   int level = std::min(100.0, ceil(100.0 * m_TimeSize * (m_TimeFront - m_TimeBack) / DVD_TIME_BASE ));
 
   // if we added lots of packets with NOPTS, make sure that the queue is not signalled empty
-  if (level == 0 && m_iDataSize != 0)
+  if (level == 0 && dataSize != 0)
   {
     CLog::Log(LOGDEBUG, "CDVDMessageQueue::GetLevel() - can't determine level");
     return 1;
@@ -297,7 +339,118 @@ int CDVDMessageQueue::GetTimeSize() const
 
 bool CDVDMessageQueue::IsDataBased() const
 {
-  return (m_TimeBack == DVD_NOPTS_VALUE  ||
-          m_TimeFront == DVD_NOPTS_VALUE ||
-          m_TimeFront <= m_TimeBack);
+  double timeBack = m_TimeBack;
+  double timeFront = m_TimeFront;
+  return (timeBack == DVD_NOPTS_VALUE  ||
+          timeFront == DVD_NOPTS_VALUE ||
+          timeFront <= timeBack);
+}
+
+bool CDVDMessageQueue::PutRing(CDVDMsg* pMsg)
+{
+  if (m_ring.empty())
+    return false;
+
+  // only a single thread may feed the ring, everybody else takes the lock
+  std::thread::id self = std::this_thread::get_id();
+  std::thread::id producer = m_ringProducer;
+  if (producer != self)
+  {
+    if (producer != std::thread::id() ||
+        !m_ringProducer.compare_exchange_strong(producer, self))
+      return false;
+  }
+
+  // Flush() and End() wait for puts in flight, see CloseRing()
+  m_ringPutting = true;
+  if (m_ringClosed || !m_bInitialized)
+  {
+    m_ringPutting = false;
+    return false;
+  }
+
+  size_t head = m_ringHead.load(std::memory_order_relaxed);
+  if (head - m_ringTail.load(std::memory_order_acquire) > m_ringMask)
+  {
+    m_ringPutting = false;
+    return false;
+  }
+
+  AddPacket(((CDVDMsgDemuxerPacket*)pMsg)->GetPacket());
+
+  SRingItem& item = m_ring[head & m_ringMask];
+  item.message = pMsg;   // takes over the reference of the caller
+  item.sequence = ++m_sequence;
+  m_ringHead.store(head + 1);
+  m_ringPutting = false;
+
+  // inform waiter for new packet
+  if (m_consumerWaiting)
+    m_hEvent.Set();
+
+  return true;
+}
+
+void CDVDMessageQueue::CloseRing()
+{
+  // the producer either sees the ring closed or is waited for here
+  m_ringClosed = true;
+  while (m_ringPutting)
+    std::this_thread::yield();
+}
+
+bool CDVDMessageQueue::PeekRing(int64_t &sequence) const
+{
+  size_t tail = m_ringTail.load(std::memory_order_relaxed);
+  if (tail == m_ringHead.load())
+    return false;
+
+  sequence = m_ring[tail & m_ringMask].sequence;
+  return true;
+}
+
+CDVDMsg* CDVDMessageQueue::PopRing()
+{
+  size_t tail = m_ringTail.load(std::memory_order_relaxed);
+  SRingItem& item = m_ring[tail & m_ringMask];
+  CDVDMsg* pMsg = item.message;
+  item.message = nullptr;
+  m_ringTail.store(tail + 1, std::memory_order_release);
+
+  RemovePacket(((CDVDMsgDemuxerPacket*)pMsg)->GetPacket());
+  return pMsg;
+}
+
+void CDVDMessageQueue::ClearRing()
+{
+  int64_t sequence;
+  while (PeekRing(sequence))
+    PopRing()->Release();
+}
+
+void CDVDMessageQueue::AddPacket(DemuxPacket* packet)
+{
+  if (!packet)
+    return;
+
+  m_iDataSize += packet->iSize;
+  if (packet->dts != DVD_NOPTS_VALUE)
+    m_TimeFront = packet->dts;
+  else if (packet->pts != DVD_NOPTS_VALUE)
+    m_TimeFront = packet->pts;
+
+  double timeBack = DVD_NOPTS_VALUE;
+  m_TimeBack.compare_exchange_strong(timeBack, m_TimeFront);
+}
+
+void CDVDMessageQueue::RemovePacket(DemuxPacket* packet)
+{
+  if (!packet)
+    return;
+
+  m_iDataSize -= packet->iSize;
+  if (packet->dts != DVD_NOPTS_VALUE)
+    m_TimeBack = packet->dts;
+  else if (packet->pts != DVD_NOPTS_VALUE)
+    m_TimeBack = packet->pts;
 }
@@ -25,20 +25,24 @@
 #include <string>
 #include <list>
 #include <algorithm>
+#include <thread>
+#include <vector>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
 struct DVDMessageListItem
 {
-  DVDMessageListItem(CDVDMsg* msg, int prio)
+  DVDMessageListItem(CDVDMsg* msg, int prio, int64_t seq = 0)
   {
     message = msg->Acquire();
     priority = prio;
+    sequence = seq;
   }
   DVDMessageListItem()
   {
     message = NULL;
     priority = 0;
+    sequence = 0;
   }
   DVDMessageListItem(const DVDMessageListItem&) = delete;
  ~DVDMessageListItem()
@@ -51,6 +55,7 @@ struct DVDMessageListItem
 
   CDVDMsg* message;
   int priority;
+  int64_t sequence;
 };
 
 enum MsgQueueReturnCode
@@ -71,6 +76,13 @@ public:
   CDVDMessageQueue(const std::string &owner);
   virtual ~CDVDMessageQueue();
 
+  /**
+   * Route demuxer packets put by a single producer thread through a bounded
+   * lock free ring instead of the locked message list. Must be called before Init().
+   * size, number of packets the ring can hold, rounded up to a power of two
+   */
+  void EnablePacketRing(unsigned int size);
+
   void Init();
   void Flush(CDVDMsg::Message message = CDVDMsg::DEMUXER_PACKET);
   void Abort();
@@ -109,16 +121,30 @@ public:
 
 private:
 
+  struct SRingItem
+  {
+    CDVDMsg* message;
+    int64_t sequence;
+  };
+
+  bool PutRing(CDVDMsg* pMsg);
+  void CloseRing();
+  bool PeekRing(int64_t &sequence) const;
+  CDVDMsg* PopRing();
+  void ClearRing();
+  void AddPacket(DemuxPacket* packet);
+  void RemovePacket(DemuxPacket* packet);
+
   CEvent m_hEvent;
   mutable CCriticalSection m_section;
 
   std::atomic<bool> m_bAbortRequest;
-  bool m_bInitialized;
+  std::atomic<bool> m_bInitialized;
   bool m_drain;
 
-  int m_iDataSize;
-  double m_TimeFront;
-  double m_TimeBack;
+  std::atomic<int> m_iDataSize;
+  std::atomic<double> m_TimeFront;
+  std::atomic<double> m_TimeBack;
   double m_TimeSize;
 
   int m_iMaxDataSize;
@@ -126,5 +152,21 @@ private:
 
   std::list<DVDMessageListItem> m_messages;
   std::list<DVDMessageListItem> m_prioMessages;
+
+  // priority 0 messages are ordered by sequence across list and ring,
+  // messages put to the front get negative numbers
+  std::atomic<int64_t> m_sequence;
+  int64_t m_frontSequence;
+
+  // single producer / single consumer packet ring, the consumer side
+  // is serialized by m_section
+  std::vector<SRingItem> m_ring;
+  size_t m_ringMask;
+  std::atomic<size_t> m_ringHead;
+  std::atomic<size_t> m_ringTail;
+  std::atomic<std::thread::id> m_ringProducer;
+  std::atomic<bool> m_ringPutting;
+  std::atomic<bool> m_ringClosed;
+  std::atomic<bool> m_consumerWaiting;
 };
 
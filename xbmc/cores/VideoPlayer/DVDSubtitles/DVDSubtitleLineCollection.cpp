@@ -19,16 +19,21 @@
  */
 
 #include "DVDSubtitleLineCollection.h"
-#include <stddef.h>
 
+#include <algorithm>
 
-CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
+static bool CompareStartTime(const CDVDOverlay* left, const CDVDOverlay* right)
 {
-  m_pHead = NULL;
-  m_pCurrent = NULL;
-  m_pTail = NULL;
+  return left->iPTSStartTime < right->iPTSStartTime;
+}
 
-  m_iSize = 0;
+CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
+{
+  m_iActive = 0;
+  m_iCurrent = 0;
+  m_bSorted = true;
+  m_bIndexed = true;
+  m_bPositioned = false;
 }
 
 CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
@@ -38,85 +43,117 @@ CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
 
 void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay)
 {
-  ListElement* pElement = new ListElement;
-  pElement->pOverlay = pOverlay;
-  pElement->pNext = NULL;
+  if (!m_overlays.empty() && pOverlay->iPTSStartTime < m_overlays.back()->iPTSStartTime)
+    m_bSorted = false;
 
-  if (!m_pHead)
-  {
-    m_pHead = m_pTail = pElement;
-    m_pCurrent = m_pHead;
-  }
-  else
-  {
-    m_pTail->pNext = pElement;
-    m_pTail = pElement;
-  }
-
-  m_iSize++;
+  m_overlays.push_back(pOverlay);
+  m_bIndexed = false;
+  m_bPositioned = false;
 }
 
 void CDVDSubtitleLineCollection::Sort()
 {
-  if (!m_pHead || !m_pHead->pNext)
+  if (m_bIndexed)
     return;
-  
-  for (ListElement* p1 = m_pHead; p1->pNext != NULL; p1 = p1->pNext)
-  {
-    for (ListElement* p2 = p1->pNext; p2 != NULL; p2 = p2->pNext)
-    {
-      if (p1->pOverlay->iPTSStartTime > p2->pOverlay->iPTSStartTime)
-      {
-        CDVDOverlay* temp = p1->pOverlay;
-        p1->pOverlay = p2->pOverlay;
-        p2->pOverlay = temp;
-      }
-    }
-  }
+
+  if (!m_bSorted)
+    std::stable_sort(m_overlays.begin(), m_overlays.end(), CompareStartTime);
+
+  m_maxStopTime.resize(m_overlays.size());
+  if (!m_overlays.empty())
+    BuildIndex(0, m_overlays.size());
+
+  m_bSorted = true;
+  m_bIndexed = true;
 }
 
-CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
+double CDVDSubtitleLineCollection::BuildIndex(size_t first, size_t last)
 {
-  CDVDOverlay* pOverlay = NULL;
+  // the middle of a range is the root of its subtree
+  size_t middle = first + (last - first) / 2;
+  double maxStopTime = m_overlays[middle]->iPTSStopTime;
 
-  if (m_pCurrent)
-  {
-    while (m_pCurrent && m_pCurrent->pOverlay->iPTSStopTime < iPts)
-    {
-      m_pCurrent = m_pCurrent->pNext;
-    }
-
-    if (m_pCurrent)
-    {
-      pOverlay = m_pCurrent->pOverlay;
-
-      // advance to the next overlay
-      m_pCurrent = m_pCurrent->pNext;
-    }
-  }
-  return pOverlay;
+  if (first < middle)
+    maxStopTime = std::max(maxStopTime, BuildIndex(first, middle));
+  if (middle + 1 < last)
+    maxStopTime = std::max(maxStopTime, BuildIndex(middle + 1, last));
+
+  m_maxStopTime[middle] = maxStopTime;
+  return maxStopTime;
 }
 
-void CDVDSubtitleLineCollection::Reset()
+void CDVDSubtitleLineCollection::FindActive(size_t first, size_t last, double iPts, VecOverlays &overlays)
 {
-  m_pCurrent = m_pHead;
+  if (first >= last)
+    return;
+
+  size_t middle = first + (last - first) / 2;
+  // everything in this subtree is over already
+  if (m_maxStopTime[middle] < iPts)
+    return;
+
+  FindActive(first, middle, iPts, overlays);
+
+  // everything right of the middle starts even later
+  CDVDOverlay* pOverlay = m_overlays[middle];
+  if (pOverlay->iPTSStartTime > iPts)
+    return;
+
+  if (pOverlay->iPTSStopTime >= iPts)
+    overlays.push_back(pOverlay);
+
+  FindActive(middle + 1, last, iPts, overlays);
 }
 
-void CDVDSubtitleLineCollection::Clear()
+void CDVDSubtitleLineCollection::GetActive(double iPts, VecOverlays &overlays)
 {
-  ListElement* pElement = NULL;
+  Sort();
+  FindActive(0, m_overlays.size(), iPts, overlays);
+}
 
-  while (m_pHead)
+CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
+{
+  if (!m_bPositioned)
   {
-    pElement = m_pHead;
-    m_pHead = pElement->pNext;
-
-    pElement->pOverlay->Release();
-    delete pElement;
+    m_active.clear();
+    GetActive(iPts, m_active);
+    m_iActive = 0;
+
+    // continue with the first overlay that isn't shown yet
+    VecOverlaysIter it = std::upper_bound(m_overlays.begin(), m_overlays.end(), iPts,
+                                          [](double pts, const CDVDOverlay* overlay) { return pts < overlay->iPTSStartTime; });
+    m_iCurrent = it - m_overlays.begin();
+    m_bPositioned = true;
   }
 
-  m_pTail    = NULL;
-  m_pHead    = NULL;
-  m_pCurrent = NULL;
-  m_iSize    = 0;
+  if (m_iActive < m_active.size())
+    return m_active[m_iActive++];
+
+  while (m_iCurrent < m_overlays.size() && m_overlays[m_iCurrent]->iPTSStopTime < iPts)
+    m_iCurrent++;
+
+  if (m_iCurrent < m_overlays.size())
+    return m_overlays[m_iCurrent++];
+
+  return NULL;
+}
+
+void CDVDSubtitleLineCollection::Reset()
+{
+  m_bPositioned = false;
+}
+
+void CDVDSubtitleLineCollection::Clear()
+{
+  for (VecOverlaysIter it = m_overlays.begin(); it != m_overlays.end(); ++it)
+    (*it)->Release();
+
+  m_overlays.clear();
+  m_maxStopTime.clear();
+  m_active.clear();
+  m_iActive = 0;
+  m_iCurrent = 0;
+  m_bSorted = true;
+  m_bIndexed = true;
+  m_bPositioned = false;
 }
@@ -22,39 +22,61 @@
 
 #include "../DVDCodecs/Overlay/DVDOverlay.h"
 
-typedef struct stListElement
-{
-  CDVDOverlay* pOverlay;
-  struct stListElement* pNext;
-
-} ListElement;
+#include <stddef.h>
+#include <vector>
 
+/*!
+ * \brief Time ordered collection of the overlays of a subtitle file.
+ *
+ * The overlays are kept in one array sorted by start time. Every element also
+ * stores the latest stop time of the elements below it in an implicit binary
+ * tree over the array, so the overlays shown at a pts are found in O(log n)
+ * even if cues overlap, and seeking doesn't have to rescan the file.
+ */
 class CDVDSubtitleLineCollection
 {
 public:
   CDVDSubtitleLineCollection();
   virtual ~CDVDSubtitleLineCollection();
 
-  //void Lock()   { EnterCriticalSection(&m_critSection); }
-  //void Unlock() { LeaveCriticalSection(&m_critSection); }
-
+  /*!
+   * \brief Add an overlay, the collection takes over the reference
+   *
+   * Overlays should be added in the order of the file, the collection is only
+   * sorted if they are not ordered by start time.
+   */
   void Add(CDVDOverlay* pSubtitle);
   void Sort();
 
-  CDVDOverlay* Get(double iPts = 0LL); // get the first overlay in this fifo
+  /*!
+   * \brief Get the next overlay which is not over yet at the given pts
+   *
+   * After Reset() the first calls return the overlays shown at iPts, the
+   * following ones the overlays starting later, in the order of their start
+   * time. The collection keeps the reference of the returned overlay.
+   */
+  CDVDOverlay* Get(double iPts = 0LL);
+
+  /*!
+   * \brief Get all overlays shown at the given pts, ordered by start time
+   */
+  void GetActive(double iPts, VecOverlays &overlays);
 
   void Reset();
 
-  void Remove();
   void Clear();
-  int GetSize() { return m_iSize; }
+  int GetSize() { return (int)m_overlays.size(); }
 
 private:
-  ListElement* m_pHead;
-  ListElement* m_pCurrent;
-  ListElement* m_pTail;
+  double BuildIndex(size_t first, size_t last);
+  void FindActive(size_t first, size_t last, double iPts, VecOverlays &overlays);
 
-  int m_iSize;
-  //CRITICAL_SECTION m_critSection;
+  VecOverlays m_overlays;
+  std::vector<double> m_maxStopTime; // latest stop time in the subtree of each element
+  VecOverlays m_active; // overlays shown at the pts of the first Get() after Reset()
+  size_t m_iActive;
+  size_t m_iCurrent;
+  bool m_bSorted;
+  bool m_bIndexed;
+  bool m_bPositioned;
 };
-
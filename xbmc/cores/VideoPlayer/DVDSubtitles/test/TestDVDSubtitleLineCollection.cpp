@@ -0,0 +1,128 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDSubtitles/DVDSubtitleLineCollection.h"
+#include "threads/SystemClock.h"
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+
+namespace
+{
+
+const int BENCHMARK_LINES = 10000;
+const int BENCHMARK_SEEKS = 10000;
+
+CDVDOverlay* CreateOverlay(double start, double stop)
+{
+  CDVDOverlay* pOverlay = new CDVDOverlay(DVDOVERLAY_TYPE_TEXT);
+  pOverlay->iPTSStartTime = start;
+  pOverlay->iPTSStopTime = stop;
+  return pOverlay;
+}
+
+std::vector<double> GetStartTimes(CDVDSubtitleLineCollection &collection, double pts)
+{
+  std::vector<double> startTimes;
+  collection.Reset();
+  for (CDVDOverlay* pOverlay = collection.Get(pts); pOverlay; pOverlay = collection.Get(pts))
+    startTimes.push_back(pOverlay->iPTSStartTime);
+  return startTimes;
+}
+
+}
+
+TEST(TestDVDSubtitleLineCollection, Sort)
+{
+  CDVDSubtitleLineCollection collection;
+  collection.Add(CreateOverlay(30, 40));
+  collection.Add(CreateOverlay(10, 20));
+  collection.Add(CreateOverlay(20, 30));
+  collection.Sort();
+
+  EXPECT_EQ(3, collection.GetSize());
+  EXPECT_EQ(std::vector<double>({ 10, 20, 30 }), GetStartTimes(collection, 0));
+}
+
+TEST(TestDVDSubtitleLineCollection, Overlapping)
+{
+  CDVDSubtitleLineCollection collection;
+  collection.Add(CreateOverlay(0, 100));
+  collection.Add(CreateOverlay(10, 20));
+  collection.Add(CreateOverlay(15, 50));
+  collection.Add(CreateOverlay(30, 40));
+  collection.Add(CreateOverlay(60, 70));
+
+  VecOverlays active;
+  collection.GetActive(35, active);
+  ASSERT_EQ(3U, active.size());
+  EXPECT_EQ(0, active[0]->iPTSStartTime);
+  EXPECT_EQ(15, active[1]->iPTSStartTime);
+  EXPECT_EQ(30, active[2]->iPTSStartTime);
+
+  active.clear();
+  collection.GetActive(55, active);
+  ASSERT_EQ(1U, active.size());
+  EXPECT_EQ(0, active[0]->iPTSStartTime);
+
+  // the shown overlays come first, then the ones starting later
+  EXPECT_EQ(std::vector<double>({ 0, 15, 30, 60 }), GetStartTimes(collection, 35));
+}
+
+TEST(TestDVDSubtitleLineCollection, Seek)
+{
+  CDVDSubtitleLineCollection collection;
+  for (int i = 0; i < 10; i++)
+    collection.Add(CreateOverlay(i * 10, i * 10 + 5));
+
+  EXPECT_EQ(std::vector<double>({ 80, 90 }), GetStartTimes(collection, 80));
+  EXPECT_EQ(std::vector<double>({ 30, 40, 50, 60, 70, 80, 90 }), GetStartTimes(collection, 27));
+
+  // without a reset the collection continues where it stopped
+  collection.Reset();
+  EXPECT_EQ(20, collection.Get(20)->iPTSStartTime);
+  EXPECT_EQ(50, collection.Get(46)->iPTSStartTime);
+
+  collection.Clear();
+  EXPECT_EQ(0, collection.GetSize());
+  EXPECT_TRUE(GetStartTimes(collection, 0).empty());
+}
+
+TEST(TestDVDSubtitleLineCollection, Seek_Benchmark)
+{
+  CDVDSubtitleLineCollection collection;
+  for (int i = 0; i < BENCHMARK_LINES; i++)
+    collection.Add(CreateOverlay(i * 1000, i * 1000 + 2500));
+
+  int found = 0;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < BENCHMARK_SEEKS; i++)
+  {
+    // seek backwards every time
+    collection.Reset();
+    if (collection.Get((BENCHMARK_SEEKS - i) * 1000.0 * BENCHMARK_LINES / BENCHMARK_SEEKS - 500))
+      found++;
+  }
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_SEEKS << " seeks in " << BENCHMARK_LINES << " lines: " << elapsed << " ms" << std::endl;
+  EXPECT_EQ(BENCHMARK_SEEKS, found);
+}
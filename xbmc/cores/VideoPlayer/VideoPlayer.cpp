@@ -29,6 +29,7 @@
 
 #include "DVDDemuxers/DVDDemux.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
+#include "DVDDemuxers/DemuxPacketPool.h"
 #include "DVDDemuxers/DVDDemuxVobsub.h"
 #include "DVDDemuxers/DVDFactoryDemuxer.h"
 #include "DVDDemuxers/DVDDemuxFFmpeg.h"
@@ -2455,6 +2456,9 @@ void CVideoPlayer::OnExit()
     SAFE_DELETE(m_pCCDemuxer);
     SAFE_DELETE(m_pInputStream);
 
+    // hand idle demux packets back to the heap
+    CDVDDemuxUtils::TrimDemuxPacketPool();
+
     // clean up all selection streams
     m_SelectionStreams.Clear(STREAM_NONE, STREAM_SOURCE_NONE);
 
@@ -4978,6 +4982,9 @@ void CVideoPlayer::UpdatePlayState(double timeout)
   else
     state.cache_bytes = 0;
 
+  CDemuxPacketPool::SStats poolStats = CDemuxPacketPool::GetInstance().GetStats();
+  CServiceBroker::GetDataCacheCore().SetDemuxPacketPoolStats(poolStats.hits, poolStats.misses, poolStats.peakBytes);
+
   state.timestamp = m_clock.GetAbsoluteClock();
 
   CSingleLock lock(m_StateSection);
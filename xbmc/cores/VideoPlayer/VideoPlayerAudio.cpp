@@ -77,6 +77,7 @@ CVideoPlayerAudio::CVideoPlayerAudio(CDVDClock* pClock, CDVDMessageQueue& parent
 
   m_messageQueue.SetMaxDataSize(6 * 1024 * 1024);
   m_messageQueue.SetMaxTimeSize(8.0);
+  m_messageQueue.EnablePacketRing(2048);
 }
 
 CVideoPlayerAudio::~CVideoPlayerAudio()
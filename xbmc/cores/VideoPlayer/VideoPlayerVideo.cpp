@@ -84,6 +84,7 @@ CVideoPlayerVideo::CVideoPlayerVideo(CDVDClock* pClock
   m_fForcedAspectRatio = 0;
   m_messageQueue.SetMaxDataSize(40 * 1024 * 1024);
   m_messageQueue.SetMaxTimeSize(8.0);
+  m_messageQueue.EnablePacketRing(2048);
 
   m_iDroppedFrames = 0;
   m_fFrameRate = 25;
@@ -83,6 +83,10 @@ public:
   virtual void ReleaseImage(int source, bool preserve = false) = 0;
   virtual void AddVideoPictureHW(DVDVideoPicture &picture, int index) {};
   virtual bool IsPictureHW(DVDVideoPicture &picture) { return false; };
+  /*! \brief Keep a reference to the decoded frame of a software picture instead of copying it
+   \return false if the picture has to be copied into the image of the buffer
+   */
+  virtual bool AddVideoPictureRef(DVDVideoPicture &picture, int index) { return false; };
   virtual void FlipPage(int source) = 0;
   virtual void PreInit() = 0;
   virtual void UnInit() = 0;
@@ -48,6 +48,7 @@
 #include "RenderFormats.h"
 #include "cores/IPlayer.h"
 #include "cores/VideoPlayer/DVDCodecs/DVDCodecUtils.h"
+#include "cores/VideoPlayer/DVDCodecs/Video/DVDVideoCodecFFmpeg.h"
 #include "cores/FFmpeg.h"
 
 extern "C" {
@@ -112,6 +113,7 @@ CLinuxRendererGL::YUVBUFFER::YUVBUFFER()
   memset(&pbo   , 0, sizeof(pbo));
   flipindex = 0;
   hwDec = NULL;
+  frameRef = NULL;
 }
 
 CLinuxRendererGL::YUVBUFFER::~YUVBUFFER()
@@ -354,7 +356,10 @@ int CLinuxRendererGL::GetImage(YV12Image *image, int source, bool readonly)
   if( readonly )
     im.flags |= IMAGE_FLAG_READING;
   else
+  {
     im.flags |= IMAGE_FLAG_WRITING;
+    SAFE_RELEASE(m_buffers[source].frameRef);
+  }
 
   // copy the image - should be operator of YV12Image
   for (int p=0;p<MAX_PLANES;p++)
@@ -386,6 +391,55 @@ void CLinuxRendererGL::ReleaseImage(int source, bool preserve)
   m_bImageReady = true;
 }
 
+bool CLinuxRendererGL::AddVideoPictureRef(DVDVideoPicture &picture, int index)
+{
+  if (m_format != RENDER_FMT_YUV420P   &&
+      m_format != RENDER_FMT_YUV420P10 &&
+      m_format != RENDER_FMT_YUV420P16 &&
+      m_format != RENDER_FMT_NV12)
+    return false;
+
+  YUVBUFFER &buf = m_buffers[index];
+
+  // the planes have to be the ones of the decoded frame, not post processed,
+  // and cover what the textures are configured for
+  if (picture.format != m_format ||
+      picture.data[0] != picture.frameRef->GetData(0) ||
+      picture.iWidth < buf.image.width ||
+      picture.iHeight < buf.image.height)
+    return false;
+
+  int planes = m_format == RENDER_FMT_NV12 ? 2 : 3;
+  for (int p = 0; p < planes; p++)
+  {
+    if (!picture.data[p] || picture.iLineSize[p] <= 0)
+      return false;
+  }
+
+  SAFE_RELEASE(buf.frameRef);
+  buf.frameRef = picture.frameRef->Acquire();
+  return true;
+}
+
+void CLinuxRendererGL::ReleaseBuffer(int idx)
+{
+  SAFE_RELEASE(m_buffers[idx].frameRef);
+}
+
+YV12Image* CLinuxRendererGL::GetUploadImage(YUVBUFFER& buf, YV12Image& frame, int planes)
+{
+  if (!buf.frameRef)
+    return &buf.image;
+
+  frame = buf.image;
+  for (int p = 0; p < planes; p++)
+  {
+    frame.plane[p]  = buf.frameRef->GetData(p);
+    frame.stride[p] = buf.frameRef->GetLineSize(p);
+  }
+  return &frame;
+}
+
 void CLinuxRendererGL::GetPlaneTextureSize(YUVPLANE& plane)
 {
   /* texture is assumed to be bound */
@@ -1639,6 +1693,8 @@ bool CLinuxRendererGL::CreateTexture(int index)
 
 void CLinuxRendererGL::DeleteTexture(int index)
 {
+  SAFE_RELEASE(m_buffers[index].frameRef);
+
   if (m_format == RENDER_FMT_NV12)
     DeleteNV12Texture(index);
   else if (m_format == RENDER_FMT_YUYV422 ||
@@ -1813,9 +1869,14 @@ bool CLinuxRendererGL::CreateYV12Texture(int index)
 bool CLinuxRendererGL::UploadYV12Texture(int source)
 {
   YUVBUFFER& buf    =  m_buffers[source];
-  YV12Image* im     = &buf.image;
   YUVFIELDS& fields =  buf.fields;
 
+  // a referenced frame is uploaded from the decoder's memory, not through the pbos
+  YV12Image  frame;
+  YV12Image* im     = GetUploadImage(buf, frame, 3);
+  GLuint     noPbo  = 0;
+  GLuint*    pbo    = buf.frameRef ? &noPbo : NULL;
+
   if (!(im->flags&IMAGE_FLAG_READY))
     return false;
   bool deinterlacing;
@@ -1834,47 +1895,47 @@ bool CLinuxRendererGL::UploadYV12Texture(int source)
     // Load Even Y Field
     LoadPlane( fields[FIELD_TOP][0] , GL_LUMINANCE, buf.flipindex
              , im->width, im->height >> 1
-             , im->stride[0]*2, im->bpp, im->plane[0] );
+             , im->stride[0]*2, im->bpp, im->plane[0], pbo );
 
     //load Odd Y Field
     LoadPlane( fields[FIELD_BOT][0], GL_LUMINANCE, buf.flipindex
              , im->width, im->height >> 1
-             , im->stride[0]*2, im->bpp, im->plane[0] + im->stride[0]) ;
+             , im->stride[0]*2, im->bpp, im->plane[0] + im->stride[0], pbo );
 
     // Load Even U & V Fields
     LoadPlane( fields[FIELD_TOP][1], GL_LUMINANCE, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[1]*2, im->bpp, im->plane[1] );
+             , im->stride[1]*2, im->bpp, im->plane[1], pbo );
 
     LoadPlane( fields[FIELD_TOP][2], GL_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[2]*2, im->bpp, im->plane[2] );
+             , im->stride[2]*2, im->bpp, im->plane[2], pbo );
 
     // Load Odd U & V Fields
     LoadPlane( fields[FIELD_BOT][1], GL_LUMINANCE, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[1]*2, im->bpp, im->plane[1] + im->stride[1] );
+             , im->stride[1]*2, im->bpp, im->plane[1] + im->stride[1], pbo );
 
     LoadPlane( fields[FIELD_BOT][2], GL_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[2]*2, im->bpp, im->plane[2] + im->stride[2] );
+             , im->stride[2]*2, im->bpp, im->plane[2] + im->stride[2], pbo );
   }
   else
   {
     //Load Y plane
     LoadPlane( fields[FIELD_FULL][0], GL_LUMINANCE, buf.flipindex
              , im->width, im->height
-             , im->stride[0], im->bpp, im->plane[0] );
+             , im->stride[0], im->bpp, im->plane[0], pbo );
 
     //load U plane
     LoadPlane( fields[FIELD_FULL][1], GL_LUMINANCE, buf.flipindex
              , im->width >> im->cshift_x, im->height >> im->cshift_y
-             , im->stride[1], im->bpp, im->plane[1] );
+             , im->stride[1], im->bpp, im->plane[1], pbo );
 
     //load V plane
     LoadPlane( fields[FIELD_FULL][2], GL_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> im->cshift_y
-             , im->stride[2], im->bpp, im->plane[2] );
+             , im->stride[2], im->bpp, im->plane[2], pbo );
   }
 
   VerifyGLState();
@@ -1938,9 +1999,14 @@ void CLinuxRendererGL::DeleteYV12Texture(int index)
 bool CLinuxRendererGL::UploadNV12Texture(int source)
 {
   YUVBUFFER& buf    =  m_buffers[source];
-  YV12Image* im     = &buf.image;
   YUVFIELDS& fields =  buf.fields;
 
+  // a referenced frame is uploaded from the decoder's memory, not through the pbos
+  YV12Image  frame;
+  YV12Image* im     = GetUploadImage(buf, frame, 2);
+  GLuint     noPbo  = 0;
+  GLuint*    pbo    = buf.frameRef ? &noPbo : NULL;
+
   if (!(im->flags & IMAGE_FLAG_READY))
     return false;
   bool deinterlacing;
@@ -1959,22 +2025,22 @@ bool CLinuxRendererGL::UploadNV12Texture(int source)
     // Load Odd Y field
     LoadPlane( fields[FIELD_TOP][0] , GL_LUMINANCE, buf.flipindex
              , im->width, im->height >> 1
-             , im->stride[0]*2, im->bpp, im->plane[0] );
+             , im->stride[0]*2, im->bpp, im->plane[0], pbo );
 
     // Load Even Y field
     LoadPlane( fields[FIELD_BOT][0], GL_LUMINANCE, buf.flipindex
              , im->width, im->height >> 1
-             , im->stride[0]*2, im->bpp, im->plane[0] + im->stride[0]) ;
+             , im->stride[0]*2, im->bpp, im->plane[0] + im->stride[0], pbo );
 
     // Load Odd UV Fields
     LoadPlane( fields[FIELD_TOP][1], GL_LUMINANCE_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[1]*2, im->bpp, im->plane[1] );
+             , im->stride[1]*2, im->bpp, im->plane[1], pbo );
 
     // Load Even UV Fields
     LoadPlane( fields[FIELD_BOT][1], GL_LUMINANCE_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[1]*2, im->bpp, im->plane[1] + im->stride[1] );
+             , im->stride[1]*2, im->bpp, im->plane[1] + im->stride[1], pbo );
 
   }
   else
@@ -1982,12 +2048,12 @@ bool CLinuxRendererGL::UploadNV12Texture(int source)
     // Load Y plane
     LoadPlane( fields[FIELD_FULL][0], GL_LUMINANCE, buf.flipindex
              , im->width, im->height
-             , im->stride[0], im->bpp, im->plane[0] );
+             , im->stride[0], im->bpp, im->plane[0], pbo );
 
     // Load UV plane
     LoadPlane( fields[FIELD_FULL][1], GL_LUMINANCE_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> im->cshift_y
-             , im->stride[1], im->bpp, im->plane[1] );
+             , im->stride[1], im->bpp, im->plane[1], pbo );
   }
 
   VerifyGLState();
@@ -41,6 +41,7 @@
 class CRenderCapture;
 
 class CBaseTexture;
+class CFFmpegRenderPicture;
 namespace Shaders { class BaseYUV2RGBShader; }
 namespace Shaders { class BaseVideoFilterShader; }
 
@@ -122,6 +123,8 @@ public:
   virtual bool IsConfigured() { return m_bConfigured; }
   virtual int GetImage(YV12Image *image, int source = AUTOSOURCE, bool readonly = false);
   virtual void ReleaseImage(int source, bool preserve = false);
+  virtual bool AddVideoPictureRef(DVDVideoPicture &picture, int index);
+  virtual void ReleaseBuffer(int idx);
   virtual void FlipPage(int source);
   virtual void PreInit();
   virtual void UnInit();
@@ -239,6 +242,7 @@ protected:
     GLuint    pbo[MAX_PLANES];
 
     void *hwDec;
+    CFFmpegRenderPicture *frameRef; /* decoded frame uploaded instead of image */
   };
 
   typedef YUVBUFFER          YUVBUFFERS[NUM_BUFFERS];
@@ -250,6 +254,7 @@ protected:
   void LoadPlane( YUVPLANE& plane, int type, unsigned flipindex
                 , unsigned width,  unsigned height
                 , int stride, int bpp, void* data, GLuint* pbo = NULL );
+  YV12Image* GetUploadImage(YUVBUFFER& buf, YV12Image& frame, int planes);
 
   void GetPlaneTextureSize(YUVPLANE& plane);
 
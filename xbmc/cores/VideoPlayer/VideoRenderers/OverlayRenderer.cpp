@@ -65,6 +65,13 @@ CRenderer::CRenderer()
 {
   m_font = "__subtitle__";
   m_fontBorder = "__subtitleborder__";
+
+  // these are read for every frame
+  m_subtitleAlign = CSettings::GetInstance().GetIntHandle(CSettings::SETTING_SUBTITLES_ALIGN);
+  m_subtitleFont = CSettings::GetInstance().GetStringHandle(CSettings::SETTING_SUBTITLES_FONT);
+  m_subtitleColor = CSettings::GetInstance().GetIntHandle(CSettings::SETTING_SUBTITLES_COLOR);
+  m_subtitleHeight = CSettings::GetInstance().GetIntHandle(CSettings::SETTING_SUBTITLES_HEIGHT);
+  m_subtitleStyle = CSettings::GetInstance().GetIntHandle(CSettings::SETTING_SUBTITLES_STYLE);
 }
 
 CRenderer::~CRenderer()
@@ -172,17 +179,17 @@ void CRenderer::Render(int idx)
 
   float total_height = 0.0f;
   float cur_height = 0.0f;
-  int subalign = CSettings::GetInstance().GetInt(CSettings::SETTING_SUBTITLES_ALIGN);
+  int subalign = m_subtitleAlign.Get();
   for (std::vector<COverlay*>::iterator it = render.begin(); it != render.end(); ++it)
   {
     COverlay* o = nullptr;
     COverlayText *text = dynamic_cast<COverlayText*>(*it);
     if (text)
     {
-      text->PrepareRender(CSettings::GetInstance().GetString(CSettings::SETTING_SUBTITLES_FONT),
-                          CSettings::GetInstance().GetInt(CSettings::SETTING_SUBTITLES_COLOR),
-                          CSettings::GetInstance().GetInt(CSettings::SETTING_SUBTITLES_HEIGHT),
-                          CSettings::GetInstance().GetInt(CSettings::SETTING_SUBTITLES_STYLE),
+      text->PrepareRender(m_subtitleFont.Get(),
+                          m_subtitleColor.Get(),
+                          m_subtitleHeight.Get(),
+                          m_subtitleStyle.Get(),
                           m_font, m_fontBorder);
       o = text;
     }
@@ -334,7 +341,7 @@ COverlay* CRenderer::Convert(CDVDOverlaySSA* o, double pts)
   int targetHeight = MathUtils::round_int(m_rv.Height());
   int useMargin;
 
-  int subalign = CSettings::GetInstance().GetInt(CSettings::SETTING_SUBTITLES_ALIGN);
+  int subalign = m_subtitleAlign.Get();
   if(subalign == SUBTITLE_ALIGN_BOTTOM_OUTSIDE
   || subalign == SUBTITLE_ALIGN_TOP_OUTSIDE
   ||(subalign == SUBTITLE_ALIGN_MANUAL && g_advancedSettings.m_videoAssFixedWorks))
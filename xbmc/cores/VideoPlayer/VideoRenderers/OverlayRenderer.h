@@ -23,6 +23,7 @@
 
 #include "threads/CriticalSection.h"
 #include "BaseRenderer.h"
+#include "settings/lib/SettingHandle.h"
 
 #include <vector>
 #include <map>
@@ -115,5 +116,10 @@ namespace OVERLAY {
     static unsigned int m_textureid;
     CRect m_rv, m_rs, m_rd;
     std::string m_font, m_fontBorder;
+    CSettingIntHandle m_subtitleAlign;
+    CSettingStringHandle m_subtitleFont;
+    CSettingIntHandle m_subtitleColor;
+    CSettingIntHandle m_subtitleHeight;
+    CSettingIntHandle m_subtitleStyle;
   };
 }
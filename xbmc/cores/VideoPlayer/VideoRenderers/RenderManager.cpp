@@ -1152,6 +1152,10 @@ int CRenderManager::AddVideoPicture(DVDVideoPicture& pic)
   {
     m_pRenderer->AddVideoPictureHW(pic, index);
   }
+  else if(pic.frameRef && m_pRenderer->AddVideoPictureRef(pic, index))
+  {
+    // the renderer uploads straight from the decoder's frame
+  }
   else if(pic.format == RENDER_FMT_YUV420P
        || pic.format == RENDER_FMT_YUV420P10
        || pic.format == RENDER_FMT_YUV420P16)
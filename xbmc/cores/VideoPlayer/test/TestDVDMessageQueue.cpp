@@ -0,0 +1,239 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDMessageQueue.h"
+#include "cores/VideoPlayer/DVDClock.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+const int PACKET_SIZE = 10;
+
+CDVDMsg* CreatePacket(int id)
+{
+  DemuxPacket* pPacket = CDVDDemuxUtils::AllocateDemuxPacket(PACKET_SIZE);
+  pPacket->iSize = PACKET_SIZE;
+  pPacket->dts = id * 1000.0;
+  pPacket->iStreamId = id;
+  return new CDVDMsgDemuxerPacket(pPacket);
+}
+
+int GetPacketId(CDVDMsg* pMsg)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return -1;
+  return ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket()->iStreamId;
+}
+
+class TestDVDMessageQueue : public testing::Test
+{
+protected:
+  TestDVDMessageQueue() :
+    m_queue("test")
+  {
+  }
+
+  void Init(unsigned int ringSize)
+  {
+    m_queue.EnablePacketRing(ringSize);
+    m_queue.Init();
+    m_queue.SetMaxDataSize(1000000);
+  }
+
+  CDVDMessageQueue m_queue;
+};
+
+}
+
+TEST_F(TestDVDMessageQueue, Order)
+{
+  Init(64);
+
+  for (int i = 0; i < 5; i++)
+    EXPECT_EQ(MSGQ_OK, m_queue.Put(CreatePacket(i)));
+  EXPECT_EQ(MSGQ_OK, m_queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESET)));
+  for (int i = 5; i < 10; i++)
+    EXPECT_EQ(MSGQ_OK, m_queue.Put(CreatePacket(i)));
+  EXPECT_EQ(MSGQ_OK, m_queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF), 1));
+
+  EXPECT_EQ(10U, m_queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(10 * PACKET_SIZE, m_queue.GetDataSize());
+
+  // priority messages overtake everything
+  CDVDMsg* pMsg;
+  int priority = 0;
+  ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 0, priority));
+  EXPECT_TRUE(pMsg->IsType(CDVDMsg::GENERAL_EOF));
+  EXPECT_EQ(1, priority);
+  pMsg->Release();
+
+  // packets from the ring and control messages from the list keep their order
+  for (int i = 0; i < 11; i++)
+  {
+    priority = 0;
+    ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 0, priority));
+    if (i == 5)
+      EXPECT_TRUE(pMsg->IsType(CDVDMsg::GENERAL_RESET));
+    else
+      EXPECT_EQ(i < 5 ? i : i - 1, GetPacketId(pMsg));
+
+    // a message put back is the next one to get
+    if (i == 2)
+    {
+      m_queue.Put(pMsg, 0, false);
+      ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 0, priority));
+      EXPECT_EQ(2, GetPacketId(pMsg));
+    }
+    pMsg->Release();
+  }
+
+  EXPECT_EQ(0, m_queue.GetDataSize());
+  EXPECT_EQ(MSGQ_TIMEOUT, m_queue.Get(&pMsg, 0));
+}
+
+TEST_F(TestDVDMessageQueue, Overflow)
+{
+  // packets which don't fit the ring go to the list
+  Init(4);
+
+  for (int i = 0; i < 20; i++)
+    EXPECT_EQ(MSGQ_OK, m_queue.Put(CreatePacket(i)));
+  EXPECT_EQ(20U, m_queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(20 * PACKET_SIZE, m_queue.GetDataSize());
+
+  CDVDMsg* pMsg;
+  for (int i = 0; i < 20; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 0));
+    EXPECT_EQ(i, GetPacketId(pMsg));
+    pMsg->Release();
+
+    // refill the ring while the list still holds older packets
+    if (i == 10)
+    {
+      for (int j = 20; j < 22; j++)
+        EXPECT_EQ(MSGQ_OK, m_queue.Put(CreatePacket(j)));
+    }
+  }
+  for (int i = 20; i < 22; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 0));
+    EXPECT_EQ(i, GetPacketId(pMsg));
+    pMsg->Release();
+  }
+  EXPECT_EQ(0, m_queue.GetDataSize());
+}
+
+TEST_F(TestDVDMessageQueue, Producer)
+{
+  const int packets = 100000;
+  Init(64);
+
+  std::thread producer([this, packets]()
+  {
+    for (int i = 0; i < packets; i++)
+      m_queue.Put(CreatePacket(i));
+  });
+
+  CDVDMsg* pMsg;
+  for (int i = 0; i < packets; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 5000));
+    EXPECT_EQ(i, GetPacketId(pMsg));
+    pMsg->Release();
+  }
+  producer.join();
+  EXPECT_EQ(0, m_queue.GetDataSize());
+}
+
+TEST_F(TestDVDMessageQueue, FlushWhileProducing)
+{
+  Init(64);
+
+  std::atomic<bool> stop(false);
+  std::thread producer([this, &stop]()
+  {
+    for (int i = 0; !stop; i++)
+      m_queue.Put(CreatePacket(i));
+  });
+
+  // the packets after a flush still arrive in order
+  CDVDMsg* pMsg;
+  int last = -1;
+  for (int i = 0; i < 10000; i++)
+  {
+    if (i % 100 == 0)
+    {
+      m_queue.Flush();
+      last = -1;
+    }
+    ASSERT_EQ(MSGQ_OK, m_queue.Get(&pMsg, 5000));
+    int id = GetPacketId(pMsg);
+    EXPECT_GT(id, last);
+    last = id;
+    pMsg->Release();
+  }
+
+  stop = true;
+  producer.join();
+
+  while (m_queue.Get(&pMsg, 0) == MSGQ_OK)
+    pMsg->Release();
+  EXPECT_EQ(0, m_queue.GetDataSize());
+  EXPECT_EQ(0U, m_queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+}
+
+TEST_F(TestDVDMessageQueue, EndWhileProducing)
+{
+  for (int round = 0; round < 1000; round++)
+  {
+    Init(64);
+
+    std::atomic<bool> ended(false);
+    std::atomic<int> putAfterEnd(0);
+    std::thread producer([this, &ended, &putAfterEnd]()
+    {
+      for (int i = 0; i < 1000; i++)
+      {
+        bool wasEnded = ended;
+        if (m_queue.Put(CreatePacket(i)) == MSGQ_OK && wasEnded)
+          putAfterEnd++;
+      }
+    });
+
+    std::this_thread::yield();
+    m_queue.End();
+    ended = true;
+    producer.join();
+
+    // nothing got into the queue once it was ended
+    EXPECT_EQ(0, putAfterEnd);
+    m_queue.Init();
+    EXPECT_EQ(0U, m_queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+    EXPECT_EQ(0, m_queue.GetDataSize());
+    m_queue.End();
+  }
+}
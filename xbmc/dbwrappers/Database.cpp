@@ -155,6 +155,8 @@ CDatabase::CDatabase(void)
   m_sqlite = true;
   m_bMultiWrite = false;
   m_multipleExecute = false;
+  m_batch = false;
+  m_savepoints = 0;
 }
 
 CDatabase::~CDatabase(void)
@@ -583,7 +585,15 @@ void CDatabase::BeginTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (m_batch)
+    {
+      if (NULL != m_pDS.get())
+      {
+        m_pDS->exec(PrepareSQL("SAVEPOINT batch%u", m_savepoints + 1));
+        m_savepoints++;
+      }
+    }
+    else if (NULL != m_pDB.get())
       m_pDB->start_transaction();
   }
   catch (...)
@@ -596,7 +606,15 @@ bool CDatabase::CommitTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (m_batch)
+    { // the changes are committed with the batch
+      if (m_savepoints > 0 && NULL != m_pDS.get())
+      {
+        m_pDS->exec(PrepareSQL("RELEASE SAVEPOINT batch%u", m_savepoints));
+        m_savepoints--;
+      }
+    }
+    else if (NULL != m_pDB.get())
       m_pDB->commit_transaction();
   }
   catch (...)
@@ -611,7 +629,16 @@ void CDatabase::RollbackTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (m_batch)
+    {
+      if (m_savepoints > 0 && NULL != m_pDS.get())
+      {
+        m_pDS->exec(PrepareSQL("ROLLBACK TO SAVEPOINT batch%u", m_savepoints));
+        m_pDS->exec(PrepareSQL("RELEASE SAVEPOINT batch%u", m_savepoints));
+        m_savepoints--;
+      }
+    }
+    else if (NULL != m_pDB.get())
       m_pDB->rollback_transaction();
   }
   catch (...)
@@ -626,6 +653,57 @@ bool CDatabase::InTransaction()
   return m_pDB->in_transaction();
 }
 
+void CDatabase::BeginBatch()
+{
+  if (m_batch)
+    return;
+
+  BeginTransaction();
+  m_batch = true;
+  m_savepoints = 0;
+}
+
+bool CDatabase::CommitBatch()
+{
+  if (!m_batch)
+    return false;
+
+  m_batch = false;
+  m_savepoints = 0;
+  return CommitTransaction();
+}
+
+void CDatabase::RollbackBatch()
+{
+  if (!m_batch)
+    return;
+
+  m_batch = false;
+  m_savepoints = 0;
+  RollbackTransaction();
+}
+
+void CDatabase::RollbackSavepoints(unsigned int savepoints)
+{
+  if (!m_batch || m_savepoints <= savepoints)
+    return;
+
+  try
+  {
+    // rolling back to a savepoint drops the ones opened after it as well
+    if (NULL != m_pDS.get())
+    {
+      m_pDS->exec(PrepareSQL("ROLLBACK TO SAVEPOINT batch%u", savepoints + 1));
+      m_pDS->exec(PrepareSQL("RELEASE SAVEPOINT batch%u", savepoints + 1));
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "database:rollbacksavepoints failed");
+  }
+  m_savepoints = savepoints;
+}
+
 bool CDatabase::CreateDatabase()
 {
   BeginTransaction();
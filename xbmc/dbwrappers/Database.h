@@ -86,6 +86,28 @@ public:
   virtual bool CommitTransaction();
   void RollbackTransaction();
   bool InTransaction();
+
+  /*!
+   * @brief Group all following transactions into one until CommitBatch() or RollbackBatch() is called.
+   *        Transactions started within the batch become savepoints, so rolling one of them back
+   *        keeps the changes of the others.
+   * @sa CommitBatch, RollbackBatch
+   */
+  void BeginBatch();
+  bool CommitBatch();
+  void RollbackBatch();
+  bool InBatch() const { return m_batch; }
+
+  /*!
+   * @brief Number of transactions currently open within the batch.
+   */
+  unsigned int GetSavepoints() const { return m_savepoints; }
+
+  /*!
+   * @brief Roll back all transactions of the batch opened after the given number of them was
+   *        open, e.g. when the code that opened them threw.
+   */
+  void RollbackSavepoints(unsigned int savepoints);
   void CopyDB(const std::string& latestDb);
   void DropAnalytics();
 
@@ -231,4 +253,7 @@ private:
 
   bool m_multipleExecute;
   std::vector<std::string> m_multipleQueries;
+
+  bool m_batch;                /*!< True if transactions are grouped into a batch */
+  unsigned int m_savepoints;   /*!< Number of open savepoints in the batch */
 };
@@ -49,6 +49,9 @@ Database::Database():
 {
   active = false;	// No connection yet
   compression = false;
+  statement_cache_size = 64;
+  statement_hits = 0;
+  statement_misses = 0;
 }
 
 Database::~Database() {
@@ -82,6 +85,148 @@ std::string Database::prepare(const char *format, ...)
   return result;
 }
 
+StatementPtr Database::get_statement(const std::string &sql)
+{
+  std::map<std::string, StatementList::iterator>::iterator it = statement_index.find(sql);
+  if (it != statement_index.end())
+  {
+    statement_hits++;
+    // move to the front of the list, it is the most recently used one now
+    statements.splice(statements.begin(), statements, it->second);
+    StatementPtr stmt = statements.front();
+    stmt->reset();
+    return stmt;
+  }
+
+  statement_misses++;
+  StatementPtr stmt = create_statement(sql);
+  if (statement_cache_size == 0)
+    return stmt;
+
+  statements.push_front(stmt);
+  statement_index[sql] = statements.begin();
+  while (statements.size() > statement_cache_size)
+  {
+    statement_index.erase(statements.back()->get_sql());
+    statements.pop_back();
+  }
+  return stmt;
+}
+
+void Database::set_statement_cache_size(unsigned int size)
+{
+  statement_cache_size = size;
+  while (statements.size() > statement_cache_size)
+  {
+    statement_index.erase(statements.back()->get_sql());
+    statements.pop_back();
+  }
+}
+
+StatementPtr Database::create_statement(const std::string &sql)
+{
+  return StatementPtr(new Statement(sql));
+}
+
+void Database::clear_statements()
+{
+  statement_index.clear();
+  statements.clear();
+}
+
+//************* Statement implementation ***************
+
+field_value& Statement::param(int pos)
+{
+  if (pos < 1)
+    throw DbErrors("Bad parameter index %i in statement: %s", pos, sql.c_str());
+  // unbound parameters are NULL, like in sqlite
+  while (params.size() < (size_t)pos)
+  {
+    params.push_back(field_value());
+    params.back().set_isNull();
+  }
+  return params[pos - 1];
+}
+
+void Statement::bind_null(int pos)
+{
+  field_value &value = param(pos);
+  value = field_value();
+  value.set_isNull();
+}
+
+void Statement::bind_int(int pos, int value)
+{
+  param(pos) = field_value(value);
+}
+
+void Statement::bind_int64(int pos, int64_t value)
+{
+  param(pos) = field_value(value);
+}
+
+void Statement::bind_double(int pos, double value)
+{
+  param(pos) = field_value(value);
+}
+
+void Statement::bind_string(int pos, const std::string &value)
+{
+  field_value str;
+  str.set_asString(value);
+  param(pos) = str;
+}
+
+void Statement::reset()
+{
+  params.clear();
+}
+
+std::string Statement::expand(Database &db) const
+{
+  std::string result;
+  result.reserve(sql.size());
+
+  size_t next = 0;
+  char quote = 0;
+  for (std::string::const_iterator c = sql.begin(); c != sql.end(); ++c)
+  {
+    if (quote)
+    {
+      if (*c == quote)
+        quote = 0;
+    }
+    else if (*c == '\'' || *c == '"')
+      quote = *c;
+    else if (*c == '?')
+    {
+      if (next >= params.size() || params[next].get_isNull())
+        result += "NULL";
+      else
+      {
+        const field_value &value = params[next];
+        switch (value.get_fType())
+        {
+        case ft_String:
+          result += db.prepare("'%s'", value.get_asString().c_str());
+          break;
+        case ft_Double:
+          result += db.prepare("%.17g", value.get_asDouble());
+          break;
+        default:
+          result += value.get_asString();
+          break;
+        }
+      }
+      next++;
+      continue;
+    }
+    result += *c;
+  }
+  return result;
+}
+
 //************* Dataset implementation ***************
 
 Dataset::Dataset():
@@ -94,6 +239,7 @@ Dataset::Dataset():
   fbof = feof = true;
   autocommit = true;
   fieldIndexMapID = ~0;
+  columnar = false;
 
   fields_object = new Fields();
 
@@ -112,6 +258,7 @@ Dataset::Dataset(Database *newDb):
   fbof = feof = true;
   autocommit = true;
   fieldIndexMapID = ~0;
+  columnar = false;
 
   fields_object = new Fields();
 
@@ -357,6 +504,24 @@ bool Dataset::get_index_map_entry(const char *f_name) {
 }
 /********* INDEXMAP SECTION END *********/
 
+int Dataset::get_field_index(const char *f_name) {
+  //Lets try to reuse a string ->index conversation
+  if (get_index_map_entry(f_name))
+    return static_cast<int>(fieldIndexMap_Entries[fieldIndexMapID].fieldIndex);
+
+  const char* name=strstr(f_name, ".");
+  if (name)
+    name++;
+
+  for (unsigned int i=0; i < fields_object->size(); i++) 
+    if (str_compare((*fields_object)[i].props.name.c_str(), f_name) == 0 || (name && str_compare((*fields_object)[i].props.name.c_str(), name) == 0)) {
+      fieldIndexMap_Entries[fieldIndexMapID].fieldIndex = i;
+      return i;
+    }
+
+  throw DbErrors("Field not found: %s",f_name);
+}
+
 const field_value Dataset::get_field_value(const char *f_name) {
   if (ds_state != dsInactive)
   {
@@ -368,22 +533,7 @@ const field_value Dataset::get_field_value(const char *f_name) {
       throw DbErrors("Field not found: %s",f_name);
     }
     else
-    {
-      //Lets try to reuse a string ->index conversation
-      if (get_index_map_entry(f_name))
-        return get_field_value(static_cast<int>(fieldIndexMap_Entries[fieldIndexMapID].fieldIndex));
-
-      const char* name=strstr(f_name, ".");
-      if (name)
-        name++;
-
-      for (unsigned int i=0; i < fields_object->size(); i++) 
-        if (str_compare((*fields_object)[i].props.name.c_str(), f_name) == 0 || (name && str_compare((*fields_object)[i].props.name.c_str(), name) == 0)) {
-          fieldIndexMap_Entries[fieldIndexMapID].fieldIndex = i;
-          return (*fields_object)[i].val;
-        }
-    }
-    throw DbErrors("Field not found: %s",f_name);
+      return get_field_value(get_field_index(f_name));
   }
   throw DbErrors("Dataset state is Inactive");
   //field_value fv;
@@ -402,11 +552,63 @@ const field_value Dataset::get_field_value(int index) {
       if (index < 0 || index >= field_count())
         throw DbErrors("Field index not found: %d",index);
 
+      if (columnar)
+      {
+        // same as an empty row of a result_set
+        if (frecno >= (int)columns.num_rows)
+          return field_value("");
+        return columns.get_field_value(frecno, index);
+      }
+
       return (*fields_object)[index].val;
   }
   throw DbErrors("Dataset state is Inactive");
 }
 
+void Dataset::check_column_field(int index) {
+  if (!columnar)
+    throw DbErrors("Dataset is not columnar");
+  if (ds_state != dsSelect)
+    throw DbErrors("Dataset state is not Select");
+  if (index < 0 || index >= (int)columns.columns.size())
+    throw DbErrors("Field index not found: %d",index);
+  if (frecno >= (int)columns.num_rows)
+    throw DbErrors("No current record");
+}
+
+string_view Dataset::get_string_view(int index) {
+  check_column_field(index);
+  return columns.get_string(frecno, index);
+}
+
+string_view Dataset::get_string_view(const char *f_name) {
+  return get_string_view(get_field_index(f_name));
+}
+
+int64_t Dataset::get_int64(int index) {
+  check_column_field(index);
+  return columns.get_int64(frecno, index);
+}
+
+int64_t Dataset::get_int64(const char *f_name) {
+  return get_int64(get_field_index(f_name));
+}
+
+double Dataset::get_double(int index) {
+  check_column_field(index);
+  return columns.get_double(frecno, index);
+}
+
+void Dataset::fill_column_fields() {
+  if (fields_object->size() == 0) // Filling columns name
+  {
+    const unsigned int ncols = columns.record_header.size();
+    fields_object->resize(ncols);
+    for (unsigned int i = 0; i < ncols; i++)
+      (*fields_object)[i].props = columns.record_header[i];
+  }
+}
+
 const sql_record* const Dataset::get_sql_record()
 {
   if (result.records.empty() || frecno >= (int)result.records.size())
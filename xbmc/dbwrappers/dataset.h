@@ -31,6 +31,7 @@
 #include <cstdio>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "qry_dat.h"
@@ -38,6 +39,7 @@
 
 namespace dbiplus {
 class Dataset;		// forward declaration of class Dataset
+class Database;		// forward declaration of class Database
 
 
 #define S_NO_CONNECTION "No active connection";
@@ -56,6 +58,49 @@ class Dataset;		// forward declaration of class Dataset
 #define DB_UNEXPECTED		7	// This shouldn't ever happen
 #define DB_UNEXPECTED_RESULT   -1       //For integer functions
 
+/******************* Class Statement definition *******************
+
+   SQL statement with ? placeholders for parameters, which are bound
+   by position starting with 1. Bind the parameters and run the
+   statement right away, the same statement may be handed out again
+   by the statement cache of the database afterwards.
+
+   This default implementation fills the bound values into the SQL
+   text, databases with support for compiled statements derive
+   from it.
+
+******************************************************************/
+class Statement {
+protected:
+  std::string sql;
+  std::vector<field_value> params;
+
+  field_value& param(int pos);
+
+public:
+/* constructor */
+  Statement(const std::string &newSql) : sql(newSql) {}
+/* destructor */
+  virtual ~Statement() {}
+
+  const std::string& get_sql() const { return sql; }
+
+/* typed binding of the parameters */
+  virtual void bind_null(int pos);
+  virtual void bind_int(int pos, int value);
+  virtual void bind_int64(int pos, int64_t value);
+  virtual void bind_double(int pos, double value);
+  virtual void bind_string(int pos, const std::string &value);
+/* forget all bound values */
+  virtual void reset();
+
+/* SQL text with the bound values filled in, strings escaped by db */
+  std::string expand(Database &db) const;
+};
+
+typedef std::shared_ptr<Statement> StatementPtr;
+
+
 /******************* Class Database definition ********************
 
    represents  connection with database server;
@@ -127,7 +172,7 @@ public:
                       const char *newLogin=NULL, const char *newPasswd=NULL,const char *newPort=NULL,
                       const char *newKey=NULL, const char *newCert=NULL, const char *newCA=NULL, 
                       const char *newCApath=NULL, const char *newCiphers=NULL, bool newCompression = false);
-  virtual void disconnect(void) { active = false; }
+  virtual void disconnect(void) { clear_statements(); active = false; }
   virtual int reset(void) { return DB_COMMAND_OK; }
   virtual int create(void) { return DB_COMMAND_OK; }
   virtual int drop(void) { return DB_COMMAND_OK; }
@@ -165,6 +210,35 @@ public:
 
   virtual bool in_transaction() {return false;};
 
+/* ---------------- prepared statements ----------------- */
+
+  /*! \brief Get a statement for the given SQL, with ? as placeholders for parameters.
+   Statements are cached per connection, the least recently used ones are dropped
+   once the cache is full.
+   \param sql - SQL statement, the values are bound to the statement instead of formatted into it.
+   \return the statement, throws DbErrors if it can't be prepared.
+   */
+  StatementPtr get_statement(const std::string &sql);
+
+  /*! \brief Set the number of statements kept in the statement cache, 0 disables it */
+  void set_statement_cache_size(unsigned int size);
+  unsigned int get_statement_cache_hits() const { return statement_hits; }
+  unsigned int get_statement_cache_misses() const { return statement_misses; }
+
+protected:
+/* creates a new statement, called for statements not in the cache */
+  virtual StatementPtr create_statement(const std::string &sql);
+/* drops all cached statements, has to be called before disconnecting */
+  void clear_statements();
+
+private:
+  typedef std::list<StatementPtr> StatementList;
+  StatementList statements;	// most recently used first
+  std::map<std::string, StatementList::iterator> statement_index;
+  unsigned int statement_cache_size;
+  unsigned int statement_hits;
+  unsigned int statement_misses;
+
 };
 
 
@@ -200,6 +274,8 @@ protected:
   /* query results*/
   result_set result;
   result_set exec_res;
+  column_set columns;		// query results in columnar mode
+  bool columnar;
   bool autorefresh;
   char* errmsg;
 
@@ -263,6 +339,9 @@ protected:
 /* Returns old field value (for :OLD) */
   virtual const field_value f_old(const char *f);
 
+/* Filling the fields information of a columnar result */
+  void fill_column_fields();
+
 public:
 
  virtual int str_compare(const char * s1, const char * s2);
@@ -308,6 +387,9 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &sql) = 0;
+/* runs a prepared statement with its bound parameters */
+  virtual bool query(Statement &stmt) { return query(stmt.expand(*db)); }
+  virtual int  exec(Statement &stmt) { return exec(stmt.expand(*db)); }
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -404,6 +486,22 @@ public:
   const result_set& get_result_set() { return result; }
   const sql_record* const get_sql_record();
 
+/* ------------- columnar results ----------------- */
+/* Store the results of the following queries column by column, with all
+   strings in one arena. Such results are not available as sql_record, only
+   through fv()/get_field_value() and the typed accessors below. */
+  void set_columnar(bool v) { columnar = v; }
+  bool get_columnar() { return columnar; }
+  const column_set& get_column_set() { return columns; }
+/* Typed access to a field of the current record of a columnar result.
+   Strings are not copied, they are valid until the dataset is closed.
+   Fields which do not hold a string give an empty string. */
+  string_view get_string_view(int index);
+  string_view get_string_view(const char *f_name);
+  int64_t get_int64(int index);
+  int64_t get_int64(const char *f_name);
+  double get_double(int index);
+
  private:
 
   unsigned int fieldIndexMapID;
@@ -456,6 +554,10 @@ public:
 
 /* Get the column index from a string field_value request */
   bool get_index_map_entry(const char *f_name);
+/* Get the column index of a field of the current result, throws if not found */
+  int get_field_index(const char *f_name);
+/* Check a columnar result has a current record and field index */
+  void check_column_field(int index);
 
   void set_ds_state(dsStates new_state) {ds_state = new_state;};	
  public:
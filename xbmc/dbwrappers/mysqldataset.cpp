@@ -1429,6 +1429,13 @@ void MysqlDataset::make_deletion() {
 }
 
 void MysqlDataset::fill_fields() {
+  if (columnar)
+  {
+    // values are read straight from the columns
+    fill_column_fields();
+    return;
+  }
+
   if ((db == NULL) || (result.record_header.empty()) || (result.records.size() < (unsigned int)frecno)) return;
 
   if (fields_object->size() == 0) // Filling columns name
@@ -1546,32 +1553,7 @@ const void* MysqlDataset::getExecRes() {
   return &exec_res;
 }
 
-bool MysqlDataset::query(const std::string &query) {
-  if(!handle()) throw DbErrors("No Database Connection");
-  std::string qry = query;
-  int fs = qry.find("select");
-  int fS = qry.find("SELECT");
-  if (!( fs >= 0 || fS >=0))
-    throw DbErrors("MUST be select SQL!");
-
-  close();
-
-  size_t loc;
-
-  // mysql doesn't understand CAST(foo as integer) => change to CAST(foo as signed integer)
-  while ((loc = ci_find(qry, "as integer)")) != std::string::npos)
-    qry = qry.insert(loc + 3, "signed ");
-
-  MYSQL_RES *stmt = NULL;
-
-  if ( static_cast<MysqlDatabase*>(db)->setErr(static_cast<MysqlDatabase*>(db)->query_with_reconnect(qry.c_str()), qry.c_str()) != MYSQL_OK )
-    throw DbErrors(db->getErrorMsg());
-
-  MYSQL* conn = handle();
-  stmt = mysql_store_result(conn);
-  if (stmt == NULL)
-    throw DbErrors("Missing result set!");
-
+void MysqlDataset::query_records(MYSQL_RES *stmt) {
   // column headers
   const unsigned int numColumns = mysql_num_fields(stmt);
   MYSQL_FIELD *fields = mysql_fetch_fields(stmt);
@@ -1638,6 +1620,93 @@ bool MysqlDataset::query(const std::string &query) {
     }
     result.records.push_back(res);
   }
+}
+
+void MysqlDataset::query_columns(MYSQL_RES *stmt) {
+  // column headers
+  const unsigned int numColumns = mysql_num_fields(stmt);
+  MYSQL_FIELD *fields = mysql_fetch_fields(stmt);
+  MYSQL_ROW row;
+  columns.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+    columns.record_header[i].name = fields[i].name;
+  columns.init_columns();
+
+  // returned rows, stored with the same types as in query_records()
+  while ((row = mysql_fetch_row(stmt)))
+  {
+    unsigned long *lengths = mysql_fetch_lengths(stmt);
+    for (unsigned int i = 0; i < numColumns; i++)
+    {
+      switch (fields[i].type)
+      {
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+          columns.add_int(i, row[i] != NULL ? atoi(row[i]) : 0);
+          break;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+          columns.add_double(i, row[i] != NULL ? atof(row[i]) : 0);
+          break;
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_VAR_STRING:
+        case MYSQL_TYPE_VARCHAR:
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_BLOB:
+          if (row[i] != NULL)
+            columns.add_string(i, row[i], strnlen(row[i], lengths[i]));
+          else
+            columns.add_string(i, "", 0);
+          break;
+        case MYSQL_TYPE_NULL:
+        default:
+          CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
+          columns.add_null(i, ft_String);
+          break;
+      }
+    }
+    columns.add_row();
+  }
+}
+
+bool MysqlDataset::query(const std::string &query) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  std::string qry = query;
+  int fs = qry.find("select");
+  int fS = qry.find("SELECT");
+  if (!( fs >= 0 || fS >=0))
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  size_t loc;
+
+  // mysql doesn't understand CAST(foo as integer) => change to CAST(foo as signed integer)
+  while ((loc = ci_find(qry, "as integer)")) != std::string::npos)
+    qry = qry.insert(loc + 3, "signed ");
+
+  MYSQL_RES *stmt = NULL;
+
+  if ( static_cast<MysqlDatabase*>(db)->setErr(static_cast<MysqlDatabase*>(db)->query_with_reconnect(qry.c_str()), qry.c_str()) != MYSQL_OK )
+    throw DbErrors(db->getErrorMsg());
+
+  MYSQL* conn = handle();
+  stmt = mysql_store_result(conn);
+  if (stmt == NULL)
+    throw DbErrors("Missing result set!");
+
+  if (columnar)
+    query_columns(stmt);
+  else
+    query_records(stmt);
+
   mysql_free_result(stmt);
   active = true;
   ds_state = dsSelect;
@@ -1664,6 +1733,7 @@ void MysqlDataset::open() {
 void MysqlDataset::close() {
   Dataset::close();
   result.clear();
+  columns.clear();
   edit_object->clear();
   fields_object->clear();
   ds_state = dsInactive;
@@ -1673,7 +1743,7 @@ void MysqlDataset::close() {
 void MysqlDataset::cancel() {
   if ((ds_state == dsInsert) || (ds_state==dsEdit))
   {
-    if (result.record_header.size())
+    if (result.record_header.size() || columns.record_header.size())
       ds_state = dsSelect;
     else
       ds_state = dsInactive;
@@ -1681,6 +1751,8 @@ void MysqlDataset::cancel() {
 }
 
 int MysqlDataset::num_rows() {
+  if (columnar)
+    return columns.num_rows;
   return result.records.size();
 }
 
@@ -127,6 +127,9 @@ protected:
   virtual void fill_fields();
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
+/* Store the rows of a query as records or column by column */
+  void query_records(MYSQL_RES *stmt);
+  void query_columns(MYSQL_RES *stmt);
 
 public:
 /* constructor */
@@ -35,6 +35,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef __GNUC__
 #pragma warning (disable:4800)
@@ -742,4 +743,162 @@ std::string field_value::gft() {
   return tmp;
   }
 
+//************* string_arena implementation ***************
+
+string_view string_arena::store(const char *s, size_t len)
+{
+  if (block_used + len + 1 > block_size)
+  {
+    // strings too big for a block get one of their own
+    size_t size = len + 1 > BLOCK_SIZE ? len + 1 : BLOCK_SIZE;
+    blocks.push_back(new char[size]);
+    block_used = 0;
+    block_size = size;
+    total_size += size;
+  }
+
+  char *data = blocks.back() + block_used;
+  if (len)
+    memcpy(data, s, len);
+  data[len] = '\0';
+  block_used += len + 1;
+  return string_view(data, len);
+}
+
+void string_arena::clear()
+{
+  for (unsigned int i = 0; i < blocks.size(); i++)
+    delete[] blocks[i];
+  blocks.clear();
+  block_used = block_size = total_size = 0;
+}
+
+//************* column_set implementation ***************
+
+void column_set::init_columns()
+{
+  columns.clear();
+  columns.resize(record_header.size());
+  num_rows = 0;
+}
+
+void column_set::add_null(unsigned int col, fType type)
+{
+  column_value v;
+  v.int64_value = 0;
+  v.str_len = 0;
+  v.type = type;
+  v.is_null = true;
+  columns[col].push_back(v);
+}
+
+void column_set::add_int(unsigned int col, int i)
+{
+  column_value v;
+  v.int64_value = 0;
+  v.int_value = i;
+  v.str_len = 0;
+  v.type = ft_Int;
+  v.is_null = false;
+  columns[col].push_back(v);
+}
+
+void column_set::add_int64(unsigned int col, int64_t i)
+{
+  column_value v;
+  v.int64_value = i;
+  v.str_len = 0;
+  v.type = ft_Int64;
+  v.is_null = false;
+  columns[col].push_back(v);
+}
+
+void column_set::add_double(unsigned int col, double d)
+{
+  column_value v;
+  v.double_value = d;
+  v.str_len = 0;
+  v.type = ft_Double;
+  v.is_null = false;
+  columns[col].push_back(v);
+}
+
+void column_set::add_string(unsigned int col, const char *s, size_t len)
+{
+  string_view str = strings.store(s, len);
+  column_value v;
+  v.str_value = str.data();
+  v.str_len = str.size();
+  v.type = ft_String;
+  v.is_null = false;
+  columns[col].push_back(v);
+}
+
+string_view column_set::get_string(unsigned int row, unsigned int col) const
+{
+  const column_value &v = columns[col][row];
+  if (v.type != ft_String || v.is_null)
+    return string_view();
+  return string_view(v.str_value, v.str_len);
+}
+
+int64_t column_set::get_int64(unsigned int row, unsigned int col) const
+{
+  const column_value &v = columns[col][row];
+  switch (v.type)
+  {
+    case ft_String:
+      return v.is_null ? 0 : _atoi64(v.str_value);
+    case ft_Int:
+      return (int64_t)v.int_value;
+    case ft_Double:
+      return (int64_t)v.double_value;
+    default:
+      return v.int64_value;
+  }
+}
+
+double column_set::get_double(unsigned int row, unsigned int col) const
+{
+  const column_value &v = columns[col][row];
+  switch (v.type)
+  {
+    case ft_String:
+      return v.is_null ? 0 : atof(v.str_value);
+    case ft_Int:
+      return (double)v.int_value;
+    case ft_Int64:
+      return (double)v.int64_value;
+    default:
+      return v.double_value;
+  }
+}
+
+field_value column_set::get_field_value(unsigned int row, unsigned int col) const
+{
+  const column_value &v = columns[col][row];
+  field_value fv;
+  switch (v.type)
+  {
+    case ft_String:
+      if (!v.is_null)
+        fv.set_asString(std::string(v.str_value, v.str_len));
+      else
+        fv.set_asString("");
+      break;
+    case ft_Int:
+      fv.set_asInt(v.int_value);
+      break;
+    case ft_Double:
+      fv.set_asDouble(v.double_value);
+      break;
+    default:
+      fv.set_asInt64(v.int64_value);
+      break;
+  }
+  if (v.is_null)
+    fv.set_isNull();
+  return fv;
+}
+
 } //namespace 
@@ -218,6 +218,114 @@ typedef sql_record::iterator rec_itor;
 typedef record_prop::iterator recprop_itor;
 typedef query_data::iterator qry_itor;
 
+/* Reference to string data owned by someone else, e.g. a columnar result set.
+   The data is zero terminated, but may contain zeros itself. */
+class string_view
+{
+public:
+  string_view() : str_data(""), str_size(0) {};
+  string_view(const char *data, size_t size) : str_data(data), str_size(size) {};
+
+  const char *data() const { return str_data; }
+  const char *c_str() const { return str_data; }
+  size_t size() const { return str_size; }
+  bool empty() const { return str_size == 0; }
+  std::string str() const { return std::string(str_data, str_size); }
+
+  bool operator== (const string_view &other) const
+    { return str_size == other.str_size && std::char_traits<char>::compare(str_data, other.str_data, str_size) == 0; }
+  bool operator!= (const string_view &other) const
+    { return !(*this == other); }
+  friend std::ostream& operator<< (std::ostream& os, const string_view &sv)
+    { return os.write(sv.str_data, sv.str_size); }
+
+private:
+  const char *str_data;
+  size_t str_size;
+};
+
+/* Copies strings into large blocks of memory which are released all at once */
+class string_arena
+{
+public:
+  string_arena() : block_used(0), block_size(0), total_size(0) {};
+  ~string_arena() { clear(); };
+
+/* copies len bytes of s and adds a terminating zero, the copy stays valid until clear() */
+  string_view store(const char *s, size_t len);
+  void clear();
+/* bytes allocated for all blocks */
+  size_t size() const { return total_size; }
+
+  static const size_t BLOCK_SIZE = 256 * 1024;
+
+private:
+  string_arena(const string_arena&);
+  string_arena& operator= (const string_arena&);
+
+  std::vector<char*> blocks;
+  size_t block_used;
+  size_t block_size;
+  size_t total_size;
+};
+
+/* Value of a single field in a columnar result set, strings are stored in
+   the arena of the result set */
+struct column_value
+{
+  union {
+    int     int_value;
+    int64_t int64_value;
+    double  double_value;
+    const char *str_value;
+  };
+  unsigned int str_len;
+  fType type; // ft_String, ft_Int, ft_Int64 or ft_Double
+  bool is_null;
+};
+
+typedef std::vector<column_value> column;
+
+/* Query results stored column by column. Unlike result_set no memory is
+   allocated per row or per field. */
+class column_set
+{
+public:
+  column_set() : num_rows(0) {};
+  ~column_set() { clear(); };
+  void clear()
+  {
+    columns.clear();
+    record_header.clear();
+    strings.clear();
+    num_rows = 0;
+  };
+
+/* sets up the columns for a new result, record_header has to be filled already */
+  void init_columns();
+
+  void add_null(unsigned int col, fType type);
+  void add_int(unsigned int col, int i);
+  void add_int64(unsigned int col, int64_t i);
+  void add_double(unsigned int col, double d);
+  void add_string(unsigned int col, const char *s, size_t len);
+/* to be called after all fields of a row were added */
+  void add_row() { num_rows++; }
+
+  string_view get_string(unsigned int row, unsigned int col) const;
+  int64_t get_int64(unsigned int row, unsigned int col) const;
+  double get_double(unsigned int row, unsigned int col) const;
+  bool get_isNull(unsigned int row, unsigned int col) const
+    { return columns[col][row].is_null; }
+/* copy of the value as stored in a result_set */
+  field_value get_field_value(unsigned int row, unsigned int col) const;
+
+  record_prop record_header;
+  std::vector<column> columns;
+  string_arena strings;
+  unsigned int num_rows;
+};
+
 class result_set
 {
 public:
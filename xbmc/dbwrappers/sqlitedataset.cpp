@@ -281,10 +281,67 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
-  sqlite3_close(conn);
+  clear_statements();
+  // statements still held by a caller are finalized later, close_v2 waits for them
+  sqlite3_close_v2(conn);
   active = false;
 }
 
+StatementPtr SqliteDatabase::create_statement(const std::string &sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  sqlite3_stmt *stmt = NULL;
+  if (setErr(sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, NULL), sql.c_str()) != SQLITE_OK)
+    throw DbErrors(getErrorMsg());
+
+  return StatementPtr(new SqliteStatement(this, sql, stmt));
+}
+
+
+//************* SqliteStatement implementation ***************
+
+SqliteStatement::SqliteStatement(SqliteDatabase *newDb, const std::string &newSql, sqlite3_stmt *newStmt) :
+  Statement(newSql),
+  db(newDb),
+  stmt(newStmt)
+{
+}
+
+SqliteStatement::~SqliteStatement() {
+  sqlite3_finalize(stmt);
+}
+
+void SqliteStatement::check(int err_code) {
+  if (db->setErr(err_code, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+void SqliteStatement::bind_null(int pos) {
+  check(sqlite3_bind_null(stmt, pos));
+}
+
+void SqliteStatement::bind_int(int pos, int value) {
+  check(sqlite3_bind_int(stmt, pos, value));
+}
+
+void SqliteStatement::bind_int64(int pos, int64_t value) {
+  check(sqlite3_bind_int64(stmt, pos, value));
+}
+
+void SqliteStatement::bind_double(int pos, double value) {
+  check(sqlite3_bind_double(stmt, pos, value));
+}
+
+void SqliteStatement::bind_string(int pos, const std::string &value) {
+  check(sqlite3_bind_text(stmt, pos, value.c_str(), value.size(), SQLITE_TRANSIENT));
+}
+
+void SqliteStatement::reset() {
+  // the result of the last step was already reported by the dataset
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+}
+
 int SqliteDatabase::create() {
   return connect(true);
 }
@@ -558,6 +615,13 @@ void SqliteDataset::make_deletion() {
 
 void SqliteDataset::fill_fields() {
   //cout <<"rr "<<result.records.size()<<"|" << frecno <<"\n";
+  if (columnar)
+  {
+    // values are read straight from the columns
+    fill_column_fields();
+    return;
+  }
+
   if ((db == NULL) || (result.record_header.empty()) || (result.records.size() < (unsigned int)frecno)) return;
 
   if (fields_object->size() == 0) // Filling columns name
@@ -660,20 +724,7 @@ const void* SqliteDataset::getExecRes() {
 }
 
 
-bool SqliteDataset::query(const std::string &query) {
-    if(!handle()) throw DbErrors("No Database Connection");
-    std::string qry = query;
-    int fs = qry.find("select");
-    int fS = qry.find("SELECT");
-    if (!( fs >= 0 || fS >=0))                                 
-         throw DbErrors("MUST be select SQL!"); 
-
-  close();
-
-  sqlite3_stmt *stmt = NULL;
-  if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
-    throw DbErrors(db->getErrorMsg());
-
+void SqliteDataset::query_records(sqlite3_stmt *stmt) {
   // column headers
   const unsigned int numColumns = sqlite3_column_count(stmt);
   result.record_header.resize(numColumns);
@@ -711,6 +762,65 @@ bool SqliteDataset::query(const std::string &query) {
     }
     result.records.push_back(res);
   }
+}
+
+void SqliteDataset::query_columns(sqlite3_stmt *stmt) {
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  columns.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+    columns.record_header[i].name = sqlite3_column_name(stmt, i);
+  columns.init_columns();
+
+  // returned rows, stored with the same types as in query_records()
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    for (unsigned int i = 0; i < numColumns; i++)
+    {
+      switch (sqlite3_column_type(stmt, i))
+      {
+      case SQLITE_INTEGER:
+        columns.add_int64(i, sqlite3_column_int64(stmt, i));
+        break;
+      case SQLITE_FLOAT:
+        columns.add_double(i, sqlite3_column_double(stmt, i));
+        break;
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+      {
+        const char *text = (const char *)sqlite3_column_text(stmt, i);
+        columns.add_string(i, text, text ? strlen(text) : 0);
+        break;
+      }
+      case SQLITE_NULL:
+      default:
+        columns.add_null(i, ft_String);
+        break;
+      }
+    }
+    columns.add_row();
+  }
+}
+
+bool SqliteDataset::query(const std::string &query) {
+    if(!handle()) throw DbErrors("No Database Connection");
+    std::string qry = query;
+    int fs = qry.find("select");
+    int fS = qry.find("SELECT");
+    if (!( fs >= 0 || fS >=0))                                 
+         throw DbErrors("MUST be select SQL!"); 
+
+  close();
+
+  sqlite3_stmt *stmt = NULL;
+  if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  if (columnar)
+    query_columns(stmt);
+  else
+    query_records(stmt);
+
   if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
   {
     active = true;
@@ -724,6 +834,53 @@ bool SqliteDataset::query(const std::string &query) {
   }  
 }
 
+bool SqliteDataset::query(Statement &statement) {
+  SqliteStatement *sqliteStatement = dynamic_cast<SqliteStatement*>(&statement);
+  if (!sqliteStatement)
+    return Dataset::query(statement);
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  close();
+
+  sqlite3_stmt *stmt = sqliteStatement->getHandle();
+  if (columnar)
+    query_columns(stmt);
+  else
+    query_records(stmt);
+
+  // reset keeps the bindings, so the statement can be run again as it is
+  if (db->setErr(sqlite3_reset(stmt), statement.get_sql().c_str()) == SQLITE_OK)
+  {
+    active = true;
+    ds_state = dsSelect;
+    this->first();
+    return true;
+  }
+  else
+  {
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+int SqliteDataset::exec(Statement &statement) {
+  SqliteStatement *sqliteStatement = dynamic_cast<SqliteStatement*>(&statement);
+  if (!sqliteStatement)
+    return Dataset::exec(statement);
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  exec_res.clear();
+
+  sqlite3_stmt *stmt = sqliteStatement->getHandle();
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+    ;
+
+  int res;
+  if ((res = db->setErr(sqlite3_reset(stmt), statement.get_sql().c_str())) == SQLITE_OK)
+    return res;
+  else
+    throw DbErrors(db->getErrorMsg());
+}
+
 void SqliteDataset::open(const std::string &sql) {
   set_select_sql(sql);
   open();
@@ -742,6 +899,7 @@ void SqliteDataset::open() {
 void SqliteDataset::close() {
   Dataset::close();
   result.clear();
+  columns.clear();
   edit_object->clear();
   fields_object->clear();
   ds_state = dsInactive;
@@ -751,7 +909,7 @@ void SqliteDataset::close() {
 
 void SqliteDataset::cancel() {
   if ((ds_state == dsInsert) || (ds_state==dsEdit)) {
-    if (result.record_header.size())
+    if (result.record_header.size() || columns.record_header.size())
       ds_state = dsSelect;
     else
       ds_state = dsInactive;
@@ -760,6 +918,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (columnar)
+    return columns.num_rows;
   return result.records.size();
 }
 
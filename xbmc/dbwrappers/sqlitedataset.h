@@ -96,6 +96,41 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+protected:
+/* compiles the statement, keeps the sqlite3_stmt for later executions */
+  virtual StatementPtr create_statement(const std::string &sql);
+
+};
+
+
+
+/***************** Class SqliteStatement definition *****************
+
+       class 'SqliteStatement' binds parameters to a compiled
+       sqlite3_stmt, which is finalized with the statement
+
+******************************************************************/
+class SqliteStatement : public Statement {
+protected:
+  SqliteDatabase *db;
+  sqlite3_stmt *stmt;
+
+  void check(int err_code);
+
+public:
+/* constructor */
+  SqliteStatement(SqliteDatabase *newDb, const std::string &newSql, sqlite3_stmt *newStmt);
+/* destructor */
+  virtual ~SqliteStatement();
+
+  sqlite3_stmt *getHandle() { return stmt; }
+
+  virtual void bind_null(int pos) override;
+  virtual void bind_int(int pos, int value) override;
+  virtual void bind_int64(int pos, int64_t value) override;
+  virtual void bind_double(int pos, double value) override;
+  virtual void bind_string(int pos, const std::string &value) override;
+  virtual void reset() override;
 };
 
 
@@ -126,6 +161,9 @@ protected:
   virtual void fill_fields();
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
+/* Store the rows of a query as records or column by column */
+  void query_records(sqlite3_stmt *stmt);
+  void query_columns(sqlite3_stmt *stmt);
 
 public:
 /* constructor */
@@ -148,6 +186,9 @@ or insert() operations default = false) */
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &query);
+/* runs a prepared statement with its bound parameters */
+  virtual bool query(Statement &stmt);
+  virtual int  exec(Statement &stmt);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
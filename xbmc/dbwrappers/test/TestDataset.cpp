@@ -0,0 +1,321 @@
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SystemClock.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+using namespace dbiplus;
+
+namespace
+{
+
+const unsigned int BENCHMARK_ROWS = 200000;
+const unsigned int BENCHMARK_INSERTS = 50000;
+
+}
+
+class TestDataset : public testing::Test
+{
+protected:
+  TestDataset()
+  {
+    m_db.setHostName(CSpecialProtocol::TranslatePath("special://temp/").c_str());
+    m_db.setDatabase("TestDataset");
+    m_path = URIUtils::AddFileToFolder(m_db.getHostName(), m_db.getDatabase());
+    XFILE::CFile::Delete(m_path);
+  }
+
+  ~TestDataset()
+  {
+    m_db.disconnect();
+    XFILE::CFile::Delete(m_path);
+  }
+
+  // a song table with a view over it shaped like the one of the music
+  // database, strings are repeated a lot as they would be in a library
+  bool CreateSongs(unsigned int count)
+  {
+    if (m_db.connect(true) != DB_CONNECTION_OK)
+      return false;
+
+    std::unique_ptr<Dataset> ds(m_db.CreateDataset());
+    ds->exec("CREATE TABLE song (idSong INTEGER PRIMARY KEY, idAlbum INTEGER, strArtists TEXT, strGenres TEXT, "
+             "strTitle TEXT, iTrack INTEGER, iDuration INTEGER, iYear INTEGER, strFileName TEXT, "
+             "strMusicBrainzTrackID TEXT, iTimesPlayed INTEGER, lastplayed TEXT, rating FLOAT, "
+             "comment TEXT, strAlbum TEXT, strPath TEXT)");
+    ds->exec("CREATE VIEW songview AS SELECT * FROM song");
+    ds->exec(m_db.prepare(
+      "WITH RECURSIVE seq(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM seq LIMIT %u) "
+      "INSERT INTO song SELECT x, x / 12, 'Artist ' || (x %% 997), 'Genre ' || (x %% 31), "
+      "'Title of song number ' || x, x %% 12 + 1, 120 + x %% 300, 1950 + x %% 70, "
+      "'track' || x || '.flac', NULL, x %% 5, CASE WHEN x %% 5 = 0 THEN NULL ELSE '2016-10-01 12:00:00' END, "
+      "(x %% 50) / 10.0, CASE WHEN x %% 3 = 0 THEN 'comment' ELSE '' END, 'Album ' || (x / 12), "
+      "'/music/Artist ' || (x %% 997) || '/Album ' || (x / 12) || '/' FROM seq", count));
+    return true;
+  }
+
+  SqliteDatabase m_db;
+  std::string m_path;
+};
+
+TEST_F(TestDataset, ColumnarMatchesRecords)
+{
+  ASSERT_TRUE(CreateSongs(1000));
+
+  std::unique_ptr<Dataset> records(m_db.CreateDataset());
+  std::unique_ptr<Dataset> columns(m_db.CreateDataset());
+  columns->set_columnar(true);
+  ASSERT_TRUE(records->query("SELECT * FROM songview ORDER BY idSong"));
+  ASSERT_TRUE(columns->query("SELECT * FROM songview ORDER BY idSong"));
+  ASSERT_EQ(1000, records->num_rows());
+  ASSERT_EQ(records->num_rows(), columns->num_rows());
+  ASSERT_EQ(records->fieldCount(), columns->fieldCount());
+  EXPECT_TRUE(columns->get_sql_record() == NULL);
+
+  while (!records->eof())
+  {
+    ASSERT_FALSE(columns->eof());
+    for (int i = 0; i < records->fieldCount(); i++)
+    {
+      const field_value expected = records->fv(i);
+      const field_value value = columns->fv(i);
+      EXPECT_EQ(expected.get_fType(), value.get_fType());
+      EXPECT_EQ(expected.get_isNull(), value.get_isNull());
+      EXPECT_EQ(expected.get_asString(), value.get_asString());
+      EXPECT_EQ(expected.get_asInt64(), columns->get_int64(i));
+      if (expected.get_fType() == ft_String)
+        EXPECT_EQ(expected.get_asString(), columns->get_string_view(i).str());
+    }
+    EXPECT_EQ(records->fv("song.strTitle").get_asString(), columns->fv("song.strTitle").get_asString());
+    EXPECT_EQ(records->fv("strPath").get_asString(), columns->get_string_view("strPath").str());
+    EXPECT_EQ(records->fv("iTrack").get_asInt(), columns->get_int64("iTrack"));
+
+    records->next();
+    columns->next();
+  }
+  EXPECT_TRUE(columns->eof());
+
+  columns->seek(10);
+  EXPECT_EQ(11, columns->get_int64("idSong"));
+  EXPECT_GT(columns->get_column_set().strings.size(), (size_t)0);
+
+  columns->close();
+  EXPECT_EQ(0, columns->num_rows());
+  EXPECT_EQ((size_t)0, columns->get_column_set().strings.size());
+}
+
+TEST_F(TestDataset, ColumnarEmptyResult)
+{
+  ASSERT_TRUE(CreateSongs(10));
+
+  std::unique_ptr<Dataset> columns(m_db.CreateDataset());
+  columns->set_columnar(true);
+  ASSERT_TRUE(columns->query("SELECT * FROM songview WHERE idSong < 0"));
+  EXPECT_EQ(0, columns->num_rows());
+  EXPECT_TRUE(columns->eof());
+  EXPECT_EQ("", columns->fv("strTitle").get_asString());
+  EXPECT_THROW(columns->get_string_view("strTitle"), DbErrors);
+}
+
+TEST_F(TestDataset, BenchmarkSongview)
+{
+  ASSERT_TRUE(CreateSongs(BENCHMARK_ROWS));
+
+  int64_t checkRecords = 0;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  {
+    std::unique_ptr<Dataset> ds(m_db.CreateDataset());
+    ASSERT_TRUE(ds->query("SELECT * FROM songview"));
+    const query_data &data = ds->get_result_set().records;
+    for (query_data::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+      const sql_record &record = **it;
+      checkRecords += record.at(0).get_asInt();
+      checkRecords += record.at(4).get_asString().size();
+      checkRecords += record.at(15).get_asString().size();
+    }
+  }
+  unsigned int elapsedRecords = XbmcThreads::SystemClockMillis() - start;
+
+  int64_t checkColumns = 0;
+  size_t arenaBytes = 0;
+  start = XbmcThreads::SystemClockMillis();
+  {
+    std::unique_ptr<Dataset> ds(m_db.CreateDataset());
+    ds->set_columnar(true);
+    ASSERT_TRUE(ds->query("SELECT * FROM songview"));
+    while (!ds->eof())
+    {
+      checkColumns += ds->get_int64(0);
+      checkColumns += ds->get_string_view(4).size();
+      checkColumns += ds->get_string_view(15).size();
+      ds->next();
+    }
+    arenaBytes = ds->get_column_set().strings.size();
+  }
+  unsigned int elapsedColumns = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_ROWS << " songview rows, records: " << elapsedRecords << " ms, columnar: "
+            << elapsedColumns << " ms (" << arenaBytes / 1024 << " kB of strings)" << std::endl;
+  EXPECT_EQ(checkRecords, checkColumns);
+}
+
+TEST_F(TestDataset, StatementBindsParameters)
+{
+  ASSERT_TRUE(CreateSongs(100));
+
+  std::unique_ptr<Dataset> ds(m_db.CreateDataset());
+  StatementPtr insert = m_db.get_statement("INSERT INTO song (idSong, idAlbum, strTitle, lastplayed, rating) VALUES (?, ?, ?, ?, ?)");
+  insert->bind_int64(1, 1000);
+  insert->bind_int(2, 7);
+  insert->bind_string(3, "Don't stop 'til you get enough?");
+  insert->bind_null(4);
+  insert->bind_double(5, 4.5);
+  ds->exec(*insert);
+  EXPECT_EQ(1000, ds->lastinsertid());
+
+  StatementPtr select = m_db.get_statement("SELECT idAlbum, strTitle, lastplayed, rating FROM song WHERE idSong = ?");
+  select->bind_int(1, 1000);
+  ASSERT_TRUE(ds->query(*select));
+  ASSERT_EQ(1, ds->num_rows());
+  EXPECT_EQ(7, ds->fv("idAlbum").get_asInt());
+  EXPECT_EQ("Don't stop 'til you get enough?", ds->fv("strTitle").get_asString());
+  EXPECT_TRUE(ds->fv("lastplayed").get_isNull());
+  EXPECT_EQ(4.5, ds->fv("rating").get_asDouble());
+  ds->close();
+
+  // the cached statement is reset, running it again finds the next row
+  select = m_db.get_statement("SELECT idAlbum, strTitle, lastplayed, rating FROM song WHERE idSong = ?");
+  select->bind_int(1, 12);
+  ASSERT_TRUE(ds->query(*select));
+  ASSERT_EQ(1, ds->num_rows());
+  EXPECT_EQ("Title of song number 12", ds->fv("strTitle").get_asString());
+  EXPECT_EQ(1, ds->fv("idAlbum").get_asInt());
+
+  EXPECT_EQ(1u, m_db.get_statement_cache_hits());
+  EXPECT_EQ(2u, m_db.get_statement_cache_misses());
+
+  EXPECT_THROW(m_db.get_statement("SELECT nosuchcolumn FROM song"), DbErrors);
+}
+
+TEST_F(TestDataset, StatementCacheEvicts)
+{
+  ASSERT_TRUE(CreateSongs(10));
+
+  m_db.set_statement_cache_size(2);
+  StatementPtr first = m_db.get_statement("SELECT idSong FROM song WHERE iTrack = ?");
+  m_db.get_statement("SELECT idSong FROM song WHERE iYear = ?");
+  EXPECT_EQ(first, m_db.get_statement("SELECT idSong FROM song WHERE iTrack = ?"));
+  m_db.get_statement("SELECT idSong FROM song WHERE iDuration = ?");
+  EXPECT_EQ(1u, m_db.get_statement_cache_hits());
+  EXPECT_EQ(3u, m_db.get_statement_cache_misses());
+
+  // iYear was the least recently used one
+  EXPECT_EQ(first, m_db.get_statement("SELECT idSong FROM song WHERE iTrack = ?"));
+  EXPECT_EQ(2u, m_db.get_statement_cache_hits());
+  m_db.get_statement("SELECT idSong FROM song WHERE iYear = ?");
+  EXPECT_EQ(4u, m_db.get_statement_cache_misses());
+
+  // statements held outside of the cache survive the disconnect
+  m_db.disconnect();
+  first.reset();
+}
+
+TEST_F(TestDataset, StatementExpand)
+{
+  ASSERT_EQ(DB_CONNECTION_OK, m_db.connect(true));
+
+  Statement stmt("SELECT * FROM song WHERE strTitle = ? AND comment <> '?' AND iYear = ? AND rating > ? AND strGenres = ?");
+  stmt.bind_string(1, "It's");
+  stmt.bind_int(2, 1999);
+  stmt.bind_double(3, 2.5);
+  EXPECT_EQ("SELECT * FROM song WHERE strTitle = 'It''s' AND comment <> '?' AND iYear = 1999 AND rating > 2.5 AND strGenres = NULL",
+            stmt.expand(m_db));
+  stmt.reset();
+  stmt.bind_null(1);
+  EXPECT_EQ("SELECT * FROM song WHERE strTitle = NULL AND comment <> '?' AND iYear = NULL AND rating > NULL AND strGenres = NULL",
+            stmt.expand(m_db));
+}
+
+TEST_F(TestDataset, BenchmarkInsertSongs)
+{
+  ASSERT_TRUE(CreateSongs(0));
+
+  std::unique_ptr<Dataset> ds(m_db.CreateDataset());
+  ds->exec("CREATE INDEX idxSong3 ON song (idAlbum)");
+  m_db.start_transaction();
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 1; i <= BENCHMARK_INSERTS; i++)
+  {
+    ds->query(m_db.prepare("SELECT idSong FROM song WHERE idAlbum=%i AND strFileName='%s' AND strTitle='%s' AND iTrack=%i AND strMusicBrainzTrackID IS NULL",
+                           i / 12, "track.flac", "Title of song", i % 12));
+    ds->close();
+    ds->exec(m_db.prepare("INSERT INTO song (idSong, idAlbum, strArtists, strGenres, strTitle, iTrack, iDuration, iYear, strFileName, rating) "
+                          "VALUES (NULL, %i, '%s', '%s', '%s', %i, %i, %i, '%s', %.1f)",
+                          i / 12, "Artist", "Genre", "Title of song", i % 12, 240, 2016, "track.flac", 2.5));
+  }
+  m_db.commit_transaction();
+  unsigned int elapsedText = XbmcThreads::SystemClockMillis() - start;
+
+  ds->exec("DELETE FROM song");
+  m_db.start_transaction();
+  start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 1; i <= BENCHMARK_INSERTS; i++)
+  {
+    StatementPtr stmt = m_db.get_statement("SELECT idSong FROM song WHERE idAlbum=? AND strFileName=? AND strTitle=? AND iTrack=? AND strMusicBrainzTrackID IS NULL");
+    stmt->bind_int(1, i / 12);
+    stmt->bind_string(2, "track.flac");
+    stmt->bind_string(3, "Title of song");
+    stmt->bind_int(4, i % 12);
+    ds->query(*stmt);
+    ds->close();
+    stmt = m_db.get_statement("INSERT INTO song (idSong, idAlbum, strArtists, strGenres, strTitle, iTrack, iDuration, iYear, strFileName, rating) "
+                              "VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    stmt->bind_int(1, i / 12);
+    stmt->bind_string(2, "Artist");
+    stmt->bind_string(3, "Genre");
+    stmt->bind_string(4, "Title of song");
+    stmt->bind_int(5, i % 12);
+    stmt->bind_int(6, 240);
+    stmt->bind_int(7, 2016);
+    stmt->bind_string(8, "track.flac");
+    stmt->bind_double(9, 2.5);
+    ds->exec(*stmt);
+  }
+  m_db.commit_transaction();
+  unsigned int elapsedPrepared = XbmcThreads::SystemClockMillis() - start;
+
+  ASSERT_TRUE(ds->query("SELECT COUNT(*) FROM song"));
+  EXPECT_EQ((int)BENCHMARK_INSERTS, ds->fv(0).get_asInt());
+
+  std::cout << BENCHMARK_INSERTS << " songs, formatted SQL: " << elapsedText << " ms ("
+            << BENCHMARK_INSERTS * 1000ull / std::max(elapsedText, 1u) << " songs/s), prepared: "
+            << elapsedPrepared << " ms (" << BENCHMARK_INSERTS * 1000ull / std::max(elapsedPrepared, 1u) << " songs/s)" << std::endl;
+}
@@ -25,6 +25,8 @@
 #include "addons/kodi-addon-dev-kit/include/kodi/xbmc_epg_types.h"
 #include "EpgContainer.h"
 #include "EpgDatabase.h"
+#include "EpgSearchIndex.h"
+#include "EpgTimeIndex.h"
 #include "guilib/LocalizeStrings.h"
 #include "pvr/addons/PVRClients.h"
 #include "pvr/PVRManager.h"
@@ -47,6 +49,8 @@ CEpg::CEpg(int iEpgID, const std::string &strName /* = "" */, const std::string
     m_iEpgID(iEpgID),
     m_strName(strName),
     m_strScraperName(strScraperName),
+    m_timeIndex(NULL),
+    m_searchIndex(NULL),
     m_bUpdateLastScanTime(false)
 {
 }
@@ -60,6 +64,8 @@ CEpg::CEpg(const CPVRChannelPtr &channel, bool bLoadedFromDb /* = false */) :
     m_strName(channel->ChannelName()),
     m_strScraperName(channel->EPGScraper()),
     m_pvrChannel(channel),
+    m_timeIndex(NULL),
+    m_searchIndex(NULL),
     m_bUpdateLastScanTime(false)
 {
 }
@@ -70,6 +76,8 @@ CEpg::CEpg(void) :
     m_bLoaded(false),
     m_bUpdatePending(false),
     m_iEpgID(0),
+    m_timeIndex(NULL),
+    m_searchIndex(NULL),
     m_bUpdateLastScanTime(false)
 {
 }
@@ -93,7 +101,10 @@ CEpg &CEpg::operator =(const CEpg &right)
   m_pvrChannel        = right.m_pvrChannel;
 
   for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = right.m_tags.begin(); it != right.m_tags.end(); ++it)
-    m_tags.insert(make_pair(it->first, it->second));
+  {
+    if (m_tags.insert(make_pair(it->first, it->second)).second)
+      IndexTag(it->first, it->second, true);
+  }
 
   return *this;
 }
@@ -140,6 +151,10 @@ bool CEpg::HasValidEntries(void) const
 void CEpg::Clear(void)
 {
   CSingleLock lock(m_critSection);
+  if (m_timeIndex)
+    m_timeIndex->Erase(this);
+  if (m_searchIndex)
+    m_searchIndex->Erase(this);
   m_tags.clear();
 }
 
@@ -162,6 +177,7 @@ void CEpg::Cleanup(const CDateTime &Time)
 
       it->second->ClearTimer();
       it->second->ClearRecording();
+      UnindexTag(it->first, it->second);
       it = m_tags.erase(it);
     }
     else
@@ -185,9 +201,11 @@ CEpgInfoTagPtr CEpg::GetTagNow(bool bUpdateIfNeeded /* = true */) const
   {
     CEpgInfoTagPtr lastActiveTag;
 
-    /* one of the first items will always match if the list is sorted */
-    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+    /* the tags don't overlap, so only the last one that started can be active */
+    std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.upper_bound(CDateTime::GetUTCDateTime());
+    if (it != m_tags.begin())
     {
+      --it;
       if (it->second->IsActive())
       {
         m_nowActiveStart = it->first;
@@ -219,11 +237,10 @@ CEpgInfoTagPtr CEpg::GetTagNext() const
   else if (Size() > 0)
   {
     /* return the first event that is in the future */
-    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
-    {
-      if (it->second->IsUpcoming())
-        return it->second;
-    }
+    CSingleLock lock(m_critSection);
+    std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.upper_bound(CDateTime::GetUTCDateTime());
+    if (it != m_tags.end())
+      return it->second;
   }
 
   return CEpgInfoTagPtr();
@@ -261,9 +278,10 @@ CEpgInfoTagPtr CEpg::GetTagByBroadcastId(unsigned int iUniqueBroadcastId) const
 CEpgInfoTagPtr CEpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
 {
   CSingleLock lock(m_critSection);
-  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.lower_bound(beginTime);
+       it != m_tags.end() && it->first <= endTime; ++it)
   {
-    if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
+    if (it->second->EndAsUTC() <= endTime)
       return it->second;
   }
 
@@ -275,15 +293,12 @@ std::vector<CEpgInfoTagPtr> CEpg::GetTagsBetween(const CDateTime &beginTime, con
   std::vector<CEpgInfoTagPtr> epgTags;
 
   CSingleLock lock(m_critSection);
-  for (const auto &infoTag : m_tags)
+  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.lower_bound(beginTime); it != m_tags.end(); ++it)
   {
-    if (infoTag.second->StartAsUTC() >= beginTime)
-    {
-      if (infoTag.second->EndAsUTC() <= endTime)
-        epgTags.emplace_back(infoTag.second);
-      else
-        break; // done.
-    }
+    if (it->second->EndAsUTC() <= endTime)
+      epgTags.emplace_back(it->second);
+    else
+      break; // done.
   }
 
   return epgTags;
@@ -293,6 +308,7 @@ void CEpg::AddEntry(const CEpgInfoTag &tag)
 {
   CEpgInfoTagPtr newTag;
   CPVRChannelPtr channel;
+  bool bNewTag(false);
   {
     CSingleLock lock(m_critSection);
     std::map<CDateTime, CEpgInfoTagPtr>::iterator itr = m_tags.find(tag.StartAsUTC());
@@ -302,6 +318,7 @@ void CEpg::AddEntry(const CEpgInfoTag &tag)
     {
       newTag.reset(new CEpgInfoTag(this, m_pvrChannel, m_strName, m_pvrChannel ? m_pvrChannel->IconPath() : ""));
       m_tags.insert(make_pair(tag.StartAsUTC(), newTag));
+      bNewTag = true;
     }
 
     channel = m_pvrChannel;
@@ -310,6 +327,11 @@ void CEpg::AddEntry(const CEpgInfoTag &tag)
   if (newTag)
   {
     newTag->Update(tag);
+    {
+      /* the index needs the end time of the tag */
+      CSingleLock lock(m_critSection);
+      IndexTag(tag.StartAsUTC(), newTag, bNewTag);
+    }
     newTag->SetPVRChannel(channel);
     newTag->SetEpg(this);
     newTag->SetTimer(g_PVRTimers->GetTimerForEpgTag(newTag));
@@ -317,6 +339,57 @@ void CEpg::AddEntry(const CEpgInfoTag &tag)
   }
 }
 
+void CEpg::SetIndexes(CEpgTimeIndex *timeIndex, CEpgSearchIndex *searchIndex)
+{
+  CSingleLock lock(m_critSection);
+  if (m_timeIndex != timeIndex)
+  {
+    if (m_timeIndex)
+      m_timeIndex->Erase(this);
+
+    m_timeIndex = timeIndex;
+    if (m_timeIndex)
+    {
+      for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+        m_timeIndex->Insert(this, it->first, it->second);
+    }
+  }
+
+  if (m_searchIndex != searchIndex)
+  {
+    if (m_searchIndex)
+      m_searchIndex->Erase(this);
+
+    m_searchIndex = searchIndex;
+    if (m_searchIndex)
+    {
+      for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+        m_searchIndex->Insert(this, it->second);
+    }
+  }
+}
+
+void CEpg::IndexTag(const CDateTime &start, const CEpgInfoTagPtr &tag, bool bNewTag)
+{
+  if (m_timeIndex && bNewTag)
+    m_timeIndex->Insert(this, start, tag);
+  else if (m_timeIndex)
+    m_timeIndex->Update(start, tag);
+
+  if (m_searchIndex && bNewTag)
+    m_searchIndex->Insert(this, tag);
+  else if (m_searchIndex)
+    m_searchIndex->Update(tag);
+}
+
+void CEpg::UnindexTag(const CDateTime &start, const CEpgInfoTagPtr &tag)
+{
+  if (m_timeIndex)
+    m_timeIndex->Erase(start, tag);
+  if (m_searchIndex)
+    m_searchIndex->Erase(tag);
+}
+
 bool CEpg::Load(void)
 {
   bool bReturn(false);
@@ -440,6 +513,8 @@ bool CEpg::UpdateEntry(const CEpgInfoTagPtr &tag, bool bUpdateDatabase /* = fals
     infoTag->SetEpg(this);
     infoTag->SetPVRChannel(m_pvrChannel);
 
+    IndexTag(tag->StartAsUTC(), infoTag, bNewTag);
+
     if (bUpdateDatabase)
       m_changedTags.insert(std::make_pair(infoTag->UniqueBroadcastID(), infoTag));
   }
@@ -485,6 +560,7 @@ bool CEpg::UpdateEntry(const CEpgInfoTagPtr &tag, EPG_EVENT_STATE newState, bool
 
         it->second->ClearTimer();
         it->second->ClearRecording();
+        UnindexTag(it->first, it->second);
         m_tags.erase(it);
       }
       else
@@ -686,11 +762,13 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
 
       it->second->ClearTimer();
       it->second->ClearRecording();
+      UnindexTag(it->first, it->second);
       m_tags.erase(it++);
     }
     else if (previousTag->EndAsUTC() > currentTag->StartAsUTC())
     {
       previousTag->SetEndFromUTC(currentTag->StartAsUTC());
+      IndexTag(previousTag->StartAsUTC(), previousTag, false);
       if (bUpdateDb)
         m_changedTags.insert(make_pair(previousTag->UniqueBroadcastID(), previousTag));
 
@@ -38,11 +38,14 @@ namespace PVR
 namespace EPG
 {
   class CEpg;
+  class CEpgSearchIndex;
+  class CEpgTimeIndex;
   typedef std::shared_ptr<CEpg> CEpgPtr;
   typedef std::map<unsigned int, CEpgPtr> EPGMAP;
 
   class CEpg : public Observable
   {
+    friend class CEpgContainer;
     friend class CEpgDatabase;
 
   public:
@@ -311,6 +314,28 @@ namespace EPG
      */
     void AddEntry(const CEpgInfoTag &tag);
 
+    /*!
+     * @brief Keep the tags of this table in the given indexes from now on.
+     * @param timeIndex The time index or NULL to remove the tags from the current one.
+     * @param searchIndex The search index or NULL to remove the tags from the current one.
+     */
+    void SetIndexes(CEpgTimeIndex *timeIndex, CEpgSearchIndex *searchIndex);
+
+    /*!
+     * @brief Add a tag to the indexes or pick up its changes. Must be called with the lock held.
+     * @param start The start time the tag is known by.
+     * @param tag The tag.
+     * @param bNewTag True if the tag was just added to this table.
+     */
+    void IndexTag(const CDateTime &start, const CEpgInfoTagPtr &tag, bool bNewTag);
+
+    /*!
+     * @brief Remove a tag from the indexes. Must be called with the lock held.
+     * @param start The start time the tag is known by.
+     * @param tag The tag.
+     */
+    void UnindexTag(const CDateTime &start, const CEpgInfoTagPtr &tag);
+
     /*!
      * @brief Load all EPG entries from clients into a temporary table and update this table with the contents of that temporary table.
      * @param start Only get entries after this start time. Use 0 to get all entries before "end".
@@ -342,6 +367,8 @@ namespace EPG
     CDateTime                           m_lastScanTime;    /*!< the last time the EPG has been updated */
 
     PVR::CPVRChannelPtr                 m_pvrChannel;      /*!< the channel this EPG belongs to */
+    CEpgTimeIndex *                     m_timeIndex;       /*!< the index of the container this table is part of, NULL for temporary tables */
+    CEpgSearchIndex *                   m_searchIndex;     /*!< the search index of the container this table is part of, NULL for temporary tables */
 
     CCriticalSection                    m_critSection;     /*!< critical section for changes in this table */
     bool                                m_bUpdateLastScanTime;
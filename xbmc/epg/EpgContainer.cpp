@@ -20,6 +20,7 @@
 
 #include "EpgContainer.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "Application.h"
@@ -36,6 +37,7 @@
 #include "settings/lib/Setting.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
+#include "utils/TextSearch.h"
 #include "utils/log.h"
 
 
@@ -110,6 +112,11 @@ void CEpgContainer::Clear(bool bClearDb /* = false */)
     {
       epgEntry.second->UnregisterObserver(this);
     }
+    /* drop the whole indexes at once instead of table by table */
+    m_timeIndex.Clear();
+    m_searchIndex.Clear();
+    for (const auto &epgEntry : m_epgs)
+      epgEntry.second->SetIndexes(NULL, NULL);
     m_epgs.clear();
     m_iNextEpgUpdate  = 0;
     m_bStarted = false;
@@ -471,6 +478,7 @@ void CEpgContainer::InsertFromDatabase(int iEpgID, const std::string &strName, c
       m_epgs.insert(std::make_pair(iEpgID, epg));
       SetChanged();
       epg->RegisterObserver(this);
+      epg->SetIndexes(&m_timeIndex, &m_searchIndex);
     }
   }
 }
@@ -496,6 +504,7 @@ CEpgPtr CEpgContainer::CreateChannelEpg(const CPVRChannelPtr &channel)
     m_epgs.insert(std::make_pair((unsigned int)epg->EpgID(), epg));
     SetChanged();
     epg->RegisterObserver(this);
+    epg->SetIndexes(&m_timeIndex, &m_searchIndex);
   }
 
   epg->SetChannel(channel);
@@ -556,6 +565,7 @@ bool CEpgContainer::DeleteEpg(const CEpg &epg, bool bDeleteFromDatabase /* = fal
     m_database.Delete(*epgEntry->second);
 
   epgEntry->second->UnregisterObserver(this);
+  epgEntry->second->SetIndexes(NULL, NULL);
   m_epgs.erase(epgEntry);
 
   return true;
@@ -772,13 +782,53 @@ const CDateTime CEpgContainer::GetLastEPGDate(void)
 int CEpgContainer::GetEPGSearch(CFileItemList &results, const EpgSearchFilter &filter)
 {
   int iInitialSize = results.Size();
+  std::vector<CEpgTimeIndex::Entry> entries;
+  bool bIndexed(false);
+
+  CSingleLock lock(m_critSection);
+
+  /* only look at the tags that contain the words of the search term */
+  if (!filter.m_strSearchTerm.empty())
+  {
+    CTextSearch search(filter.m_strSearchTerm, filter.m_bIsCaseSensitive, SEARCH_DEFAULT_OR);
+    bIndexed = m_searchIndex.GetCandidates(search, entries);
+    if (bIndexed)
+    {
+      std::stable_sort(entries.begin(), entries.end(), [](const CEpgTimeIndex::Entry &left, const CEpgTimeIndex::Entry &right) {
+        return left.tag->StartAsUTC() < right.tag->StartAsUTC();
+      });
+    }
+  }
+
+  /* or at the tags in the window, with a day to spare for the conversion from local time */
+  if (!bIndexed && filter.m_startDateTime.IsValid() && filter.m_endDateTime.IsValid())
+  {
+    const CDateTimeSpan margin(1, 0, 0, 0);
+    m_timeIndex.GetOverlapping(filter.m_startDateTime.GetAsUTCDateTime() - margin,
+                               filter.m_endDateTime.GetAsUTCDateTime() + margin, entries);
+    bIndexed = true;
+  }
 
   /* get filtered results from all tables */
+  if (bIndexed)
+  {
+    std::map<const CEpg *, bool> validEpgs;
+    for (const auto &entry : entries)
+    {
+      auto valid = validEpgs.find(entry.epg);
+      if (valid == validEpgs.end())
+        valid = validEpgs.insert(std::make_pair(entry.epg, entry.epg->HasValidEntries())).first;
+
+      if (valid->second && filter.FilterEntry(*entry.tag))
+        results.Add(CFileItemPtr(new CFileItem(entry.tag)));
+    }
+  }
+  else
   {
-    CSingleLock lock(m_critSection);
     for (const auto &epgEntry : m_epgs)
       epgEntry.second->Get(results, filter);
   }
+  lock.Leave();
 
   /* remove duplicate entries */
   if (filter.m_bPreventRepeats)
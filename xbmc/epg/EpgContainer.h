@@ -29,6 +29,8 @@
 
 #include "Epg.h"
 #include "EpgDatabase.h"
+#include "EpgSearchIndex.h"
+#include "EpgTimeIndex.h"
 
 class CFileItemList;
 class CGUIDialogProgressBarHandle;
@@ -291,6 +293,8 @@ namespace EPG
     time_t       m_iNextEpgActiveTagCheck; /*!< the time the EPG will be checked for active tag updates */
     unsigned int m_iNextEpgId;             /*!< the next epg ID that will be given to a new table when the db isn't being used */
     EPGMAP       m_epgs;                   /*!< the EPGs in this container */
+    CEpgTimeIndex m_timeIndex;             /*!< the tags of all EPGs in this container by time */
+    CEpgSearchIndex m_searchIndex;         /*!< the tags of all EPGs in this container by the words in their texts */
     //@}
 
     CGUIDialogProgressBarHandle *  m_progressHandle; /*!< the progress dialog that is visible when updating the first time */
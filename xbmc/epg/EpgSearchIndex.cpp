@@ -0,0 +1,354 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgSearchIndex.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+#include "EpgInfoTag.h"
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+#include "utils/TextSearch.h"
+
+using namespace EPG;
+
+/* don't bother compacting small indexes */
+#define EPG_SEARCH_INDEX_MIN_COMPACT 1024
+
+static inline bool IsWordChar(unsigned char c)
+{
+  /* bytes of multi byte utf-8 characters are part of a word too */
+  return c >= 0x80 ||
+      (c >= '0' && c <= '9') ||
+      (c >= 'a' && c <= 'z') ||
+      (c >= 'A' && c <= 'Z');
+}
+
+CEpgSearchIndex::CEpgSearchIndex(void) :
+    m_iRemoved(0)
+{
+}
+
+void CEpgSearchIndex::GetWords(const std::string &strText, std::vector<std::string> &words)
+{
+  std::string strLower(strText);
+  StringUtils::ToLower(strLower);
+
+  size_t iStart = std::string::npos;
+  for (size_t iPtr = 0; iPtr <= strLower.size(); ++iPtr)
+  {
+    bool bWordChar = iPtr < strLower.size() && IsWordChar(strLower[iPtr]);
+    if (bWordChar && iStart == std::string::npos)
+      iStart = iPtr;
+    else if (!bWordChar && iStart != std::string::npos)
+    {
+      words.push_back(strLower.substr(iStart, iPtr - iStart));
+      iStart = std::string::npos;
+    }
+  }
+}
+
+size_t CEpgSearchIndex::GetTextHash(const CEpgInfoTag &tag)
+{
+  std::hash<std::string> hash;
+  size_t iHash = hash(tag.Title());
+  iHash = iHash * 31 + hash(tag.PlotOutline());
+  iHash = iHash * 31 + hash(tag.Plot());
+  return iHash;
+}
+
+void CEpgSearchIndex::Intersect(Postings &result, const Postings &other)
+{
+  Postings intersection;
+  std::set_intersection(result.begin(), result.end(), other.begin(), other.end(), std::back_inserter(intersection));
+  result.swap(intersection);
+}
+
+void CEpgSearchIndex::Add(const CEpg *epg, const CEpgInfoTagPtr &tag, size_t iTextHash)
+{
+  std::vector<std::string> words;
+  GetWords(tag->Title(), words);
+  GetWords(tag->PlotOutline(), words);
+  GetWords(tag->Plot(), words);
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+
+  /* new documents get the highest id, so the postings stay sorted */
+  unsigned int iDocument = m_documents.size();
+  m_documents.push_back(Document{ epg, tag, iTextHash });
+  m_ids[tag.get()] = iDocument;
+
+  for (const auto &word : words)
+  {
+    auto wordId = m_wordIds.find(word);
+    if (wordId == m_wordIds.end())
+    {
+      wordId = m_wordIds.insert(std::make_pair(word, m_words.size())).first;
+      m_words.push_back(word);
+      m_postings.push_back(Postings());
+    }
+    m_postings[wordId->second].push_back(iDocument);
+  }
+}
+
+void CEpgSearchIndex::Remove(unsigned int iDocument)
+{
+  Document &document = m_documents[iDocument];
+  m_ids.erase(document.tag.get());
+  document.epg = NULL;
+  document.tag.reset();
+  m_iRemoved++;
+}
+
+void CEpgSearchIndex::Compact(void)
+{
+  if (m_iRemoved < EPG_SEARCH_INDEX_MIN_COMPACT || m_iRemoved * 2 < m_documents.size())
+    return;
+
+  /* renumber the documents that are left, in the same order */
+  const unsigned int REMOVED = static_cast<unsigned int>(-1);
+  std::vector<unsigned int> newIds(m_documents.size(), REMOVED);
+  std::vector<Document> documents;
+  documents.reserve(m_documents.size() - m_iRemoved);
+  m_ids.clear();
+  for (size_t iPtr = 0; iPtr < m_documents.size(); ++iPtr)
+  {
+    if (!m_documents[iPtr].tag)
+      continue;
+
+    newIds[iPtr] = documents.size();
+    m_ids[m_documents[iPtr].tag.get()] = documents.size();
+    documents.push_back(std::move(m_documents[iPtr]));
+  }
+
+  /* drop the words that are only used by removed documents */
+  std::vector<std::string> words;
+  std::vector<Postings> postings;
+  m_wordIds.clear();
+  for (size_t iPtr = 0; iPtr < m_words.size(); ++iPtr)
+  {
+    Postings wordPostings;
+    for (unsigned int iDocument : m_postings[iPtr])
+    {
+      if (newIds[iDocument] != REMOVED)
+        wordPostings.push_back(newIds[iDocument]);
+    }
+
+    if (wordPostings.empty())
+      continue;
+
+    m_wordIds.insert(std::make_pair(m_words[iPtr], words.size()));
+    words.push_back(std::move(m_words[iPtr]));
+    postings.push_back(std::move(wordPostings));
+  }
+
+  m_documents.swap(documents);
+  m_words.swap(words);
+  m_postings.swap(postings);
+  m_iRemoved = 0;
+}
+
+void CEpgSearchIndex::Insert(const CEpg *epg, const CEpgInfoTagPtr &tag)
+{
+  size_t iTextHash = GetTextHash(*tag);
+
+  CSingleLock lock(m_critSection);
+  auto id = m_ids.find(tag.get());
+  if (id != m_ids.end())
+  {
+    if (m_documents[id->second].iTextHash == iTextHash && m_documents[id->second].epg == epg)
+      return;
+    Remove(id->second);
+  }
+
+  Add(epg, tag, iTextHash);
+  Compact();
+}
+
+bool CEpgSearchIndex::Erase(const CEpgInfoTagPtr &tag)
+{
+  CSingleLock lock(m_critSection);
+  auto id = m_ids.find(tag.get());
+  if (id == m_ids.end())
+    return false;
+
+  Remove(id->second);
+  Compact();
+  return true;
+}
+
+void CEpgSearchIndex::Erase(const CEpg *epg)
+{
+  CSingleLock lock(m_critSection);
+  for (size_t iPtr = 0; iPtr < m_documents.size(); ++iPtr)
+  {
+    if (m_documents[iPtr].tag && m_documents[iPtr].epg == epg)
+      Remove(iPtr);
+  }
+  Compact();
+}
+
+void CEpgSearchIndex::Update(const CEpgInfoTagPtr &tag)
+{
+  size_t iTextHash = GetTextHash(*tag);
+
+  CSingleLock lock(m_critSection);
+  auto id = m_ids.find(tag.get());
+  if (id == m_ids.end() || m_documents[id->second].iTextHash == iTextHash)
+    return;
+
+  const CEpg *epg = m_documents[id->second].epg;
+  Remove(id->second);
+  Add(epg, tag, iTextHash);
+  Compact();
+}
+
+void CEpgSearchIndex::Clear(void)
+{
+  CSingleLock lock(m_critSection);
+  m_documents.clear();
+  m_ids.clear();
+  m_words.clear();
+  m_wordIds.clear();
+  m_postings.clear();
+  m_iRemoved = 0;
+}
+
+bool CEpgSearchIndex::GetTermDocuments(const std::string &strTerm, Postings &documents) const
+{
+  std::vector<std::string> termWords;
+  GetWords(strTerm, termWords);
+  if (termWords.empty())
+    return false;
+
+  bool bFirst(true);
+  for (const auto &termWord : termWords)
+  {
+    /* a search matches parts of words, so every word that contains the word of the term is a hit */
+    std::vector<unsigned int> wordIds;
+    for (size_t iPtr = 0; iPtr < m_words.size(); ++iPtr)
+    {
+      if (m_words[iPtr].find(termWord) != std::string::npos)
+        wordIds.push_back(iPtr);
+    }
+
+    Postings wordDocuments;
+    if (wordIds.size() == 1)
+      wordDocuments = m_postings[wordIds.front()];
+    else if (wordIds.size() > 1)
+    {
+      /* merge the lists by marking the documents, short words can be part of thousands of words */
+      std::vector<bool> marked(m_documents.size(), false);
+      for (unsigned int iWord : wordIds)
+      {
+        for (unsigned int iDocument : m_postings[iWord])
+          marked[iDocument] = true;
+      }
+
+      for (size_t iDocument = 0; iDocument < marked.size(); ++iDocument)
+      {
+        if (marked[iDocument])
+          wordDocuments.push_back(iDocument);
+      }
+    }
+
+    if (bFirst)
+      documents.swap(wordDocuments);
+    else
+      Intersect(documents, wordDocuments);
+    bFirst = false;
+
+    if (documents.empty())
+      break;
+  }
+
+  return true;
+}
+
+bool CEpgSearchIndex::GetCandidates(const CTextSearch &search, std::vector<Entry> &entries) const
+{
+  CSingleLock lock(m_critSection);
+
+  /* every and term has to match */
+  Postings documents;
+  bool bNarrowed(false);
+  for (const auto &strTerm : search.GetAndTerms())
+  {
+    Postings termDocuments;
+    if (!GetTermDocuments(strTerm, termDocuments))
+      continue;
+
+    if (bNarrowed)
+      Intersect(documents, termDocuments);
+    else
+      documents.swap(termDocuments);
+    bNarrowed = true;
+  }
+
+  /* and one of the or terms */
+  if (!search.GetOrTerms().empty() && (!bNarrowed || !documents.empty()))
+  {
+    Postings orDocuments;
+    bool bOrNarrowed(true);
+    for (const auto &strTerm : search.GetOrTerms())
+    {
+      Postings termDocuments;
+      if (!GetTermDocuments(strTerm, termDocuments))
+      {
+        bOrNarrowed = false;
+        break;
+      }
+
+      Postings merged;
+      std::set_union(orDocuments.begin(), orDocuments.end(), termDocuments.begin(), termDocuments.end(), std::back_inserter(merged));
+      orDocuments.swap(merged);
+    }
+
+    if (bOrNarrowed)
+    {
+      if (bNarrowed)
+        Intersect(documents, orDocuments);
+      else
+        documents.swap(orDocuments);
+      bNarrowed = true;
+    }
+  }
+
+  /* searches with only not terms have to look at everything */
+  if (!bNarrowed)
+    return false;
+
+  for (unsigned int iDocument : documents)
+  {
+    const Document &document = m_documents[iDocument];
+    if (document.tag)
+      entries.push_back(Entry{ document.epg, document.tag });
+  }
+
+  return true;
+}
+
+size_t CEpgSearchIndex::Size(void) const
+{
+  CSingleLock lock(m_critSection);
+  return m_documents.size() - m_iRemoved;
+}
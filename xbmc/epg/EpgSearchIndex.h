@@ -0,0 +1,122 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "EpgTimeIndex.h"
+#include "threads/CriticalSection.h"
+
+class CTextSearch;
+
+namespace EPG
+{
+  /*!
+   * @brief Inverted index of the words in the title, plot outline and plot of the tags of all EPG tables.
+   *
+   * A word is a run of letters and digits, lower cased the same way CTextSearch
+   * does it. Every word a search term consists of has to be part of a word of a
+   * matching tag, so the index hands out the tags that contain all of them as
+   * candidates. The candidates still have to be checked with the search itself,
+   * the index only narrows down the tags that are looked at.
+   *
+   * Removed tags are only dropped from the word lists once they make up half of
+   * the index. Like CEpgTimeIndex, the index never calls back into the tables.
+   */
+  class CEpgSearchIndex
+  {
+  public:
+    typedef CEpgTimeIndex::Entry Entry;
+
+    CEpgSearchIndex(void);
+
+    /*!
+     * @brief Add a tag, or pick up the changed texts of a tag that was added before.
+     * @param epg The table the tag belongs to.
+     * @param tag The tag to add.
+     */
+    void Insert(const CEpg *epg, const CEpgInfoTagPtr &tag);
+
+    /*!
+     * @brief Remove a tag.
+     * @param tag The tag to remove.
+     * @return True if the tag was found, false otherwise.
+     */
+    bool Erase(const CEpgInfoTagPtr &tag);
+
+    /*!
+     * @brief Remove all tags of a table.
+     * @param epg The table.
+     */
+    void Erase(const CEpg *epg);
+
+    /*!
+     * @brief Pick up the changed texts of a tag.
+     * @param tag The changed tag.
+     */
+    void Update(const CEpgInfoTagPtr &tag);
+
+    void Clear(void);
+
+    /*!
+     * @brief Get the tags that may match a search.
+     * @param search The search.
+     * @param entries The candidates are appended to this, ordered by the time they were added.
+     * @return True if the candidates were found, false if the search can't be narrowed down and all tags have to be checked.
+     */
+    bool GetCandidates(const CTextSearch &search, std::vector<Entry> &entries) const;
+
+    size_t Size(void) const;
+
+    /*!
+     * @brief Split a text in the words the index uses.
+     * @param strText The text to split.
+     * @param words The lower cased words are appended to this.
+     */
+    static void GetWords(const std::string &strText, std::vector<std::string> &words);
+
+  private:
+    struct Document
+    {
+      const CEpg *epg;
+      CEpgInfoTagPtr tag;   /*!< empty if the tag was removed */
+      size_t iTextHash;
+    };
+    typedef std::vector<unsigned int> Postings;
+
+    static size_t GetTextHash(const CEpgInfoTag &tag);
+    static void Intersect(Postings &result, const Postings &other);
+
+    void Add(const CEpg *epg, const CEpgInfoTagPtr &tag, size_t iTextHash);
+    void Remove(unsigned int iDocument);
+    void Compact(void);
+    bool GetTermDocuments(const std::string &strTerm, Postings &documents) const;
+
+    std::vector<Document> m_documents;                           /*!< the tags by document id */
+    std::unordered_map<const CEpgInfoTag *, unsigned int> m_ids; /*!< the document ids of the tags in the index */
+    std::vector<std::string> m_words;                            /*!< the words by word id */
+    std::unordered_map<std::string, unsigned int> m_wordIds;
+    std::vector<Postings> m_postings;                            /*!< ascending document ids by word id, may contain removed documents */
+    size_t m_iRemoved;
+    mutable CCriticalSection m_critSection;
+  };
+}
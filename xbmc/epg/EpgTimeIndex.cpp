@@ -0,0 +1,218 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgTimeIndex.h"
+
+#include <algorithm>
+
+#include "EpgInfoTag.h"
+#include "threads/SingleLock.h"
+#include "XBDateTime.h"
+
+using namespace EPG;
+
+CEpgTimeIndex::CEpgTimeIndex(void) :
+    m_maxDuration(0),
+    m_size(0)
+{
+}
+
+time_t CEpgTimeIndex::GetTime(const CDateTime &time)
+{
+  time_t result = 0;
+  if (time.IsValid())
+    time.GetAsTime(result);
+  return result;
+}
+
+time_t CEpgTimeIndex::GetBucket(time_t start)
+{
+  time_t offset = start % BUCKET_SPAN;
+  if (offset < 0)
+    offset += BUCKET_SPAN;
+  return start - offset;
+}
+
+void CEpgTimeIndex::Insert(const CEpg *epg, const CDateTime &start, const CEpgInfoTagPtr &tag)
+{
+  time_t iStart = GetTime(start);
+  time_t iEnd = GetTime(tag->EndAsUTC());
+
+  CSingleLock lock(m_critSection);
+  Bucket &bucket = m_buckets[GetBucket(iStart)];
+  if (bucket.tags.empty())
+    bucket.maxEnd = iEnd;
+
+  /* tags with the same start time stay in the order they were added */
+  size_t index = std::upper_bound(bucket.starts.begin(), bucket.starts.end(), iStart) - bucket.starts.begin();
+  bucket.starts.insert(bucket.starts.begin() + index, iStart);
+  bucket.ends.insert(bucket.ends.begin() + index, iEnd);
+  bucket.epgs.insert(bucket.epgs.begin() + index, epg);
+  bucket.tags.insert(bucket.tags.begin() + index, tag);
+
+  bucket.maxEnd = std::max(bucket.maxEnd, iEnd);
+  if (iStart > 0)
+    m_maxDuration = std::max(m_maxDuration, iEnd - iStart);
+  m_size++;
+}
+
+bool CEpgTimeIndex::Find(time_t start, const CEpgInfoTagPtr &tag, BucketMap::iterator &bucket, size_t &index)
+{
+  bucket = m_buckets.find(GetBucket(start));
+  if (bucket == m_buckets.end())
+    return false;
+
+  const std::vector<time_t> &starts = bucket->second.starts;
+  for (index = std::lower_bound(starts.begin(), starts.end(), start) - starts.begin();
+       index < starts.size() && starts[index] == start; ++index)
+  {
+    if (bucket->second.tags[index] == tag)
+      return true;
+  }
+  return false;
+}
+
+void CEpgTimeIndex::RemoveAt(Bucket &bucket, size_t index)
+{
+  bucket.starts.erase(bucket.starts.begin() + index);
+  bucket.ends.erase(bucket.ends.begin() + index);
+  bucket.epgs.erase(bucket.epgs.begin() + index);
+  bucket.tags.erase(bucket.tags.begin() + index);
+}
+
+void CEpgTimeIndex::UpdateMaxEnd(Bucket &bucket)
+{
+  if (!bucket.ends.empty())
+    bucket.maxEnd = *std::max_element(bucket.ends.begin(), bucket.ends.end());
+}
+
+bool CEpgTimeIndex::Erase(const CDateTime &start, const CEpgInfoTagPtr &tag)
+{
+  CSingleLock lock(m_critSection);
+  BucketMap::iterator bucket;
+  size_t index;
+  if (!Find(GetTime(start), tag, bucket, index))
+    return false;
+
+  RemoveAt(bucket->second, index);
+  if (bucket->second.tags.empty())
+    m_buckets.erase(bucket);
+  else
+    UpdateMaxEnd(bucket->second);
+  m_size--;
+
+  return true;
+}
+
+void CEpgTimeIndex::Erase(const CEpg *epg)
+{
+  CSingleLock lock(m_critSection);
+  for (BucketMap::iterator it = m_buckets.begin(); it != m_buckets.end();)
+  {
+    Bucket &bucket = it->second;
+    size_t iKept = 0;
+    for (size_t i = 0; i < bucket.tags.size(); ++i)
+    {
+      if (bucket.epgs[i] == epg)
+        continue;
+
+      if (iKept != i)
+      {
+        bucket.starts[iKept] = bucket.starts[i];
+        bucket.ends[iKept] = bucket.ends[i];
+        bucket.epgs[iKept] = bucket.epgs[i];
+        bucket.tags[iKept] = std::move(bucket.tags[i]);
+      }
+      iKept++;
+    }
+
+    m_size -= bucket.tags.size() - iKept;
+    if (iKept == 0)
+    {
+      it = m_buckets.erase(it);
+      continue;
+    }
+
+    bucket.starts.resize(iKept);
+    bucket.ends.resize(iKept);
+    bucket.epgs.resize(iKept);
+    bucket.tags.resize(iKept);
+    UpdateMaxEnd(bucket);
+    ++it;
+  }
+}
+
+void CEpgTimeIndex::Update(const CDateTime &start, const CEpgInfoTagPtr &tag)
+{
+  time_t iStart = GetTime(start);
+  time_t iEnd = GetTime(tag->EndAsUTC());
+
+  CSingleLock lock(m_critSection);
+  BucketMap::iterator bucket;
+  size_t index;
+  if (!Find(iStart, tag, bucket, index) || bucket->second.ends[index] == iEnd)
+    return;
+
+  bucket->second.ends[index] = iEnd;
+  UpdateMaxEnd(bucket->second);
+  if (iStart > 0)
+    m_maxDuration = std::max(m_maxDuration, iEnd - iStart);
+}
+
+void CEpgTimeIndex::Clear(void)
+{
+  CSingleLock lock(m_critSection);
+  m_buckets.clear();
+  m_maxDuration = 0;
+  m_size = 0;
+}
+
+size_t CEpgTimeIndex::GetOverlapping(const CDateTime &begin, const CDateTime &end, std::vector<Entry> &entries) const
+{
+  time_t iBegin = GetTime(begin);
+  time_t iEnd = GetTime(end);
+  size_t iInitialSize = entries.size();
+
+  CSingleLock lock(m_critSection);
+
+  /* no tag that starts before this can reach into the window */
+  BucketMap::const_iterator it = m_buckets.lower_bound(GetBucket(iBegin - m_maxDuration));
+  for (; it != m_buckets.end() && it->first <= iEnd; ++it)
+  {
+    const Bucket &bucket = it->second;
+    if (bucket.maxEnd < iBegin)
+      continue;
+
+    size_t iLast = std::upper_bound(bucket.starts.begin(), bucket.starts.end(), iEnd) - bucket.starts.begin();
+    for (size_t i = 0; i < iLast; ++i)
+    {
+      if (bucket.ends[i] >= iBegin)
+        entries.push_back(Entry{ bucket.epgs[i], bucket.tags[i] });
+    }
+  }
+
+  return entries.size() - iInitialSize;
+}
+
+size_t CEpgTimeIndex::Size(void) const
+{
+  CSingleLock lock(m_critSection);
+  return m_size;
+}
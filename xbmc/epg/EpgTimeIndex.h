@@ -0,0 +1,125 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <ctime>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+
+class CDateTime;
+
+namespace EPG
+{
+  class CEpg;
+  class CEpgInfoTag;
+  typedef std::shared_ptr<EPG::CEpgInfoTag> CEpgInfoTagPtr;
+
+  /*!
+   * @brief Index of the tags of all EPG tables by their start and end time.
+   *
+   * The entries are kept in flat arrays sorted by start time, split in buckets
+   * of BUCKET_SPAN seconds so adding or removing a tag only moves the entries
+   * of one bucket. A query for a time window looks up the first bucket with a
+   * binary search and only visits the entries that may overlap the window.
+   *
+   * The tables update the index themselves while they hold their own lock, the
+   * index never calls back into them.
+   */
+  class CEpgTimeIndex
+  {
+  public:
+    struct Entry
+    {
+      const CEpg *epg;
+      CEpgInfoTagPtr tag;
+    };
+
+    CEpgTimeIndex(void);
+
+    /*!
+     * @brief Add a tag.
+     * @param epg The table the tag belongs to.
+     * @param start The start time the table knows the tag by.
+     * @param tag The tag to add.
+     */
+    void Insert(const CEpg *epg, const CDateTime &start, const CEpgInfoTagPtr &tag);
+
+    /*!
+     * @brief Remove a tag.
+     * @param start The start time the tag was added with.
+     * @param tag The tag to remove.
+     * @return True if the tag was found, false otherwise.
+     */
+    bool Erase(const CDateTime &start, const CEpgInfoTagPtr &tag);
+
+    /*!
+     * @brief Remove all tags of a table.
+     * @param epg The table.
+     */
+    void Erase(const CEpg *epg);
+
+    /*!
+     * @brief Pick up a changed end time of a tag.
+     * @param start The start time the tag was added with.
+     * @param tag The changed tag.
+     */
+    void Update(const CDateTime &start, const CEpgInfoTagPtr &tag);
+
+    void Clear(void);
+
+    /*!
+     * @brief Get all tags that overlap or touch a time window, ordered by start time.
+     * @param begin The start of the window in UTC.
+     * @param end The end of the window in UTC.
+     * @param entries The entries are appended to this.
+     * @return The number of entries found.
+     */
+    size_t GetOverlapping(const CDateTime &begin, const CDateTime &end, std::vector<Entry> &entries) const;
+
+    size_t Size(void) const;
+
+    static const time_t BUCKET_SPAN = 3600;
+
+  private:
+    struct Bucket
+    {
+      std::vector<time_t> starts;
+      std::vector<time_t> ends;
+      std::vector<const CEpg *> epgs;
+      std::vector<CEpgInfoTagPtr> tags;
+      time_t maxEnd;
+    };
+    typedef std::map<time_t, Bucket> BucketMap;
+
+    static time_t GetTime(const CDateTime &time);
+    static time_t GetBucket(time_t start);
+    static void RemoveAt(Bucket &bucket, size_t index);
+    static void UpdateMaxEnd(Bucket &bucket);
+    bool Find(time_t start, const CEpgInfoTagPtr &tag, BucketMap::iterator &bucket, size_t &index);
+
+    BucketMap m_buckets;
+    time_t m_maxDuration;   /*!< the longest tag that was added since the index was cleared */
+    size_t m_size;
+    mutable CCriticalSection m_critSection;
+  };
+}
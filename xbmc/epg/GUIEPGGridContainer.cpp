@@ -1641,7 +1641,13 @@ void CGUIEPGGridContainer::HandleChannels(bool bRender, unsigned int currentTime
   {
     // Free memory not used on screen
     if (m_gridModel->ChannelItemsSize() > m_channelsPerPage + cacheBeforeChannel + cacheAfterChannel)
+    {
       m_gridModel->FreeChannelMemory(chanOffset - cacheBeforeChannel, chanOffset + m_channelsPerPage + 1 + cacheAfterChannel);
+
+      // the selected item points into the grid rows of the current page, which may not be scrolled into view yet
+      m_gridModel->FreeGridMemory(std::min(chanOffset, m_channelOffset) - cacheBeforeChannel,
+                                  std::max(chanOffset, m_channelOffset) + m_channelsPerPage + 1 + cacheAfterChannel);
+    }
   }
 
   CPoint originChannel = CPoint(m_channelPosX, m_channelPosY) + m_renderOffset;
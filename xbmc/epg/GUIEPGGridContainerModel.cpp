@@ -20,6 +20,7 @@
 
 #include "GUIEPGGridContainerModel.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "FileItem.h"
@@ -49,14 +50,10 @@ void CGUIEPGGridContainerModel::SetInvalid()
 
 void CGUIEPGGridContainerModel::Reset()
 {
-  for (auto &channel : m_gridIndex)
+  for (const auto &row : m_gridIndex)
   {
-    for (const auto &block : channel)
-    {
-      if (block.item)
-        block.item->ClearProperties();
-    }
-    channel.clear();
+    for (const auto &run : row.items)
+      run.item->ClearProperties();
   }
   m_gridIndex.clear();
 
@@ -155,8 +152,7 @@ void CGUIEPGGridContainerModel::Refresh(const std::unique_ptr<CFileItemList> &it
   FreeItemsMemory();
 
   ////////////////////////////////////////////////////////////////////////
-  // Create epg grid
-  const CDateTimeSpan blockDuration(0, 0, MINSPERBLOCK, 0);
+  // Create epg grid, the rows of the channels are filled in when they're needed
   const CDateTimeSpan gridDuration(m_gridEnd - m_gridStart);
   m_blocks = (gridDuration.GetDays() * 24 * 60 + gridDuration.GetHours() * 60 + gridDuration.GetMinutes()) / MINSPERBLOCK;
   if (m_blocks >= MAXBLOCKS)
@@ -164,118 +160,140 @@ void CGUIEPGGridContainerModel::Refresh(const std::unique_ptr<CFileItemList> &it
   else if (m_blocks < iBlocksPerPage)
     m_blocks = iBlocksPerPage;
 
-  m_gridIndex.reserve(m_channelItems.size());
-  const std::vector<GridItem> blocks(m_blocks);
+  m_blockSize = fBlockSize;
+  m_gridIndex.resize(m_channelItems.size());
+}
+
+CGUIEPGGridContainerModel::GridRow &CGUIEPGGridContainerModel::GetGridRow(int iChannel) const
+{
+  GridRow &row = m_gridIndex[iChannel];
+  if (!row.items.empty() || m_blocks <= 0)
+    return row;
 
-  for (size_t channel = 0; channel < m_channelItems.size(); ++channel)
+  // Note: Start block of an event is start-time-based calculated block + 1,
+  //       unless start times matches exactly the begin of a block.
+  const int iBlockSeconds = MINSPERBLOCK * 60;
+  int iNextBlock = 0; // first block that is not covered yet
+
+  for (long progIdx = m_epgItemsPtr[iChannel].start; progIdx <= m_epgItemsPtr[iChannel].stop && iNextBlock < m_blocks; ++progIdx)
   {
-    m_gridIndex.emplace_back(blocks);
-
-    CDateTime gridCursor(m_gridStart); //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[channel].start;
-    unsigned long lastIdx = m_epgItemsPtr[channel].stop;
-    int iEpgId            = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
-    int itemSize          = 1; // size of the programme in blocks
-    int savedBlock        = 0;
-    CFileItemPtr item;
-    CEpgInfoTagPtr tag;
-
-    for (int block = 0; block < m_blocks; ++block)
-    {
-      while (progIdx <= lastIdx)
-      {
-        item = m_programmeItems[progIdx];
-        tag = item->GetEPGInfoTag();
+    const CEpgInfoTagPtr tag(m_programmeItems[progIdx]->GetEPGInfoTag());
+    const CDateTime start(tag->StartAsUTC());
+    const CDateTime end(tag->EndAsUTC());
 
-        // Note: Start block of an event is start-time-based calculated block + 1,
-        //       unless start times matches exactly the begin of a block.
+    if (!start.IsValid() || !end.IsValid() || end <= m_gridStart)
+      continue;
 
-        if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
-          break;
+    if (m_gridEnd <= start)
+      break;
 
-        if (gridCursor < tag->EndAsUTC())
-        {
-          m_gridIndex[channel][block].item = item;
-          m_gridIndex[channel][block].progIndex = progIdx;
-          break;
-        }
+    int iFirstBlock = 0;
+    if (start > m_gridStart)
+      iFirstBlock = ((start - m_gridStart).GetSecondsTotal() + iBlockSeconds - 1) / iBlockSeconds;
 
-        progIdx++;
-      }
+    int iLastBlock = ((end - m_gridStart).GetSecondsTotal() + iBlockSeconds - 1) / iBlockSeconds - 1;
+    if (iLastBlock >= m_blocks)
+      iLastBlock = m_blocks - 1;
 
-      gridCursor += blockDuration;
+    // overlapping events keep the blocks of the one that started first
+    if (iFirstBlock < iNextBlock)
+      iFirstBlock = iNextBlock;
 
-      if (block == 0)
-        continue;
+    if (iFirstBlock > iLastBlock)
+      continue;
 
-      const CFileItemPtr prevItem(m_gridIndex[channel][block - 1].item);
-      const CFileItemPtr currItem(m_gridIndex[channel][block].item);
+    if (iFirstBlock > iNextBlock)
+      AddGridRun(row, iChannel, iNextBlock, iFirstBlock - 1, -1);
 
-      if (block == m_blocks - 1 || prevItem != currItem)
-      {
-        // special handling for last block.
-        int blockDelta = -1;
-        int sizeDelta = 0;
-        if (block == m_blocks - 1 && prevItem == currItem)
-        {
-          itemSize++;
-          blockDelta = 0;
-          sizeDelta = 1;
-        }
-
-        if (prevItem)
-        {
-          m_gridIndex[channel][savedBlock].item->SetProperty("GenreType", prevItem->GetEPGInfoTag()->GenreType());
-        }
-        else
-        {
-          CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
-          gapTag->SetPVRChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
-          CFileItemPtr gapItem(new CFileItem(gapTag));
-          for (int i = block + blockDelta; i >= block - itemSize + sizeDelta; --i)
-          {
-            m_gridIndex[channel][i].item = gapItem;
-          }
-        }
-
-        float fItemWidth = itemSize * fBlockSize;
-        m_gridIndex[channel][savedBlock].originWidth = fItemWidth;
-        m_gridIndex[channel][savedBlock].width = fItemWidth;
-
-        itemSize = 1;
-        savedBlock = block;
-
-        // special handling for last block.
-        if (block == m_blocks - 1 && prevItem != currItem)
-        {
-          if (currItem)
-          {
-            m_gridIndex[channel][savedBlock].item->SetProperty("GenreType", currItem->GetEPGInfoTag()->GenreType());
-          }
-          else
-          {
-            CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
-            gapTag->SetPVRChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
-            CFileItemPtr gapItem(new CFileItem(gapTag));
-            m_gridIndex[channel][block].item = gapItem;
-          }
-
-          m_gridIndex[channel][savedBlock].originWidth = fBlockSize; // size always 1 block here
-          m_gridIndex[channel][savedBlock].width = fBlockSize;
-        }
-      }
-      else
-      {
-        itemSize++;
-      }
-    }
+    AddGridRun(row, iChannel, iFirstBlock, iLastBlock, progIdx);
+    iNextBlock = iLastBlock + 1;
   }
+
+  if (iNextBlock < m_blocks)
+    AddGridRun(row, iChannel, iNextBlock, m_blocks - 1, -1);
+
+  return row;
 }
 
-void CGUIEPGGridContainerModel::FindChannelAndBlockIndex(int channelUid, unsigned int broadcastUid, int eventOffset, int &newChannelIndex, int &newBlockIndex) const
+void CGUIEPGGridContainerModel::AddGridRun(GridRow &row, int iChannel, int iStartBlock, int iEndBlock, int iProgIndex) const
+{
+  GridItem run;
+  if (iProgIndex >= 0)
+  {
+    run.item = m_programmeItems[iProgIndex];
+    run.item->SetProperty("GenreType", run.item->GetEPGInfoTag()->GenreType());
+  }
+  else
+  {
+    CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
+    gapTag->SetPVRChannel(m_channelItems[iChannel]->GetPVRChannelInfoTag());
+    run.item.reset(new CFileItem(gapTag));
+  }
+
+  run.progIndex = iProgIndex;
+  run.originWidth = (iEndBlock - iStartBlock + 1) * m_blockSize;
+  run.width = run.originWidth;
+
+  row.startBlocks.emplace_back(iStartBlock);
+  row.items.emplace_back(run);
+}
+
+GridItem *CGUIEPGGridContainerModel::GetGridRun(int iChannel, int iBlock, bool &bFirstBlock) const
+{
+  GridRow &row = GetGridRow(iChannel);
+  std::vector<int>::const_iterator it = std::upper_bound(row.startBlocks.begin(), row.startBlocks.end(), iBlock);
+  if (it == row.startBlocks.begin())
+    return nullptr;
+
+  --it;
+  bFirstBlock = *it == iBlock;
+  return &row.items[it - row.startBlocks.begin()];
+}
+
+GridItem *CGUIEPGGridContainerModel::GetGridItemPtr(int iChannel, int iBlock)
 {
-  const CDateTimeSpan blockDuration(0, 0, MINSPERBLOCK, 0);
+  bool bFirstBlock;
+  return GetGridRun(iChannel, iBlock, bFirstBlock);
+}
 
+CFileItemPtr CGUIEPGGridContainerModel::GetGridItem(int iChannel, int iBlock) const
+{
+  bool bFirstBlock;
+  const GridItem *run = GetGridRun(iChannel, iBlock, bFirstBlock);
+  return run ? run->item : CFileItemPtr();
+}
+
+float CGUIEPGGridContainerModel::GetGridItemWidth(int iChannel, int iBlock) const
+{
+  bool bFirstBlock;
+  const GridItem *run = GetGridRun(iChannel, iBlock, bFirstBlock);
+  return run && bFirstBlock ? run->width : 0.0f;
+}
+
+float CGUIEPGGridContainerModel::GetGridItemOriginWidth(int iChannel, int iBlock) const
+{
+  bool bFirstBlock;
+  const GridItem *run = GetGridRun(iChannel, iBlock, bFirstBlock);
+  return run && bFirstBlock ? run->originWidth : 0.0f;
+}
+
+int CGUIEPGGridContainerModel::GetGridItemIndex(int iChannel, int iBlock) const
+{
+  bool bFirstBlock;
+  const GridItem *run = GetGridRun(iChannel, iBlock, bFirstBlock);
+  return run ? run->progIndex : -1;
+}
+
+void CGUIEPGGridContainerModel::SetGridItemWidth(int iChannel, int iBlock, float fWidth)
+{
+  bool bFirstBlock;
+  GridItem *run = GetGridRun(iChannel, iBlock, bFirstBlock);
+  if (run && bFirstBlock)
+    run->width = fWidth;
+}
+
+void CGUIEPGGridContainerModel::FindChannelAndBlockIndex(int channelUid, unsigned int broadcastUid, int eventOffset, int &newChannelIndex, int &newBlockIndex) const
+{
   newChannelIndex = INVALID_INDEX;
   newBlockIndex = INVALID_INDEX;
 
@@ -291,35 +309,17 @@ void CGUIEPGGridContainerModel::FindChannelAndBlockIndex(int channelUid, unsigne
     iCurrentChannel++;
   }
 
-  if (newChannelIndex != INVALID_INDEX)
+  if (newChannelIndex != INVALID_INDEX && broadcastUid > 0)
   {
     // find the block
-    CDateTime gridCursor(m_gridStart); //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[newChannelIndex].start;
-    unsigned long lastIdx = m_epgItemsPtr[newChannelIndex].stop;
-    int iEpgId = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
-    CEpgInfoTagPtr tag;
-    for (int block = 0; block < m_blocks; ++block)
+    const GridRow &row = GetGridRow(newChannelIndex);
+    for (size_t i = 0; i < row.items.size(); ++i)
     {
-      while (progIdx <= lastIdx)
+      if (row.items[i].progIndex >= 0 && row.items[i].item->GetEPGInfoTag()->UniqueBroadcastID() == broadcastUid)
       {
-        tag = m_programmeItems[progIdx]->GetEPGInfoTag();
-
-        if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
-          break; // next block
-
-        if (gridCursor < tag->EndAsUTC())
-        {
-          if (broadcastUid > 0 && tag->UniqueBroadcastID() == broadcastUid)
-          {
-            newBlockIndex = block + eventOffset;
-            return; // done.
-          }
-          break; // next block
-        }
-        progIdx++;
+        newBlockIndex = row.startBlocks[i] + eventOffset;
+        return; // done.
       }
-      gridCursor += blockDuration;
     }
   }
 }
@@ -356,40 +356,33 @@ void CGUIEPGGridContainerModel::FreeProgrammeMemory(int channel, int keepStart,
 {
   if (keepStart < keepEnd)
   {
-    // remove before keepStart and after keepEnd
-    if (keepStart > 0 && keepStart < m_blocks)
+    // remove the runs that end before keepStart or start after keepEnd
+    const GridRow &row = m_gridIndex[channel];
+    for (size_t i = 0; i < row.items.size(); ++i)
     {
-      // if item exist and block is not part of visible item
-      CGUIListItemPtr last(m_gridIndex[channel][keepStart].item);
-      for (int i = keepStart - 1; i > 0; --i)
-      {
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
-        {
-          m_gridIndex[channel][i].item->FreeMemory();
-          // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
-          // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
-          // to avoid calling FreeMemory() multiple times on item that ocupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
-        }
-      }
+      int iLastBlock = i + 1 < row.startBlocks.size() ? row.startBlocks[i + 1] - 1 : m_blocks - 1;
+      if (iLastBlock < keepStart || row.startBlocks[i] > keepEnd)
+        row.items[i].item->FreeMemory();
     }
+  }
+}
 
-    if (keepEnd > 0 && keepEnd < m_blocks)
-    {
-      CGUIListItemPtr last(m_gridIndex[channel][keepEnd].item);
-      for (int i = keepEnd + 1; i < m_blocks; ++i)
-      {
-        // if item exist and block is not part of visible item
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
-        {
-          m_gridIndex[channel][i].item->FreeMemory();
-          // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
-          // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
-          // to avoid calling FreeMemory() multiple times on item that ocupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
-        }
-      }
-    }
+void CGUIEPGGridContainerModel::FreeGridMemory(int keepStart, int keepEnd)
+{
+  for (int i = 0; i < static_cast<int>(m_gridIndex.size()); ++i)
+  {
+    if (i >= keepStart && i <= keepEnd)
+      continue;
+
+    GridRow &row = m_gridIndex[i];
+    if (row.items.empty())
+      continue;
+
+    for (const auto &run : row.items)
+      run.item->FreeMemory();
+
+    std::vector<int>().swap(row.startBlocks);
+    std::vector<GridItem>().swap(row.items);
   }
 }
 
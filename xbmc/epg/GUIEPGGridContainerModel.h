@@ -47,7 +47,7 @@ namespace EPG
     static const int MINSPERBLOCK = 5; // minutes
     static const int MAXBLOCKS = 33 * 24 * 60 / MINSPERBLOCK; //! 33 days of 5 minute blocks (31 days for upcoming data + 1 day for past data + 1 day for fillers)
 
-    CGUIEPGGridContainerModel() : m_blocks(0) {}
+    CGUIEPGGridContainerModel() : m_blockSize(0.0f), m_blocks(0) {}
     virtual ~CGUIEPGGridContainerModel() { Reset(); }
 
     void Refresh(const std::unique_ptr<CFileItemList> &items, const CDateTime &gridStart, const CDateTime &gridEnd, int iRulerUnit, int iBlocksPerPage, float fBlockSize);
@@ -60,6 +60,11 @@ namespace EPG
     void FreeProgrammeMemory(int channel, int keepStart, int keepEnd);
     void FreeRulerMemory(int keepStart, int keepEnd);
 
+    /*!
+     * @brief Drop the grid rows of the channels outside the given range, they are built again when needed.
+     */
+    void FreeGridMemory(int keepStart, int keepEnd);
+
     CFileItemPtr GetProgrammeItem(int iIndex) const { return m_programmeItems[iIndex]; }
     bool HasProgrammeItems() const { return !m_programmeItems.empty(); }
     int ProgrammeItemsSize() const { return static_cast<int>(m_programmeItems.size()); }
@@ -73,12 +78,12 @@ namespace EPG
 
     int GetBlockCount() const { return m_blocks; }
     bool HasGridItems() const { return !m_gridIndex.empty(); }
-    GridItem *GetGridItemPtr(int iChannel, int iBlock) { return &m_gridIndex[iChannel][iBlock]; }
-    CFileItemPtr GetGridItem(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].item; }
-    float GetGridItemWidth(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].width; }
-    float GetGridItemOriginWidth(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].originWidth; }
-    int GetGridItemIndex(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].progIndex; }
-    void SetGridItemWidth(int iChannel, int iBlock, float fWidth) { m_gridIndex[iChannel][iBlock].width = fWidth; }
+    GridItem *GetGridItemPtr(int iChannel, int iBlock);
+    CFileItemPtr GetGridItem(int iChannel, int iBlock) const;
+    float GetGridItemWidth(int iChannel, int iBlock) const;
+    float GetGridItemOriginWidth(int iChannel, int iBlock) const;
+    int GetGridItemIndex(int iChannel, int iBlock) const;
+    void SetGridItemWidth(int iChannel, int iBlock, float fWidth);
 
     bool IsZeroGridDuration() const { return (m_gridEnd - m_gridStart) == CDateTimeSpan(0, 0, 0, 0); }
     const CDateTime &GetGridStart() const { return m_gridStart; }
@@ -99,6 +104,20 @@ namespace EPG
       long stop;
     };
 
+    /*!
+     * The programmes and gaps of a channel, one item per run of blocks. The
+     * widths are those of the whole run, the other blocks of a run have none.
+     */
+    struct GridRow
+    {
+      std::vector<int> startBlocks;
+      std::vector<GridItem> items;
+    };
+
+    GridRow &GetGridRow(int iChannel) const;
+    GridItem *GetGridRun(int iChannel, int iBlock, bool &bFirstBlock) const;
+    void AddGridRun(GridRow &row, int iChannel, int iStartBlock, int iEndBlock, int iProgIndex) const;
+
     CDateTime m_gridStart;
     CDateTime m_gridEnd;
 
@@ -106,8 +125,9 @@ namespace EPG
     std::vector<CFileItemPtr> m_channelItems;
     std::vector<CFileItemPtr> m_rulerItems;
     std::vector<ItemsPtr> m_epgItemsPtr;
-    std::vector<std::vector<GridItem> > m_gridIndex;
+    mutable std::vector<GridRow> m_gridIndex; // rows are built when a channel is first accessed
 
+    float m_blockSize;
     int m_blocks;
   };
 }
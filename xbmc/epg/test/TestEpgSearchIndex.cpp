@@ -0,0 +1,210 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "epg/EpgInfoTag.h"
+#include "epg/EpgSearchIndex.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/TextSearch.h"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <iostream>
+
+using namespace EPG;
+
+namespace
+{
+
+const size_t BENCHMARK_ITEMS = 200000;
+
+const char *WORDS[] = {
+  "news", "weather", "sport", "football", "tennis", "cooking", "kitchen", "garden",
+  "history", "science", "nature", "wildlife", "ocean", "mountain", "travel", "journey",
+  "comedy", "drama", "crime", "detective", "murder", "mystery", "family", "house",
+  "doctor", "hospital", "police", "london", "paris", "berlin", "election", "report"
+};
+const size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+CEpgInfoTagPtr CreateTag(unsigned int id, const std::string &strTitle, const std::string &strPlotOutline, const std::string &strPlot)
+{
+  EPG_TAG data;
+  memset(&data, 0, sizeof(data));
+  data.iUniqueBroadcastId = id;
+  data.startTime = 1451606400 + id * 1800;
+  data.endTime = data.startTime + 1800;
+  data.strTitle = strTitle.c_str();
+  data.strPlotOutline = strPlotOutline.c_str();
+  data.strPlot = strPlot.c_str();
+  return CEpgInfoTagPtr(new CEpgInfoTag(data));
+}
+
+// a guide with a few common words and many that only show up in some tags,
+// like the names of series and people
+std::vector<CEpgInfoTagPtr> GetGuide(size_t items)
+{
+  std::vector<CEpgInfoTagPtr> guide;
+  guide.reserve(items);
+  unsigned int seed = 12345;
+  for (size_t i = 0; i < items; i++)
+  {
+    std::string strTitle, strPlot;
+    for (unsigned int word = 0; word < 12; word++)
+    {
+      seed = seed * 1103515245 + 12345;
+      std::string &strText = word < 3 ? strTitle : strPlot;
+      if (!strText.empty())
+        strText += " ";
+      if (word % 4 == 3)
+        strText += StringUtils::Format("Name%u", (seed >> 8) % (items / 10 + 1));
+      else
+        strText += WORDS[(seed >> 16) % WORD_COUNT];
+    }
+    guide.push_back(CreateTag(i, strTitle, StringUtils::Format("Episode %u.", (unsigned int)i % 50), strPlot));
+  }
+  return guide;
+}
+
+bool Matches(const CTextSearch &search, const CEpgInfoTag &tag)
+{
+  return search.Search(tag.Title()) || search.Search(tag.PlotOutline()) || search.Search(tag.Plot());
+}
+
+std::vector<CEpgInfoTagPtr> ScanGuide(const std::vector<CEpgInfoTagPtr> &guide, const CTextSearch &search)
+{
+  std::vector<CEpgInfoTagPtr> results;
+  for (const auto &tag : guide)
+  {
+    if (Matches(search, *tag))
+      results.push_back(tag);
+  }
+  return results;
+}
+
+std::vector<CEpgInfoTagPtr> SearchIndex(const CEpgSearchIndex &index, const CTextSearch &search)
+{
+  std::vector<CEpgSearchIndex::Entry> entries;
+  std::vector<CEpgInfoTagPtr> results;
+  if (!index.GetCandidates(search, entries))
+    return results;
+
+  for (const auto &entry : entries)
+  {
+    if (Matches(search, *entry.tag))
+      results.push_back(entry.tag);
+  }
+  return results;
+}
+
+size_t CountCandidates(const CEpgSearchIndex &index, const std::string &strTerms)
+{
+  std::vector<CEpgSearchIndex::Entry> entries;
+  index.GetCandidates(CTextSearch(strTerms), entries);
+  return entries.size();
+}
+
+}
+
+TEST(TestEpgSearchIndex, GetWords)
+{
+  std::vector<std::string> words;
+  CEpgSearchIndex::GetWords("The Big-Bang Theory: S01E02 (1/2)", words);
+
+  std::vector<std::string> expected = { "the", "big", "bang", "theory", "s01e02", "1", "2" };
+  EXPECT_TRUE(words == expected);
+}
+
+TEST(TestEpgSearchIndex, GetCandidates)
+{
+  CEpgSearchIndex index;
+  CEpgInfoTagPtr news = CreateTag(1, "Evening News", "", "The latest headlines.");
+  CEpgInfoTagPtr football = CreateTag(2, "Football", "Premier League", "Highlights of the day.");
+  CEpgInfoTagPtr film = CreateTag(3, "The Newsroom", "Drama", "");
+  index.Insert(NULL, news);
+  index.Insert(NULL, football);
+  index.Insert(NULL, film);
+  EXPECT_EQ(3U, index.Size());
+
+  EXPECT_EQ(2U, CountCandidates(index, "news"));
+  EXPECT_EQ(1U, CountCandidates(index, "HEADLINE"));
+  EXPECT_EQ(1U, CountCandidates(index, "\"premier league\""));
+  EXPECT_EQ(3U, CountCandidates(index, "the football"));
+  EXPECT_EQ(1U, CountCandidates(index, "the and football"));
+  EXPECT_EQ(0U, CountCandidates(index, "cooking"));
+
+  // there is nothing to look up for searches that only exclude words
+  std::vector<CEpgSearchIndex::Entry> entries;
+  EXPECT_FALSE(index.GetCandidates(CTextSearch("news", false, SEARCH_DEFAULT_NOT), entries));
+
+  EXPECT_TRUE(index.Erase(news));
+  EXPECT_FALSE(index.Erase(news));
+  EXPECT_EQ(1U, CountCandidates(index, "news"));
+  EXPECT_EQ(0U, CountCandidates(index, "headlines"));
+}
+
+TEST(TestEpgSearchIndex, Update)
+{
+  CEpgSearchIndex index;
+  CEpgInfoTagPtr tag = CreateTag(1, "Evening News", "", "");
+  index.Insert(NULL, tag);
+
+  EPG_TAG data;
+  memset(&data, 0, sizeof(data));
+  data.iUniqueBroadcastId = 1;
+  data.strTitle = "Weather";
+  tag->Update(CEpgInfoTag(data));
+  index.Update(tag);
+
+  EXPECT_EQ(1U, index.Size());
+  EXPECT_EQ(0U, CountCandidates(index, "news"));
+  EXPECT_EQ(1U, CountCandidates(index, "weather"));
+}
+
+TEST(TestEpgSearchIndex, Search_Benchmark)
+{
+  std::vector<CEpgInfoTagPtr> guide = GetGuide(BENCHMARK_ITEMS);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CEpgSearchIndex index;
+  for (const auto &tag : guide)
+    index.Insert(NULL, tag);
+  unsigned int elapsedBuild = XbmcThreads::SystemClockMillis() - start;
+
+  const char *searches[] = { "name42", "detective", "\"ocean journey\"", "paris and name7", "murder or crime", "episode 4" };
+  for (const char *strSearch : searches)
+  {
+    CTextSearch search(strSearch);
+
+    start = XbmcThreads::SystemClockMillis();
+    std::vector<CEpgInfoTagPtr> scanned = ScanGuide(guide, search);
+    unsigned int elapsedScan = XbmcThreads::SystemClockMillis() - start;
+
+    start = XbmcThreads::SystemClockMillis();
+    std::vector<CEpgInfoTagPtr> indexed = SearchIndex(index, search);
+    unsigned int elapsedIndex = XbmcThreads::SystemClockMillis() - start;
+
+    std::cout << BENCHMARK_ITEMS << " tags, search '" << strSearch << "' (" << scanned.size() << " results), scan: "
+              << elapsedScan << " ms, index: " << elapsedIndex << " ms" << std::endl;
+    EXPECT_TRUE(scanned == indexed);
+  }
+
+  std::cout << BENCHMARK_ITEMS << " tags, building the index: " << elapsedBuild << " ms" << std::endl;
+}
@@ -0,0 +1,179 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "epg/EpgInfoTag.h"
+#include "epg/EpgTimeIndex.h"
+#include "XBDateTime.h"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+using namespace EPG;
+
+namespace
+{
+
+// 2016-01-01 00:00 UTC, the start of a bucket
+const time_t START = 1451606400;
+
+// the index never looks at the tables, it only tells them apart
+const CEpg *EPG_1 = reinterpret_cast<const CEpg *>(0x10);
+const CEpg *EPG_2 = reinterpret_cast<const CEpg *>(0x20);
+
+CEpgInfoTagPtr CreateTag(unsigned int id, time_t start, time_t duration)
+{
+  EPG_TAG data;
+  memset(&data, 0, sizeof(data));
+  data.iUniqueBroadcastId = id;
+  data.startTime = start;
+  data.endTime = start + duration;
+  data.strTitle = "";
+  return CEpgInfoTagPtr(new CEpgInfoTag(data));
+}
+
+std::vector<CEpgTimeIndex::Entry> GetOverlapping(const CEpgTimeIndex &index, time_t begin, time_t end)
+{
+  std::vector<CEpgTimeIndex::Entry> entries;
+  index.GetOverlapping(CDateTime(begin), CDateTime(end), entries);
+  return entries;
+}
+
+}
+
+class TestEpgTimeIndex : public ::testing::Test
+{
+protected:
+  CEpgTimeIndex index;
+
+  CEpgInfoTagPtr Insert(const CEpg *epg, unsigned int id, time_t start, time_t duration)
+  {
+    CEpgInfoTagPtr tag(CreateTag(id, start, duration));
+    index.Insert(epg, tag->StartAsUTC(), tag);
+    return tag;
+  }
+};
+
+TEST_F(TestEpgTimeIndex, Insert)
+{
+  CEpgInfoTagPtr tag3 = Insert(EPG_1, 3, START + 3600, 3600);
+  CEpgInfoTagPtr tag1 = Insert(EPG_1, 1, START, 1800);
+  CEpgInfoTagPtr tag2 = Insert(EPG_2, 2, START + 1800, 1800);
+  EXPECT_EQ(3u, index.Size());
+
+  // ordered by start time, whatever order they were added in
+  std::vector<CEpgTimeIndex::Entry> entries = GetOverlapping(index, START, START + 7200);
+  ASSERT_EQ(3u, entries.size());
+  EXPECT_EQ(tag1, entries[0].tag);
+  EXPECT_EQ(tag2, entries[1].tag);
+  EXPECT_EQ(tag3, entries[2].tag);
+  EXPECT_EQ(EPG_1, entries[0].epg);
+  EXPECT_EQ(EPG_2, entries[1].epg);
+}
+
+TEST_F(TestEpgTimeIndex, Range)
+{
+  CEpgInfoTagPtr tag1 = Insert(EPG_1, 1, START, 1800);
+  CEpgInfoTagPtr tag2 = Insert(EPG_1, 2, START + 1800, 1800);
+  CEpgInfoTagPtr tag3 = Insert(EPG_1, 3, START + 3600, 3600);
+
+  std::vector<CEpgTimeIndex::Entry> entries = GetOverlapping(index, START + 1000, START + 2000);
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_EQ(tag1, entries[0].tag);
+  EXPECT_EQ(tag2, entries[1].tag);
+
+  // tags that only touch the window are included
+  entries = GetOverlapping(index, START + 3600, START + 3600);
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_EQ(tag2, entries[0].tag);
+  EXPECT_EQ(tag3, entries[1].tag);
+
+  EXPECT_TRUE(GetOverlapping(index, START + 7201, START + 9000).empty());
+  EXPECT_TRUE(GetOverlapping(index, START - 3600, START - 1).empty());
+}
+
+TEST_F(TestEpgTimeIndex, RangeSpanningBounds)
+{
+  // starts a few buckets before the window and ends after it
+  CEpgInfoTagPtr movie = Insert(EPG_1, 1, START, 5 * 3600);
+  CEpgInfoTagPtr news = Insert(EPG_2, 2, START + 3 * 3600, 600);
+  CEpgInfoTagPtr late = Insert(EPG_2, 3, START + 6 * 3600, 600);
+
+  std::vector<CEpgTimeIndex::Entry> entries = GetOverlapping(index, START + 3 * 3600 + 300, START + 4 * 3600);
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_EQ(movie, entries[0].tag);
+  EXPECT_EQ(news, entries[1].tag);
+
+  // a window inside of a tag
+  entries = GetOverlapping(index, START + 3600, START + 3600 + 60);
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(movie, entries[0].tag);
+
+  // a window around all tags
+  EXPECT_EQ(3u, GetOverlapping(index, START - 3600, START + 7 * 3600).size());
+}
+
+TEST_F(TestEpgTimeIndex, Remove)
+{
+  CEpgInfoTagPtr tag1 = Insert(EPG_1, 1, START, 1800);
+  CEpgInfoTagPtr tag2 = Insert(EPG_1, 2, START, 1800);
+  CEpgInfoTagPtr tag3 = Insert(EPG_2, 3, START + 1800, 1800);
+  CEpgInfoTagPtr tag4 = Insert(EPG_2, 4, START + 3600, 1800);
+
+  // only the given tag goes, not the others starting at the same time
+  EXPECT_TRUE(index.Erase(tag1->StartAsUTC(), tag1));
+  EXPECT_FALSE(index.Erase(tag1->StartAsUTC(), tag1));
+  EXPECT_EQ(3u, index.Size());
+
+  std::vector<CEpgTimeIndex::Entry> entries = GetOverlapping(index, START, START + 600);
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(tag2, entries[0].tag);
+
+  // all tags of a table
+  index.Erase(EPG_2);
+  EXPECT_EQ(1u, index.Size());
+  entries = GetOverlapping(index, START, START + 7200);
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(tag2, entries[0].tag);
+
+  index.Clear();
+  EXPECT_EQ(0u, index.Size());
+  EXPECT_TRUE(GetOverlapping(index, START, START + 7200).empty());
+}
+
+TEST_F(TestEpgTimeIndex, Update)
+{
+  CEpgInfoTagPtr tag = Insert(EPG_1, 1, START, 1800);
+  EXPECT_TRUE(GetOverlapping(index, START + 2 * 3600, START + 3 * 3600).empty());
+
+  // a longer tag reaches into later windows
+  tag->SetEndFromUTC(CDateTime(START + 2 * 3600 + 600));
+  index.Update(tag->StartAsUTC(), tag);
+  std::vector<CEpgTimeIndex::Entry> entries = GetOverlapping(index, START + 2 * 3600, START + 3 * 3600);
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(tag, entries[0].tag);
+
+  // and a shorter one no longer does
+  tag->SetEndFromUTC(CDateTime(START + 1800));
+  index.Update(tag->StartAsUTC(), tag);
+  EXPECT_TRUE(GetOverlapping(index, START + 2 * 3600, START + 3 * 3600).empty());
+  EXPECT_EQ(1u, GetOverlapping(index, START + 1000, START + 1000).size());
+  EXPECT_EQ(1u, index.Size());
+}
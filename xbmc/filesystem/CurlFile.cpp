@@ -353,7 +353,9 @@ long CCurlFile::CReadState::Connect(unsigned int size)
   m_stillRunning = 1;
 
   // (Try to) fill buffer
-  if (FillBuffer(1) != FILLBUFFER_OK)
+  int8_t fill = FillBuffer(1);
+  g_curlInterface.TrackTransfer(m_easyHandle);
+  if (fill != FILLBUFFER_OK)
   {
     // Check response code
     long response;
@@ -475,6 +477,10 @@ void CCurlFile::SetCommonOptions(CReadState* state)
 
   g_curlInterface.easy_reset(h);
 
+  // share dns lookups and tls sessions with all other handles
+  if (g_curlInterface.GetShareHandle())
+    g_curlInterface.easy_setopt(h, CURLOPT_SHARE, g_curlInterface.GetShareHandle());
+
   g_curlInterface.easy_setopt(h, CURLOPT_DEBUGFUNCTION, debug_callback);
 
   if( g_advancedSettings.m_logLevel >= LOG_LEVEL_DEBUG )
@@ -607,6 +613,10 @@ void CCurlFile::SetCommonOptions(CReadState* state)
 
   if (m_useOldHttpVersion)
     g_curlInterface.easy_setopt(h, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_0);
+#if LIBCURL_VERSION_NUM >= 0x072f00 // 7.47.0
+  else if (g_advancedSettings.m_curlUseHttp2)
+    g_curlInterface.easy_setopt(h, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS); // negotiate http/2 on https
+#endif
 
   if (g_advancedSettings.m_curlDisableIPV6)
     g_curlInterface.easy_setopt(h, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
@@ -1240,6 +1250,7 @@ bool CCurlFile::Exists(const CURL& url)
   }
 
   CURLcode result = g_curlInterface.easy_perform(m_state->m_easyHandle);
+  g_curlInterface.TrackTransfer(m_state->m_easyHandle);
   g_curlInterface.easy_release(&m_state->m_easyHandle, NULL);
 
   if (result == CURLE_WRITE_ERROR || result == CURLE_OK)
@@ -1438,6 +1449,8 @@ int CCurlFile::Stat(const CURL& url, struct __stat64* buffer)
 
   }
 
+  g_curlInterface.TrackTransfer(m_state->m_easyHandle);
+
   if( result != CURLE_ABORTED_BY_CALLBACK && result != CURLE_OK )
   {
     g_curlInterface.easy_release(&m_state->m_easyHandle, NULL);
@@ -208,7 +208,7 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
       pDirectory->SetMask(hints.mask);
       for (int i = 0; i < items.Size(); ++i)
       {
-        CFileItemPtr item = items[i];
+        std::shared_ptr<const CFileItem> item = items.Peek(i);
         if (!item->m_bIsFolder && !pDirectory->IsAllowed(item->GetURL()))
         {
           items.Remove(i);
@@ -222,7 +222,7 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
     {
       for (int i = 0; i < items.Size(); ++i)
       {
-        if (items[i]->GetProperty("file:hidden").asBoolean())
+        if (items.Peek(i)->GetProperty("file:hidden").asBoolean())
         {
           items.Remove(i);
           i--; // don't confuse loop
@@ -242,8 +242,10 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
     {
       for (int i = 0; i < items.Size(); ++i)
       {
-        CFileItemPtr item = items[i];
-        item->SetPath(URIUtils::SubstitutePath(item->GetPath(), true));
+        // only copy the items that actually change
+        std::string path = URIUtils::SubstitutePath(items.Peek(i)->GetPath(), true);
+        if (path != items.Peek(i)->GetPath())
+          items[i]->SetPath(path);
       }
     }
 
@@ -376,9 +378,10 @@ void CDirectory::FilterFileDirectories(CFileItemList &items, const std::string &
 {
   for (int i=0; i< items.Size(); ++i)
   {
-    CFileItemPtr pItem=items[i];
-    if (!pItem->m_bIsFolder && pItem->IsFileFolder(EFILEFOLDER_TYPE_ALWAYS))
+    std::shared_ptr<const CFileItem> item = items.Peek(i);
+    if (!item->m_bIsFolder && item->IsFileFolder(EFILEFOLDER_TYPE_ALWAYS))
     {
+      CFileItemPtr pItem = items[i];
       std::unique_ptr<IFileDirectory> pDirectory(CFileDirectoryFactory::Create(pItem->GetURL(),pItem.get(),mask));
       if (pDirectory.get())
         pItem->m_bIsFolder = true;
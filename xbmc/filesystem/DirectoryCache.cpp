@@ -28,6 +28,7 @@
 #include "climits"
 
 #include <algorithm>
+#include <cinttypes>
 
 // Maximum number of directories to keep in our cache
 #define MAX_CACHED_DIRS 50
@@ -38,6 +39,9 @@ CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
   m_lastAccess = 0;
+#ifdef _DEBUG
+  m_itemsSize = 0;
+#endif
   m_Items = new CFileItemList;
   m_Items->SetIgnoreURLOptions(true);
   m_Items->SetFastLookup(true);
@@ -59,6 +63,10 @@ CDirectoryCache::CDirectoryCache(void)
 #ifdef _DEBUG
   m_cacheHits = 0;
   m_cacheMisses = 0;
+  m_directoryHits = 0;
+  m_directoryMisses = 0;
+  m_itemsShared = 0;
+  m_bytesShared = 0;
 #endif
 }
 
@@ -81,14 +89,22 @@ bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &it
     if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
        (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
     {
-      items.Copy(*dir->m_Items);
+      // the cached items are never changed, the caller gets copies of them
+      // the first time it asks the list for them
+      items.Share(*dir->m_Items);
       dir->SetLastAccess(m_accessCounter);
 #ifdef _DEBUG
       m_cacheHits+=items.Size();
+      m_directoryHits++;
+      m_itemsShared += dir->m_Items->Size();
+      m_bytesShared += dir->m_itemsSize;
 #endif
       return true;
     }
   }
+#ifdef _DEBUG
+  m_directoryMisses++;
+#endif
   return false;
 }
 
@@ -120,7 +136,14 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
 
   CDir* dir = new CDir(cacheType);
   dir->m_Items->Copy(items);
+  // every listing that is shown gets its default icons, a hit would have to
+  // copy all of its items if that was left to the gui
+  dir->m_Items->FillInDefaultIcons();
   dir->SetLastAccess(m_accessCounter);
+#ifdef _DEBUG
+  for (int i = 0; i < dir->m_Items->Size(); i++)
+    dir->m_itemsSize += GetItemSize(*dir->m_Items->Get(i));
+#endif
   m_cache.insert(std::pair<std::string, CDir*>(storedPath, dir));
 }
 
@@ -175,8 +198,12 @@ void CDirectoryCache::AddFile(const std::string& strFile)
   {
     CDir *dir = i->second;
     CFileItemPtr item(new CFileItem(strFile, false));
+    item->FillInDefaultIcon();
     dir->m_Items->Add(item);
     dir->SetLastAccess(m_accessCounter);
+#ifdef _DEBUG
+    dir->m_itemsSize += GetItemSize(*item);
+#endif
   }
 }
 
@@ -271,6 +298,13 @@ void CDirectoryCache::Delete(iCache it)
 }
 
 #ifdef _DEBUG
+void CDirectoryCache::OnSharedItemCopied(const CFileItem &item)
+{
+  // the item was counted as shared when it was handed out
+  m_itemsShared--;
+  m_bytesShared -= GetItemSize(item);
+}
+
 void CDirectoryCache::PrintStats() const
 {
   CSingleLock lock (m_cs);
@@ -287,5 +321,15 @@ void CDirectoryCache::PrintStats() const
     numDirs++;
   }
   CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+
+  unsigned int lookups = m_directoryHits + m_directoryMisses;
+  CLog::Log(LOGDEBUG, "%s - %u of %u folder lookups were hits (%.1f%%), %u items shared instead of copied, about %" PRIu64 " kB",
+            __FUNCTION__, m_directoryHits, lookups, lookups ? 100.0f * m_directoryHits / lookups : 0.0f, m_itemsShared.load(), m_bytesShared.load() / 1024);
+}
+
+uint64_t CDirectoryCache::GetItemSize(const CFileItem &item)
+{
+  // only the parts every item has, good enough to compare with the copies
+  return sizeof(CFileItem) + item.GetPath().capacity() + item.GetLabel().capacity() + item.GetLabel2().capacity();
 }
 #endif
@@ -23,6 +23,8 @@
 #include "Directory.h"
 #include "threads/CriticalSection.h"
 
+#include <atomic>
+
 #include <map>
 #include <set>
 
@@ -43,6 +45,9 @@ namespace XFILE
 
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
+#ifdef _DEBUG
+      uint64_t m_itemsSize; ///< rough size of the items, what a hit doesn't have to copy
+#endif
     private:
       unsigned int m_lastAccess;
     };
@@ -59,6 +64,10 @@ namespace XFILE
     bool FileExists(const std::string& strPath, bool& bInCache);
 #ifdef _DEBUG
     void PrintStats() const;
+
+    /*! \brief Called when a list had to copy an item it shared with the cache after all
+     */
+    void OnSharedItemCopied(const CFileItem &item);
 #endif
   protected:
     void InitCache(std::set<std::string>& dirs);
@@ -75,8 +84,14 @@ namespace XFILE
     unsigned int m_accessCounter;
 
 #ifdef _DEBUG
+    static uint64_t GetItemSize(const CFileItem &item);
+
     unsigned int m_cacheHits;
     unsigned int m_cacheMisses;
+    unsigned int m_directoryHits;
+    unsigned int m_directoryMisses;
+    std::atomic<unsigned int> m_itemsShared;  ///< handed out by a hit and never copied
+    std::atomic<uint64_t> m_bytesShared;
 #endif
   };
 }
@@ -0,0 +1,363 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DirectoryPrefetcher.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+#include "utils/log.h"
+#include "utils/URIUtils.h"
+
+namespace XFILE
+{
+  class CDirectoryPrefetchJob : public CJob
+  {
+  public:
+    CDirectoryPrefetchJob(const CDirectoryPrefetcher::SRequest &request)
+      : m_request(request)
+      , m_result(false)
+      , m_statResult(-1)
+    {
+      memset(&m_stat, 0, sizeof(m_stat));
+    }
+
+    virtual bool DoWork() override
+    {
+      switch (m_request.type)
+      {
+      case CDirectoryPrefetcher::REQUEST_DIRECTORY:
+        m_items.reset(new CFileItemList);
+        m_result = CDirectory::GetDirectory(m_request.path, *m_items, m_request.mask, m_request.flags);
+        break;
+      case CDirectoryPrefetcher::REQUEST_STAT:
+        m_statResult = CFile::Stat(m_request.path, &m_stat);
+        m_result = m_statResult == 0;
+        break;
+      case CDirectoryPrefetcher::REQUEST_EXISTS:
+        m_result = CFile::Exists(m_request.path);
+        break;
+      }
+      return true;
+    }
+
+    virtual const char *GetType() const override { return "directoryprefetch"; }
+
+    CDirectoryPrefetcher::SRequest m_request;
+    bool m_result;
+    int m_statResult;
+    struct __stat64 m_stat;
+    std::shared_ptr<CFileItemList> m_items;
+  };
+
+  CDirectoryPrefetcher::CDirectoryPrefetcher()
+    : m_connections(0)
+    , m_running(0)
+    , m_hits(0)
+    , m_misses(0)
+  {
+  }
+
+  CDirectoryPrefetcher::~CDirectoryPrefetcher()
+  {
+    Reset();
+  }
+
+  void CDirectoryPrefetcher::SetConnections(unsigned int connections)
+  {
+    CSingleLock lock(m_critSection);
+    m_connections = connections;
+    Dispatch();
+  }
+
+  size_t CDirectoryPrefetcher::GetLookahead()
+  {
+    // keep a couple of requests per connection ahead of the scanner
+    CSingleLock lock(m_critSection);
+    return 2 * m_connections;
+  }
+
+  void CDirectoryPrefetcher::PrefetchDirectories(const std::vector<std::string> &paths, size_t first, const std::string &mask, int flags)
+  {
+    Prefetch(REQUEST_DIRECTORY, paths, first, mask, flags);
+  }
+
+  void CDirectoryPrefetcher::PrefetchStats(const std::vector<std::string> &paths, size_t first)
+  {
+    Prefetch(REQUEST_STAT, paths, first, "", DIR_FLAG_DEFAULTS);
+  }
+
+  void CDirectoryPrefetcher::PrefetchExists(const std::vector<std::string> &paths, size_t first)
+  {
+    Prefetch(REQUEST_EXISTS, paths, first, "", DIR_FLAG_DEFAULTS);
+  }
+
+  void CDirectoryPrefetcher::Prefetch(RequestType type, const std::vector<std::string> &paths, size_t first, const std::string &mask, int flags)
+  {
+    CSingleLock lock(m_critSection);
+    if (m_connections == 0 || first >= paths.size())
+      return;
+
+    size_t last = std::min(paths.size(), first + 2 * m_connections);
+
+    // queue in reverse, so the requests end up in order in front of the
+    // ones of the directories visited after this batch
+    for (size_t i = last; i-- > first; )
+    {
+      std::string key = GetKey(type, paths[i]);
+      if (m_entries.find(key) != m_entries.end())
+        continue;
+
+      SEntry &entry = m_entries[key];
+      entry.request.type = type;
+      entry.request.path = paths[i];
+      entry.request.mask = mask;
+      entry.request.flags = flags;
+      entry.state = STATE_QUEUED;
+      entry.discard = false;
+      entry.result = false;
+      entry.statResult = -1;
+
+      m_hosts[GetHost(paths[i])].queued.push_front(key);
+    }
+    Dispatch();
+  }
+
+  void CDirectoryPrefetcher::Dispatch()
+  {
+    for (std::map<std::string, SHost>::iterator host = m_hosts.begin(); host != m_hosts.end(); )
+    {
+      while (host->second.running < m_connections && !host->second.queued.empty())
+      {
+        std::string key = host->second.queued.front();
+        host->second.queued.pop_front();
+
+        // the request may have been taken or discarded in the meantime
+        std::map<std::string, SEntry>::iterator it = m_entries.find(key);
+        if (it == m_entries.end() || it->second.state != STATE_QUEUED)
+          continue;
+
+        // the requests block on the network and the scanner may run in a pooled job
+        // waiting for them, so they get workers of their own
+        CDirectoryPrefetchJob *job = new CDirectoryPrefetchJob(it->second.request);
+        if (!CJobManager::GetInstance().AddJob(job, this, CJob::PRIORITY_DEDICATED))
+        {
+          delete job;
+          m_entries.erase(it);
+          continue;
+        }
+        it->second.state = STATE_RUNNING;
+        host->second.running++;
+        m_running++;
+      }
+
+      if (host->second.running == 0 && host->second.queued.empty())
+        host = m_hosts.erase(host);
+      else
+        ++host;
+    }
+  }
+
+  void CDirectoryPrefetcher::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    CDirectoryPrefetchJob *prefetch = static_cast<CDirectoryPrefetchJob*>(job);
+
+    CSingleLock lock(m_critSection);
+    m_running--;
+    std::map<std::string, SHost>::iterator host = m_hosts.find(GetHost(prefetch->m_request.path));
+    if (host != m_hosts.end())
+      host->second.running--;
+
+    std::map<std::string, SEntry>::iterator it = m_entries.find(GetKey(prefetch->m_request.type, prefetch->m_request.path));
+    if (it != m_entries.end() && it->second.state == STATE_RUNNING)
+    {
+      if (it->second.discard)
+        m_entries.erase(it);
+      else
+      {
+        it->second.state = STATE_DONE;
+        it->second.result = prefetch->m_result;
+        it->second.statResult = prefetch->m_statResult;
+        it->second.stat = prefetch->m_stat;
+        it->second.items = prefetch->m_items;
+      }
+    }
+
+    Dispatch();
+    // nothing may touch this after waking up a waiting Reset()
+    m_changed.notifyAll();
+  }
+
+  bool CDirectoryPrefetcher::Take(RequestType type, const std::string &path, SEntry &entry)
+  {
+    CSingleLock lock(m_critSection);
+    std::string key = GetKey(type, path);
+
+    std::map<std::string, SEntry>::iterator it = m_entries.find(key);
+    while (it != m_entries.end() && it->second.state == STATE_RUNNING)
+    {
+      m_changed.wait(lock);
+      it = m_entries.find(key);
+    }
+
+    if (it == m_entries.end() || it->second.state != STATE_DONE)
+    { // not prefetched, the caller fetches it itself
+      if (it != m_entries.end())
+        m_entries.erase(it);
+      m_misses++;
+      return false;
+    }
+
+    entry = it->second;
+    m_entries.erase(it);
+    m_hits++;
+    return true;
+  }
+
+  bool CDirectoryPrefetcher::GetDirectory(const std::string &path, CFileItemList &items, const std::string &mask, int flags)
+  {
+    SEntry entry;
+    if (Take(REQUEST_DIRECTORY, path, entry) && entry.request.mask == mask && entry.request.flags == flags)
+    {
+      items.Assign(*entry.items);
+      return entry.result;
+    }
+    return CDirectory::GetDirectory(path, items, mask, flags);
+  }
+
+  int CDirectoryPrefetcher::Stat(const std::string &path, struct __stat64 *buffer)
+  {
+    SEntry entry;
+    if (Take(REQUEST_STAT, path, entry))
+    {
+      *buffer = entry.stat;
+      return entry.statResult;
+    }
+    return CFile::Stat(path, buffer);
+  }
+
+  bool CDirectoryPrefetcher::Exists(const std::string &path)
+  {
+    SEntry entry;
+    if (Take(REQUEST_EXISTS, path, entry))
+      return entry.result;
+    return CFile::Exists(path);
+  }
+
+  void CDirectoryPrefetcher::GetRecursiveDirsListing(const std::string &path, CFileItemList &items, int flags)
+  {
+    CFileItemList myItems;
+    GetDirectory(path, myItems, "", flags);
+
+    std::vector<CFileItemPtr> folders;
+    std::vector<std::string> paths;
+    for (int i = 0; i < myItems.Size(); ++i)
+    {
+      if (myItems[i]->m_bIsFolder && !myItems[i]->IsPath(".."))
+      {
+        folders.push_back(myItems[i]);
+        paths.push_back(myItems[i]->GetPath());
+      }
+    }
+
+    for (size_t i = 0; i < folders.size(); ++i)
+    {
+      PrefetchDirectories(paths, i, "", flags);
+      items.Add(folders[i]);
+      GetRecursiveDirsListing(paths[i], items, flags);
+    }
+  }
+
+  void CDirectoryPrefetcher::Discard(const std::string &path)
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<std::string, SEntry>::iterator it = m_entries.begin(); it != m_entries.end(); )
+    {
+      if (!URIUtils::PathHasParent(it->second.request.path, path))
+        ++it;
+      else if (it->second.state == STATE_RUNNING)
+      {
+        it->second.discard = true;
+        ++it;
+      }
+      else
+        it = m_entries.erase(it);
+    }
+  }
+
+  void CDirectoryPrefetcher::Reset()
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<std::string, SHost>::iterator host = m_hosts.begin(); host != m_hosts.end(); ++host)
+      host->second.queued.clear();
+
+    for (std::map<std::string, SEntry>::iterator it = m_entries.begin(); it != m_entries.end(); )
+    {
+      if (it->second.state == STATE_RUNNING)
+      {
+        it->second.discard = true;
+        ++it;
+      }
+      else
+        it = m_entries.erase(it);
+    }
+
+    // the jobs call back into us, wait for the ones still running
+    while (m_running > 0)
+      m_changed.wait(lock);
+
+    m_entries.clear();
+    m_hosts.clear();
+
+    if (m_hits)
+      CLog::Log(LOGDEBUG, "%s - %u of %u requests were prefetched", __FUNCTION__, m_hits, m_hits + m_misses);
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+  unsigned int CDirectoryPrefetcher::GetHits()
+  {
+    CSingleLock lock(m_critSection);
+    return m_hits;
+  }
+
+  unsigned int CDirectoryPrefetcher::GetMisses()
+  {
+    CSingleLock lock(m_critSection);
+    return m_misses;
+  }
+
+  std::string CDirectoryPrefetcher::GetKey(RequestType type, const std::string &path)
+  {
+    return std::string(1, '0' + type) + path;
+  }
+
+  std::string CDirectoryPrefetcher::GetHost(const std::string &path)
+  {
+    CURL url(path);
+    return url.GetProtocol() + "://" + url.GetHostName();
+  }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IDirectory.h"
+#include "IFile.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "utils/Job.h"
+
+class CFileItemList;
+
+namespace XFILE
+{
+  /*!
+   * \brief Fetches directory listings and file stats ahead of a library scanner.
+   *
+   * The scanners walk a source one directory at a time, so on network shares
+   * most of the time is spent waiting for round trips. The scanner tells the
+   * prefetcher which paths it is going to visit next, they are then fetched
+   * by jobs with at most a given number of requests per host in flight.
+   * Asking for a path that is being fetched waits for the result, any other
+   * path is fetched right away on the calling thread.
+   *
+   * Scanners recurse depth first, so the paths queued last are fetched first.
+   */
+  class CDirectoryPrefetcher : public IJobCallback
+  {
+  public:
+    CDirectoryPrefetcher();
+    virtual ~CDirectoryPrefetcher();
+
+    /*! \brief Set the number of requests in flight per host, 0 disables prefetching
+     */
+    void SetConnections(unsigned int connections);
+
+    /*! \brief Number of paths queued ahead of the one visited next
+     */
+    size_t GetLookahead();
+
+    /*! \brief Queue listings of the next directories to be visited
+     \param paths directories in the order they will be visited.
+     \param first index of the directory that is visited next, the following
+     ones are queued up to the lookahead limit.
+     */
+    void PrefetchDirectories(const std::vector<std::string> &paths, size_t first, const std::string &mask, int flags = DIR_FLAG_DEFAULTS);
+    void PrefetchStats(const std::vector<std::string> &paths, size_t first);
+    void PrefetchExists(const std::vector<std::string> &paths, size_t first);
+
+    bool GetDirectory(const std::string &path, CFileItemList &items, const std::string &mask, int flags = DIR_FLAG_DEFAULTS);
+    int Stat(const std::string &path, struct __stat64 *buffer);
+    bool Exists(const std::string &path);
+
+    /*! \brief Same as CUtil::GetRecursiveDirsListing, the subfolders of
+     each level are prefetched.
+     */
+    void GetRecursiveDirsListing(const std::string &path, CFileItemList &items, int flags = DIR_FLAG_DEFAULTS);
+
+    /*! \brief Drop anything prefetched for a path that won't be visited,
+     including the requests for the files and folders in it, e.g. its .nomedia file
+     */
+    void Discard(const std::string &path);
+
+    /*! \brief Drop all queued requests and results, waits for running requests
+     */
+    void Reset();
+
+    /*! \brief Number of requests answered with a prefetched result since the last Reset()
+     */
+    unsigned int GetHits();
+
+    /*! \brief Number of requests that had to be fetched on the calling thread since the last Reset()
+     */
+    unsigned int GetMisses();
+
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job) override;
+
+  private:
+    enum RequestType
+    {
+      REQUEST_DIRECTORY = 0,
+      REQUEST_STAT,
+      REQUEST_EXISTS
+    };
+
+    enum RequestState
+    {
+      STATE_QUEUED = 0,
+      STATE_RUNNING,
+      STATE_DONE
+    };
+
+    struct SRequest
+    {
+      RequestType type;
+      std::string path;
+      std::string mask;
+      int flags;
+    };
+
+    struct SEntry
+    {
+      SRequest request;
+      RequestState state;
+      bool discard;
+      bool result;
+      int statResult;
+      struct __stat64 stat;
+      std::shared_ptr<CFileItemList> items;
+    };
+
+    struct SHost
+    {
+      std::deque<std::string> queued;   ///< keys of queued requests, the next one first
+      unsigned int running;
+    };
+
+    friend class CDirectoryPrefetchJob;
+
+    void Prefetch(RequestType type, const std::vector<std::string> &paths, size_t first, const std::string &mask, int flags);
+    bool Take(RequestType type, const std::string &path, SEntry &entry);
+    void Dispatch();
+
+    static std::string GetKey(RequestType type, const std::string &path);
+    static std::string GetHost(const std::string &path);
+
+    CCriticalSection m_critSection;
+    XbmcThreads::ConditionVariable m_changed;
+    std::map<std::string, SEntry> m_entries;
+    std::map<std::string, SHost> m_hosts;
+    unsigned int m_connections;
+    unsigned int m_running;
+    unsigned int m_hits;
+    unsigned int m_misses;
+  };
+}
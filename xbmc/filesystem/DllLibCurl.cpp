@@ -21,6 +21,7 @@
 #include "threads/SystemClock.h"
 #include "system.h"
 #include "DllLibCurl.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 
@@ -67,6 +68,15 @@ static long g_curlReferences = 0;
 static unsigned int g_curlTimeout = 0;
 #endif
 
+/* how long to wait for a free slot when a host has reached its connection limit */
+#define HOST_SLOT_TIMEOUT 5000
+
+DllLibCurlGlobal::DllLibCurlGlobal()
+  : m_share(NULL)
+  , m_stats()
+{
+}
+
 bool DllLibCurlGlobal::Load()
 {
   CSingleLock lock(m_critSection);
@@ -91,6 +101,8 @@ bool DllLibCurlGlobal::Load()
   /* check idle will clean up the last one */
   g_curlReferences = 2;
 
+  CreateShare();
+
 #if defined(HAS_CURL_STATIC)
   // Initialize ssl locking array
   m_sslLockArray = new CCriticalSection*[CRYPTO_num_locks()];
@@ -112,6 +124,8 @@ void DllLibCurlGlobal::Unload()
     if (!IsLoaded())
       return;
 
+    DestroyShare();
+
     // close libcurl
     global_cleanup();
 
@@ -145,6 +159,7 @@ void DllLibCurlGlobal::CheckIdle()
   /* 20 seconds idle time before closing handle */
   const unsigned int idletime = 30000;
 
+  bool closed = false;
   VEC_CURLSESSIONS::iterator it = m_sessions.begin();
   while(it != m_sessions.end())
   {
@@ -162,11 +177,20 @@ void DllLibCurlGlobal::CheckIdle()
       Unload();
 
       it = m_sessions.erase(it);
+      closed = true;
       continue;
     }
     ++it;
   }
 
+  if (closed)
+  {
+    STransportStats stats = GetTransportStats();
+    CLog::Log(LOGDEBUG, "%s - Transport stats: %" PRIu64 " requests, %.0f%% reused connections, %" PRIu64 " http/2, ttfb avg %.0f ms max %.0f ms, %" PRIu64 " host waits",
+              __FUNCTION__, stats.requests, stats.GetReuseRatio() * 100.0, stats.http2Requests,
+              stats.GetAverageTTFB() * 1000.0, stats.ttfbMax * 1000.0, stats.hostWaits);
+  }
+
   /* check if we should unload the dll */
 #if(0) // we never unload libcurl, since libssl can break when python unloads then
   if(g_curlReferences == 1 && XbmcThreads::SystemClockMillis() - g_curlTimeout > idletime)
@@ -180,6 +204,27 @@ void DllLibCurlGlobal::easy_aquire(const char *protocol, const char *hostname, C
 
   CSingleLock lock(m_critSection);
 
+  /* limit the number of concurrent requests to a single host, if we run out */
+  /* of slots wait a bit for one to be released but never block for good    */
+  /* streams (acquired with a multi handle) hold their session as long as   */
+  /* they are read, they are neither limited nor counted                    */
+  bool streaming = multi_handle != NULL;
+  unsigned int limit = g_advancedSettings.m_curlMaxHostConnections;
+  if (!streaming && limit > 0 && GetBusySessions(protocol, hostname) >= limit)
+  {
+    {
+      CSingleLock statsLock(m_statsSection);
+      m_stats.hostWaits++;
+    }
+
+    XbmcThreads::EndTime timeout(HOST_SLOT_TIMEOUT);
+    while (GetBusySessions(protocol, hostname) >= limit && !timeout.IsTimePast())
+      m_sessionReleased.wait(m_critSection, timeout.MillisLeft());
+
+    if (GetBusySessions(protocol, hostname) >= limit)
+      CLog::Log(LOGDEBUG, "%s - No free slot for %s://%s after %d ms, exceeding limit of %u", __FUNCTION__, protocol, hostname, HOST_SLOT_TIMEOUT, limit);
+  }
+
   VEC_CURLSESSIONS::iterator it;
   for(it = m_sessions.begin(); it != m_sessions.end(); ++it)
   {
@@ -190,6 +235,7 @@ void DllLibCurlGlobal::easy_aquire(const char *protocol, const char *hostname, C
       if( it->m_protocol.compare(protocol) == 0 && it->m_hostname.compare(hostname) == 0)
       {
         it->m_busy = true;
+        it->m_streaming = streaming;
         if(easy_handle)
         {
           if(!it->m_easy)
@@ -213,6 +259,7 @@ void DllLibCurlGlobal::easy_aquire(const char *protocol, const char *hostname, C
 
   SSession session = {};
   session.m_busy = true;
+  session.m_streaming = streaming;
   session.m_protocol = protocol;
   session.m_hostname = hostname;
 
@@ -268,7 +315,9 @@ void DllLibCurlGlobal::easy_release(CURL_HANDLE** easy_handle, CURLM** multi_han
       /* will reset verbose too so it won't print that it closed connections on cleanup*/
       easy_reset(easy);
       it->m_busy = false;
+      it->m_streaming = false;
       it->m_idletimestamp = XbmcThreads::SystemClockMillis();
+      m_sessionReleased.notifyAll();
       return;
     }
   }
@@ -326,3 +375,103 @@ void DllLibCurlGlobal::easy_duplicate(CURL_HANDLE* easy, CURLM* multi, CURL_HAND
   }
   return;
 }
+
+unsigned int DllLibCurlGlobal::GetBusySessions(const char *protocol, const char *hostname)
+{
+  CSingleLock lock(m_critSection);
+
+  unsigned int busy = 0;
+  for (VEC_CURLSESSIONS::const_iterator it = m_sessions.begin(); it != m_sessions.end(); ++it)
+  {
+    if (it->m_busy && !it->m_streaming &&
+        it->m_protocol.compare(protocol) == 0 && it->m_hostname.compare(hostname) == 0)
+      busy++;
+  }
+  return busy;
+}
+
+bool DllLibCurlGlobal::CreateShare()
+{
+  m_share = share_init();
+  if (!m_share)
+  {
+    CLog::Log(LOGWARNING, "%s - Unable to create shared curl cache", __FUNCTION__);
+    return false;
+  }
+
+  share_setopt(m_share, CURLSHOPT_LOCKFUNC, share_lock);
+  share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+  share_setopt(m_share, CURLSHOPT_USERDATA, this);
+
+  /* connections are not shared, curl doesn't support using a shared connection */
+  /* cache from concurrent threads. they are kept alive by the session instead  */
+  share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  return true;
+}
+
+void DllLibCurlGlobal::DestroyShare()
+{
+  if (m_share)
+    share_cleanup(m_share);
+  m_share = NULL;
+}
+
+void DllLibCurlGlobal::share_lock(CURL_HANDLE *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+  DllLibCurlGlobal* global = static_cast<DllLibCurlGlobal*>(userptr);
+  if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+    global->m_shareLocks[data].lock();
+}
+
+void DllLibCurlGlobal::share_unlock(CURL_HANDLE *handle, curl_lock_data data, void *userptr)
+{
+  DllLibCurlGlobal* global = static_cast<DllLibCurlGlobal*>(userptr);
+  if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+    global->m_shareLocks[data].unlock();
+}
+
+void DllLibCurlGlobal::TrackTransfer(CURL_HANDLE* easy_handle)
+{
+  if (!easy_handle)
+    return;
+
+  long connects = 0;
+  double ttfb = 0.0;
+  if (easy_getinfo(easy_handle, CURLINFO_NUM_CONNECTS, &connects) != CURLE_OK
+   || easy_getinfo(easy_handle, CURLINFO_STARTTRANSFER_TIME, &ttfb) != CURLE_OK)
+    return;
+
+  /* nothing received, the transfer never reached the server */
+  if (ttfb <= 0.0)
+    return;
+
+  bool http2 = false;
+#if LIBCURL_VERSION_NUM >= 0x073200 // 7.50.0
+  long version = 0;
+  if (easy_getinfo(easy_handle, CURLINFO_HTTP_VERSION, &version) == CURLE_OK)
+    http2 = version == CURL_HTTP_VERSION_2_0;
+#endif
+
+  CSingleLock lock(m_statsSection);
+  m_stats.requests++;
+  if (connects == 0)
+    m_stats.reusedConnections++;
+  if (http2)
+    m_stats.http2Requests++;
+  m_stats.ttfbTotal += ttfb;
+  if (ttfb > m_stats.ttfbMax)
+    m_stats.ttfbMax = ttfb;
+}
+
+DllLibCurlGlobal::STransportStats DllLibCurlGlobal::GetTransportStats()
+{
+  CSingleLock lock(m_statsSection);
+  return m_stats;
+}
+
+void DllLibCurlGlobal::ResetTransportStats()
+{
+  CSingleLock lock(m_statsSection);
+  m_stats = STransportStats();
+}
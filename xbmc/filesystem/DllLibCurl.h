@@ -20,7 +20,9 @@
  */
 
 #include "DynamicDll.h"
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <vector>
 
@@ -55,6 +57,8 @@ namespace XCURL
     virtual CURLMcode multi_cleanup(CURLM * handle )=0;
     virtual struct curl_slist* slist_append(struct curl_slist *, const char *)=0;
     virtual void  slist_free_all(struct curl_slist *)=0;
+    virtual CURLSH * share_init(void)=0;
+    virtual CURLSHcode share_cleanup(CURLSH *share_handle)=0;
   };
 
   class DllLibCurl : public DllDynamic, DllLibCurlInterface
@@ -81,6 +85,9 @@ namespace XCURL
     DEFINE_METHOD2(struct curl_slist*, slist_append, (struct curl_slist * p1, const char * p2))
     DEFINE_METHOD1(void, slist_free_all, (struct curl_slist * p1))
     DEFINE_METHOD1(const char *, easy_strerror, (CURLcode p1))
+    DEFINE_METHOD0(CURLSH *, share_init)
+    DEFINE_METHOD_FP(CURLSHcode, share_setopt, (CURLSH *p1, CURLSHoption p2, ...))
+    DEFINE_METHOD1(CURLSHcode, share_cleanup, (CURLSH *p1))
 #if defined(HAS_CURL_STATIC)
     DEFINE_METHOD1(void, crypto_set_id_callback, (unsigned long (*p1)(void)))
     DEFINE_METHOD1(void, crypto_set_locking_callback, (void (*p1)(int, int, const char *, int)))
@@ -107,6 +114,9 @@ namespace XCURL
       RESOLVE_METHOD_RENAME(curl_multi_cleanup, multi_cleanup)
       RESOLVE_METHOD_RENAME(curl_slist_append, slist_append)
       RESOLVE_METHOD_RENAME(curl_slist_free_all, slist_free_all)
+      RESOLVE_METHOD_RENAME(curl_share_init, share_init)
+      RESOLVE_METHOD_RENAME_FP(curl_share_setopt, share_setopt)
+      RESOLVE_METHOD_RENAME(curl_share_cleanup, share_cleanup)
 #if defined(HAS_CURL_STATIC)
       RESOLVE_METHOD_RENAME(CRYPTO_set_id_callback, crypto_set_id_callback)
       RESOLVE_METHOD_RENAME(CRYPTO_set_locking_callback, crypto_set_locking_callback)
@@ -118,6 +128,8 @@ namespace XCURL
   class DllLibCurlGlobal : public DllLibCurl
   {
   public:
+    DllLibCurlGlobal();
+
     /* extend interface with buffered functions */
     void easy_aquire(const char *protocol, const char *hostname, CURL_HANDLE** easy_handle, CURLM** multi_handle);
     void easy_release(CURL_HANDLE** easy_handle, CURLM** multi_handle);
@@ -125,6 +137,28 @@ namespace XCURL
     CURL_HANDLE* easy_duphandle(CURL_HANDLE* easy_handle);
     void CheckIdle();
 
+    /* shared dns and tls session cache, set on every handle by SetCommonOptions */
+    CURLSH* GetShareHandle() const { return m_share; }
+
+    /* counters of all transfers done through the session pool */
+    typedef struct STransportStats
+    {
+      uint64_t requests;          // transfers that got a response
+      uint64_t reusedConnections; // transfers served over an already open connection
+      uint64_t http2Requests;     // transfers that negotiated http/2
+      uint64_t hostWaits;         // requests that had to wait for a free slot of a host
+      double   ttfbTotal;         // seconds, sum of the time to first byte of all requests
+      double   ttfbMax;           // seconds
+
+      double GetReuseRatio() const { return requests ? (double)reusedConnections / requests : 0.0; }
+      double GetAverageTTFB() const { return requests ? ttfbTotal / requests : 0.0; }
+    } STransportStats;
+
+    /* account a finished (or started, for streams) transfer of a handle */
+    void TrackTransfer(CURL_HANDLE* easy_handle);
+    STransportStats GetTransportStats();
+    void ResetTransportStats();
+
     /* overloaded load and unload with reference counter */
     virtual bool Load();
     virtual void Unload();
@@ -136,6 +170,7 @@ namespace XCURL
       std::string   m_protocol;
       std::string   m_hostname;
       bool          m_busy;
+      bool          m_streaming;    // busy with a transfer driven through m_multi
       CURL_HANDLE*  m_easy;
       CURLM*        m_multi;
     } SSession;
@@ -144,6 +179,21 @@ namespace XCURL
 
     VEC_CURLSESSIONS m_sessions;
     CCriticalSection m_critSection;
+
+  private:
+    bool CreateShare();
+    void DestroyShare();
+    unsigned int GetBusySessions(const char *protocol, const char *hostname);
+
+    static void share_lock(CURL_HANDLE *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void share_unlock(CURL_HANDLE *handle, curl_lock_data data, void *userptr);
+
+    CURLSH* m_share;
+    CCriticalSection m_shareLocks[CURL_LOCK_DATA_LAST];
+    XbmcThreads::ConditionVariable m_sessionReleased;
+
+    STransportStats m_stats;
+    CCriticalSection m_statsSection;
   };
 }
 
@@ -25,6 +25,7 @@
 #include "URL.h"
 
 #include "CircularCache.h"
+#include "MappedRangeCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "settings/AdvancedSettings.h"
@@ -179,7 +180,13 @@ bool CFileCache::Open(const CURL& url)
 
   if (!m_pCache)
   {
-    if (g_advancedSettings.m_cacheMemSize == 0)
+    if (g_advancedSettings.m_cacheDiskSize > 0)
+    {
+      // Keeps several ranges of the file, so no double buffering is needed
+      m_pCache = new CMappedRangeCache(g_advancedSettings.m_cacheDiskSize);
+      m_forwardCacheSize = g_advancedSettings.m_cacheDiskSize - g_advancedSettings.m_cacheDiskSize / 4;
+    }
+    else if (g_advancedSettings.m_cacheMemSize == 0)
     {
       // Use cache on disk
       m_pCache = new CSimpleFileCache();
@@ -211,7 +218,7 @@ bool CFileCache::Open(const CURL& url)
       m_forwardCacheSize = front;
     }
 
-    if (m_flags & READ_MULTI_STREAM)
+    if ((m_flags & READ_MULTI_STREAM) && g_advancedSettings.m_cacheDiskSize == 0)
     {
       // If READ_MULTI_STREAM flag is set: Double buffering is required
       m_pCache = new CDoubleCache(m_pCache);
@@ -408,6 +415,23 @@ void CFileCache::Process()
 
     m_writePos += iTotalWrite;
 
+    // the cache may already hold the data behind what we wrote (when cached
+    // ranges merge), continue reading the source behind it
+    int64_t cacheEndPos = m_pCache->CachedDataEndPos();
+    if (!m_bStop && iTotalWrite > 0 && cacheEndPos > m_writePos)
+    {
+      if (m_source.Seek(cacheEndPos, SEEK_SET) != cacheEndPos)
+      {
+        CLog::Log(LOGERROR, "CFileCache::Process - Error %d seeking to end of cached data at %" PRId64, (int)GetLastError(), cacheEndPos);
+        m_bStop = true;
+        break;
+      }
+      m_writePos = cacheEndPos;
+      average.Reset(m_writePos, false);
+      limiter.Reset(m_writePos);
+      cacheReachEOF = (m_writePos == m_fileSize);
+    }
+
     // under estimate write rate by a second, to
     // avoid uncertainty at start of caching
     m_writeRateActual = average.Rate(m_writePos, 1000);
@@ -0,0 +1,515 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "threads/SystemClock.h"
+#include "system.h"
+#include "threads/SingleLock.h"
+#include "MappedRangeCache.h"
+#include "SpecialProtocol.h"
+#include "Util.h"
+#include "utils/log.h"
+
+#if defined(TARGET_WINDOWS)
+#include "platform/win32/WIN32Util.h"
+#include "URL.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace XFILE;
+
+CMappedRangeCache::CMappedRangeCache(size_t size)
+ : CCacheStrategy()
+ , m_buf(NULL)
+ , m_size(std::max(size / BLOCK_SIZE, (size_t)4) * BLOCK_SIZE)
+ , m_size_back(m_size / 4)
+ , m_activeStart(0)
+ , m_cur(0)
+ , m_end(0)
+ , m_useCounter(0)
+#ifdef TARGET_WINDOWS
+ , m_hFile(INVALID_HANDLE_VALUE)
+ , m_handle(NULL)
+#endif
+{
+}
+
+CMappedRangeCache::~CMappedRangeCache()
+{
+  Close();
+}
+
+int CMappedRangeCache::Open()
+{
+  Close();
+
+  CSingleLock lock(m_sync);
+
+  m_filename = CSpecialProtocol::TranslatePath(CUtil::GetNextFilename("special://temp/filecache%03d.cache", 999));
+  if (m_filename.empty())
+  {
+    CLog::Log(LOGERROR, "%s - Unable to generate a new filename", __FUNCTION__);
+    return CACHE_RC_ERROR;
+  }
+
+  if (!MapFile())
+  {
+    CLog::LogF(LOGERROR, "failed to map %" PRIuS" bytes of \"%s\"", m_size, m_filename.c_str());
+    UnmapFile();
+    return CACHE_RC_ERROR;
+  }
+
+  size_t slots = m_size / BLOCK_SIZE;
+  m_slots.assign(slots, -1);
+  m_freeSlots.clear();
+  for (size_t slot = slots; slot > 0; slot--)
+    m_freeSlots.push_back(slot - 1);
+
+  ClearRanges();
+  m_activeStart = m_cur = m_end = 0;
+  m_ranges[0] = SRange{ 0, ++m_useCounter };
+
+  return CACHE_RC_OK;
+}
+
+void CMappedRangeCache::Close()
+{
+  CSingleLock lock(m_sync);
+
+  UnmapFile();
+
+  m_slots.clear();
+  m_freeSlots.clear();
+  m_blockSlots.clear();
+  m_ranges.clear();
+}
+
+bool CMappedRangeCache::MapFile()
+{
+#if defined(TARGET_WINDOWS)
+  std::wstring filenameW(CWIN32Util::ConvertPathToWin32Form(CURL(m_filename)));
+  m_hFile = CreateFileW(filenameW.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW,
+                        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+  if (m_hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  ULARGE_INTEGER size;
+  size.QuadPart = m_size;
+  m_handle = CreateFileMapping(m_hFile, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+  if (m_handle == NULL)
+    return false;
+
+  m_buf = (uint8_t*)MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  return m_buf != NULL;
+#else
+  int fd = open(m_filename.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+    return false;
+
+  // the mapping keeps the file alive, nobody needs to see it on disk
+  unlink(m_filename.c_str());
+
+  void* buf = MAP_FAILED;
+  if (ftruncate(fd, m_size) == 0)
+    buf = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (buf == MAP_FAILED)
+    return false;
+
+  m_buf = (uint8_t*)buf;
+  return true;
+#endif
+}
+
+void CMappedRangeCache::UnmapFile()
+{
+#if defined(TARGET_WINDOWS)
+  if (m_buf)
+    UnmapViewOfFile(m_buf);
+  if (m_handle)
+    CloseHandle(m_handle);
+  if (m_hFile != INVALID_HANDLE_VALUE)
+    CloseHandle(m_hFile);
+  m_handle = NULL;
+  m_hFile = INVALID_HANDLE_VALUE;
+#else
+  if (m_buf)
+    munmap(m_buf, m_size);
+#endif
+  m_buf = NULL;
+  m_filename.clear();
+}
+
+void CMappedRangeCache::ClearRanges()
+{
+  for (size_t slot = 0; slot < m_slots.size(); slot++)
+  {
+    if (m_slots[slot] >= 0)
+    {
+      m_slots[slot] = -1;
+      m_freeSlots.push_back(slot);
+    }
+  }
+  m_blockSlots.clear();
+  m_ranges.clear();
+}
+
+CMappedRangeCache::RangeMap::iterator CMappedRangeCache::FindRange(int64_t iFilePosition)
+{
+  // first range starting after the position, the one before may contain it
+  RangeMap::iterator it = m_ranges.upper_bound(iFilePosition);
+  if (it == m_ranges.begin())
+    return m_ranges.end();
+
+  --it;
+  if (iFilePosition <= it->second.end)
+    return it;
+
+  return m_ranges.end();
+}
+
+CMappedRangeCache::RangeMap::iterator CMappedRangeCache::ActiveRange()
+{
+  return m_ranges.find(m_activeStart);
+}
+
+bool CMappedRangeCache::IsBlockUsed(int64_t block, RangeMap::iterator ignore)
+{
+  int64_t blockStart = block * BLOCK_SIZE;
+  int64_t blockEnd = blockStart + BLOCK_SIZE;
+
+  // ranges are disjoint, only the one starting last before the block can reach into it
+  RangeMap::iterator it = m_ranges.upper_bound(blockStart);
+  if (it != m_ranges.begin())
+    --it;
+
+  for (; it != m_ranges.end() && it->first < blockEnd; ++it)
+  {
+    if (it != ignore && it->second.end > it->first && it->second.end > blockStart)
+      return true;
+  }
+  return false;
+}
+
+void CMappedRangeCache::ReleaseBlocks(int64_t start, int64_t end, RangeMap::iterator ignore)
+{
+  if (end <= start)
+    return;
+
+  for (int64_t block = start / BLOCK_SIZE; block <= (end - 1) / BLOCK_SIZE; block++)
+  {
+    std::map<int64_t, size_t>::iterator it = m_blockSlots.find(block);
+    if (it == m_blockSlots.end() || IsBlockUsed(block, ignore))
+      continue;
+
+    m_slots[it->second] = -1;
+    m_freeSlots.push_back(it->second);
+    m_blockSlots.erase(it);
+  }
+}
+
+bool CMappedRangeCache::EvictRange()
+{
+  RangeMap::iterator victim = m_ranges.end();
+  for (RangeMap::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+  {
+    if (it->first == m_activeStart)
+      continue;
+    if (victim == m_ranges.end() || it->second.lastUse < victim->second.lastUse)
+      victim = it;
+  }
+
+  if (victim == m_ranges.end())
+    return false;
+
+  int64_t start = victim->first;
+  int64_t end = victim->second.end;
+  ReleaseBlocks(start, end, victim);
+  m_ranges.erase(victim);
+  return true;
+}
+
+bool CMappedRangeCache::TrimActiveRange()
+{
+  RangeMap::iterator active = ActiveRange();
+  if (active == m_ranges.end())
+    return false;
+
+  // keep the back buffer, only drop whole blocks
+  int64_t keep = std::max(active->first, m_cur - (int64_t)m_size_back);
+  int64_t start = keep - keep % BLOCK_SIZE;
+  if (start <= active->first)
+    return false;
+
+  SRange range = active->second;
+  ReleaseBlocks(active->first, start, active);
+  m_ranges.erase(active);
+  m_ranges[start] = range;
+  m_activeStart = start;
+  return true;
+}
+
+uint8_t* CMappedRangeCache::GetBlock(int64_t block, bool allocate)
+{
+  std::map<int64_t, size_t>::iterator it = m_blockSlots.find(block);
+  if (it != m_blockSlots.end())
+    return m_buf + it->second * BLOCK_SIZE;
+
+  if (!allocate)
+    return NULL;
+
+  while (m_freeSlots.empty())
+  {
+    if (!EvictRange() && !TrimActiveRange())
+      return NULL;
+  }
+
+  size_t slot = m_freeSlots.back();
+  m_freeSlots.pop_back();
+  m_slots[slot] = block;
+  m_blockSlots[block] = slot;
+  return m_buf + slot * BLOCK_SIZE;
+}
+
+size_t CMappedRangeCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
+  CSingleLock lock(m_sync);
+
+  size_t back  = (size_t)(m_cur - m_activeStart);
+  size_t front = (size_t)std::max((int64_t)0, m_end - m_cur);
+
+  // one block is lost when the ranges are not block aligned
+  size_t used = std::min(back, m_size_back) + front + BLOCK_SIZE;
+  size_t limit = used < m_size ? m_size - used : 0;
+
+  return std::min(iRequestSize, limit);
+}
+
+int CMappedRangeCache::WriteToCache(const char *pBuffer, size_t iSize)
+{
+  CSingleLock lock(m_sync);
+
+  if (!m_buf)
+    return CACHE_RC_ERROR;
+
+  size_t written = 0;
+  while (written < iSize)
+  {
+    int64_t block = m_end / BLOCK_SIZE;
+    size_t offset = (size_t)(m_end % BLOCK_SIZE);
+    size_t len = std::min(iSize - written, BLOCK_SIZE - offset);
+
+    uint8_t* data = GetBlock(block, true);
+    if (!data)
+      break;
+
+    memcpy(data + offset, pBuffer + written, len);
+    written += len;
+    m_end += len;
+
+    RangeMap::iterator active = ActiveRange();
+    active->second.end = std::max(active->second.end, m_end);
+    active->second.lastUse = ++m_useCounter;
+
+    // swallow the next range when we reach it
+    RangeMap::iterator next = std::next(active);
+    if (next != m_ranges.end() && next->first <= active->second.end)
+    {
+      active->second.end = std::max(active->second.end, next->second.end);
+      m_ranges.erase(next);
+
+      // the rest of the buffer up to the end of the merged range is cached
+      // already. if that is not all, the writer has to continue its source at
+      // CachedDataEndPos()
+      size_t skip = (size_t)std::min((int64_t)(iSize - written), active->second.end - m_end);
+      written += skip;
+      m_end = active->second.end;
+    }
+  }
+
+  if (written > 0)
+    m_written.Set();
+
+  return written;
+}
+
+int CMappedRangeCache::ReadFromCache(char *pBuffer, size_t iMaxSize)
+{
+  CSingleLock lock(m_sync);
+
+  RangeMap::iterator active = ActiveRange();
+  int64_t avail = active != m_ranges.end() ? active->second.end - m_cur : 0;
+  if (avail <= 0)
+  {
+    if (IsEndOfInput())
+      return 0;
+    else
+      return CACHE_RC_WOULD_BLOCK;
+  }
+
+  size_t offset = (size_t)(m_cur % BLOCK_SIZE);
+  size_t len = std::min((size_t)std::min(avail, (int64_t)iMaxSize), BLOCK_SIZE - offset);
+
+  uint8_t* data = GetBlock(m_cur / BLOCK_SIZE, false);
+  if (!data)
+  {
+    CLog::LogF(LOGERROR, "no block for cached position %" PRId64, m_cur);
+    return CACHE_RC_ERROR;
+  }
+
+  memcpy(pBuffer, data + offset, len);
+  m_cur += len;
+  active->second.lastUse = ++m_useCounter;
+
+  m_space.Set();
+
+  return len;
+}
+
+int64_t CMappedRangeCache::WaitForData(unsigned int iMinAvail, unsigned int iMillis)
+{
+  CSingleLock lock(m_sync);
+
+  RangeMap::iterator active = ActiveRange();
+  int64_t avail = active != m_ranges.end() ? active->second.end - m_cur : 0;
+
+  if (iMillis == 0 || IsEndOfInput())
+    return avail;
+
+  if (iMinAvail > m_size - m_size_back - BLOCK_SIZE)
+    iMinAvail = m_size - m_size_back - BLOCK_SIZE;
+
+  XbmcThreads::EndTime endtime(iMillis);
+  while (!IsEndOfInput() && avail < iMinAvail && !endtime.IsTimePast())
+  {
+    lock.Leave();
+    m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
+    lock.Enter();
+    active = ActiveRange();
+    avail = active != m_ranges.end() ? active->second.end - m_cur : 0;
+  }
+
+  return avail;
+}
+
+int64_t CMappedRangeCache::Seek(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+
+  // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
+  // we try to avoid a (heavy) seek on the source
+  RangeMap::iterator active = ActiveRange();
+  if (active != m_ranges.end() &&
+      iFilePosition >= active->second.end && iFilePosition < active->second.end + 100000)
+  {
+    /* Make everything in the active range back cache, to make sure
+     * there's sufficient forward space
+     */
+    m_cur = active->second.end;
+    lock.Leave();
+    WaitForData((unsigned int)(iFilePosition - m_cur), 5000);
+    lock.Enter();
+    active = ActiveRange();
+  }
+
+  // other ranges need a seek event, so the source continues behind them
+  if (active != m_ranges.end() &&
+      iFilePosition >= active->first && iFilePosition <= active->second.end)
+  {
+    m_cur = iFilePosition;
+    return iFilePosition;
+  }
+
+  return CACHE_RC_ERROR;
+}
+
+bool CMappedRangeCache::Reset(int64_t iSourcePosition, bool clearAnyway)
+{
+  CSingleLock lock(m_sync);
+
+  if (clearAnyway)
+  {
+    ClearRanges();
+    m_activeStart = m_cur = m_end = iSourcePosition;
+    m_ranges[iSourcePosition] = SRange{ iSourcePosition, ++m_useCounter };
+    return true;
+  }
+
+  // forget the old active range if nothing was ever written to it
+  RangeMap::iterator active = ActiveRange();
+  if (active != m_ranges.end() && active->first == active->second.end &&
+      active->first != iSourcePosition)
+    m_ranges.erase(active);
+
+  RangeMap::iterator it = FindRange(iSourcePosition);
+  if (it != m_ranges.end())
+  {
+    m_activeStart = it->first;
+    m_cur = iSourcePosition;
+    m_end = it->second.end;
+    it->second.lastUse = ++m_useCounter;
+    return false;
+  }
+
+  m_activeStart = m_cur = m_end = iSourcePosition;
+  m_ranges[iSourcePosition] = SRange{ iSourcePosition, ++m_useCounter };
+  return true;
+}
+
+int64_t CMappedRangeCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+
+  RangeMap::iterator it = FindRange(iFilePosition);
+  if (it != m_ranges.end())
+    return it->second.end;
+  return iFilePosition;
+}
+
+int64_t CMappedRangeCache::CachedDataEndPos()
+{
+  CSingleLock lock(m_sync);
+
+  return m_end;
+}
+
+bool CMappedRangeCache::IsCachedPosition(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+
+  return FindRange(iFilePosition) != m_ranges.end();
+}
+
+size_t CMappedRangeCache::GetRangeCount()
+{
+  CSingleLock lock(m_sync);
+
+  return m_ranges.size();
+}
+
+CCacheStrategy *CMappedRangeCache::CreateNew()
+{
+  return new CMappedRangeCache(m_size);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+namespace XFILE {
+
+/*!
+ * \brief Cache strategy keeping several cached ranges of a file in a memory
+ * mapped temporary file.
+ *
+ * The backing file is split into fixed size blocks which are assigned to
+ * blocks of the source file on demand. The cached byte ranges are kept in an
+ * index ordered by position, so seeking back into data that was already
+ * downloaded does not need to hit the source again. When the budget is used
+ * up the least recently used range is dropped. The range currently being read
+ * and written is the active one, it is never dropped but may lose data behind
+ * the read position.
+ */
+class CMappedRangeCache : public CCacheStrategy
+{
+public:
+  CMappedRangeCache(size_t size);
+  virtual ~CMappedRangeCache();
+
+  virtual int Open() override;
+  virtual void Close() override;
+
+  virtual size_t GetMaxWriteSize(const size_t& iRequestSize) override;
+  virtual int WriteToCache(const char *pBuffer, size_t iSize) override;
+  virtual int ReadFromCache(char *pBuffer, size_t iMaxSize) override;
+  virtual int64_t WaitForData(unsigned int iMinAvail, unsigned int iMillis) override;
+
+  virtual int64_t Seek(int64_t iFilePosition) override;
+  virtual bool Reset(int64_t iSourcePosition, bool clearAnyway=true) override;
+
+  virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition) override;
+  virtual int64_t CachedDataEndPos() override;
+  virtual bool IsCachedPosition(int64_t iFilePosition) override;
+
+  virtual CCacheStrategy *CreateNew() override;
+
+  /*!
+   \brief Number of disjoint ranges currently cached
+   */
+  size_t GetRangeCount();
+
+  static const size_t BLOCK_SIZE = 256 * 1024;
+
+protected:
+  struct SRange
+  {
+    int64_t end;
+    unsigned int lastUse;
+  };
+  typedef std::map<int64_t, SRange> RangeMap;
+
+  RangeMap::iterator FindRange(int64_t iFilePosition);
+  RangeMap::iterator ActiveRange();
+  uint8_t* GetBlock(int64_t block, bool allocate);
+  bool IsBlockUsed(int64_t block, RangeMap::iterator ignore);
+  void ReleaseBlocks(int64_t start, int64_t end, RangeMap::iterator ignore);
+  bool EvictRange();
+  bool TrimActiveRange();
+  void ClearRanges();
+
+  bool MapFile();
+  void UnmapFile();
+
+  std::string m_filename;
+  uint8_t* m_buf;
+  size_t m_size;        /**< bytes of the backing file, multiple of BLOCK_SIZE */
+  size_t m_size_back;   /**< bytes behind the read position kept in the active range */
+
+  std::vector<int64_t> m_slots;             /**< source block stored in each slot, -1 if unused */
+  std::vector<size_t> m_freeSlots;
+  std::map<int64_t, size_t> m_blockSlots;   /**< source block to slot */
+
+  RangeMap m_ranges;     /**< cached ranges by start position */
+  int64_t m_activeStart; /**< start of the range the reader and writer are in */
+  int64_t m_cur;         /**< current reading position */
+  int64_t m_end;         /**< current writing position */
+  unsigned int m_useCounter;
+
+  CCriticalSection m_sync;
+  CEvent m_written;
+#ifdef TARGET_WINDOWS
+  HANDLE m_hFile;
+  HANDLE m_handle;
+#endif
+};
+
+} // namespace XFILE
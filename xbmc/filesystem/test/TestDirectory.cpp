@@ -19,6 +19,7 @@
  */
 
 #include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
 #include "filesystem/SpecialProtocol.h"
 #include "FileItem.h"
 #include "utils/URIUtils.h"
@@ -65,3 +66,62 @@ TEST(TestDirectory, CreateRecursive)
   EXPECT_TRUE(XFILE::CDirectory::Create(path2));
   EXPECT_TRUE(XFILE::CDirectory::RemoveRecursive(path1));
 }
+
+TEST(TestDirectory, CacheHitSharesItems)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList listing;
+  listing.Add(CFileItemPtr(new CFileItem("/cache/a.avi", false)));
+  listing.Add(CFileItemPtr(new CFileItem("/cache/b.avi", false)));
+  cache.SetDirectory("/cache/", listing, XFILE::DIR_CACHE_ALWAYS);
+
+  CFileItemList first, second;
+  EXPECT_TRUE(cache.GetDirectory("/cache/", first));
+  EXPECT_TRUE(cache.GetDirectory("/cache/", second));
+  ASSERT_EQ(2, first.Size());
+
+  // both hits hand out the cached items instead of copies
+  EXPECT_EQ(first.Peek(0).get(), second.Peek(0).get());
+
+  // the filter passes of GetDirectory only read the items
+  XFILE::CDirectory::FilterFileDirectories(first, "");
+  EXPECT_EQ(first.Peek(0).get(), second.Peek(0).get());
+  EXPECT_EQ(first.Peek(1).get(), second.Peek(1).get());
+
+  // an item is copied once it is handed out to be changed
+  EXPECT_NE(first[0].get(), second.Peek(0).get());
+  EXPECT_EQ(first.Peek(1).get(), second.Peek(1).get());
+}
+
+TEST(TestDirectory, CacheHitShownWithoutCopies)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList listing;
+  CFileItemPtr b(new CFileItem("/cache/b.avi", false));
+  b->SetLabel("b.avi");
+  listing.Add(b);
+  CFileItemPtr a(new CFileItem("/cache/a.avi", false));
+  a->SetLabel("a");
+  listing.Add(a);
+  cache.SetDirectory("/cache/", listing, XFILE::DIR_CACHE_ALWAYS);
+
+  CFileItemList first, second;
+  EXPECT_TRUE(cache.GetDirectory("/cache/", first));
+  EXPECT_TRUE(cache.GetDirectory("/cache/", second));
+
+  // the cache filled in the icons already, and sorting by label doesn't
+  // change the sort labels of the items
+  first.FillInDefaultIcons();
+  first.Sort(SortByLabel, SortOrderAscending);
+  EXPECT_EQ("a", first.Peek(0)->GetLabel());
+  EXPECT_FALSE(first.Peek(0)->GetIconImage().empty());
+  EXPECT_EQ(first.Peek(0).get(), second.Peek(1).get());
+  EXPECT_EQ(first.Peek(1).get(), second.Peek(0).get());
+
+  // only the item that has an extension to remove is copied
+  first.RemoveExtensions();
+  EXPECT_EQ(first.Peek(0).get(), second.Peek(1).get());
+  EXPECT_NE(first.Peek(1).get(), second.Peek(0).get());
+  EXPECT_EQ("b", first.Peek(1)->GetLabel());
+  EXPECT_EQ("b.avi", second.Peek(0)->GetLabel());
+}
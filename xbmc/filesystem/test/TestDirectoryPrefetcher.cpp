@@ -0,0 +1,138 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/Directory.h"
+#include "filesystem/DirectoryPrefetcher.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "FileItem.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace XFILE;
+
+class TestDirectoryPrefetcher : public ::testing::Test
+{
+protected:
+  std::string root;
+  std::vector<std::string> folders;
+  std::vector<std::string> noMediaFiles;
+  CDirectoryPrefetcher prefetcher;
+
+  // root/a/.nomedia, root/b/ and root/c/
+  void SetUp() override
+  {
+    root = URIUtils::AddFileToFolder(CSpecialProtocol::TranslatePath("special://temp/"), "TestDirectoryPrefetcher");
+    URIUtils::AddSlashAtEnd(root);
+    for (const char *name : { "a", "b", "c" })
+    {
+      std::string folder = URIUtils::AddFileToFolder(root, name);
+      URIUtils::AddSlashAtEnd(folder);
+      ASSERT_TRUE(CDirectory::Create(folder));
+      folders.push_back(folder);
+      noMediaFiles.push_back(URIUtils::AddFileToFolder(folder, ".nomedia"));
+    }
+
+    CFile file;
+    ASSERT_TRUE(file.OpenForWrite(noMediaFiles[0], true));
+    file.Close();
+
+    // enough connections to run every request right away, requests still
+    // queued when they are asked for are fetched by the caller
+    prefetcher.SetConnections(8);
+  }
+
+  void TearDown() override
+  {
+    prefetcher.Reset();
+    CDirectory::RemoveRecursive(root);
+  }
+};
+
+TEST_F(TestDirectoryPrefetcher, Hit)
+{
+  prefetcher.PrefetchDirectories(folders, 0, "");
+  prefetcher.PrefetchExists(noMediaFiles, 0);
+
+  CFileItemList items;
+  EXPECT_TRUE(prefetcher.GetDirectory(folders[0], items, ""));
+  EXPECT_EQ(1, items.Size());
+  EXPECT_TRUE(prefetcher.Exists(noMediaFiles[0]));
+  EXPECT_FALSE(prefetcher.Exists(noMediaFiles[1]));
+  EXPECT_EQ(3u, prefetcher.GetHits());
+  EXPECT_EQ(0u, prefetcher.GetMisses());
+}
+
+TEST_F(TestDirectoryPrefetcher, Miss)
+{
+  prefetcher.PrefetchExists(noMediaFiles, 0);
+
+  // not prefetched at all
+  CFileItemList items;
+  EXPECT_TRUE(prefetcher.GetDirectory(folders[0], items, ""));
+  EXPECT_EQ(1, items.Size());
+
+  // a result is only handed out once
+  EXPECT_TRUE(prefetcher.Exists(noMediaFiles[0]));
+  EXPECT_TRUE(prefetcher.Exists(noMediaFiles[0]));
+
+  EXPECT_EQ(1u, prefetcher.GetHits());
+  EXPECT_EQ(2u, prefetcher.GetMisses());
+}
+
+TEST_F(TestDirectoryPrefetcher, Discard)
+{
+  prefetcher.PrefetchDirectories(folders, 0, "");
+  prefetcher.PrefetchExists(noMediaFiles, 0);
+
+  // drops the listing and the .nomedia request of the folder, running or not
+  prefetcher.Discard(folders[0]);
+
+  CFileItemList items;
+  EXPECT_TRUE(prefetcher.GetDirectory(folders[0], items, ""));
+  EXPECT_TRUE(prefetcher.Exists(noMediaFiles[0]));
+  EXPECT_EQ(0u, prefetcher.GetHits());
+  EXPECT_EQ(2u, prefetcher.GetMisses());
+
+  // the other folders are left alone
+  EXPECT_FALSE(prefetcher.Exists(noMediaFiles[1]));
+  EXPECT_EQ(1u, prefetcher.GetHits());
+}
+
+TEST_F(TestDirectoryPrefetcher, Reset)
+{
+  prefetcher.PrefetchDirectories(folders, 0, "");
+  prefetcher.PrefetchExists(noMediaFiles, 0);
+  EXPECT_TRUE(prefetcher.Exists(noMediaFiles[0]));
+
+  prefetcher.Reset();
+  EXPECT_EQ(0u, prefetcher.GetHits());
+  EXPECT_EQ(0u, prefetcher.GetMisses());
+
+  CFileItemList items;
+  EXPECT_TRUE(prefetcher.GetDirectory(folders[1], items, ""));
+  EXPECT_FALSE(prefetcher.Exists(noMediaFiles[1]));
+  EXPECT_EQ(0u, prefetcher.GetHits());
+  EXPECT_EQ(2u, prefetcher.GetMisses());
+}
@@ -0,0 +1,173 @@
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "filesystem/MappedRangeCache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+static const size_t BLOCK = CMappedRangeCache::BLOCK_SIZE;
+
+class TestMappedRangeCache : public ::testing::Test
+{
+protected:
+  TestMappedRangeCache() : cache(8 * BLOCK)
+  {
+    for (size_t i = 0; i < sizeof(source); i++)
+      source[i] = (char)(i * 7 + i / 251);
+  }
+
+  // write source data at the current write position, like CFileCache does
+  void Fill(int64_t from, size_t len)
+  {
+    size_t done = 0;
+    while (done < len)
+    {
+      int written = cache.WriteToCache(source + from + done, len - done);
+      ASSERT_GT(written, 0);
+      done += written;
+    }
+  }
+
+  void Check(int64_t from, size_t len)
+  {
+    std::vector<char> buf(len);
+    size_t done = 0;
+    while (done < len)
+    {
+      int read = cache.ReadFromCache(buf.data() + done, len - done);
+      ASSERT_GT(read, 0);
+      done += read;
+    }
+    EXPECT_EQ(0, memcmp(buf.data(), source + from, len));
+  }
+
+  CMappedRangeCache cache;
+  char source[32 * 256 * 1024];
+};
+
+TEST_F(TestMappedRangeCache, ReadWrite)
+{
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(0, BLOCK + 1000);
+  EXPECT_EQ((int64_t)(BLOCK + 1000), cache.CachedDataEndPos());
+  EXPECT_EQ((int64_t)(BLOCK + 1000), cache.WaitForData(0, 0));
+  Check(0, BLOCK + 1000);
+
+  char c;
+  EXPECT_EQ(CACHE_RC_WOULD_BLOCK, cache.ReadFromCache(&c, 1));
+  cache.EndOfInput();
+  EXPECT_EQ(0, cache.ReadFromCache(&c, 1));
+}
+
+TEST_F(TestMappedRangeCache, KeepsRanges)
+{
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(0, 1000);
+  EXPECT_TRUE(cache.Reset(3 * BLOCK + 10, false));
+  Fill(3 * BLOCK + 10, 2000);
+  EXPECT_EQ(2u, cache.GetRangeCount());
+
+  // the first range is still cached, but needs a seek event to become active
+  EXPECT_TRUE(cache.IsCachedPosition(500));
+  EXPECT_EQ(1000, cache.CachedDataEndPosIfSeekTo(500));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(500));
+  EXPECT_FALSE(cache.Reset(500, false));
+  EXPECT_EQ(1000, cache.CachedDataEndPos());
+  Check(500, 500);
+
+  EXPECT_FALSE(cache.IsCachedPosition(BLOCK));
+  EXPECT_EQ((int64_t)BLOCK, cache.CachedDataEndPosIfSeekTo(BLOCK));
+}
+
+TEST_F(TestMappedRangeCache, MergesRanges)
+{
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  EXPECT_TRUE(cache.Reset(BLOCK, false));
+  Fill(BLOCK, BLOCK);
+  EXPECT_TRUE(cache.Reset(100, false));
+  Fill(100, BLOCK);
+  EXPECT_EQ(1u, cache.GetRangeCount());
+  EXPECT_EQ((int64_t)(2 * BLOCK), cache.CachedDataEndPosIfSeekTo(100));
+  // writing continues behind the merged range
+  EXPECT_EQ((int64_t)(2 * BLOCK), cache.CachedDataEndPos());
+  Check(100, 2 * BLOCK - 100);
+
+  Fill(2 * BLOCK, 1000);
+  EXPECT_EQ((int64_t)(2 * BLOCK + 1000), cache.CachedDataEndPos());
+  Check(2 * BLOCK, 1000);
+}
+
+TEST_F(TestMappedRangeCache, MergesRangesWithinWrite)
+{
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  EXPECT_TRUE(cache.Reset(1000, false));
+  Fill(1000, 1000);
+  EXPECT_TRUE(cache.Reset(0, false));
+
+  // one write covering the whole next range, only the part behind it is new
+  EXPECT_EQ(3000, cache.WriteToCache(source, 3000));
+  EXPECT_EQ(1u, cache.GetRangeCount());
+  EXPECT_EQ(3000, cache.CachedDataEndPos());
+  Check(0, 3000);
+}
+
+TEST_F(TestMappedRangeCache, EvictsLeastRecentlyUsed)
+{
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(0, 2 * BLOCK);
+  EXPECT_TRUE(cache.Reset(10 * BLOCK, false));
+  Fill(10 * BLOCK, 2 * BLOCK);
+  EXPECT_TRUE(cache.Reset(20 * BLOCK, false));
+
+  // reading along the active range needs the space of the older ranges
+  for (int i = 0; i < 6; i++)
+  {
+    Fill(20 * BLOCK + i * BLOCK, BLOCK);
+    Check(20 * BLOCK + i * BLOCK, BLOCK);
+  }
+  EXPECT_FALSE(cache.IsCachedPosition(0));
+  EXPECT_TRUE(cache.IsCachedPosition(25 * BLOCK));
+  EXPECT_GT(cache.GetMaxWriteSize(BLOCK), 0u);
+}
+
+TEST_F(TestMappedRangeCache, ForwardLimit)
+{
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  size_t writable = cache.GetMaxWriteSize(16 * BLOCK);
+  EXPECT_LT(writable, 8 * BLOCK);
+  Fill(0, writable);
+  EXPECT_EQ(0u, cache.GetMaxWriteSize(BLOCK));
+
+  // only a quarter of the cache is kept behind the read position
+  Check(0, 3 * BLOCK);
+  EXPECT_GT(cache.GetMaxWriteSize(BLOCK), 0u);
+}
@@ -28,6 +28,7 @@
 #include "GraphicContext.h"
 #include "system.h"
 #include "Texture.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
 #include "threads/SystemClock.h"
 #include "URL.h"
@@ -224,6 +225,8 @@ void CTextureMap::Add(CBaseTexture* texture, int delay)
 /*                                                                      */
 /************************************************************************/
 CGUITextureManager::CGUITextureManager(void)
+  : m_textureBytes(0)
+  , m_unusedBytes(0)
 {
   // we set the theme bundle to be the first bundle (thus prioritizing it)
   m_TexBundle[0].SetThemeBundle(true);
@@ -266,14 +269,10 @@ bool CGUITextureManager::HasTexture(const std::string &textureName, std::string
 
   // Check our loaded and bundled textures - we store in bundles using \\.
   std::string bundledName = CTextureBundle::Normalize(textureName);
-  for (int i = 0; i < (int)m_vecTextures.size(); ++i)
+  if (m_textures.find(textureName) != m_textures.end())
   {
-    CTextureMap *pMap = m_vecTextures[i];
-    if (pMap->GetName() == textureName)
-    {
-      if (size) *size = 1;
-      return true;
-    }
+    if (size) *size = 1;
+    return true;
   }
 
   for (int i = 0; i < 2; i++)
@@ -307,28 +306,22 @@ const CTextureArray& CGUITextureManager::Load(const std::string& strTextureName,
 
   if (size) // we found the texture
   {
-    for (int i = 0; i < (int)m_vecTextures.size(); ++i)
-    {
-      CTextureMap *pMap = m_vecTextures[i];
-      if (pMap->GetName() == strTextureName)
-      {
-        //CLog::Log(LOGDEBUG, "Total memusage %u", GetMemoryUsage());
-        return pMap->GetTexture();
-      }
-    }
+    TextureMap::iterator i = m_textures.find(strTextureName);
+    if (i != m_textures.end())
+      return i->second->GetTexture();
     // Whoops, not there.
     return emptyTexture;
   }
 
-  for (ilistUnused i = m_unusedTextures.begin(); i != m_unusedTextures.end(); ++i)
+  std::unordered_map<std::string, UnusedTextures::iterator>::iterator unused = m_unusedByName.find(strTextureName);
+  if (unused != m_unusedByName.end())
   {
-    CTextureMap* pMap = i->first;
-    if (pMap->GetName() == strTextureName && i->second > 0)
-    {
-      m_vecTextures.push_back(pMap);
-      m_unusedTextures.erase(i);
-      return pMap->GetTexture();
-    }
+    CTextureMap* pMap = unused->second->map;
+    m_unusedBytes -= pMap->GetMemoryUsage();
+    m_unusedTextures.erase(unused->second);
+    m_unusedByName.erase(unused);
+    AddTexture(pMap);
+    return pMap->GetTexture();
   }
 
   if (checkBundleOnly && bundle == -1)
@@ -373,7 +366,7 @@ const CTextureArray& CGUITextureManager::Load(const std::string& strTextureName,
     delete[] pTextures;
     delete[] Delay;
 
-    m_vecTextures.push_back(pMap);
+    AddTexture(pMap);
     return pMap->GetTexture();
   }
   else if (StringUtils::EndsWithNoCase(strPath, ".gif") ||
@@ -430,7 +423,7 @@ const CTextureArray& CGUITextureManager::Load(const std::string& strTextureName,
 
     file.Close();
 
-    m_vecTextures.push_back(pMap);
+    AddTexture(pMap);
     return pMap->GetTexture();
   }
 
@@ -457,7 +450,7 @@ const CTextureArray& CGUITextureManager::Load(const std::string& strTextureName,
 
   CTextureMap* pMap = new CTextureMap(strTextureName, width, height, 0);
   pMap->Add(pTexture, 100);
-  m_vecTextures.push_back(pMap);
+  AddTexture(pMap);
 
 #ifdef _DEBUG_TEXTURES
   int64_t end, freq;
@@ -476,42 +469,71 @@ void CGUITextureManager::ReleaseTexture(const std::string& strTextureName, bool
 {
   CSingleLock lock(g_graphicsContext);
 
-  ivecTextures i;
-  i = m_vecTextures.begin();
-  while (i != m_vecTextures.end())
+  TextureMap::iterator i = m_textures.find(strTextureName);
+  if (i == m_textures.end())
   {
-    CTextureMap* pMap = *i;
-    if (pMap->GetName() == strTextureName)
-    {
-      if (pMap->Release())
-      {
-        //CLog::Log(LOGINFO, "  cleanup:%s", strTextureName.c_str());
-        // add to our textures to free
-        m_unusedTextures.push_back(std::make_pair(pMap, immediately ? 0 : XbmcThreads::SystemClockMillis()));
-        i = m_vecTextures.erase(i);
-      }
-      return;
-    }
-    ++i;
+    CLog::Log(LOGWARNING, "%s: Unable to release texture %s", __FUNCTION__, strTextureName.c_str());
+    return;
   }
-  CLog::Log(LOGWARNING, "%s: Unable to release texture %s", __FUNCTION__, strTextureName.c_str());
+
+  CTextureMap* pMap = i->second;
+  if (pMap->Release())
+  {
+    //CLog::Log(LOGINFO, "  cleanup:%s", strTextureName.c_str());
+    // add to our textures to free
+    m_textures.erase(i);
+    m_textureBytes -= pMap->GetMemoryUsage();
+
+    UnusedTexture unused = { pMap, immediately ? 0 : XbmcThreads::SystemClockMillis() };
+    UnusedTextures::iterator it = m_unusedTextures.insert(m_unusedTextures.end(), unused);
+    m_unusedBytes += pMap->GetMemoryUsage();
+    if (unused.releaseTime > 0)
+      m_unusedByName[strTextureName] = it;
+  }
+}
+
+void CGUITextureManager::AddTexture(CTextureMap* pMap)
+{
+  m_textures[pMap->GetName()] = pMap;
+  m_textureBytes += pMap->GetMemoryUsage();
+}
+
+void CGUITextureManager::FreeUnusedTexture(UnusedTextures::iterator i)
+{
+  std::unordered_map<std::string, UnusedTextures::iterator>::iterator unused = m_unusedByName.find(i->map->GetName());
+  if (unused != m_unusedByName.end() && unused->second == i)
+    m_unusedByName.erase(unused);
+
+  m_unusedBytes -= i->map->GetMemoryUsage();
+  delete i->map;
+  m_unusedTextures.erase(i);
 }
 
 void CGUITextureManager::FreeUnusedTextures(unsigned int timeDelay)
 {
   unsigned int currFrameTime = XbmcThreads::SystemClockMillis();
   CSingleLock lock(g_graphicsContext);
-  for (ilistUnused i = m_unusedTextures.begin(); i != m_unusedTextures.end();)
+  for (UnusedTextures::iterator i = m_unusedTextures.begin(); i != m_unusedTextures.end();)
   {
-    if (currFrameTime - i->second >= timeDelay)
-    {
-      delete i->first;
-      i = m_unusedTextures.erase(i);
-    }
+    if (currFrameTime - i->releaseTime >= timeDelay)
+      FreeUnusedTexture(i++);
     else
       ++i;
   }
 
+  // keep the released textures within budget, dropping the ones unused the longest
+  uint64_t budget = (uint64_t)g_advancedSettings.m_guiUnusedTextureMemory * 1024 * 1024;
+  if (budget > 0 && m_unusedBytes > budget)
+  {
+    unsigned int freed = 0;
+    while (m_unusedBytes > budget && !m_unusedTextures.empty())
+    {
+      FreeUnusedTexture(m_unusedTextures.begin());
+      freed++;
+    }
+    CLog::Log(LOGDEBUG, "%s: freed %u released textures to stay within %u MB", __FUNCTION__, freed, g_advancedSettings.m_guiUnusedTextureMemory);
+  }
+
 #if defined(HAS_GL) || defined(HAS_GLES)
   for (unsigned int i = 0; i < m_unusedHwTextures.size(); ++i)
   {
@@ -537,15 +559,13 @@ void CGUITextureManager::Cleanup()
 {
   CSingleLock lock(g_graphicsContext);
 
-  ivecTextures i;
-  i = m_vecTextures.begin();
-  while (i != m_vecTextures.end())
+  for (TextureMap::iterator i = m_textures.begin(); i != m_textures.end(); ++i)
   {
-    CTextureMap* pMap = *i;
-    CLog::Log(LOGWARNING, "%s: Having to cleanup texture %s", __FUNCTION__, pMap->GetName().c_str());
-    delete pMap;
-    i = m_vecTextures.erase(i);
+    CLog::Log(LOGWARNING, "%s: Having to cleanup texture %s", __FUNCTION__, i->first.c_str());
+    delete i->second;
   }
+  m_textures.clear();
+  m_textureBytes = 0;
   m_TexBundle[0].Close();
   m_TexBundle[1].Close();
   m_TexBundle[0] = CTextureBundle(true);
@@ -555,13 +575,13 @@ void CGUITextureManager::Cleanup()
 
 void CGUITextureManager::Dump() const
 {
-  CLog::Log(LOGDEBUG, "%s: total texturemaps size:%" PRIuS, __FUNCTION__, m_vecTextures.size());
+  CLog::Log(LOGDEBUG, "%s: total texturemaps size:%" PRIuS ", %" PRIu64 " bytes, %" PRIuS " released textures, %" PRIu64 " bytes",
+            __FUNCTION__, m_textures.size(), m_textureBytes, m_unusedTextures.size(), m_unusedBytes);
 
-  for (int i = 0; i < (int)m_vecTextures.size(); ++i)
+  for (TextureMap::const_iterator i = m_textures.begin(); i != m_textures.end(); ++i)
   {
-    const CTextureMap* pMap = m_vecTextures[i];
-    if (!pMap->IsEmpty())
-      pMap->Dump();
+    if (!i->second->IsEmpty())
+      i->second->Dump();
   }
 }
 
@@ -569,16 +589,15 @@ void CGUITextureManager::Flush()
 {
   CSingleLock lock(g_graphicsContext);
 
-  ivecTextures i;
-  i = m_vecTextures.begin();
-  while (i != m_vecTextures.end())
+  for (TextureMap::iterator i = m_textures.begin(); i != m_textures.end(); )
   {
-    CTextureMap* pMap = *i;
+    CTextureMap* pMap = i->second;
     pMap->Flush();
     if (pMap->IsEmpty() )
     {
+      m_textureBytes -= pMap->GetMemoryUsage();
       delete pMap;
-      i = m_vecTextures.erase(i);
+      i = m_textures.erase(i);
     }
     else
     {
@@ -589,12 +608,19 @@ void CGUITextureManager::Flush()
 
 unsigned int CGUITextureManager::GetMemoryUsage() const
 {
-  unsigned int memUsage = 0;
-  for (int i = 0; i < (int)m_vecTextures.size(); ++i)
-  {
-    memUsage += m_vecTextures[i]->GetMemoryUsage();
-  }
-  return memUsage;
+  return (unsigned int)m_textureBytes;
+}
+
+CGUITextureManager::Stats CGUITextureManager::GetStats() const
+{
+  CSingleLock lock(g_graphicsContext);
+
+  Stats stats;
+  stats.liveTextures = m_textures.size();
+  stats.liveBytes = m_textureBytes;
+  stats.unusedTextures = m_unusedTextures.size();
+  stats.unusedBytes = m_unusedBytes;
+  return stats;
 }
 
 void CGUITextureManager::SetTexturePath(const std::string &texturePath)
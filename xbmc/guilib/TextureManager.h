@@ -25,6 +25,8 @@
 #pragma once
 
 #include <list>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -104,6 +106,14 @@ protected:
 class CGUITextureManager
 {
 public:
+  struct Stats
+  {
+    unsigned int liveTextures;   ///< textures in use by controls
+    uint64_t liveBytes;
+    unsigned int unusedTextures; ///< released textures kept around in case they are used again
+    uint64_t unusedBytes;
+  };
+
   CGUITextureManager(void);
   virtual ~CGUITextureManager(void);
 
@@ -122,14 +132,33 @@ public:
   void SetTexturePath(const std::string &texturePath);    ///< Set a single path as the path to check when loading media (clear then add)
   void RemoveTexturePath(const std::string &texturePath); ///< Remove a path from the paths to check when loading media
 
-  void FreeUnusedTextures(unsigned int timeDelay = 0); ///< Free textures (called from app thread only)
+  /*! \brief Free released textures (called from app thread only)
+   \param timeDelay free the textures released at least this many ms ago.
+   The least recently released ones are freed as well while the released textures take up more than
+   the memory budget set by the gui/unusedtexturememory advanced setting.
+   */
+  void FreeUnusedTextures(unsigned int timeDelay = 0);
   void ReleaseHwTexture(unsigned int texture);
+
+  Stats GetStats() const;
 protected:
-  std::vector<CTextureMap*> m_vecTextures;
-  std::list<std::pair<CTextureMap*, unsigned int> > m_unusedTextures;
+  struct UnusedTexture
+  {
+    CTextureMap* map;
+    unsigned int releaseTime; ///< 0 if it was released immediately and can't be reused
+  };
+  typedef std::unordered_map<std::string, CTextureMap*> TextureMap;
+  typedef std::list<UnusedTexture> UnusedTextures;
+
+  void AddTexture(CTextureMap* pMap);
+  void FreeUnusedTexture(UnusedTextures::iterator i);
+
+  TextureMap m_textures;                  ///< textures in use, by name
+  uint64_t m_textureBytes;
+  UnusedTextures m_unusedTextures;        ///< released textures, the least recently released first
+  std::unordered_map<std::string, UnusedTextures::iterator> m_unusedByName; ///< the ones that can be reused
+  uint64_t m_unusedBytes;
   std::vector<unsigned int> m_unusedHwTextures;
-  typedef std::vector<CTextureMap*>::iterator ivecTextures;
-  typedef std::list<std::pair<CTextureMap*, unsigned int> >::iterator ilistUnused;
   // we have 2 texture bundles (one for the base textures, one for the theme)
   CTextureBundle m_TexBundle[2];
 
@@ -20,6 +20,8 @@
 
 #include "AnnouncementManager.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include <iterator>
 #include <stdio.h>
 #include "utils/log.h"
 #include "utils/Variant.h"
@@ -31,12 +33,14 @@
 #include "pvr/channels/PVRChannel.h"
 #include "PlayListPlayer.h"
 #include "ServiceBroker.h"
+#include "settings/AdvancedSettings.h"
 
 #define LOOKUP_PROPERTY "database-lookup"
 
 using namespace ANNOUNCEMENT;
 
-CAnnouncementManager::CAnnouncementManager() : CThread("Announce")
+CAnnouncementManager::CAnnouncementManager() : CThread("Announce"),
+  m_iQueuedBarriers(0)
 {
 }
 
@@ -117,13 +121,94 @@ void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, c
   if (item != nullptr)
     announcement.item = CFileItemPtr(new CFileItem(*item));
 
+  if (g_advancedSettings.m_jsonAnnouncementCoalesceTime > 0)
+    announcement.key = GetCoalesceKey(announcement);
+  announcement.time = XbmcThreads::SystemClockMillis();
+
   {
-    CSingleLock lock (m_critSection);
-    m_announcementQueue.push_back(announcement);
+    CSingleLock lock (m_queueCritSection);
+    if (announcement.key.empty())
+    {
+      m_announcementQueue.push_back(std::move(announcement));
+      m_iQueuedBarriers++;
+
+      // later updates must not be merged into the ones that go out before this
+      m_heldUpdates.clear();
+    }
+    else
+    {
+      auto held = m_heldUpdates.find(announcement.key);
+      if (held != m_heldUpdates.end())
+      {
+        // the update that is still queued goes out with the latest data, fields
+        // that only the held update has (e.g. playcount) are kept
+        if (announcement.item != nullptr)
+          held->second->item = std::move(announcement.item);
+
+        CVariant &heldData = held->second->data;
+        if (heldData.isObject() && announcement.data.isObject())
+        {
+          for (CVariant::iterator_map field = announcement.data.begin_map(); field != announcement.data.end_map(); ++field)
+            heldData[field->first] = std::move(field->second);
+        }
+        else
+          heldData = std::move(announcement.data);
+        return;
+      }
+
+      m_announcementQueue.push_back(std::move(announcement));
+      m_heldUpdates[m_announcementQueue.back().key] = std::prev(m_announcementQueue.end());
+    }
   }
   m_queueEvent.Set();
 }
 
+std::string CAnnouncementManager::GetCoalesceKey(const CAnnounceData &announcement)
+{
+  if (announcement.message != "OnUpdate")
+    return "";
+
+  std::string key = StringUtils::Format("%d|%s|", announcement.flag, announcement.sender.c_str());
+  if (announcement.item != nullptr)
+    return key + "item|" + announcement.item->GetPath() + "|" + announcement.item->GetLabel();
+
+  const CVariant &data = announcement.data;
+  if (data.isObject() && data.isMember("type") && data.isMember("id"))
+    return key + data["type"].asString() + "|" + data["id"].asString();
+
+  return "";
+}
+
+int CAnnouncementManager::TakeDueAnnouncements(AnnouncementQueue &announcements)
+{
+  CSingleLock lock (m_queueCritSection);
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  unsigned int coalesceTime = g_advancedSettings.m_jsonAnnouncementCoalesceTime;
+
+  while (!m_announcementQueue.empty())
+  {
+    const CAnnounceData &announcement = m_announcementQueue.front();
+    if (announcement.key.empty())
+      m_iQueuedBarriers--;
+    else
+    {
+      // an update is held back until its time is up or something that was
+      // announced after it has to go out
+      unsigned int age = now - announcement.time;
+      if (m_iQueuedBarriers == 0 && age < coalesceTime)
+        return coalesceTime - age;
+
+      auto held = m_heldUpdates.find(announcement.key);
+      if (held != m_heldUpdates.end() && held->second == m_announcementQueue.begin())
+        m_heldUpdates.erase(held);
+    }
+
+    announcements.splice(announcements.end(), m_announcementQueue, m_announcementQueue.begin());
+  }
+
+  return -1;
+}
+
 void CAnnouncementManager::DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
   CLog::Log(LOGDEBUG, "CAnnouncementManager - Announcement: %s from %s", message, sender);
@@ -289,20 +374,19 @@ void CAnnouncementManager::Process()
 
   while (!m_bStop)
   {
-    CSingleLock lock (m_critSection);
-    if (!m_announcementQueue.empty())
-    {
-      auto announcement = m_announcementQueue.front();
-      m_announcementQueue.pop_front();
-      {
-        CSingleExit ex(m_critSection);
-        DoAnnounce(announcement.flag, announcement.sender.c_str(), announcement.message.c_str(), announcement.item, announcement.data);
-      }
-    }
-    else
-    {
-      CSingleExit ex(m_critSection);
+    // send everything that is due in one go, without holding up Announce()
+    AnnouncementQueue announcements;
+    int wait = TakeDueAnnouncements(announcements);
+
+    for (auto &announcement : announcements)
+      DoAnnounce(announcement.flag, announcement.sender.c_str(), announcement.message.c_str(), announcement.item, announcement.data);
+
+    if (!announcements.empty())
+      continue;
+
+    if (wait < 0)
       m_queueEvent.Wait();
-    }
+    else
+      m_queueEvent.WaitMSec(wait);
   }
 }
@@ -18,6 +18,8 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <list>
+#include <unordered_map>
 #include <vector>
 
 #include "IAnnouncer.h"
@@ -31,6 +33,15 @@ class CVariant;
 
 namespace ANNOUNCEMENT
 {
+  /*!
+   \brief Hands the announcements to the announcers on its own thread.
+
+   Announce() only queues the announcement, so the caller never waits for
+   the announcers. OnUpdate announcements of the same item that come in
+   within the time set in advancedsettings.xml are sent only once, with the
+   data of the latest one. They are held back for that time, but are never
+   sent after any announcement that was made later.
+   */
   class CAnnouncementManager : public CThread
   {
   public:
@@ -64,14 +75,30 @@ namespace ANNOUNCEMENT
       std::string message;
       CFileItemPtr item;
       CVariant data;
+      std::string key;    ///< identifies the item of an update that can be coalesced, empty otherwise
+      unsigned int time;  ///< when the announcement was queued
     };
-    std::list<CAnnounceData> m_announcementQueue;
+    typedef std::list<CAnnounceData> AnnouncementQueue;
+
+    static std::string GetCoalesceKey(const CAnnounceData &announcement);
+
+    /*!
+     \brief Take the announcements that are due from the queue
+     \param announcements The announcements are moved to the end of this
+     \return The ms until the next held back update is due, or -1 if the queue is empty
+     */
+    int TakeDueAnnouncements(AnnouncementQueue &announcements);
+
+    AnnouncementQueue m_announcementQueue;
+    std::unordered_map<std::string, AnnouncementQueue::iterator> m_heldUpdates;  ///< the queued updates by item
+    unsigned int m_iQueuedBarriers;  ///< queued announcements that can't be coalesced, the updates before them are due
     CEvent m_queueEvent;
 
   private:
     CAnnouncementManager(const CAnnouncementManager&);
     CAnnouncementManager const& operator=(CAnnouncementManager const&);
 
+    CCriticalSection m_queueCritSection;  ///< guards the queue, never held while announcing
     CCriticalSection m_critSection;
     std::vector<IAnnouncer *> m_announcers;
   };
@@ -18,6 +18,9 @@
  *
  */
 
+#include <algorithm>
+#include <climits>
+
 #include "AudioLibrary.h"
 #include "music/MusicDatabase.h"
 #include "FileItem.h"
@@ -282,8 +285,19 @@ JSONRPC_STATUS CAudioLibrary::GetAlbumDetails(const std::string &method, ITransp
 
 JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
-  CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  // the songs are read in batches while they are written to the response
+  struct SongsQuery
+  {
+    CMusicDatabase musicdatabase;
+    CMusicDatabase detailsdatabase; // musicdatabase holds the rows of the query
+    CMusicDatabase::CSongsCursor cursor;
+    SortDescription sorting;
+    CVariant parameters;
+    CFileItemList songs;
+    int next = 0;
+  };
+  std::shared_ptr<SongsQuery> query(new SongsQuery);
+  if (!query->musicdatabase.Open() || !query->detailsdatabase.Open())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -346,18 +360,47 @@ JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLaye
   std::set<std::string> additionalProperties;
   bool artistData = CheckForAdditionalProperties(parameterObject["properties"], checkProperties, additionalProperties);
  
-  CFileItemList items;
-  if (!musicdatabase.GetSongsFullByWhere(musicUrl.ToString(), CDatabase::Filter(), items, sorting, artistData, false))
-    return InternalError; 
+  if (!query->musicdatabase.OpenSongsFullByWhere(musicUrl.ToString(), CDatabase::Filter(), query->cursor, sorting, artistData))
+    return InternalError;
 
-  JSONRPC_STATUS ret = GetAdditionalSongDetails(parameterObject, items, musicdatabase);
-  if (ret != OK)
-    return ret;
+  query->sorting = sorting;
+  query->parameters = parameterObject;
 
-  int size = items.Size();
-  if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
-    size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
+  // songs that are only in order once sorted are all read at once
+  int batchSize = query->cursor.sortItems ? INT_MAX : 50;
+  FileItemSource songs = [query, batchSize](CFileItemPtr &item)
+  {
+    if (query->next >= query->songs.Size())
+    {
+      query->songs.Clear();
+      query->next = 0;
+
+      CFileItemPtr song;
+      while (query->songs.Size() < batchSize)
+      {
+        if (!query->musicdatabase.GetNextSong(query->cursor, song))
+          return false;
+        if (song == NULL)
+          break;
+        query->songs.Add(song);
+      }
+
+      if (query->cursor.sortItems)
+        query->songs.Sort(query->sorting);
+
+      JSONRPC_STATUS ret = GetAdditionalSongDetails(query->parameters, query->songs, query->detailsdatabase);
+      query->detailsdatabase.Close();
+      if (ret != OK)
+        return false;
+    }
+
+    item.reset();
+    if (query->next < query->songs.Size())
+      item = query->songs.Get(query->next++);
+    return true;
+  };
+  if (!HandleFileItemSource("songid", true, "songs", songs, parameterObject, result, std::max(query->cursor.total, 0), transport))
+    return InternalError;
 
   return OK;
 }
@@ -250,6 +250,71 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
   delete thumbLoader;
 }
 
+bool CFileItemHandler::HandleFileItemSource(const char *ID, bool allowFile, const char *resultname, const FileItemSource &source, const CVariant &parameterObject, CVariant &result, int size, ITransportLayer *transport)
+{
+  int start, end;
+  HandleLimits(parameterObject, result, size, start, end);
+
+  // an empty list doesn't get a member in the result
+  CFileItemPtr item;
+  if (!source(item))
+    return false;
+  if (item == NULL)
+    return true;
+
+  std::shared_ptr<CThumbLoader> thumbLoader;
+  if (item->HasVideoInfoTag())
+    thumbLoader.reset(new CVideoThumbLoader());
+  else if (item->HasMusicInfoTag())
+    thumbLoader.reset(new CMusicThumbLoader());
+
+  if (thumbLoader != NULL)
+    thumbLoader->OnLoaderStart();
+
+  std::set<std::string> fields;
+  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
+  {
+    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
+      fields.insert(field->asString());
+  }
+
+  HandleFileItem(ID, allowFile, resultname, item, parameterObject, fields, result, true, thumbLoader.get());
+
+  // the parameters only live as long as the request
+  CVariant parameters(parameterObject);
+  ITransportLayer::ItemSource items = [ID, allowFile, source, parameters, fields, thumbLoader](CVariant &object, bool &done)
+  {
+    CFileItemPtr item;
+    if (!source(item))
+      return false;
+
+    if (item == NULL)
+      done = true;
+    else
+    {
+      CVariant list;
+      HandleFileItem(ID, allowFile, "items", item, parameters, fields, list, false, thumbLoader.get());
+      object = std::move(list["items"]);
+    }
+    return true;
+  };
+
+  if (transport != NULL && transport->StreamItems(resultname, items))
+    return true;
+
+  while (true)
+  {
+    CVariant object;
+    bool done = false;
+    if (!items(object, done))
+      return false;
+    if (done)
+      return true;
+
+    result[resultname].append(std::move(object));
+  }
+}
+
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */, CThumbLoader *thumbLoader /* = NULL */)
 {
   std::set<std::string> fields;
@@ -19,6 +19,7 @@
  *
  */
 
+#include <functional>
 #include <set>
 
 #include "JSONRPC.h"
@@ -33,9 +34,22 @@ namespace JSONRPC
   class CFileItemHandler : public CJSONUtils
   {
   protected:
+    /*!
+     \brief Sets item to the next item of a list or to an empty item once
+     there are no more items. Returns false if the item couldn't be read.
+     */
+    typedef std::function<bool(CFileItemPtr &item)> FileItemSource;
+
     static void FillDetails(const ISerializable *info, const CFileItemPtr &item, std::set<std::string> &fields, CVariant &result, CThumbLoader *thumbLoader = NULL);
     static void HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit = true);
     static void HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit = true);
+    /*!
+     \brief Like HandleFileItemList() for the items of an already sorted and
+     limited query that are read one at a time. If the transport supports it,
+     the items after the first one are only read while the response is sent.
+     \return false if an item couldn't be read.
+     */
+    static bool HandleFileItemSource(const char *ID, bool allowFile, const char *resultname, const FileItemSource &source, const CVariant &parameterObject, CVariant &result, int size, ITransportLayer *transport);
     static void HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append = true, CThumbLoader *thumbLoader = NULL);
     static void HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const std::set<std::string> &validFields, CVariant &result, bool append = true, CThumbLoader *thumbLoader = NULL);
 
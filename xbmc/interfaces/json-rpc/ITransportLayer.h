@@ -19,6 +19,7 @@
  *
  */
 
+#include <functional>
 #include <string>
 
 class CVariant;
@@ -38,9 +39,22 @@ namespace JSONRPC
   class ITransportLayer
   {
   public:
+    /*!
+     \brief Produces the next item of a list, sets done instead once there
+     are no more items. Returns false if the item couldn't be produced.
+     */
+    typedef std::function<bool(CVariant &item, bool &done)> ItemSource;
+
     virtual ~ITransportLayer() { };
     virtual bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) = 0;
     virtual bool Download(const char *path, CVariant &result) = 0;
     virtual int GetCapabilities() = 0;
+
+    /*!
+     \brief Let the transport write the remaining items of result[member]
+     while the response is sent instead of adding them to the result.
+     \return false if the items have to be added to the result.
+     */
+    virtual bool StreamItems(const std::string &member, const ItemSource &source) { return false; }
   };
 }
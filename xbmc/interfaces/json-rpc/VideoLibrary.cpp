@@ -18,6 +18,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "VideoLibrary.h"
 #include "messaging/ApplicationMessenger.h"
 #include "TextureDatabase.h"
@@ -34,8 +36,9 @@ using namespace KODI::MESSAGING;
 
 JSONRPC_STATUS CVideoLibrary::GetMovies(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
-  CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  // the movies are read while they are written to the response
+  std::shared_ptr<CVideoDatabase> videodatabase(new CVideoDatabase);
+  if (!videodatabase->Open())
     return InternalError;
 
   SortDescription sorting;
@@ -78,15 +81,25 @@ JSONRPC_STATUS CVideoLibrary::GetMovies(const std::string &method, ITransportLay
     videoUrl.AddOption("xsp", xsp);
   }
 
-  // setID must not be -1 otherwise GetMoviesNav() will return sets
-  if (setID < 0)
-    setID = 0;
+  if (genreID > 0)
+    videoUrl.AddOption("genreid", genreID);
+  else if (year > 0)
+    videoUrl.AddOption("year", year);
+  else if (setID > 0)
+    videoUrl.AddOption("setid", setID);
 
-  CFileItemList items;
-  if (!videodatabase.GetMoviesNav(videoUrl.ToString(), items, genreID, year, -1, -1, -1, -1, setID, -1, sorting, RequiresAdditionalDetails(MediaTypeMovie, parameterObject)))
+  std::shared_ptr<CVideoDatabase::CItemsCursor> cursor(new CVideoDatabase::CItemsCursor);
+  if (!videodatabase->OpenMoviesByWhere(videoUrl.ToString(), CDatabase::Filter(), *cursor, sorting, RequiresAdditionalDetails(MediaTypeMovie, parameterObject)))
     return InvalidParams;
 
-  return HandleItems("movieid", "movies", items, parameterObject, result, false);
+  FileItemSource movies = [videodatabase, cursor](CFileItemPtr &item)
+  {
+    return videodatabase->GetNextMovie(*cursor, item);
+  };
+  if (!HandleFileItemSource("movieid", true, "movies", movies, parameterObject, result, std::max(cursor->total, 0), transport))
+    return InvalidParams;
+
+  return OK;
 }
 
 JSONRPC_STATUS CVideoLibrary::GetMovieDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
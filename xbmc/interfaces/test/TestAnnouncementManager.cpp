@@ -0,0 +1,170 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/AnnouncementManager.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+using namespace ANNOUNCEMENT;
+
+namespace
+{
+
+class CTestAnnouncer : public IAnnouncer
+{
+public:
+  virtual void Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+  {
+    CSingleLock lock(m_critSection);
+    m_messages.push_back(message);
+    m_data.push_back(data);
+    if (m_messages.size() >= m_expected)
+      m_event.Set();
+  }
+
+  // wait until the given number of announcements came in
+  bool WaitFor(size_t count, unsigned int timeoutMs = 5000)
+  {
+    XbmcThreads::EndTime timeout(timeoutMs);
+    while (true)
+    {
+      {
+        CSingleLock lock(m_critSection);
+        m_expected = count;
+        if (m_messages.size() >= m_expected)
+          return true;
+      }
+      if (timeout.IsTimePast() || !m_event.WaitMSec(timeout.MillisLeft()))
+        return Count() >= count;
+    }
+  }
+
+  size_t Count()
+  {
+    CSingleLock lock(m_critSection);
+    return m_messages.size();
+  }
+
+  CCriticalSection m_critSection;
+  CEvent m_event;
+  size_t m_expected = 0;
+  std::vector<std::string> m_messages;
+  std::vector<CVariant> m_data;
+};
+
+CVariant GetUpdate(const char *type, int id, int revision)
+{
+  CVariant data;
+  data["type"] = type;
+  data["id"] = id;
+  data["revision"] = revision;
+  return data;
+}
+
+}
+
+class TestAnnouncementManager : public testing::Test
+{
+protected:
+  TestAnnouncementManager()
+  {
+    m_coalesceTime = g_advancedSettings.m_jsonAnnouncementCoalesceTime;
+    g_advancedSettings.m_jsonAnnouncementCoalesceTime = 200;
+    m_manager.AddAnnouncer(&m_announcer);
+    m_manager.Start();
+  }
+
+  ~TestAnnouncementManager()
+  {
+    m_manager.Deinitialize();
+    g_advancedSettings.m_jsonAnnouncementCoalesceTime = m_coalesceTime;
+  }
+
+  unsigned int m_coalesceTime;
+  CAnnouncementManager m_manager;
+  CTestAnnouncer m_announcer;
+};
+
+TEST_F(TestAnnouncementManager, Coalesce)
+{
+  for (int revision = 0; revision < 100; revision++)
+  {
+    for (int id = 0; id < 10; id++)
+      m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", GetUpdate("movie", id, revision));
+  }
+
+  ASSERT_TRUE(m_announcer.WaitFor(10));
+  EXPECT_FALSE(m_announcer.WaitFor(11, 500));
+  ASSERT_EQ(10U, m_announcer.Count());
+
+  // every item is announced once, with the latest data and in the order of the first update
+  for (int id = 0; id < 10; id++)
+  {
+    EXPECT_EQ(id, m_announcer.m_data[id]["id"].asInteger());
+    EXPECT_EQ(99, m_announcer.m_data[id]["revision"].asInteger());
+  }
+}
+
+TEST_F(TestAnnouncementManager, CoalesceKeepsFields)
+{
+  CVariant watched = GetUpdate("movie", 1, 0);
+  watched["playcount"] = 1;
+  watched["transaction"] = true;
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", watched);
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", GetUpdate("movie", 1, 1));
+
+  ASSERT_TRUE(m_announcer.WaitFor(1));
+  EXPECT_FALSE(m_announcer.WaitFor(2, 500));
+  EXPECT_EQ(1, m_announcer.m_data[0]["revision"].asInteger());
+  EXPECT_EQ(1, m_announcer.m_data[0]["playcount"].asInteger());
+  EXPECT_TRUE(m_announcer.m_data[0]["transaction"].asBoolean());
+}
+
+TEST_F(TestAnnouncementManager, Order)
+{
+  m_manager.Announce(VideoLibrary, "xbmc", "OnScanStarted");
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", GetUpdate("movie", 1, 0));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", GetUpdate("movie", 1, 1));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnRemove", GetUpdate("movie", 1, 2));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnUpdate", GetUpdate("movie", 1, 3));
+  m_manager.Announce(VideoLibrary, "xbmc", "OnScanFinished");
+
+  ASSERT_TRUE(m_announcer.WaitFor(5));
+  std::vector<std::string> expected = { "OnScanStarted", "OnUpdate", "OnRemove", "OnUpdate", "OnScanFinished" };
+  EXPECT_TRUE(m_announcer.m_messages == expected);
+  EXPECT_EQ(1, m_announcer.m_data[1]["revision"].asInteger());
+  EXPECT_EQ(3, m_announcer.m_data[3]["revision"].asInteger());
+}
+
+TEST_F(TestAnnouncementManager, Disabled)
+{
+  g_advancedSettings.m_jsonAnnouncementCoalesceTime = 0;
+  for (int revision = 0; revision < 10; revision++)
+    m_manager.Announce(AudioLibrary, "xbmc", "OnUpdate", GetUpdate("song", 1, revision));
+
+  ASSERT_TRUE(m_announcer.WaitFor(10));
+  for (int revision = 0; revision < 10; revision++)
+    EXPECT_EQ(revision, m_announcer.m_data[revision]["revision"].asInteger());
+}
@@ -68,6 +68,8 @@
 #include "dbwrappers/dataset.h"
 #include "utils/XMLUtils.h"
 
+#include <cmath>
+
 using namespace XFILE;
 using namespace MUSICDATABASEDIRECTORY;
 using namespace KODI::MESSAGING;
@@ -657,49 +659,64 @@ int CMusicDatabase::AddSong(const int idAlbum,
     URIUtils::Split(strPathAndFileName, strPath, strFileName);
     int idPath = AddPath(strPath);
 
+    // the scanner adds songs one by one, so the statements are compiled once and rebound
+    dbiplus::StatementPtr stmt;
     if (!strMusicBrainzTrackID.empty())
-      strSQL = PrepareSQL("SELECT * FROM song WHERE idAlbum = %i AND strMusicBrainzTrackID = '%s'",
-                          idAlbum,
-                          strMusicBrainzTrackID.c_str());
+    {
+      stmt = m_pDB->get_statement("SELECT idSong FROM song WHERE idAlbum = ? AND strMusicBrainzTrackID = ?");
+      stmt->bind_int(1, idAlbum);
+      stmt->bind_string(2, strMusicBrainzTrackID);
+    }
     else
-      strSQL = PrepareSQL("SELECT * FROM song WHERE idAlbum=%i AND strFileName='%s' AND strTitle='%s' AND iTrack=%i AND strMusicBrainzTrackID IS NULL",
-                          idAlbum,
-                          strFileName.c_str(),
-                          strTitle.c_str(),
-                          iTrack);
+    {
+      stmt = m_pDB->get_statement("SELECT idSong FROM song WHERE idAlbum = ? AND strFileName = ? AND strTitle = ? AND iTrack = ? AND strMusicBrainzTrackID IS NULL");
+      stmt->bind_int(1, idAlbum);
+      stmt->bind_string(2, strFileName);
+      stmt->bind_string(3, strTitle);
+      stmt->bind_int(4, iTrack);
+    }
+    strSQL = stmt->get_sql();
 
-    if (!m_pDS->query(strSQL))
+    if (!m_pDS->query(*stmt))
       return -1;
 
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
-      strSQL=PrepareSQL("INSERT INTO song ("
-                                          "idSong,idAlbum,idPath,strArtists,strGenres,"
-                                          "strTitle,iTrack,iDuration,iYear,strFileName,"
-                                          "strMusicBrainzTrackID,iTimesPlayed,iStartOffset,"
-                                          "iEndOffset,lastplayed,rating,userrating,votes,comment,mood"
-                        ") values (NULL, %i, %i, '%s', '%s', '%s', %i, %i, %i, '%s'",
-                    idAlbum,
-                    idPath,
-                    artistString.c_str(),
-                    StringUtils::Join(genres, g_advancedSettings.m_musicItemSeparator).c_str(),
-                    strTitle.c_str(),
-                    iTrack, iDuration, iYear,
-                    strFileName.c_str());
-
+      stmt = m_pDB->get_statement("INSERT INTO song ("
+                                    "idSong,idAlbum,idPath,strArtists,strGenres,"
+                                    "strTitle,iTrack,iDuration,iYear,strFileName,"
+                                    "strMusicBrainzTrackID,iTimesPlayed,iStartOffset,"
+                                    "iEndOffset,lastplayed,rating,userrating,votes,comment,mood"
+                                  ") values (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+      stmt->bind_int(1, idAlbum);
+      stmt->bind_int(2, idPath);
+      stmt->bind_string(3, artistString);
+      stmt->bind_string(4, StringUtils::Join(genres, g_advancedSettings.m_musicItemSeparator));
+      stmt->bind_string(5, strTitle);
+      stmt->bind_int(6, iTrack);
+      stmt->bind_int(7, iDuration);
+      stmt->bind_int(8, iYear);
+      stmt->bind_string(9, strFileName);
       if (strMusicBrainzTrackID.empty())
-        strSQL += PrepareSQL(",NULL");
+        stmt->bind_null(10);
       else
-        strSQL += PrepareSQL(",'%s'", strMusicBrainzTrackID.c_str());
-
+        stmt->bind_string(10, strMusicBrainzTrackID);
+      stmt->bind_int(11, iTimesPlayed);
+      stmt->bind_int(12, iStartOffset);
+      stmt->bind_int(13, iEndOffset);
       if (dtLastPlayed.IsValid())
-        strSQL += PrepareSQL(",%i,%i,%i,'%s', %.1f, %i, %i, '%s','%s')",
-                      iTimesPlayed, iStartOffset, iEndOffset, dtLastPlayed.GetAsDBDateTime().c_str(), rating, userrating, votes, strComment.c_str(), strMood.c_str());
+        stmt->bind_string(14, dtLastPlayed.GetAsDBDateTime());
       else
-        strSQL += PrepareSQL(",%i,%i,%i,NULL, %.1f, %i, %i,'%s', '%s')",
-                      iTimesPlayed, iStartOffset, iEndOffset, rating, userrating, votes, strComment.c_str(), strMood.c_str());
-      m_pDS->exec(strSQL);
+        stmt->bind_null(14);
+      // ratings were always stored with one decimal
+      stmt->bind_double(15, std::round(rating * 10) / 10.0);
+      stmt->bind_int(16, userrating);
+      stmt->bind_int(17, votes);
+      stmt->bind_string(18, strComment);
+      stmt->bind_string(19, strMood);
+      strSQL = stmt->get_sql();
+      m_pDS->exec(*stmt);
       idSong = (int)m_pDS->lastinsertid();
     }
     else
@@ -4242,17 +4259,56 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
 }
 
 bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filter &filter, CFileItemList &items, const SortDescription &sortDescription /* = SortDescription() */, bool artistData /* = false*/, bool cueSheetData /* = true*/)
+{
+  unsigned int time = XbmcThreads::SystemClockMillis();
+
+  CSongsCursor cursor;
+  if (!OpenSongsFullByWhere(baseDir, filter, cursor, sortDescription, artistData))
+    return false;
+
+  // Store the total number of songs as a property
+  if (cursor.total >= 0)
+  {
+    items.SetProperty("total", cursor.total);
+    items.Reserve(cursor.total);
+  }
+
+  CFileItemPtr item;
+  while (true)
+  {
+    if (!GetNextSong(cursor, item))
+      return false;
+    if (item == NULL)
+      break;
+    items.Add(item);
+  }
+
+  // Finally do any sorting in items list we have not been able to do before in SQL or dataset,
+  // that is when have join with songartistview and sorting other than random with limit
+  if (cursor.sortItems)
+    items.Sort(sortDescription);
+
+  if (cueSheetData)
+  { // Load some info from embedded cuesheet if present (now only ReplayGain)
+    CueInfoLoader cueLoader;
+    for (int i = 0; i < items.Size(); ++i)
+      cueLoader.Load(LoadCuesheet(items[i]->GetMusicInfoTag()->GetURL()), items[i]);
+  }
+  CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, filter.where.c_str(), XbmcThreads::SystemClockMillis() - time);
+  return true;
+}
+
+bool CMusicDatabase::OpenSongsFullByWhere(const std::string &baseDir, const Filter &filter, CSongsCursor &cursor, const SortDescription &sortDescription /* = SortDescription() */, bool artistData /* = false*/)
 {
   if (m_pDB.get() == NULL || m_pDS.get() == NULL)
     return false;
 
   try
   {
-    unsigned int time = XbmcThreads::SystemClockMillis();
     int total = -1;
 
     Filter extFilter = filter;
-    CMusicDbUrl musicUrl;
+    CMusicDbUrl &musicUrl = cursor.url;
     SortDescription sorting = sortDescription;
     if (!musicUrl.FromString(baseDir) || !GetFilter(musicUrl, extFilter, sorting))
       return false;
@@ -4314,94 +4370,101 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
       return true;
     }
 
-    // Store the total number of songs as a property
-    items.SetProperty("total", total);
+    cursor.total = total;
+    cursor.artistData = artistData;
+    // any sorting that can't be done on the dataset is left to the items
+    cursor.sortItems = artistData && sortDescription.sortBy != SortByNone && !(limitedInSQL && sortDescription.sortBy == SortByRandom);
 
-    DatabaseResults results;
-    results.reserve(iRowsFound);
+    cursor.results.reserve(iRowsFound);
     // Avoid sorting with limits when have join with songartistview 
     // Limit when SortByNone already applied in SQL, 
     // apply sort later to fileitems list rather than dataset
     sorting = sortDescription;
     if (artistData && sortDescription.sortBy != SortByNone)
       sorting.sortBy = SortByNone;
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeSong, m_pDS, results))
+    if (!SortUtils::SortFromDataset(sorting, MediaTypeSong, m_pDS, cursor.results))
       return false;
 
-    // Get songs from returned rows. If join songartistview then there is a row for every artist
-    items.Reserve(total);
+    return true;
+  }
+  catch (...)
+  {
+    // cleanup
+    m_pDS->close();
+    CLog::Log(LOGERROR, "%s(%s) failed", __FUNCTION__, filter.where.c_str());
+  }
+  return false;
+}
+
+bool CMusicDatabase::GetNextSong(CSongsCursor &cursor, CFileItemPtr &item)
+{
+  item.reset();
+  if (m_pDS.get() == NULL)
+    return false;
+
+  try
+  {
+    // If join songartistview then there is a row for every artist
     int songArtistOffset = song_enumCount;
     int songId = -1;
     VECARTISTCREDITS artistCredits;
     const dbiplus::query_data &data = m_pDS->get_result_set().records;
-    int count = 0;
-    for (const auto &i : results)
+    while (cursor.position < cursor.results.size())
     {
-      unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)cursor.results[cursor.position].at(FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
 
       try
       {
         if (songId != record->at(song_idSong).get_asInt())
-        { //New song
-          if (songId > 0 && !artistCredits.empty())
-          {
-            //Store artist credits for previous song
-            GetFileItemFromArtistCredits(artistCredits, items[items.Size() - 1].get());
-            artistCredits.clear();
-          }
+        {
+          // the row belongs to the next song
+          if (item != NULL)
+            break;
+
           songId = record->at(song_idSong).get_asInt();
-          CFileItemPtr item(new CFileItem);
-          GetFileItemFromDataset(record, item.get(), musicUrl);
+          item.reset(new CFileItem);
+          GetFileItemFromDataset(record, item.get(), cursor.url);
           // HACK for sorting by database returned order
-          item->m_iprogramCount = ++count;
-          items.Add(item);
+          item->m_iprogramCount = ++cursor.count;
         }
         // Get song artist credits and contributors
-        if (artistData)
+        if (cursor.artistData)
         {
           int idSongArtistRole = record->at(songArtistOffset + artistCredit_idRole).get_asInt();
           if (idSongArtistRole == ROLE_ARTIST)
             artistCredits.push_back(GetArtistCreditFromDataset(record, songArtistOffset));
           else
-            items[items.Size() - 1]->GetMusicInfoTag()->AppendArtistRole(GetArtistRoleFromDataset(record, songArtistOffset));
+            item->GetMusicInfoTag()->AppendArtistRole(GetArtistRoleFromDataset(record, songArtistOffset));
         }
+        cursor.position++;
       }
       catch (...)
       {
         m_pDS->close();
-        CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
-        return (items.Size() > 0);
+        cursor.position = cursor.results.size();
+        CLog::Log(LOGERROR, "%s: out of memory loading query", __FUNCTION__);
+        return cursor.count > 0;
       }
     }
-    if (!artistCredits.empty())
+
+    if (item != NULL)
     {
-      //Store artist credits for final song
-      GetFileItemFromArtistCredits(artistCredits, items[items.Size() - 1].get());
-      artistCredits.clear();
+      //Store artist credits for the song
+      if (!artistCredits.empty())
+        GetFileItemFromArtistCredits(artistCredits, item.get());
+      return true;
     }
+
     // cleanup
     m_pDS->close();
-
-    // Finally do any sorting in items list we have not been able to do before in SQL or dataset,
-    // that is when have join with songartistview and sorting other than random with limit
-    if (artistData && sortDescription.sortBy != SortByNone && !(limitedInSQL && sortDescription.sortBy == SortByRandom))
-      items.Sort(sortDescription);
-
-    if (cueSheetData)
-    { // Load some info from embedded cuesheet if present (now only ReplayGain)
-      CueInfoLoader cueLoader;
-      for (int i = 0; i < items.Size(); ++i)
-        cueLoader.Load(LoadCuesheet(items[i]->GetMusicInfoTag()->GetURL()), items[i]);
-    }
-    CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, filter.where.c_str(), XbmcThreads::SystemClockMillis() - time);
     return true;
   }
   catch (...)
   {
     // cleanup
     m_pDS->close();
-    CLog::Log(LOGERROR, "%s(%s) failed", __FUNCTION__, filter.where.c_str());
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
   }
   return false;
 }
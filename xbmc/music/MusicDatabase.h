@@ -95,6 +95,18 @@ class CMusicDatabase : public CDatabase
   friend class TestDatabaseUtilsHelper;
 
 public:
+  class CSongsCursor  // the rows of a song query that are turned into items one at a time
+  {
+  public:
+    CMusicDbUrl url;
+    DatabaseResults results;
+    size_t position = 0;
+    bool artistData = false;
+    bool sortItems = false;  // the items still have to be sorted
+    int total = -1;
+    int count = 0;
+  };
+
   CMusicDatabase(void);
   virtual ~CMusicDatabase(void);
 
@@ -394,6 +406,14 @@ public:
   bool GetSongsByYear(const std::string& baseDir, CFileItemList& items, int year);
   bool GetSongsByWhere(const std::string &baseDir, const Filter &filter, CFileItemList& items, const SortDescription &sortDescription = SortDescription());
   bool GetSongsFullByWhere(const std::string &baseDir, const Filter &filter, CFileItemList& items, const SortDescription &sortDescription = SortDescription(), bool artistData = false, bool cueSheetData = false);
+  /*! \brief Run the query of GetSongsFullByWhere() without creating the items yet
+   The rows stay in the dataset until GetNextSong() has read the last one, no
+   other query may be run on this database in between. If sortItems is set in
+   the cursor, the items are only in order once they are sorted.
+   */
+  bool OpenSongsFullByWhere(const std::string &baseDir, const Filter &filter, CSongsCursor &cursor, const SortDescription &sortDescription = SortDescription(), bool artistData = false);
+  /*! \brief Create the item of the next song of a query, item is empty once all songs are read */
+  bool GetNextSong(CSongsCursor &cursor, std::shared_ptr<CFileItem> &item);
   bool GetAlbumsByWhere(const std::string &baseDir, const Filter &filter, CFileItemList &items, const SortDescription &sortDescription = SortDescription(), bool countOnly = false);
   bool GetAlbumsByWhere(const std::string &baseDir, const Filter &filter, VECALBUMS& albums, int& total, const SortDescription &sortDescription = SortDescription(), bool countOnly = false);
   bool GetArtistsByWhere(const std::string& strBaseDir, const Filter &filter, CFileItemList& items, const SortDescription &sortDescription = SortDescription(), bool countOnly = false);
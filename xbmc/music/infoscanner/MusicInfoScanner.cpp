@@ -137,6 +137,9 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
+      // folders are fetched ahead of the scan
+      m_prefetcher.SetConnections(g_advancedSettings.m_iMusicLibraryScanConnections);
+
       bool commit = true;
       for (std::set<std::string>::const_iterator it = m_pathsToScan.begin(); it != m_pathsToScan.end(); ++it)
       {
@@ -253,6 +256,7 @@ void CMusicInfoScanner::Process()
   {
     CLog::Log(LOGERROR, "MusicInfoScanner: Exception while scanning.");
   }
+  m_prefetcher.Reset();
   m_musicDatabase.Close();
   CLog::Log(LOGDEBUG, "%s - Finished scan", __FUNCTION__);
   
@@ -453,7 +457,10 @@ bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
 
   std::set<std::string>::const_iterator it = m_seenPaths.find(strDirectory);
   if (it != m_seenPaths.end())
+  {
+    m_prefetcher.Discard(strDirectory);
     return true;
+  }
 
   m_seenPaths.insert(strDirectory);
 
@@ -461,11 +468,15 @@ bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
   const std::vector<std::string> &regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
   if (IsExcluded(strDirectory, regexps))
+  {
+    m_prefetcher.Discard(strDirectory);
     return true;
+  }
 
   // load subfolder
+  const std::string mask = g_advancedSettings.GetMusicExtensions() + "|.jpg|.tbn|.lrc|.cdg";
   CFileItemList items;
-  CDirectory::GetDirectory(strDirectory, items, g_advancedSettings.GetMusicExtensions() + "|.jpg|.tbn|.lrc|.cdg");
+  m_prefetcher.GetDirectory(strDirectory, items, mask);
 
   // sort and get the path hash.  Note that we don't filter .cue sheet items here as we want
   // to detect changes in the .cue sheet as well.  The .cue sheet items only need filtering
@@ -512,20 +523,25 @@ bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
   }
 
   // now scan the subfolders
+  std::vector<std::string> folders;
   for (int i = 0; i < items.Size(); ++i)
   {
     CFileItemPtr pItem = items[i];
 
-    if (m_bStop)
-      break;
     // if we have a directory item (non-playlist) we then recurse into that folder
     if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+      folders.push_back(pItem->GetPath());
+  }
+
+  for (size_t i = 0; i < folders.size(); ++i)
+  {
+    if (m_bStop)
+      break;
+
+    PrefetchFolders(folders, i, mask);
+    if (!DoScan(folders[i]))
     {
-      std::string strPath=pItem->GetPath();
-      if (!DoScan(strPath))
-      {
-        m_bStop = true;
-      }
+      m_bStop = true;
     }
   }
 
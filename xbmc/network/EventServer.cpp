@@ -46,6 +46,9 @@ using namespace EVENTPACKET;
 using namespace EVENTCLIENT;
 using namespace SOCKETS;
 
+// the most packets that are handled before the events are processed again
+#define MAX_PACKETS_PER_WAKEUP 64
+
 /************************************************************************/
 /* CEventServer                                                         */
 /************************************************************************/
@@ -104,6 +107,8 @@ void CEventServer::StartServer()
 void CEventServer::StopServer(bool bWait)
 {
   CZeroconf::GetInstance()->RemoveService("services.eventserver");
+  m_bStop = true;
+  m_listener.Wake();
   StopThread(bWait);
 }
 
@@ -153,7 +158,6 @@ void CEventServer::Process()
 
 void CEventServer::Run()
 {
-  CSocketListener listener;
   int packetSize = 0;
 
   CLog::Log(LOGNOTICE, "ES: Starting UDP Event server on port %d", m_iPort);
@@ -188,6 +192,13 @@ void CEventServer::Run()
     return;
   }
 
+  // packets are read until the socket runs dry, so it must not block
+  if (!CSocketPoller::SetNonBlocking(m_pSocket->Socket()))
+  {
+    CLog::Log(LOGERROR, "ES: Could not make socket non-blocking");
+    return;
+  }
+
   // publish service
   std::vector<std::pair<std::string, std::string> > txt;
   CZeroconf::GetInstance()->PublishService("servers.eventserver",
@@ -196,8 +207,9 @@ void CEventServer::Run()
                                m_iPort,
                                txt);
 
-  // add our socket to the 'select' listener
-  listener.AddSocket(m_pSocket);
+  // add our socket to the listener
+  m_listener.Clear();
+  m_listener.AddSocket(m_pSocket);
 
   m_bRunning = true;
 
@@ -205,12 +217,16 @@ void CEventServer::Run()
   {
     try
     {
-      // start listening until we timeout
-      if (listener.Listen(m_iListenTimeout))
+      // start listening until we timeout, handle the packets that queued up
+      // in one go but leave the rest for the next round if a client floods us
+      if (m_listener.Listen(m_iListenTimeout))
       {
-        CAddress addr;
-        if ((packetSize = m_pSocket->Read(addr, PACKET_SIZE, (void *)m_pPacketBuffer)) > -1)
+        for (int i = 0; i < MAX_PACKETS_PER_WAKEUP; i++)
         {
+          CAddress addr;
+          if ((packetSize = m_pSocket->Read(addr, PACKET_SIZE, (void *)m_pPacketBuffer)) < 0)
+            break;
+
           ProcessPacket(addr, packetSize);
         }
       }
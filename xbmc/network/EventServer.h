@@ -79,6 +79,7 @@ namespace EVENTSERVER
     std::map<unsigned long, EVENTCLIENT::CEventClient*>  m_clients;
     static CEventServer* m_pInstance;
     SOCKETS::CUDPSocket* m_pSocket;
+    SOCKETS::CSocketListener m_listener;
     int              m_iPort;
     int              m_iListenTimeout;
     int              m_iMaxClients;
@@ -223,11 +223,7 @@ void CSocketListener::AddSocket(CBaseSocket *sock)
   if (sock && sock->Ready())
   {
     m_sockets.push_back(sock);
-    FD_SET(sock->Socket(), &m_fdset);
-#ifndef WINSOCK_VERSION
-    if (sock->Socket() > m_iMaxSockets)
-      m_iMaxSockets = sock->Socket();
-#endif
+    m_poller.Add(sock->Socket(), CSocketPoller::EventRead);
   }
 }
 
@@ -239,75 +235,54 @@ bool CSocketListener::Listen(int timeout)
     throw LISTENEMPTY;
   }
 
-  m_iReadyCount = 0;
   m_iCurrentSocket = 0;
 
-  FD_ZERO(&m_fdset);
-  for (unsigned int i = 0 ; i<m_sockets.size() ; i++)
+  if (m_poller.Wait(m_ready, timeout) < 0)
   {
-    FD_SET(m_sockets[i]->Socket(), &m_fdset);
-  }
-
-  // set our timeout
-  struct timeval tv;
-  int rem = timeout % 1000;
-  tv.tv_usec = rem * 1000;
-  tv.tv_sec = timeout / 1000;
-
-  m_iReadyCount = select(m_iMaxSockets+1, &m_fdset, NULL, NULL, (timeout < 0 ? NULL : &tv));
-
-  if (m_iReadyCount<0)
-  {
-    CLog::Log(LOGERROR, "SOCK: Error selecting socket(s)");
+    CLog::Log(LOGERROR, "SOCK: Error polling socket(s)");
     Clear();
     throw LISTENERROR;
   }
-  else
-  {
-    m_iCurrentSocket = 0;
-    return (m_iReadyCount>0);
-  }
+
+  return !m_ready.empty();
+}
+
+void CSocketListener::Wake()
+{
+  m_poller.Wake();
 }
 
 void CSocketListener::Clear()
 {
   m_sockets.clear();
-  FD_ZERO(&m_fdset);
-  m_iReadyCount = 0;
-  m_iMaxSockets = 0;
+  m_ready.clear();
   m_iCurrentSocket = 0;
+  m_poller.Open();
 }
 
-CBaseSocket* CSocketListener::GetFirstReadySocket()
+CBaseSocket* CSocketListener::GetReadySocket()
 {
-  if (m_iReadyCount<=0)
-    return NULL;
-
-  for (int i = 0 ; i < (int)m_sockets.size() ; i++)
+  for (; m_iCurrentSocket < (int)m_ready.size(); m_iCurrentSocket++)
   {
-    if (FD_ISSET((m_sockets[i])->Socket(), &m_fdset))
+    for (unsigned int i = 0 ; i < m_sockets.size() ; i++)
     {
-      m_iCurrentSocket = i;
-      return m_sockets[i];
+      if (m_sockets[i]->Socket() == m_ready[m_iCurrentSocket].socket)
+        return m_sockets[i];
     }
   }
   return NULL;
 }
 
-CBaseSocket* CSocketListener::GetNextReadySocket()
+CBaseSocket* CSocketListener::GetFirstReadySocket()
 {
-  if (m_iReadyCount<=0)
-    return NULL;
+  m_iCurrentSocket = 0;
+  return GetReadySocket();
+}
 
-  for (int i = m_iCurrentSocket+1 ; i<(int)m_sockets.size() ; i++)
-  {
-    if (FD_ISSET(m_sockets[i]->Socket(), &m_fdset))
-    {
-      m_iCurrentSocket = i;
-      return m_sockets[i];
-    }
-  }
-  return NULL;
+CBaseSocket* CSocketListener::GetNextReadySocket()
+{
+  m_iCurrentSocket++;
+  return GetReadySocket();
 }
 
 #endif // HAS_EVENT_SERVER
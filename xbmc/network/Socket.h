@@ -31,6 +31,9 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+
+#include "SocketPoller.h"
+
 #ifdef TARGET_POSIX
 typedef int SOCKET;
 #endif
@@ -243,16 +246,18 @@ namespace SOCKETS
     CSocketListener();
     void         AddSocket(CBaseSocket *);
     bool         Listen(int timeoutMs); // in ms, -1=>never timeout, 0=>poll
+    void         Wake(); // make Listen() return early, may be called from any thread
     void         Clear();
     CBaseSocket* GetFirstReadySocket();
     CBaseSocket* GetNextReadySocket();
 
   protected:
-    std::vector<CBaseSocket*> m_sockets;
-    int                       m_iReadyCount;
-    int                       m_iMaxSockets;
-    int                       m_iCurrentSocket;
-    fd_set                    m_fdset;
+    CBaseSocket* GetReadySocket();
+
+    std::vector<CBaseSocket*>          m_sockets;
+    std::vector<CSocketPoller::Event>  m_ready;
+    int                                m_iCurrentSocket;
+    CSocketPoller                      m_poller;
   };
 
 }
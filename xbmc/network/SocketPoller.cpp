@@ -0,0 +1,375 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SocketPoller.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#ifdef HAS_EPOLL
+#include <sys/eventfd.h>
+#endif
+
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#if defined(TARGET_WINDOWS)
+#define poll WSAPoll
+#define POLLER_INTERRUPTED() (WSAGetLastError() == WSAEINTR)
+#else
+#define POLLER_INTERRUPTED() (errno == EINTR)
+#endif
+
+/* the number of ready sockets that are picked up with one call to epoll_wait */
+#define POLLER_MAX_EVENTS 256
+
+CSocketPoller::CSocketPoller()
+#ifdef HAS_EPOLL
+  : m_epoll(-1),
+    m_wakeEvent(-1),
+#else
+  : m_wakeSocket(INVALID_SOCKET),
+#endif
+    m_bWakePending(false)
+{
+}
+
+CSocketPoller::~CSocketPoller()
+{
+  Close();
+}
+
+#ifdef HAS_EPOLL
+
+static uint32_t ToEpoll(int events)
+{
+  uint32_t result = 0;
+  if (events & CSocketPoller::EventRead)
+    result |= EPOLLIN | EPOLLRDHUP;
+  if (events & CSocketPoller::EventWrite)
+    result |= EPOLLOUT;
+  if (events & CSocketPoller::EventTrigger)
+    result |= EPOLLET;
+  return result;
+}
+
+bool CSocketPoller::Open()
+{
+  Close();
+
+  CSingleLock lock(m_critSection);
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll < 0)
+  {
+    CLog::Log(LOGERROR, "CSocketPoller: Failed to create epoll instance: %d", errno);
+    return false;
+  }
+
+  m_wakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_wakeEvent < 0)
+  {
+    CLog::Log(LOGERROR, "CSocketPoller: Failed to create wake event: %d", errno);
+    close(m_epoll);
+    m_epoll = -1;
+    return false;
+  }
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = m_wakeEvent;
+  epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeEvent, &event);
+
+  m_epollEvents.resize(POLLER_MAX_EVENTS);
+  m_bWakePending = false;
+  return true;
+}
+
+void CSocketPoller::Close()
+{
+  CSingleLock lock(m_critSection);
+  if (m_wakeEvent >= 0)
+    close(m_wakeEvent);
+  if (m_epoll >= 0)
+    close(m_epoll);
+  m_wakeEvent = -1;
+  m_epoll = -1;
+}
+
+bool CSocketPoller::IsOpen() const
+{
+  return m_epoll >= 0;
+}
+
+bool CSocketPoller::Add(SOCKET socket, int events)
+{
+  struct epoll_event event = {};
+  event.events = ToEpoll(events);
+  event.data.fd = socket;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) < 0)
+  {
+    CLog::Log(LOGERROR, "CSocketPoller: Failed to add socket %d: %d", socket, errno);
+    return false;
+  }
+  return true;
+}
+
+bool CSocketPoller::Modify(SOCKET socket, int events)
+{
+  struct epoll_event event = {};
+  event.events = ToEpoll(events);
+  event.data.fd = socket;
+  return epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket, &event) == 0;
+}
+
+void CSocketPoller::Remove(SOCKET socket)
+{
+  struct epoll_event event = {};
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, &event);
+}
+
+int CSocketPoller::Wait(std::vector<Event> &events, int timeoutMs)
+{
+  events.clear();
+
+  int count = epoll_wait(m_epoll, &m_epollEvents[0], m_epollEvents.size(), timeoutMs);
+  if (count < 0)
+    return POLLER_INTERRUPTED() ? 0 : -1;
+
+  for (int i = 0; i < count; i++)
+  {
+    const struct epoll_event &event = m_epollEvents[i];
+    if (event.data.fd == m_wakeEvent)
+    {
+      ClearWake();
+      continue;
+    }
+
+    Event ready = { event.data.fd, 0 };
+    if (event.events & (EPOLLIN | EPOLLRDHUP))
+      ready.events |= EventRead;
+    if (event.events & EPOLLOUT)
+      ready.events |= EventWrite;
+    if (event.events & (EPOLLERR | EPOLLHUP))
+      ready.events |= EventError;
+    events.push_back(ready);
+  }
+
+  return events.size();
+}
+
+void CSocketPoller::Wake()
+{
+  CSingleLock lock(m_critSection);
+  if (m_bWakePending || m_wakeEvent < 0)
+    return;
+
+  uint64_t value = 1;
+  if (write(m_wakeEvent, &value, sizeof(value)) == sizeof(value))
+    m_bWakePending = true;
+}
+
+void CSocketPoller::ClearWake()
+{
+  CSingleLock lock(m_critSection);
+  uint64_t value;
+  if (read(m_wakeEvent, &value, sizeof(value)) < 0 && errno != EAGAIN)
+    CLog::Log(LOGERROR, "CSocketPoller: Failed to read wake event: %d", errno);
+  m_bWakePending = false;
+}
+
+#else
+
+static short ToPoll(int events)
+{
+  short result = 0;
+  if (events & CSocketPoller::EventRead)
+    result |= POLLIN;
+  if (events & CSocketPoller::EventWrite)
+    result |= POLLOUT;
+  return result;
+}
+
+bool CSocketPoller::Open()
+{
+  Close();
+
+  /* poll() can only wait for sockets, wake it with a datagram the socket sends to itself */
+  CSingleLock lock(m_critSection);
+  m_wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_wakeSocket == INVALID_SOCKET)
+  {
+    CLog::Log(LOGERROR, "CSocketPoller: Failed to create wake socket");
+    return false;
+  }
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t len = sizeof(addr);
+  if (bind(m_wakeSocket, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+      getsockname(m_wakeSocket, (struct sockaddr*)&addr, &len) != 0 ||
+      connect(m_wakeSocket, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+      !SetNonBlocking(m_wakeSocket))
+  {
+    CLog::Log(LOGERROR, "CSocketPoller: Failed to set up wake socket");
+    closesocket(m_wakeSocket);
+    m_wakeSocket = INVALID_SOCKET;
+    return false;
+  }
+
+  struct pollfd fd = {};
+  fd.fd = m_wakeSocket;
+  fd.events = POLLIN;
+  m_fds.push_back(fd);
+
+  m_bWakePending = false;
+  return true;
+}
+
+void CSocketPoller::Close()
+{
+  CSingleLock lock(m_critSection);
+  if (m_wakeSocket != INVALID_SOCKET)
+    closesocket(m_wakeSocket);
+  m_wakeSocket = INVALID_SOCKET;
+  m_fds.clear();
+}
+
+bool CSocketPoller::IsOpen() const
+{
+  return m_wakeSocket != INVALID_SOCKET;
+}
+
+bool CSocketPoller::Add(SOCKET socket, int events)
+{
+  struct pollfd fd = {};
+  fd.fd = socket;
+  fd.events = ToPoll(events);
+  m_fds.push_back(fd);
+  return true;
+}
+
+bool CSocketPoller::Modify(SOCKET socket, int events)
+{
+  for (std::vector<struct pollfd>::iterator it = m_fds.begin(); it != m_fds.end(); ++it)
+  {
+    if (it->fd == socket)
+    {
+      it->events = ToPoll(events);
+      return true;
+    }
+  }
+  return false;
+}
+
+void CSocketPoller::Remove(SOCKET socket)
+{
+  /* the wake socket always stays in front */
+  for (size_t i = 1; i < m_fds.size(); i++)
+  {
+    if (m_fds[i].fd == socket)
+    {
+      m_fds[i] = m_fds.back();
+      m_fds.pop_back();
+      return;
+    }
+  }
+}
+
+int CSocketPoller::Wait(std::vector<Event> &events, int timeoutMs)
+{
+  events.clear();
+
+  int count = poll(&m_fds[0], m_fds.size(), timeoutMs);
+  if (count < 0)
+    return POLLER_INTERRUPTED() ? 0 : -1;
+
+  for (size_t i = 0; i < m_fds.size() && count > 0; i++)
+  {
+    const struct pollfd &fd = m_fds[i];
+    if (fd.revents == 0)
+      continue;
+    count--;
+
+    if (i == 0)
+    {
+      ClearWake();
+      continue;
+    }
+
+    Event ready = { fd.fd, 0 };
+    if (fd.revents & POLLIN)
+      ready.events |= EventRead;
+    if (fd.revents & POLLOUT)
+      ready.events |= EventWrite;
+    if (fd.revents & (POLLERR | POLLHUP | POLLNVAL))
+      ready.events |= EventError;
+    events.push_back(ready);
+  }
+
+  return events.size();
+}
+
+void CSocketPoller::Wake()
+{
+  CSingleLock lock(m_critSection);
+  if (m_bWakePending || m_wakeSocket == INVALID_SOCKET)
+    return;
+
+  char value = 1;
+  if (send(m_wakeSocket, &value, sizeof(value), 0) == sizeof(value))
+    m_bWakePending = true;
+}
+
+void CSocketPoller::ClearWake()
+{
+  CSingleLock lock(m_critSection);
+  char buffer[16];
+  while (recv(m_wakeSocket, buffer, sizeof(buffer), 0) > 0)
+    ;
+  m_bWakePending = false;
+}
+
+#endif
+
+bool CSocketPoller::SetNonBlocking(SOCKET socket)
+{
+#ifdef TARGET_WINDOWS
+  u_long nonblocking = 1;
+  return ioctlsocket(socket, FIONBIO, &nonblocking) == 0;
+#else
+  int flags = fcntl(socket, F_GETFL);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool CSocketPoller::WouldBlock()
+{
+#ifdef TARGET_WINDOWS
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
@@ -0,0 +1,120 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <vector>
+#include <sys/socket.h>
+
+#include "system.h"
+#include "threads/CriticalSection.h"
+
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID)
+#define HAS_EPOLL
+#include <sys/epoll.h>
+#elif !defined(TARGET_WINDOWS)
+#include <poll.h>
+#endif
+
+/*!
+ \brief Waits for any number of sockets to become readable or writable.
+
+ Uses epoll where it is available and poll() (WSAPoll() on Windows)
+ everywhere else, so unlike select() there is no limit on the number or the
+ value of the sockets, and the set of sockets doesn't have to be built again
+ for every wait.
+
+ Sockets that are added as edge triggered are only reported again once more
+ data arrives or more room is available, so they have to be read or written
+ until the call would block. poll() has no edge triggered mode, it keeps on
+ reporting them like all other sockets, which is fine for a caller that reads
+ until the call would block anyway. Changing the events of a socket with
+ Modify() reports it again if it is ready, in both modes.
+
+ Only Wake() may be called from other threads than the one that waits.
+ */
+class CSocketPoller
+{
+public:
+  enum Events
+  {
+    EventRead    = 0x01,
+    EventWrite   = 0x02,
+    EventError   = 0x04,  ///< the connection was closed or failed, only reported
+    EventTrigger = 0x08   ///< report the socket edge triggered, only requested
+  };
+
+  struct Event
+  {
+    SOCKET socket;
+    int    events;
+  };
+
+  CSocketPoller();
+  ~CSocketPoller();
+
+  bool Open();
+  void Close();
+  bool IsOpen() const;
+
+  bool Add(SOCKET socket, int events);
+  bool Modify(SOCKET socket, int events);
+  void Remove(SOCKET socket);
+
+  /*!
+   \brief Wait for sockets to become ready
+   \param events The ready sockets are stored in this
+   \param timeoutMs The time to wait in ms, -1 to wait until a socket is ready or Wake() is called
+   \return The number of ready sockets, 0 on a timeout or Wake(), -1 on errors
+   */
+  int Wait(std::vector<Event> &events, int timeoutMs);
+
+  /*!
+   \brief Make a Wait() that is in progress, or the next one, return right away
+   */
+  void Wake();
+
+  /*!
+   \brief Put a socket in non-blocking mode
+   */
+  static bool SetNonBlocking(SOCKET socket);
+
+  /*!
+   \brief Whether the last failed socket call would have blocked
+   */
+  static bool WouldBlock();
+
+private:
+  CSocketPoller(const CSocketPoller&);
+  CSocketPoller& operator=(const CSocketPoller&);
+
+  void ClearWake();
+
+#ifdef HAS_EPOLL
+  int m_epoll;
+  int m_wakeEvent;
+  std::vector<struct epoll_event> m_epollEvents;
+#else
+  /* the sockets are kept in the array that is handed to poll() as is */
+  std::vector<struct pollfd> m_fds;
+  SOCKET m_wakeSocket;
+#endif
+  bool m_bWakePending;
+  CCriticalSection m_critSection;  ///< guards the wake socket against Close() while another thread calls Wake()
+};
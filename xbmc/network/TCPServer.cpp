@@ -19,6 +19,7 @@
  */
 
 #include "TCPServer.h"
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
@@ -28,8 +29,8 @@
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "interfaces/AnnouncementManager.h"
+#include "utils/JSONVariantWriter.h"
 #include "utils/log.h"
-#include "utils/Variant.h"
 #include "threads/SingleLock.h"
 #include "websocket/WebSocketManager.h"
 #include "Network.h"
@@ -56,7 +57,14 @@ static const bdaddr_t bt_bdaddr_local = {{0, 0, 0, 0xff, 0xff, 0xff}};
 using namespace JSONRPC;
 using namespace ANNOUNCEMENT;
 
-#define RECEIVEBUFFER 1024
+#define RECEIVEBUFFER 4096
+#define RESPONSECHUNK 16384
+// announcements are dropped for clients that have more than this queued up
+#define ANNOUNCEMENTQUEUE (1024 * 1024)
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -91,6 +99,9 @@ void CTCPServer::StopServer(bool bWait)
 {
   if (ServerInstance)
   {
+    // don't let the server wait for sockets until its timeout
+    ServerInstance->m_bStop = true;
+    ServerInstance->m_poller.Wake();
     ServerInstance->StopThread(bWait);
     if (bWait)
     {
@@ -119,112 +130,221 @@ void CTCPServer::Process()
 {
   m_bStop = false;
 
+  std::vector<CSocketPoller::Event> events;
   while (!m_bStop)
   {
-    SOCKET          max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
-    FD_ZERO(&rfds);
+    int res = m_poller.Wait(events, 1000);
+    if (res < 0)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Polling failed");
+      Sleep(1000);
+      Recover();
+      continue;
+    }
 
-    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    for (std::vector<CSocketPoller::Event>::const_iterator event = events.begin(); event != events.end(); ++event)
     {
-      FD_SET(*it, &rfds);
-      if ((intptr_t)*it > (intptr_t)max_fd)
-        max_fd = *it;
+      if (std::find(m_servers.begin(), m_servers.end(), event->socket) != m_servers.end())
+      {
+        Accept(event->socket);
+        continue;
+      }
+
+      if (event->events & CSocketPoller::EventWrite)
+        Flush(event->socket);
+      if (event->events & (CSocketPoller::EventRead | CSocketPoller::EventError))
+        Receive(event->socket);
     }
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    FanOutAnnouncements();
+  }
+
+  Deinitialize();
+}
+
+void CTCPServer::Accept(SOCKET server)
+{
+  // the servers are edge triggered, so take all connections that are waiting
+  while (true)
+  {
+    CTCPClient *newconnection = new CTCPClient();
+    newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+    if (newconnection->m_socket == INVALID_SOCKET)
     {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
+      int error = errno;
+      bool wouldBlock = CSocketPoller::WouldBlock();
+      delete newconnection;
+      if (wouldBlock)
+        return;
+
+      CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", error);
+      if (EBADF == error)
+      {
+        Sleep(1000);
+        Recover();
+      }
+      return;
     }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
-    if (res < 0)
+    CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
+    if (!CSocketPoller::SetNonBlocking(newconnection->m_socket) ||
+        !m_poller.Add(newconnection->m_socket, newconnection->m_events))
     {
-      CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
-      Sleep(1000);
-      Initialize();
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to watch new connection");
+      newconnection->Disconnect();
+      delete newconnection;
+      continue;
     }
-    else if (res > 0)
+
+    CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+    m_connections[newconnection->m_socket] = newconnection;
+  }
+}
+
+void CTCPServer::Receive(SOCKET socket)
+{
+  std::unordered_map<SOCKET, CTCPClient*>::iterator it = m_connections.find(socket);
+  if (it == m_connections.end())
+    return;
+
+  // the connections are edge triggered, so read until there is nothing left,
+  // but leave the requests in the socket while a response is still being sent
+  char buffer[RECEIVEBUFFER] = {};
+  bool close = false;
+  while (!close)
+  {
+    if (it->second->HasPendingResponse())
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      if (!it->second->Flush())
       {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
-        {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (!response.empty())
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
-        }
+        close = true;
+        break;
       }
 
-      for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+      if (it->second->HasPendingResponse())
+        break;
+    }
+
+    int nread = recv(socket, buffer, RECEIVEBUFFER, 0);
+    if (nread < 0 && CSocketPoller::WouldBlock())
+      break;
+
+    if (nread <= 0)
+    {
+      close = true;
+      break;
+    }
+
+    std::string response;
+    if (it->second->IsNew())
+    {
+      CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
+
+      if (!response.empty())
+        it->second->Send(response.c_str(), response.size());
+
+      if (websocket != NULL)
       {
-        if (FD_ISSET(*it, &rfds))
-        {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
-        }
+        // Replace the CTCPClient with a CWebSocketClient
+        CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(it->second));
+        delete it->second;
+        it->second = websocketClient;
       }
     }
+
+    if (response.size() <= 0)
+      it->second->PushBuffer(this, buffer, nread);
+
+    close = it->second->Closing();
   }
 
-  Deinitialize();
+  if (close)
+  {
+    CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+    RemoveConnection(socket);
+  }
+  else
+    Flush(socket);
+}
+
+void CTCPServer::Flush(SOCKET socket)
+{
+  std::unordered_map<SOCKET, CTCPClient*>::iterator it = m_connections.find(socket);
+  if (it == m_connections.end())
+    return;
+
+  if (!it->second->Flush())
+  {
+    CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+    RemoveConnection(socket);
+    return;
+  }
+
+  UpdateEvents(socket);
+}
+
+void CTCPServer::UpdateEvents(SOCKET socket)
+{
+  CTCPClient *client = m_connections[socket];
+
+  // only wait for requests once the last response is out, and only wait for
+  // room in the socket while there is something left to send
+  int events = CSocketPoller::EventTrigger;
+  if (!client->HasPendingResponse())
+    events |= CSocketPoller::EventRead;
+  if (client->HasPendingData())
+    events |= CSocketPoller::EventWrite;
+
+  if (events != client->m_events && m_poller.Modify(socket, events))
+    client->m_events = events;
+}
+
+void CTCPServer::RemoveConnection(SOCKET socket)
+{
+  std::unordered_map<SOCKET, CTCPClient*>::iterator it = m_connections.find(socket);
+  if (it == m_connections.end())
+    return;
+
+  m_poller.Remove(socket);
+  it->second->Disconnect();
+  delete it->second;
+  m_connections.erase(it);
+}
+
+void CTCPServer::FanOutAnnouncements()
+{
+  std::vector<Announcement> announcements;
+  {
+    CSingleLock lock(m_critSection);
+    announcements.swap(m_announcements);
+  }
+
+  if (announcements.empty())
+    return;
+
+  // queue everything that came in since the last round and send it in one go
+  std::vector<SOCKET> failed;
+  for (std::unordered_map<SOCKET, CTCPClient*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+  {
+    CTCPClient *client = it->second;
+    for (std::vector<Announcement>::const_iterator announcement = announcements.begin(); announcement != announcements.end(); ++announcement)
+    {
+      if ((client->GetAnnouncementFlags() & announcement->flag) != 0)
+        client->Announce(announcement->data);
+    }
+
+    if (!client->Flush())
+      failed.push_back(it->first);
+    else
+      UpdateEvents(it->first);
+  }
+
+  for (std::vector<SOCKET>::const_iterator socket = failed.begin(); socket != failed.end(); ++socket)
+  {
+    CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+    RemoveConnection(*socket);
+  }
 }
 
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
@@ -244,18 +364,14 @@ int CTCPServer::GetCapabilities()
 
 void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
-  std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
-
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  // the announcement is serialised once here and handed out to the clients by the server thread
+  Announcement announcement = { flag, std::make_shared<const std::string>(IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact)) };
   {
-    {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
-        continue;
-    }
-
-    m_connections[i]->Send(str.c_str(), str.size());
+    CSingleLock lock(m_critSection);
+    m_announcements.push_back(announcement);
   }
+
+  m_poller.Wake();
 }
 
 bool CTCPServer::Initialize()
@@ -267,6 +383,12 @@ bool CTCPServer::Initialize()
   started |= InitializeBlue();
   started |= InitializeTCP();
 
+  if (started && !OpenPoller())
+  {
+    Deinitialize();
+    started = false;
+  }
+
   if (started)
   {
     CAnnouncementManager::GetInstance().AddAnnouncer(this);
@@ -276,6 +398,60 @@ bool CTCPServer::Initialize()
   return false;
 }
 
+bool CTCPServer::OpenPoller()
+{
+  if (!m_poller.Open())
+    return false;
+
+  for (std::vector<SOCKET>::const_iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+  {
+    CSocketPoller::SetNonBlocking(*it);
+    m_poller.Add(*it, CSocketPoller::EventRead | CSocketPoller::EventTrigger);
+  }
+
+  // connections kept by a recovery, whatever they got in the meantime is
+  // reported right away when they are added
+  std::vector<SOCKET> failed;
+  for (std::unordered_map<SOCKET, CTCPClient*>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+  {
+    if (!m_poller.Add(it->first, it->second->m_events))
+      failed.push_back(it->first);
+  }
+
+  for (std::vector<SOCKET>::const_iterator socket = failed.begin(); socket != failed.end(); ++socket)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to watch connection again");
+    RemoveConnection(*socket);
+  }
+
+  return true;
+}
+
+bool CTCPServer::Recover()
+{
+  // nothing left to keep after a recovery failed
+  if (m_servers.empty())
+    return Initialize();
+
+  // set up the servers and the poller again, the clients stay connected
+  CloseServers();
+
+  bool started = false;
+
+  started |= InitializeBlue();
+  started |= InitializeTCP();
+
+  if (started && OpenPoller())
+  {
+    CLog::Log(LOGINFO, "JSONRPC Server: Successfully recovered, kept %u connections", (unsigned int)m_connections.size());
+    return true;
+  }
+
+  CLog::Log(LOGERROR, "JSONRPC Server: Failed to recover, dropping all connections");
+  Deinitialize();
+  return false;
+}
+
 bool CTCPServer::InitializeBlue()
 {
   if (!m_nonlocal)
@@ -461,8 +637,6 @@ bool CTCPServer::InitializeTCP()
 {
   SOCKET fd;
 
-  Deinitialize();
-
   if ((fd = CreateTCPServerSocket(m_port, !m_nonlocal, 10, "JSONRPC")) == INVALID_SOCKET)
     return false;
 
@@ -472,14 +646,25 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  for (std::unordered_map<SOCKET, CTCPClient*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
+    it->second->Disconnect();
+    delete it->second;
   }
 
   m_connections.clear();
 
+  CloseServers();
+
+  CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
+
+  m_poller.Close();
+  CSingleLock lock(m_critSection);
+  m_announcements.clear();
+}
+
+void CTCPServer::CloseServers()
+{
   for (unsigned int i = 0; i < m_servers.size(); i++)
     closesocket(m_servers[i]);
 
@@ -490,8 +675,6 @@ void CTCPServer::Deinitialize()
     sdp_close((sdp_session_t*)m_sdpd);
   m_sdpd = NULL;
 #endif
-
-  CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
 }
 
 CTCPServer::CTCPClient::CTCPClient()
@@ -499,10 +682,16 @@ CTCPServer::CTCPClient::CTCPClient()
   m_new = true;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
+  m_events = CSocketPoller::EventRead | CSocketPoller::EventTrigger;
   m_beginBrackets = 0;
   m_endBrackets = 0;
   m_beginChar = 0;
   m_endChar = 0;
+  m_sendOffset = 0;
+  m_queuedSize = 0;
+  m_droppedAnnouncements = 0;
+  m_responseStarted = false;
+  m_responseFailed = false;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -512,6 +701,10 @@ CTCPServer::CTCPClient::CTCPClient(const CTCPClient& client)
   Copy(client);
 }
 
+CTCPServer::CTCPClient::~CTCPClient()
+{
+}
+
 CTCPServer::CTCPClient& CTCPServer::CTCPClient::operator=(const CTCPClient& client)
 {
   Copy(client);
@@ -536,12 +729,126 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  if (size > 0)
+    Queue(std::make_shared<const std::string>(data, size));
+}
+
+void CTCPServer::CTCPClient::Queue(const Buffer &data)
+{
+  if (data->empty())
+    return;
+
+  m_sendQueue.push_back(data);
+  m_queuedSize += data->size();
+}
+
+void CTCPServer::CTCPClient::Announce(const Buffer &announcement)
+{
+  if (m_queuedSize >= ANNOUNCEMENTQUEUE)
+  {
+    if (m_droppedAnnouncements++ == 0)
+      CLog::Log(LOGWARNING, "JSONRPC Server: Client doesn't keep up, dropping announcements");
+    return;
+  }
+
+  if (m_droppedAnnouncements > 0)
+  {
+    CLog::Log(LOGINFO, "JSONRPC Server: Client caught up again, %u announcements were dropped", m_droppedAnnouncements);
+    m_droppedAnnouncements = 0;
+  }
+
+  // don't mix the announcement into a response that is being sent
+  if (HasPendingResponse())
+  {
+    m_heldAnnouncements.push_back(announcement);
+    m_queuedSize += announcement->size();
+  }
+  else
+    QueueAnnouncement(announcement);
+}
+
+void CTCPServer::CTCPClient::QueueAnnouncement(const Buffer &announcement)
+{
+  Queue(announcement);
+}
+
+bool CTCPServer::CTCPClient::QueueResponseChunk(CJSONVariantWriter &writer, bool first, bool &finished)
+{
+  std::string chunk;
+  if (!writer.WriteChunk(chunk, RESPONSECHUNK))
+    return false;
+
+  Queue(std::make_shared<const std::string>(std::move(chunk)));
+  finished = writer.IsFinished();
+  return true;
+}
+
+void CTCPServer::CTCPClient::QueueNextResponseChunk()
+{
+  bool finished = false;
+  if (!QueueResponseChunk(*m_responseWriter, !m_responseStarted, finished))
+  {
+    // the client already got part of the response, there is no way to end it properly
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to serialise the response, dropping the connection");
+    m_responseFailed = true;
+  }
+  else if (!finished)
+  {
+    m_responseStarted = true;
+    return;
+  }
+
+  m_responseWriter.reset();
+  m_response = CVariant();
+  m_responseStarted = false;
+
+  if (m_responseFailed)
+  {
+    while (!m_heldAnnouncements.empty())
+    {
+      m_queuedSize -= m_heldAnnouncements.front()->size();
+      m_heldAnnouncements.pop_front();
+    }
+    return;
+  }
+
+  while (!m_heldAnnouncements.empty())
   {
-    CSingleLock lock (m_critSection);
-    sent += send(m_socket, data + sent, size - sent, 0);
-  } while (sent < size);
+    m_queuedSize -= m_heldAnnouncements.front()->size();
+    QueueAnnouncement(m_heldAnnouncements.front());
+    m_heldAnnouncements.pop_front();
+  }
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  while (m_socket != INVALID_SOCKET)
+  {
+    // the response is serialised one chunk at a time while the queue drains
+    if (m_sendQueue.empty() && HasPendingResponse())
+      QueueNextResponseChunk();
+
+    if (m_responseFailed)
+      return false;
+
+    if (m_sendQueue.empty())
+      return true;
+
+    const std::string &data = *m_sendQueue.front();
+    int sent = send(m_socket, data.c_str() + m_sendOffset, data.size() - m_sendOffset, MSG_NOSIGNAL);
+    if (sent < 0)
+      return CSocketPoller::WouldBlock();
+
+    m_sendOffset += sent;
+    if (m_sendOffset == data.size())
+    {
+      m_queuedSize -= data.size();
+      m_sendQueue.pop_front();
+      m_sendOffset = 0;
+    }
+  }
+
+  return false;
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
@@ -572,8 +879,18 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
         m_endBrackets++;
       if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
       {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
+        // the responses have to go out in the order of the requests
+        while (HasPendingResponse())
+          QueueNextResponseChunk();
+
+        // the connection is dropped, don't answer any more requests
+        if (m_responseFailed)
+          return;
+
+        if (CJSONRPC::MethodCall(m_buffer, host, this, m_response))
+          m_responseWriter.reset(new CJSONVariantWriter(m_response, g_advancedSettings.m_jsonOutputCompact));
+        else
+          m_response = CVariant();
         m_beginChar = m_beginBrackets = m_endBrackets = 0;
         m_buffer.clear();
       }
@@ -585,7 +902,8 @@ void CTCPServer::CTCPClient::Disconnect()
 {
   if (m_socket > 0)
   {
-    CSingleLock lock (m_critSection);
+    // send whatever the socket still takes
+    Flush();
     shutdown(m_socket, SHUT_RDWR);
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
@@ -594,16 +912,24 @@ void CTCPServer::CTCPClient::Disconnect()
 
 void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
 {
-  m_new               = client.m_new;
-  m_socket            = client.m_socket;
-  m_cliaddr           = client.m_cliaddr;
-  m_addrlen           = client.m_addrlen;
-  m_announcementflags = client.m_announcementflags;
-  m_beginBrackets     = client.m_beginBrackets;
-  m_endBrackets       = client.m_endBrackets;
-  m_beginChar         = client.m_beginChar;
-  m_endChar           = client.m_endChar;
-  m_buffer            = client.m_buffer;
+  m_new                  = client.m_new;
+  m_socket               = client.m_socket;
+  m_cliaddr              = client.m_cliaddr;
+  m_addrlen              = client.m_addrlen;
+  m_events               = client.m_events;
+  m_announcementflags    = client.m_announcementflags;
+  m_beginBrackets        = client.m_beginBrackets;
+  m_endBrackets          = client.m_endBrackets;
+  m_beginChar            = client.m_beginChar;
+  m_endChar              = client.m_endChar;
+  m_buffer               = client.m_buffer;
+  m_sendQueue            = client.m_sendQueue;
+  m_sendOffset           = client.m_sendOffset;
+  m_queuedSize           = client.m_queuedSize;
+  m_heldAnnouncements    = client.m_heldAnnouncements;
+  m_droppedAnnouncements = client.m_droppedAnnouncements;
+  m_responseStarted      = false;
+  m_responseFailed       = client.m_responseFailed;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -648,6 +974,29 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
     CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
 }
 
+bool CTCPServer::CWebSocketClient::QueueResponseChunk(CJSONVariantWriter &writer, bool first, bool &finished)
+{
+  // the response is sent as one message split in frames of one chunk each,
+  // a message that breaks off is never finished with a final frame
+  std::string chunk;
+  if (!writer.WriteChunk(chunk, RESPONSECHUNK))
+    return false;
+
+  finished = writer.IsFinished();
+  CWebSocketFrame *frame = m_websocket->SendFragment(first ? WebSocketTextFrame : WebSocketContinuationFrame, chunk.c_str(), chunk.size(), finished);
+  if (frame == NULL)
+    return false;
+
+  CTCPClient::Send(frame->GetFrameData(), (unsigned int)frame->GetFrameLength());
+  delete frame;
+  return true;
+}
+
+void CTCPServer::CWebSocketClient::QueueAnnouncement(const Buffer &announcement)
+{
+  Send(announcement->c_str(), announcement->size());
+}
+
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   bool send;
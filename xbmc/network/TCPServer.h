@@ -19,6 +19,9 @@
  *
  */
 
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <sys/socket.h>
 
@@ -28,9 +31,11 @@
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
+#include "utils/Variant.h"
 #include "websocket/WebSocket.h"
+#include "SocketPoller.h"
 
-class CVariant;
+class CJSONVariantWriter;
 
 namespace JSONRPC
 {
@@ -49,21 +54,43 @@ namespace JSONRPC
   protected:
     void Process();
   private:
+    typedef std::shared_ptr<const std::string> Buffer;
+
     CTCPServer(int port, bool nonlocal);
     bool Initialize();
     bool InitializeBlue();
     bool InitializeTCP();
     void Deinitialize();
-
+    void CloseServers();
+    bool OpenPoller();
+    bool Recover();
+
+    void Accept(SOCKET server);
+    void Receive(SOCKET socket);
+    void Flush(SOCKET socket);
+    void FanOutAnnouncements();
+    void UpdateEvents(SOCKET socket);
+    void RemoveConnection(SOCKET socket);
+
+    /*!
+     \brief A connection, only ever touched by the server thread.
+
+     Everything that is sent goes through a write queue that is flushed as far
+     as the socket takes it, the rest is sent once the socket is writable again.
+     Responses are only serialised chunk by chunk while the queue drains, and no
+     more requests are read from a client until its response went out, so a
+     client that doesn't read can't make the queue grow. Announcements that
+     come in while the queue is full are dropped.
+     */
     class CTCPClient : public IClient
     {
     public:
       CTCPClient();
-      //Copying a CCriticalSection is not allowed, so copy everything but that
+      //Copying the pending response is not possible, so copy everything but that
       //when adding a member variable, make sure to copy it in CTCPClient::Copy
       CTCPClient(const CTCPClient& client);
       CTCPClient& operator=(const CTCPClient& client);
-      virtual ~CTCPClient() { };
+      virtual ~CTCPClient();
 
       virtual int  GetPermissionFlags();
       virtual int  GetAnnouncementFlags();
@@ -76,19 +103,59 @@ namespace JSONRPC
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
+      /*!
+       \brief Queue an announcement, unless the client is too far behind
+       \param announcement The serialised announcement
+       */
+      void Announce(const Buffer &announcement);
+
+      /*!
+       \brief Send as much of the write queue as the socket takes
+       \return False if the connection failed
+       */
+      bool Flush();
+
+      bool HasPendingResponse() const { return m_responseWriter != nullptr; }
+      bool HasPendingData() const { return !m_sendQueue.empty(); }
+
       SOCKET           m_socket;
       sockaddr_storage m_cliaddr;
       socklen_t        m_addrlen;
-      CCriticalSection m_critSection;
+      int              m_events;  ///< the events the poller waits for
 
     protected:
       void Copy(const CTCPClient& client);
+      void Queue(const Buffer &data);
+
+      /*!
+       \brief Queue the next chunk of the pending response
+       \param writer The writer of the pending response
+       \param first Whether this is the first chunk of the response
+       \param finished Set to true once the response is complete
+       \return False if the response couldn't be serialised
+       */
+      virtual bool QueueResponseChunk(CJSONVariantWriter &writer, bool first, bool &finished);
+      virtual void QueueAnnouncement(const Buffer &announcement);
+
     private:
+      void QueueNextResponseChunk();
+
       bool m_new;
       int m_announcementflags;
       int m_beginBrackets, m_endBrackets;
       char m_beginChar, m_endChar;
       std::string m_buffer;
+
+      std::deque<Buffer> m_sendQueue;
+      size_t m_sendOffset;  ///< the bytes of the first buffer that were sent already
+      size_t m_queuedSize;  ///< the bytes in the write queue and the held back announcements
+      std::deque<Buffer> m_heldAnnouncements;  ///< announcements that came in during a response
+      unsigned int m_droppedAnnouncements;
+
+      CVariant m_response;
+      std::unique_ptr<CJSONVariantWriter> m_responseWriter;
+      bool m_responseStarted;
+      bool m_responseFailed;  ///< a response broke off half way, the connection is dropped
     };
 
     class CWebSocketClient : public CTCPClient
@@ -107,16 +174,30 @@ namespace JSONRPC
       virtual bool IsNew() const { return m_websocket == NULL; }
       virtual bool Closing() const { return m_websocket != NULL && m_websocket->GetState() == WebSocketStateClosed; }
 
+    protected:
+      virtual bool QueueResponseChunk(CJSONVariantWriter &writer, bool first, bool &finished);
+      virtual void QueueAnnouncement(const Buffer &announcement);
+
     private:
       CWebSocket *m_websocket;
     };
 
-    std::vector<CTCPClient*> m_connections;
+    struct Announcement
+    {
+      ANNOUNCEMENT::AnnouncementFlag flag;
+      Buffer data;
+    };
+
+    CSocketPoller m_poller;
+    std::unordered_map<SOCKET, CTCPClient*> m_connections;
     std::vector<SOCKET> m_servers;
     int m_port;
     bool m_nonlocal;
     void* m_sdpd;
 
+    CCriticalSection m_critSection;             ///< guards the announcements that wait for the server thread
+    std::vector<Announcement> m_announcements;
+
     static CTCPServer *ServerInstance;
   };
 }
@@ -60,6 +60,20 @@
 
 #define MAX_POST_BUFFER_SIZE 2048
 
+#define STREAM_BLOCK_SIZE 16384
+
+#ifndef MHD_SIZE_UNKNOWN
+#define MHD_SIZE_UNKNOWN ((uint64_t) -1)
+#endif
+
+#ifndef MHD_CONTENT_READER_END_OF_STREAM
+#define MHD_CONTENT_READER_END_OF_STREAM ((size_t) -1)
+#endif
+
+#ifndef MHD_CONTENT_READER_END_WITH_ERROR
+#define MHD_CONTENT_READER_END_WITH_ERROR (((size_t) -1) - 1)
+#endif
+
 #define PAGE_FILE_NOT_FOUND "<html><head><title>File not found</title></head><body>File not found</body></html>"
 #define NOT_SUPPORTED       "<html><head><title>Not Supported</title></head><body>The method you are trying to use is not supported by this server</body></html>"
 
@@ -79,6 +93,10 @@ typedef struct {
   uint64_t writePosition;
 } HttpFileDownloadContext;
 
+typedef struct {
+  std::shared_ptr<IHTTPRequestHandler> handler;
+} HttpStreamDownloadContext;
+
 CWebServer::CWebServer()
   : m_port(0),
     m_daemon_ip6(nullptr),
@@ -502,6 +520,10 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
       ret = CreateMemoryDownloadResponse(handler, response);
       break;
 
+    case HTTPStreamDownload:
+      ret = CreateStreamDownloadResponse(handler, response);
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, responseDetails.status, request.method, response);
       break;
@@ -886,6 +908,35 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
   return MHD_YES;
 }
 
+int CWebServer::CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const
+{
+  if (handler == nullptr)
+    return MHD_NO;
+
+  const HTTPRequest &request = handler->GetRequest();
+  if (request.method == HEAD)
+    return CreateMemoryDownloadResponse(request.connection, nullptr, 0, false, false, response);
+
+  // the context keeps the request handler alive until the whole response has been sent
+  std::unique_ptr<HttpStreamDownloadContext> context(new HttpStreamDownloadContext());
+  context->handler = handler;
+
+  // without a length MHD uses chunked encoding or closes the connection at the end
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, STREAM_BLOCK_SIZE,
+                                                &CWebServer::StreamReaderCallback,
+                                                context.get(),
+                                                &CWebServer::StreamReaderFreeCallback);
+  if (response == nullptr)
+  {
+    CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP response for %s to be streamed", m_port, request.pathUrl.c_str());
+    return MHD_NO;
+  }
+
+  context.release(); // ownership was passed to mhd
+
+  return MHD_YES;
+}
+
 int CWebServer::CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const
 {
   size_t payloadSize = 0;
@@ -1087,6 +1138,44 @@ void CWebServer::ContentReaderFreeCallback(void *cls)
     CLog::Log(LOGDEBUG, "CWebServer [OUT] done");
 }
 
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  if (context == nullptr || context->handler == nullptr || max <= 0)
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+
+  ssize_t written = context->handler->ReadResponseData(buf, static_cast<size_t>(max));
+  if (written == 0)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+  // closes the connection without the last chunk, the client sees a broken response
+  if (written < 0)
+  {
+    CLog::Log(LOGERROR, "CWebServer: aborting the response for %s", context->handler->GetRequest().pathUrl.c_str());
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+  }
+
+  if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+    CLog::Log(LOGDEBUG, "CWebServer [OUT] wrote %d bytes from %" PRIu64, (int)written, (uint64_t)pos);
+
+  return written;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  delete context;
+
+  if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+    CLog::Log(LOGDEBUG, "CWebServer [OUT] done");
+}
+
 // local helper
 static void panicHandlerForMHD(void* unused, const char* file, unsigned int line, const char *reason)
 {
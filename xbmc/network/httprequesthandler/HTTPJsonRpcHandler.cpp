@@ -19,6 +19,10 @@
  */
 
 #include "HTTPJsonRpcHandler.h"
+
+#include <algorithm>
+#include <string.h>
+
 #include "URL.h"
 #include "filesystem/File.h"
 #include "interfaces/json-rpc/JSONRPC.h"
@@ -26,9 +30,8 @@
 #include "interfaces/json-rpc/JSONUtils.h"
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
-#include "utils/JSONVariantWriter.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/log.h"
-#include "utils/Variant.h"
 
 #define MAX_HTTP_POST_SIZE 65536
 
@@ -82,19 +85,19 @@ int CHTTPJsonRpcHandler::HandleRequest()
       jsonpCallback = argument->second;
   }
 
+  bool hasResponse = true;
+  bool compact = g_advancedSettings.m_jsonOutputCompact;
   if (isRequest)
   {
-    m_responseData = JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client);
-
-    if (!jsonpCallback.empty())
-      m_responseData = jsonpCallback + "(" + m_responseData + ");";
+    size_t begin = m_requestData.find_first_not_of(" \t\r\n");
+    m_transportLayer.m_canStream = begin != std::string::npos && m_requestData[begin] == '{';
+    hasResponse = JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client, m_responseValue);
   }
   else if (jsonpCallback.empty())
   {
     // get the whole output of JSONRPC.Introspect
-    CVariant result;
-    JSONRPC::CJSONServiceDescription::Print(result, &m_transportLayer, &client);
-    m_responseData = CJSONVariantWriter::Write(result, false);
+    JSONRPC::CJSONServiceDescription::Print(m_responseValue, &m_transportLayer, &client);
+    compact = false;
   }
   else
   {
@@ -106,22 +109,72 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   m_requestData.clear();
 
-  m_responseRange.SetData(m_responseData.c_str(), m_responseData.size());
+  // the response is serialised while it is being sent
+  if (hasResponse)
+  {
+    m_responseWriter.reset(new CJSONVariantWriter(m_responseValue, compact));
+
+    // the items the method left to the transport are written after the ones in the result
+    const CVariant &response = m_responseValue;
+    if (m_transportLayer.m_streamedItems && response["result"][m_transportLayer.m_streamedMember].isArray())
+      m_responseWriter->StreamArray(response["result"][m_transportLayer.m_streamedMember], m_transportLayer.m_streamedItems);
+  }
+  m_transportLayer.m_streamedItems = nullptr;
 
-  m_response.type = HTTPMemoryDownloadNoFreeCopy;
+  if (!jsonpCallback.empty())
+  {
+    m_responseData = jsonpCallback + "(";
+    m_responseSuffix = ");";
+  }
+
+  m_response.type = HTTPStreamDownload;
   m_response.status = MHD_HTTP_OK;
   m_response.contentType = "application/json";
-  m_response.totalLength = m_responseData.size();
 
   return MHD_YES;
 }
 
-HttpResponseRanges CHTTPJsonRpcHandler::GetResponseData() const
+ssize_t CHTTPJsonRpcHandler::ReadResponseData(char *buffer, size_t size)
 {
-  HttpResponseRanges ranges;
-  ranges.push_back(m_responseRange);
+  if (m_responseFailed)
+    return -1;
 
-  return ranges;
+  size_t written = 0;
+  while (written < size)
+  {
+    if (m_responseDataPosition >= m_responseData.size())
+    {
+      m_responseData.clear();
+      m_responseDataPosition = 0;
+
+      if (m_responseWriter != nullptr && !m_responseWriter->IsFinished())
+      {
+        if (!m_responseWriter->WriteChunk(m_responseData, size - written))
+        {
+          // the client already got part of the response, don't let it look complete
+          CLog::Log(LOGERROR, "JSONRPC: Failed to serialise the response");
+          m_responseWriter.reset();
+          m_responseData.clear();
+          m_responseSuffix.clear();
+          m_responseFailed = true;
+          return -1;
+        }
+      }
+      else if (!m_responseSuffix.empty())
+        m_responseData.swap(m_responseSuffix);
+      else
+        break;
+
+      continue;
+    }
+
+    size_t length = std::min(size - written, m_responseData.size() - m_responseDataPosition);
+    memcpy(buffer + written, m_responseData.c_str() + m_responseDataPosition, length);
+    m_responseDataPosition += length;
+    written += length;
+  }
+
+  return written;
 }
 
 #if (MHD_VERSION >= 0x00040001)
@@ -170,6 +223,16 @@ int CHTTPJsonRpcHandler::CHTTPTransportLayer::GetCapabilities()
   return JSONRPC::Response | JSONRPC::FileDownloadRedirect;
 }
 
+bool CHTTPJsonRpcHandler::CHTTPTransportLayer::StreamItems(const std::string &member, const ItemSource &source)
+{
+  if (!m_canStream || m_streamedItems)
+    return false;
+
+  m_streamedMember = member;
+  m_streamedItems = source;
+  return true;
+}
+
 int CHTTPJsonRpcHandler::CHTTPClient::GetPermissionFlags()
 {
   return JSONRPC::OPERATION_PERMISSION_ALL;
@@ -19,11 +19,14 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
 
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
@@ -37,13 +40,15 @@ public:
 
   virtual int HandleRequest();
 
-  virtual HttpResponseRanges GetResponseData() const;
+  virtual ssize_t ReadResponseData(char *buffer, size_t size);
 
   virtual int GetPriority() const { return 5; }
 
 protected:
   explicit CHTTPJsonRpcHandler(const HTTPRequest &request)
-    : IHTTPRequestHandler(request)
+    : IHTTPRequestHandler(request),
+      m_responseDataPosition(0),
+      m_responseFailed(false)
   { }
 
 #if (MHD_VERSION >= 0x00040001)
@@ -54,8 +59,12 @@ protected:
 
 private:
   std::string m_requestData;
-  std::string m_responseData;
-  CHttpResponseRange m_responseRange;
+  CVariant m_responseValue;
+  std::unique_ptr<CJSONVariantWriter> m_responseWriter;
+  std::string m_responseData;         // the part of the response that is being sent
+  size_t m_responseDataPosition;
+  std::string m_responseSuffix;
+  bool m_responseFailed;
 
   class CHTTPTransportLayer : public JSONRPC::ITransportLayer
   {
@@ -67,6 +76,11 @@ private:
     bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override;
     bool Download(const char *path, CVariant &result) override;
     int GetCapabilities() override;
+    bool StreamItems(const std::string &member, const ItemSource &source) override;
+
+    bool m_canStream = false;     // only the single result of a request can be streamed
+    std::string m_streamedMember;
+    ItemSource m_streamedItems;
   };
   CHTTPTransportLayer m_transportLayer;
 
@@ -65,7 +65,10 @@ typedef enum HTTPResponseType
   HTTPMemoryDownloadFreeNoCopy,
   // creates a HTTP response from a buffer by copying followed by freeing the buffer
   // the buffer must have been malloc'ed and not new'ed
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  // creates a HTTP response of unknown length with the content read from the
+  // request handler while it is being sent
+  HTTPStreamDownload
 } HTTPResponseType;
 
 typedef struct HTTPRequest
@@ -172,6 +175,18 @@ public:
   */
   virtual std::string GetResponseFile() const { return ""; }
 
+  /*!
+  * \brief Reads the next part of the response data.
+  *
+  * \details This is only used if the response type is HTTPStreamDownload.
+  *
+  * \param buffer Buffer to copy the response data to
+  * \param size Maximum number of bytes to copy
+  * \return Number of bytes copied, 0 at the end of the response or less than
+  *         0 if the response broke off and the connection has to be dropped.
+  */
+  virtual ssize_t ReadResponseData(char *buffer, size_t size) { return -1; }
+
   /*!
   * \brief Returns the HTTP request handled by the HTTP request handler.
   */
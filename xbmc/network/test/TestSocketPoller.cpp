@@ -0,0 +1,144 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "network/SocketPoller.h"
+
+#include "gtest/gtest.h"
+
+class TestSocketPoller : public testing::Test
+{
+protected:
+  TestSocketPoller()
+    : m_client(INVALID_SOCKET),
+      m_server(INVALID_SOCKET)
+  { }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_poller.Open());
+
+    // a connected pair of sockets on the loopback interface
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NE(INVALID_SOCKET, listener);
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(0, bind(listener, (struct sockaddr*)&addr, sizeof(addr)));
+    ASSERT_EQ(0, getsockname(listener, (struct sockaddr*)&addr, &len));
+    ASSERT_EQ(0, listen(listener, 1));
+
+    m_client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, connect(m_client, (struct sockaddr*)&addr, sizeof(addr)));
+    m_server = accept(listener, NULL, NULL);
+    closesocket(listener);
+    ASSERT_NE(INVALID_SOCKET, m_server);
+    ASSERT_TRUE(CSocketPoller::SetNonBlocking(m_server));
+  }
+
+  virtual void TearDown()
+  {
+    if (m_client != INVALID_SOCKET)
+      closesocket(m_client);
+    if (m_server != INVALID_SOCKET)
+      closesocket(m_server);
+    m_poller.Close();
+  }
+
+  CSocketPoller m_poller;
+  std::vector<CSocketPoller::Event> m_events;
+  SOCKET m_client;
+  SOCKET m_server;
+};
+
+TEST_F(TestSocketPoller, Wake)
+{
+  m_poller.Wake();
+  m_poller.Wake();
+  EXPECT_EQ(0, m_poller.Wait(m_events, -1));
+
+  // the wake was used up
+  EXPECT_EQ(0, m_poller.Wait(m_events, 0));
+}
+
+TEST_F(TestSocketPoller, Read)
+{
+  ASSERT_TRUE(m_poller.Add(m_server, CSocketPoller::EventRead | CSocketPoller::EventTrigger));
+  EXPECT_EQ(0, m_poller.Wait(m_events, 0));
+
+  ASSERT_EQ(4, send(m_client, "test", 4, 0));
+  ASSERT_EQ(1, m_poller.Wait(m_events, 1000));
+  EXPECT_EQ(m_server, m_events[0].socket);
+  EXPECT_TRUE((m_events[0].events & CSocketPoller::EventRead) != 0);
+  EXPECT_TRUE((m_events[0].events & CSocketPoller::EventWrite) == 0);
+
+  // changing the events reports a socket that is still ready again
+  ASSERT_TRUE(m_poller.Modify(m_server, CSocketPoller::EventRead | CSocketPoller::EventTrigger));
+  EXPECT_EQ(1, m_poller.Wait(m_events, 0));
+
+  char buffer[16];
+  EXPECT_EQ(4, recv(m_server, buffer, sizeof(buffer), 0));
+  EXPECT_EQ(-1, recv(m_server, buffer, sizeof(buffer), 0));
+  EXPECT_TRUE(CSocketPoller::WouldBlock());
+  EXPECT_EQ(0, m_poller.Wait(m_events, 0));
+}
+
+TEST_F(TestSocketPoller, Write)
+{
+  ASSERT_TRUE(m_poller.Add(m_server, CSocketPoller::EventWrite | CSocketPoller::EventTrigger));
+  ASSERT_EQ(1, m_poller.Wait(m_events, 1000));
+  EXPECT_EQ(m_server, m_events[0].socket);
+  EXPECT_TRUE((m_events[0].events & CSocketPoller::EventWrite) != 0);
+
+  // fill the socket until it doesn't take any more
+  char buffer[4096] = {};
+  while (send(m_server, buffer, sizeof(buffer), 0) > 0)
+    ;
+  EXPECT_TRUE(CSocketPoller::WouldBlock());
+  ASSERT_TRUE(m_poller.Modify(m_server, CSocketPoller::EventWrite | CSocketPoller::EventTrigger));
+  EXPECT_EQ(0, m_poller.Wait(m_events, 0));
+}
+
+TEST_F(TestSocketPoller, Remove)
+{
+  ASSERT_TRUE(m_poller.Add(m_server, CSocketPoller::EventRead));
+  ASSERT_EQ(4, send(m_client, "test", 4, 0));
+  ASSERT_EQ(1, m_poller.Wait(m_events, 1000));
+
+  m_poller.Remove(m_server);
+  EXPECT_EQ(0, m_poller.Wait(m_events, 0));
+}
+
+TEST_F(TestSocketPoller, Close)
+{
+  ASSERT_TRUE(m_poller.Add(m_server, CSocketPoller::EventRead | CSocketPoller::EventTrigger));
+  closesocket(m_client);
+  m_client = INVALID_SOCKET;
+
+  ASSERT_EQ(1, m_poller.Wait(m_events, 1000));
+  EXPECT_TRUE((m_events[0].events & CSocketPoller::EventRead) != 0);
+
+  char buffer[16];
+  EXPECT_EQ(0, recv(m_server, buffer, sizeof(buffer), 0));
+}
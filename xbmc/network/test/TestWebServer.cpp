@@ -25,6 +25,7 @@
 #include "system.h"
 #include "URL.h"
 #include "filesystem/CurlFile.h"
+#include "filesystem/DllLibCurl.h"
 #include "filesystem/File.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "network/WebServer.h"
@@ -419,6 +420,25 @@ TEST_F(TestWebServer, CanHeadFile)
   CheckHtmlTestFileResponse(curl);
 }
 
+TEST_F(TestWebServer, CanReuseConnection)
+{
+  g_curlInterface.ResetTransportStats();
+
+  std::string result;
+  CCurlFile curl;
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_HTML), result));
+  ASSERT_STREQ(TEST_FILES_DATA, result.c_str());
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_HTML), result));
+  ASSERT_STREQ(TEST_FILES_DATA, result.c_str());
+
+  XCURL::DllLibCurlGlobal::STransportStats stats = g_curlInterface.GetTransportStats();
+  EXPECT_EQ(2U, stats.requests);
+  EXPECT_EQ(1U, stats.reusedConnections);
+  EXPECT_DOUBLE_EQ(0.5, stats.GetReuseRatio());
+  EXPECT_GT(stats.ttfbMax, 0.0);
+  EXPECT_LE(stats.ttfbMax, stats.ttfbTotal);
+}
+
 TEST_F(TestWebServer, CanNotGetNonExistingFile)
 {
   std::string result;
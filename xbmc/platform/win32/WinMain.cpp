@@ -24,6 +24,7 @@
 #include "platform/xbmc.h"
 #include "utils/CPUInfo.h"
 #include "utils/Environment.h"
+#include "utils/log.h"
 #include "utils/CharsetConverter.h" // Required to initialize converters before usage
 
 #include <dbghelp.h>
@@ -35,6 +36,8 @@ extern "C" int main(int argc, char* argv[]);
 // Minidump creation function
 LONG WINAPI CreateMiniDump(EXCEPTION_POINTERS* pEp)
 {
+  // the lines logged right before the crash are still in the log buffers
+  CLog::Flush();
   win32_exception::write_stacktrace(pEp);
   win32_exception::write_minidump(pEp);
   return pEp->ExceptionRecord->ExceptionCode;
@@ -158,6 +158,7 @@ void CAdvancedSettings::Initialize()
   m_DXVAForceProcessorRenderer = true;
   m_DXVAAllowHqScaling = true;
   m_videoFpsDetect = 1;
+  m_videoProbeCache = true;
   m_videoBusyDialogDelay_ms = 500;
 
   m_mediacodecForceSoftwareRendring = false;
@@ -279,6 +280,7 @@ void CAdvancedSettings::Initialize()
 
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryCleanOnUpdate = false;
+  m_iMusicLibraryScanConnections = 4;
   m_iMusicLibraryRecentlyAddedItems = 25;
   m_strMusicLibraryAlbumFormat = "";
   m_prioritiseAPEv2tags = false;
@@ -291,10 +293,13 @@ void CAdvancedSettings::Initialize()
   m_iVideoLibraryRecentlyAddedItems = 25;
   m_bVideoLibraryCleanOnUpdate = false;
   m_bVideoLibraryUseFastHash = true;
+  m_iVideoLibraryScanConnections = 4;
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
   m_bVideoScannerIgnoreErrors = false;
+  m_iVideoScannerIngestBatchSize = 50;
+  m_iVideoScannerIngestQueueSize = 200;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
   m_iEpgLingerTime = 60 * 24;           /* keep 24 hours by default */
@@ -325,6 +330,8 @@ void CAdvancedSettings::Initialize()
   m_curlretries = 2;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
+  m_curlMaxHostConnections = 6;
+  m_curlUseHttp2 = true;
 
 #if defined(TARGET_DARWIN_IOS)
   m_startFullScreen = true;
@@ -360,6 +367,7 @@ void CAdvancedSettings::Initialize()
   m_iPVRNumericChannelSwitchTimeout = 1000;
 
   m_cacheMemSize = 1024 * 1024 * 20;
+  m_cacheDiskSize = 0; // Disabled, multi range disk cache is opt-in
   m_cacheBufferMode = CACHE_BUFFER_MODE_INTERNET; // Default (buffer all internet streams/filesystems)
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
@@ -369,6 +377,7 @@ void CAdvancedSettings::Initialize()
 
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
+  m_jsonAnnouncementCoalesceTime = 250;
 
 #ifdef HAS_DS_PLAYER
   m_bDSPlayerFastChannelSwitching = true;
@@ -387,6 +396,7 @@ void CAdvancedSettings::Initialize()
 #endif
   m_guiVisualizeDirtyRegions = false;
   m_guiAlgorithmDirtyRegions = 3;
+  m_guiUnusedTextureMemory = 0;
   m_airTunesPort = 36666;
   m_airPlayPort = 36667;
 
@@ -700,6 +710,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "usedisplaycontrolhwstereo", m_useDisplayControlHWStereo);
     //0 = disable fps detect, 1 = only detect on timestamps with uniform spacing, 2 detect on all timestamps
     XMLUtils::GetInt(pElement, "fpsdetect", m_videoFpsDetect, 0, 2);
+    XMLUtils::GetBoolean(pElement, "probecache", m_videoProbeCache);
 
     // controls the delay, in milliseconds, until
     // the busy dialog is shown when starting video playback.
@@ -765,6 +776,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "prioritiseapetags", m_prioritiseAPEv2tags);
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bMusicLibraryCleanOnUpdate);
+    // requests per host fetching folders ahead of the scan, 0 disables prefetching
+    XMLUtils::GetInt(pElement, "scanconnections", m_iMusicLibraryScanConnections, 0, 32);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
     XMLUtils::GetInt(pElement, "dateadded", m_iMusicLibraryDateAdded);
@@ -790,6 +803,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "recentlyaddeditems", m_iVideoLibraryRecentlyAddedItems, 1, INT_MAX);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bVideoLibraryCleanOnUpdate);
     XMLUtils::GetBoolean(pElement, "usefasthash", m_bVideoLibraryUseFastHash);
+    XMLUtils::GetInt(pElement, "scanconnections", m_iVideoLibraryScanConnections, 0, 32);
     XMLUtils::GetString(pElement, "itemseparator", m_videoItemSeparator);
     XMLUtils::GetBoolean(pElement, "exportautothumbs", m_bVideoLibraryExportAutoThumbs);
     XMLUtils::GetBoolean(pElement, "importwatchedstate", m_bVideoLibraryImportWatchedState);
@@ -801,6 +815,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "ignoreerrors", m_bVideoScannerIgnoreErrors);
+    // 0 writes every item right away
+    XMLUtils::GetInt(pElement, "ingestbatchsize", m_iVideoScannerIngestBatchSize, 0, 10000);
+    XMLUtils::GetInt(pElement, "ingestqueuesize", m_iVideoScannerIngestQueueSize, 1, 100000);
   }
 
   // Backward-compatibility of ExternalPlayer config
@@ -824,12 +841,15 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
+    XMLUtils::GetInt(pElement, "curlmaxhostconnections", m_curlMaxHostConnections, 0, 64);
+    XMLUtils::GetBoolean(pElement, "curlhttp2", m_curlUseHttp2);
   }
 
   pElement = pRootElement->FirstChildElement("cache");
   if (pElement)
   {
     XMLUtils::GetUInt(pElement, "memorysize", m_cacheMemSize);
+    XMLUtils::GetUInt(pElement, "disksize", m_cacheDiskSize);
     XMLUtils::GetUInt(pElement, "buffermode", m_cacheBufferMode, 0, 4);
     XMLUtils::GetFloat(pElement, "readfactor", m_cacheReadFactor);
   }
@@ -839,6 +859,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetBoolean(pElement, "compactoutput", m_jsonOutputCompact);
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
+    XMLUtils::GetUInt(pElement, "announcementcoalescetime", m_jsonAnnouncementCoalesceTime, 0, 10000);
   }
 
   pElement = pRootElement->FirstChildElement("samba");
@@ -1225,6 +1246,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetBoolean(pElement, "visualizedirtyregions", m_guiVisualizeDirtyRegions);
     XMLUtils::GetInt(pElement, "algorithmdirtyregions",     m_guiAlgorithmDirtyRegions);
+    XMLUtils::GetUInt(pElement, "unusedtexturememory", m_guiUnusedTextureMemory, 0, 4096);
   }
 
   std::string seekSteps;
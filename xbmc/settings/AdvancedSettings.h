@@ -202,6 +202,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_DXVAForceProcessorRenderer;
     bool m_DXVAAllowHqScaling;
     int  m_videoFpsDetect;
+    bool m_videoProbeCache;
     int  m_videoBusyDialogDelay_ms;
     bool m_mediacodecForceSoftwareRendring;
 
@@ -268,6 +269,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_iMusicLibraryDateAdded;
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryCleanOnUpdate;
+    int m_iMusicLibraryScanConnections;
     std::string m_strMusicLibraryAlbumFormat;
     bool m_prioritiseAPEv2tags;
     std::string m_musicItemSeparator;
@@ -279,11 +281,14 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_iVideoLibraryRecentlyAddedItems;
     bool m_bVideoLibraryCleanOnUpdate;
     bool m_bVideoLibraryUseFastHash;
+    int m_iVideoLibraryScanConnections;
     bool m_bVideoLibraryExportAutoThumbs;
     bool m_bVideoLibraryImportWatchedState;
     bool m_bVideoLibraryImportResumePoint;
 
     bool m_bVideoScannerIgnoreErrors;
+    int m_iVideoScannerIngestBatchSize;
+    int m_iVideoScannerIngestQueueSize;
     int m_iVideoLibraryDateAdded;
 
     std::set<std::string> m_vecTokens;
@@ -310,6 +315,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_curllowspeedtime;
     int m_curlretries;
     bool m_curlDisableIPV6;
+    int m_curlMaxHostConnections;
+    bool m_curlUseHttp2;
 
     bool m_fullScreen;
     bool m_startFullScreen;
@@ -359,14 +366,17 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
 
     bool m_guiVisualizeDirtyRegions;
     int  m_guiAlgorithmDirtyRegions;
+    unsigned int m_guiUnusedTextureMemory; ///< MB of released gui textures kept for reuse, 0 for no limit
     unsigned int m_addonPackageFolderSize;
 
     unsigned int m_cacheMemSize;
+    unsigned int m_cacheDiskSize;
     unsigned int m_cacheBufferMode;
     float m_cacheReadFactor;
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
+    unsigned int m_jsonAnnouncementCoalesceTime; ///< \brief ms an OnUpdate announcement waits for more updates of the same item, 0 to send them right away
 
     bool m_enableMultimediaKeys;
     std::vector<std::string> m_settingsFiles;
@@ -812,6 +812,26 @@ bool CSettings::SetString(const std::string &id, const std::string &value)
   return m_settingsManager->SetString(id, value);
 }
 
+CSettingBoolHandle CSettings::GetBoolHandle(const std::string &id) const
+{
+  return m_settingsManager->GetBoolHandle(id);
+}
+
+CSettingIntHandle CSettings::GetIntHandle(const std::string &id) const
+{
+  return m_settingsManager->GetIntHandle(id);
+}
+
+CSettingNumberHandle CSettings::GetNumberHandle(const std::string &id) const
+{
+  return m_settingsManager->GetNumberHandle(id);
+}
+
+CSettingStringHandle CSettings::GetStringHandle(const std::string &id) const
+{
+  return m_settingsManager->GetStringHandle(id);
+}
+
 std::vector<CVariant> CSettings::GetList(const std::string &id) const
 {
   CSetting *setting = m_settingsManager->GetSetting(id);
@@ -28,6 +28,7 @@
 #include "settings/SettingControl.h"
 #include "settings/SettingCreator.h"
 #include "settings/lib/ISettingCallback.h"
+#include "settings/lib/SettingHandle.h"
 #include "threads/CriticalSection.h"
 
 class CSetting;
@@ -580,6 +581,39 @@ public:
    \return String value of the setting with the given identifier
    */
   std::string GetString(const std::string &id) const;
+
+  /*!
+   \brief Gets a handle to the boolean setting with the given identifier.
+
+   Code which reads a setting very often (e.g. once per frame) should use a
+   handle instead of looking the setting up by its identifier every time.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not a boolean setting
+   \sa CSettingsManager::GetBoolHandle()
+   */
+  CSettingBoolHandle GetBoolHandle(const std::string &id) const;
+  /*!
+   \brief Gets a handle to the integer setting with the given identifier.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not an integer setting
+   */
+  CSettingIntHandle GetIntHandle(const std::string &id) const;
+  /*!
+   \brief Gets a handle to the real number setting with the given identifier.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not a real number setting
+   */
+  CSettingNumberHandle GetNumberHandle(const std::string &id) const;
+  /*!
+   \brief Gets a handle to the string setting with the given identifier.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not a string setting
+   */
+  CSettingStringHandle GetStringHandle(const std::string &id) const;
   /*!
    \brief Gets the values of the list setting with the given identifier.
 
@@ -689,7 +689,7 @@ void CSettingBool::copy(const CSettingBool &setting)
 {
   CSetting::Copy(setting);
 
-  m_value = setting.m_value;
+  m_value = setting.m_value.load();
   m_default = setting.m_default;
 }
   
@@ -981,7 +981,7 @@ void CSettingInt::copy(const CSettingInt &setting)
 
   CExclusiveLock lock(m_critical);
 
-  m_value = setting.m_value;
+  m_value = setting.m_value.load();
   m_default = setting.m_default;
   m_min = setting.m_min;
   m_step = setting.m_step;
@@ -1170,7 +1170,7 @@ void CSettingNumber::copy(const CSettingNumber &setting)
   CSetting::Copy(setting);
   CExclusiveLock lock(m_critical);
 
-  m_value = setting.m_value;
+  m_value = setting.m_value.load();
   m_default = setting.m_default;
   m_min = setting.m_min;
   m_step = setting.m_step;
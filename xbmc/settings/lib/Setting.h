@@ -19,6 +19,7 @@
  *
  */
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <string>
@@ -222,7 +223,7 @@ public:
   virtual bool CheckValidity(const std::string &value) const override;
   virtual void Reset() override { SetValue(m_default); }
 
-  bool GetValue() const { CSharedLock lock(m_critical); return m_value; }
+  bool GetValue() const { return m_value; }
   bool SetValue(bool value);
   bool GetDefault() const { return m_default; }
   void SetDefault(bool value);
@@ -231,7 +232,7 @@ private:
   void copy(const CSettingBool &setting);
   bool fromString(const std::string &strValue, bool &value) const;
 
-  bool m_value;
+  std::atomic<bool> m_value;  ///< read without taking m_critical, see CSettingHandle
   bool m_default;
 };
 
@@ -262,7 +263,7 @@ public:
   virtual bool CheckValidity(int value) const;
   virtual void Reset() override { SetValue(m_default); }
 
-  int GetValue() const { CSharedLock lock(m_critical); return m_value; }
+  int GetValue() const { return m_value; }
   bool SetValue(int value);
   int GetDefault() const { return m_default; }
   void SetDefault(int value);
@@ -294,7 +295,7 @@ private:
   void copy(const CSettingInt &setting);
   static bool fromString(const std::string &strValue, int &value);
 
-  int m_value;
+  std::atomic<int> m_value;  ///< read without taking m_critical, see CSettingHandle
   int m_default;
   int m_min;
   int m_step;
@@ -332,7 +333,7 @@ public:
   virtual bool CheckValidity(double value) const;
   virtual void Reset() override { SetValue(m_default); }
 
-  double GetValue() const { CSharedLock lock(m_critical); return m_value; }
+  double GetValue() const { return m_value; }
   bool SetValue(double value);
   double GetDefault() const { return m_default; }
   void SetDefault(double value);
@@ -348,7 +349,7 @@ private:
   virtual void copy(const CSettingNumber &setting);
   static bool fromString(const std::string &strValue, double &value);
 
-  double m_value;
+  std::atomic<double> m_value;  ///< read without taking m_critical, see CSettingHandle
   double m_default;
   double m_min;
   double m_step;
@@ -0,0 +1,80 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+#include "Setting.h"
+
+/*!
+ \ingroup settings
+ \brief Typed reference to a setting which has been looked up once.
+
+ Reading a setting by its identifier locks the settings manager and searches
+ all settings for the identifier. Code which reads the same setting over and
+ over again (e.g. for every frame or packet) should get a handle for it once
+ and read the value through the handle instead. Reading the value of a
+ boolean, integer or number setting through a handle is a single atomic load.
+
+ A handle stays valid until the settings manager it was resolved from is
+ cleared, unloading and loading the settings (e.g. when switching profiles)
+ keeps it working. A handle to an unknown setting or to a setting of a
+ different type is invalid and returns the same default value as
+ CSettingsManager::GetBool() etc.
+
+ Changes to the value are still announced through ISettingCallback, a handle
+ always returns the current value.
+
+ \sa CSettingsManager::GetBoolHandle()
+ */
+template<class TSetting, typename TValue>
+class CSettingHandle
+{
+public:
+  CSettingHandle()
+    : m_setting(NULL)
+  { }
+  explicit CSettingHandle(TSetting *setting)
+    : m_setting(setting)
+  { }
+
+  bool IsValid() const { return m_setting != NULL; }
+  TSetting* GetSetting() const { return m_setting; }
+
+  TValue Get() const
+  {
+    if (m_setting == NULL)
+      return TValue();
+
+    return m_setting->GetValue();
+  }
+
+private:
+  TSetting *m_setting;
+};
+
+typedef CSettingHandle<CSettingBool, bool> CSettingBoolHandle;
+typedef CSettingHandle<CSettingInt, int> CSettingIntHandle;
+typedef CSettingHandle<CSettingNumber, double> CSettingNumberHandle;
+/*!
+ \brief Handle to a string setting, reading it still takes the lock of the
+ setting itself (but not the one of the settings manager).
+ */
+typedef CSettingHandle<CSettingString, std::string> CSettingStringHandle;
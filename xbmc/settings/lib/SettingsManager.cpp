@@ -610,6 +610,46 @@ bool CSettingsManager::SetString(const std::string &id, const std::string &value
   return ((CSettingString*)setting)->SetValue(value);
 }
 
+CSettingBoolHandle CSettingsManager::GetBoolHandle(const std::string &id) const
+{
+  CSharedLock lock(m_settingsCritical);
+  CSetting *setting = GetSetting(id);
+  if (setting == NULL || setting->GetType() != SettingTypeBool)
+    return CSettingBoolHandle();
+
+  return CSettingBoolHandle((CSettingBool*)setting);
+}
+
+CSettingIntHandle CSettingsManager::GetIntHandle(const std::string &id) const
+{
+  CSharedLock lock(m_settingsCritical);
+  CSetting *setting = GetSetting(id);
+  if (setting == NULL || setting->GetType() != SettingTypeInteger)
+    return CSettingIntHandle();
+
+  return CSettingIntHandle((CSettingInt*)setting);
+}
+
+CSettingNumberHandle CSettingsManager::GetNumberHandle(const std::string &id) const
+{
+  CSharedLock lock(m_settingsCritical);
+  CSetting *setting = GetSetting(id);
+  if (setting == NULL || setting->GetType() != SettingTypeNumber)
+    return CSettingNumberHandle();
+
+  return CSettingNumberHandle((CSettingNumber*)setting);
+}
+
+CSettingStringHandle CSettingsManager::GetStringHandle(const std::string &id) const
+{
+  CSharedLock lock(m_settingsCritical);
+  CSetting *setting = GetSetting(id);
+  if (setting == NULL || setting->GetType() != SettingTypeString)
+    return CSettingStringHandle();
+
+  return CSettingStringHandle((CSettingString*)setting);
+}
+
 std::vector< std::shared_ptr<CSetting> > CSettingsManager::GetList(const std::string &id) const
 {
   CSharedLock lock(m_settingsCritical);
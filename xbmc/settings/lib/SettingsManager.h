@@ -32,6 +32,7 @@
 #include "SettingConditions.h"
 #include "SettingDefinitions.h"
 #include "SettingDependency.h"
+#include "SettingHandle.h"
 #include "threads/SharedSection.h"
 
 class CSettingSection;
@@ -311,6 +312,41 @@ public:
    \return String value of the setting with the given identifier
    */
   std::string GetString(const std::string &id) const;
+
+  /*!
+   \brief Gets a handle to the boolean setting with the given identifier.
+
+   The handle allows reading the value of the setting without looking it up
+   again. It must not be used after the settings have been cleared.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not a boolean setting
+   */
+  CSettingBoolHandle GetBoolHandle(const std::string &id) const;
+  /*!
+   \brief Gets a handle to the integer setting with the given identifier.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not an integer setting
+   \sa GetBoolHandle()
+   */
+  CSettingIntHandle GetIntHandle(const std::string &id) const;
+  /*!
+   \brief Gets a handle to the real number setting with the given identifier.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not a real number setting
+   \sa GetBoolHandle()
+   */
+  CSettingNumberHandle GetNumberHandle(const std::string &id) const;
+  /*!
+   \brief Gets a handle to the string setting with the given identifier.
+
+   \param id Setting identifier
+   \return Handle to the setting or an invalid handle if the identifier is unknown or not a string setting
+   \sa GetBoolHandle()
+   */
+  CSettingStringHandle GetStringHandle(const std::string &id) const;
   /*!
    \brief Gets the values of the list setting with the given identifier.
 
@@ -0,0 +1,166 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "settings/lib/SettingsManager.h"
+#include "threads/SystemClock.h"
+#include "utils/XBMCTinyXML.h"
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+
+namespace
+{
+
+const int BENCHMARK_READS = 1000000;
+
+const char *SETTINGS_DEFINITION =
+  "<settings>"
+  "  <section id=\"test\">"
+  "    <category id=\"test\">"
+  "      <group id=\"1\">"
+  "        <setting id=\"test.bool\" type=\"boolean\"><default>true</default></setting>"
+  "        <setting id=\"test.int\" type=\"integer\">"
+  "          <default>2</default>"
+  "          <constraints><minimum>0</minimum><step>1</step><maximum>10</maximum></constraints>"
+  "        </setting>"
+  "        <setting id=\"test.number\" type=\"number\">"
+  "          <default>1.5</default>"
+  "          <constraints><minimum>0</minimum><step>0.5</step><maximum>10</maximum></constraints>"
+  "        </setting>"
+  "        <setting id=\"test.string\" type=\"string\"><default>value</default></setting>"
+  "      </group>"
+  "    </category>"
+  "  </section>"
+  "</settings>";
+
+class CTestSettingCallback : public ISettingCallback
+{
+public:
+  virtual void OnSettingChanged(const CSetting *setting) override
+  {
+    m_changed++;
+  }
+
+  int m_changed = 0;
+};
+
+class TestSettingHandle : public testing::Test
+{
+protected:
+  TestSettingHandle()
+  {
+    CXBMCTinyXML document;
+    document.Parse(SETTINGS_DEFINITION);
+    m_manager.Initialize(document.RootElement());
+    m_manager.SetLoaded();
+  }
+
+  ~TestSettingHandle()
+  {
+    m_manager.Clear();
+  }
+
+  CSettingsManager m_manager;
+};
+
+}
+
+TEST_F(TestSettingHandle, Read)
+{
+  CSettingBoolHandle boolHandle = m_manager.GetBoolHandle("test.bool");
+  CSettingIntHandle intHandle = m_manager.GetIntHandle("test.int");
+  CSettingNumberHandle numberHandle = m_manager.GetNumberHandle("test.number");
+  CSettingStringHandle stringHandle = m_manager.GetStringHandle("test.string");
+
+  ASSERT_TRUE(boolHandle.IsValid());
+  ASSERT_TRUE(intHandle.IsValid());
+  ASSERT_TRUE(numberHandle.IsValid());
+  ASSERT_TRUE(stringHandle.IsValid());
+
+  EXPECT_EQ(m_manager.GetBool("test.bool"), boolHandle.Get());
+  EXPECT_EQ(m_manager.GetInt("test.int"), intHandle.Get());
+  EXPECT_EQ(m_manager.GetNumber("test.number"), numberHandle.Get());
+  EXPECT_EQ(m_manager.GetString("test.string"), stringHandle.Get());
+  EXPECT_EQ(m_manager.GetSetting("test.int"), intHandle.GetSetting());
+}
+
+TEST_F(TestSettingHandle, Changed)
+{
+  CTestSettingCallback callback;
+  std::set<std::string> settings = { "test.bool", "test.int", "test.number", "test.string" };
+  m_manager.RegisterCallback(&callback, settings);
+
+  CSettingBoolHandle boolHandle = m_manager.GetBoolHandle("test.bool");
+  CSettingIntHandle intHandle = m_manager.GetIntHandle("test.int");
+  CSettingNumberHandle numberHandle = m_manager.GetNumberHandle("test.number");
+  CSettingStringHandle stringHandle = m_manager.GetStringHandle("test.string");
+
+  EXPECT_TRUE(m_manager.SetBool("test.bool", false));
+  EXPECT_TRUE(m_manager.SetInt("test.int", 7));
+  EXPECT_TRUE(m_manager.SetNumber("test.number", 3.5));
+  EXPECT_TRUE(m_manager.SetString("test.string", "changed"));
+  EXPECT_EQ(4, callback.m_changed);
+
+  EXPECT_FALSE(boolHandle.Get());
+  EXPECT_EQ(7, intHandle.Get());
+  EXPECT_EQ(3.5, numberHandle.Get());
+  EXPECT_EQ("changed", stringHandle.Get());
+
+  // an invalid value doesn't change what the handle returns
+  EXPECT_FALSE(m_manager.SetInt("test.int", 11));
+  EXPECT_EQ(7, intHandle.Get());
+
+  m_manager.UnregisterCallback(&callback);
+}
+
+TEST_F(TestSettingHandle, Invalid)
+{
+  CSettingIntHandle unknown = m_manager.GetIntHandle("test.unknown");
+  EXPECT_FALSE(unknown.IsValid());
+  EXPECT_EQ(0, unknown.Get());
+
+  // the type of the handle has to match the type of the setting
+  CSettingBoolHandle wrongType = m_manager.GetBoolHandle("test.int");
+  EXPECT_FALSE(wrongType.IsValid());
+  EXPECT_FALSE(wrongType.Get());
+
+  EXPECT_EQ("", CSettingStringHandle().Get());
+}
+
+TEST_F(TestSettingHandle, Read_Benchmark)
+{
+  CSettingIntHandle handle = m_manager.GetIntHandle("test.int");
+  int sum = 0;
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < BENCHMARK_READS; i++)
+    sum += m_manager.GetInt("test.int");
+  unsigned int elapsedId = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < BENCHMARK_READS; i++)
+    sum += handle.Get();
+  unsigned int elapsedHandle = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_READS << " reads of an integer setting: " << elapsedId << " ms by identifier, "
+            << elapsedHandle << " ms through a handle" << std::endl;
+  EXPECT_EQ(2 * 2 * BENCHMARK_READS, sum);
+}
@@ -136,3 +136,48 @@ const TestFileData BaseMovies[] = {{ "c:\\dir\\filename.avi", false, "c:\\dir\\f
                                    { "/home/user/movies/movie_name/BDMV/index.bdmv", true, "/home/user/movies/movie_name/" }};
 
 INSTANTIATE_TEST_CASE_P(BaseNameMovies, TestFileItemBasePath, ValuesIn(BaseMovies));
+
+TEST(TestFileItemList, ShareCopiesItemsOnAccess)
+{
+  CFileItemList cached;
+  cached.Add(CFileItemPtr(new CFileItem("/dir/a.avi", false)));
+  cached.Add(CFileItemPtr(new CFileItem("/dir/b.avi", false)));
+  cached.SetFastLookup(true);
+  const CFileItem *first = cached.GetList()[0].get();
+
+  CFileItemList items;
+  items.Share(cached);
+  EXPECT_EQ(2, items.Size());
+
+  CFileItemPtr item = items[0];
+  EXPECT_NE(first, item.get());
+  item->SetLabel("changed");
+  item->SetPath("/dir/c.avi");
+  EXPECT_EQ("", cached[0]->GetLabel());
+  EXPECT_EQ("/dir/a.avi", cached[0]->GetPath());
+  EXPECT_TRUE(cached.Contains("/dir/a.avi"));
+
+  // handed out once, the copy stays
+  EXPECT_EQ(item.get(), items[0].get());
+
+  items.Remove(1);
+  EXPECT_EQ(1, items.Size());
+  EXPECT_EQ(2, cached.Size());
+}
+
+TEST(TestFileItemList, ShareFastLookup)
+{
+  CFileItemList cached;
+  cached.Add(CFileItemPtr(new CFileItem("/dir/a.avi", false)));
+  cached.Add(CFileItemPtr(new CFileItem("/dir/b.avi", false)));
+
+  CFileItemList items;
+  items.SetFastLookup(true);
+  items.Share(cached);
+
+  CFileItemPtr item = items.Get("/dir/b.avi");
+  ASSERT_TRUE(item != nullptr);
+  item->SetLabel("changed");
+  EXPECT_EQ("", cached[1]->GetLabel());
+  EXPECT_EQ(item.get(), items[1].get());
+}
@@ -22,24 +22,42 @@
 
 using namespace Actor;
 
-void Message::Release()
-{
-  bool skip;
-  origin->Lock();
-  skip = isSync ? !isSyncFini : false;
-  isSyncFini = true;
-  origin->Unlock();
+/* the free messages a protocol keeps, all of them are allocated up front */
+#define MSG_POOL_SIZE 32
 
-  if (skip)
-    return;
-
-  // free data buffer
-  if (data != buffer)
-    delete [] data;
+void Message::SetData(void *payload, int size)
+{
+  if (size > MSG_INTERNAL_BUFFER_SIZE)
+  {
+    // the buffer stays with the message, so a protocol that sends large
+    // payloads stops allocating once its messages have grown to them
+    if (size > heapDataSize)
+    {
+      delete [] heapData;
+      heapData = new uint8_t[size];
+      heapDataSize = size;
+    }
+    data = heapData;
+  }
+  else
+    data = buffer;
+  memcpy(data, payload, size);
+  payloadSize = size;
+}
 
-  // delete event in case of sync message
-  if (event)
-    delete event;
+void Message::Release()
+{
+  if (isSync)
+  {
+    bool skip;
+    origin->Lock();
+    skip = !isSyncFini;
+    isSyncFini = true;
+    origin->Unlock();
+
+    if (skip)
+      return;
+  }
 
   origin->ReturnMessage(this);
 }
@@ -63,13 +81,7 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
     msg->isOut = !isOut;
     replyMessage = msg;
     if (data)
-    {
-      if (size > MSG_INTERNAL_BUFFER_SIZE)
-        msg->data = new uint8_t[size];
-      else
-        msg->data = msg->buffer;
-      memcpy(msg->data, data, size);
-    }
+      msg->SetData(data, size);
   }
 
   origin->Unlock();
@@ -80,36 +92,143 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
   return true;
 }
 
-Protocol::~Protocol()
+MessageQueue::MessageQueue() :
+  m_head(&m_stub),
+  m_tail(&m_stub)
 {
-  Message *msg;
-  Purge();
-  while (!freeMessageQueue.empty())
+}
+
+void MessageQueue::Push(Message *msg)
+{
+  msg->next.store(NULL, std::memory_order_relaxed);
+  Message *prev = m_head.exchange(msg, std::memory_order_acq_rel);
+  prev->next.store(msg, std::memory_order_release);
+}
+
+Message *MessageQueue::Pop()
+{
+  Message *tail = m_tail;
+  Message *next = tail->next.load(std::memory_order_acquire);
+  if (tail == &m_stub)
   {
-    msg = freeMessageQueue.front();
-    freeMessageQueue.pop();
-    delete msg;
+    if (!next)
+      return NULL;
+    m_tail = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next)
+  {
+    m_tail = next;
+    return tail;
+  }
+
+  // the last message can only be taken with the stub behind it, unless a
+  // sender is just appending to it
+  if (tail != m_head.load(std::memory_order_acquire))
+    return NULL;
+
+  Push(&m_stub);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next)
+  {
+    m_tail = next;
+    return tail;
   }
+  return NULL;
 }
 
-Message *Protocol::GetMessage()
+MessagePool::MessagePool(size_t size) :
+  m_cells(size),
+  m_mask(size - 1),
+  m_pushPos(0),
+  m_popPos(0)
 {
-  Message *msg;
+  for (size_t i = 0; i < size; i++)
+  {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    m_cells[i].msg = NULL;
+  }
+}
 
-  CSingleLock lock(criticalSection);
+bool MessagePool::Push(Message *msg)
+{
+  size_t pos = m_pushPos.load(std::memory_order_relaxed);
+  while (true)
+  {
+    Cell &cell = m_cells[pos & m_mask];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+      {
+        cell.msg = msg;
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (diff < 0)
+      return false;
+    else
+      pos = m_pushPos.load(std::memory_order_relaxed);
+  }
+}
 
-  if (!freeMessageQueue.empty())
+Message *MessagePool::Pop()
+{
+  size_t pos = m_popPos.load(std::memory_order_relaxed);
+  while (true)
   {
-    msg = freeMessageQueue.front();
-    freeMessageQueue.pop();
+    Cell &cell = m_cells[pos & m_mask];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+    if (diff == 0)
+    {
+      if (m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+      {
+        Message *msg = cell.msg;
+        cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return msg;
+      }
+    }
+    else if (diff < 0)
+      return NULL;
+    else
+      pos = m_popPos.load(std::memory_order_relaxed);
   }
-  else
+}
+
+Protocol::Protocol(std::string name, CEvent* inEvent, CEvent *outEvent) :
+  portName(name),
+  containerInEvent(inEvent),
+  containerOutEvent(outEvent),
+  freeMessages(MSG_POOL_SIZE),
+  inDefered(false),
+  outDefered(false)
+{
+  for (int i = 0; i < MSG_POOL_SIZE; i++)
+    freeMessages.Push(new Message());
+}
+
+Protocol::~Protocol()
+{
+  Message *msg;
+  Purge();
+  while ((msg = freeMessages.Pop()))
+    delete msg;
+}
+
+Message *Protocol::GetMessage()
+{
+  Message *msg = freeMessages.Pop();
+  if (!msg)
     msg = new Message();
 
   msg->isSync = false;
   msg->isSyncFini = false;
   msg->isSyncTimeout = false;
-  msg->event = NULL;
   msg->data = NULL;
   msg->payloadSize = 0;
   msg->replyMessage = NULL;
@@ -120,9 +239,8 @@ Message *Protocol::GetMessage()
 
 void Protocol::ReturnMessage(Message *msg)
 {
-  CSingleLock lock(criticalSection);
-
-  freeMessageQueue.push(msg);
+  if (!freeMessages.Push(msg))
+    delete msg;
 }
 
 bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* = 0 */, Message *outMsg /* = NULL */)
@@ -137,17 +255,9 @@ bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* =
   msg->isOut = true;
 
   if (data)
-  {
-    if (size > MSG_INTERNAL_BUFFER_SIZE)
-      msg->data = new uint8_t[size];
-    else
-      msg->data = msg->buffer;
-    memcpy(msg->data, data, size);
-  }
+    msg->SetData(data, size);
 
-  { CSingleLock lock(criticalSection);
-    outMessages.push(msg);
-  }
+  outMessages.messages.Push(msg);
   containerOutEvent->Set();
 
   return true;
@@ -165,17 +275,9 @@ bool Protocol::SendInMessage(int signal, void *data /* = NULL */, int size /* =
   msg->isOut = false;
 
   if (data)
-  {
-    if (size > MSG_INTERNAL_BUFFER_SIZE)
-      msg->data = new uint8_t[size];
-    else
-      msg->data = msg->buffer;
-    memcpy(msg->data, data, size);
-  }
+    msg->SetData(data, size);
 
-  { CSingleLock lock(criticalSection);
-    inMessages.push(msg);
-  }
+  inMessages.messages.Push(msg);
   containerInEvent->Set();
 
   return true;
@@ -187,7 +289,9 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
   Message *msg = GetMessage();
   msg->isOut = true;
   msg->isSync = true;
-  msg->event = new CEvent;
+  // pooled messages keep their event for the next sync message
+  if (!msg->event)
+    msg->event = new CEvent;
   msg->event->Reset();
   SendOutMessage(signal, data, size, msg);
 
@@ -214,30 +318,35 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
     return false;
 }
 
-bool Protocol::ReceiveOutMessage(Message **msg)
+bool Protocol::Receive(Mailbox &mailbox, Message **msg)
 {
-  CSingleLock lock(criticalSection);
+  CSingleLock lock(mailbox.receiveSection);
 
-  if (outMessages.empty() || outDefered)
-    return false;
+  if (!mailbox.kept.empty())
+  {
+    *msg = mailbox.kept.front();
+    mailbox.kept.pop_front();
+    return true;
+  }
 
-  *msg = outMessages.front();
-  outMessages.pop();
+  *msg = mailbox.messages.Pop();
+  return *msg != NULL;
+}
 
-  return true;
+bool Protocol::ReceiveOutMessage(Message **msg)
+{
+  if (outDefered)
+    return false;
+
+  return Receive(outMessages, msg);
 }
 
 bool Protocol::ReceiveInMessage(Message **msg)
 {
-  CSingleLock lock(criticalSection);
-
-  if (inMessages.empty() || inDefered)
+  if (inDefered)
     return false;
 
-  *msg = inMessages.front();
-  inMessages.pop();
-
-  return true;
+  return Receive(inMessages, msg);
 }
 
 
@@ -245,53 +354,36 @@ void Protocol::Purge()
 {
   Message *msg;
 
-  while (ReceiveInMessage(&msg))
+  while (Receive(inMessages, &msg))
     msg->Release();
 
-  while (ReceiveOutMessage(&msg))
+  while (Receive(outMessages, &msg))
     msg->Release();
 }
 
-void Protocol::PurgeIn(int signal)
+void Protocol::Purge(Mailbox &mailbox, int signal)
 {
   Message *msg;
-  std::queue<Message*> msgs;
+  std::deque<Message*> msgs;
 
-  CSingleLock lock(criticalSection);
+  CSingleLock lock(mailbox.receiveSection);
 
-  while (!inMessages.empty())
+  while (Receive(mailbox, &msg))
   {
-    msg = inMessages.front();
-    inMessages.pop();
     if (msg->signal != signal)
-      msgs.push(msg);
-  }
-  while (!msgs.empty())
-  {
-    msg = msgs.front();
-    msgs.pop();
-    inMessages.push(msg);
+      msgs.push_back(msg);
+    else
+      msg->Release();
   }
+  mailbox.kept.swap(msgs);
 }
 
-void Protocol::PurgeOut(int signal)
+void Protocol::PurgeIn(int signal)
 {
-  Message *msg;
-  std::queue<Message*> msgs;
-
-  CSingleLock lock(criticalSection);
+  Purge(inMessages, signal);
+}
 
-  while (!outMessages.empty())
-  {
-    msg = outMessages.front();
-    outMessages.pop();
-    if (msg->signal != signal)
-      msgs.push(msg);
-  }
-  while (!msgs.empty())
-  {
-    msg = msgs.front();
-    msgs.pop();
-    outMessages.push(msg);
-  }
+void Protocol::PurgeOut(int signal)
+{
+  Purge(outMessages, signal);
 }
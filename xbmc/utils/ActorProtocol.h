@@ -21,7 +21,9 @@
 #pragma once
 
 #include "threads/Thread.h"
-#include <queue>
+#include <atomic>
+#include <deque>
+#include <vector>
 #include "memory.h"
 
 #define MSG_INTERNAL_BUFFER_SIZE 32
@@ -34,6 +36,7 @@ class Protocol;
 class Message
 {
   friend class Protocol;
+  friend class MessageQueue;
 public:
   int signal;
   bool isSync;
@@ -51,14 +54,65 @@ public:
   bool Reply(int sig, void *data = NULL, int size = 0);
 
 private:
-  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL;};
+  Message() : next(NULL), heapData(NULL), heapDataSize(0) {isSync = false; data = NULL; event = NULL; replyMessage = NULL;};
+  ~Message() { delete [] heapData; delete event; };
+  void SetData(void *payload, int size);
+
+  std::atomic<Message*> next;  ///< links the message in a queue
+  uint8_t *heapData;           ///< payloads larger than the internal buffer, kept for the next use of the message
+  int heapDataSize;
+};
+
+/*!
+ \brief Queue of messages that any number of threads can send to without locking.
+
+ Only one thread at a time may take messages out of it, the protocol
+ serialises that with a lock that senders never take. A message that is
+ pushed while the queue is read may not be seen until the next read; the
+ sender sets the event of the container afterwards, so it is never lost.
+ */
+class MessageQueue
+{
+public:
+  MessageQueue();
+  void Push(Message *msg);
+  Message *Pop();
+
+private:
+  MessageQueue(const MessageQueue&);
+  MessageQueue& operator=(const MessageQueue&);
+
+  std::atomic<Message*> m_head;  ///< the last message, where senders append
+  Message *m_tail;               ///< the first message, only used by the reader
+  Message m_stub;
+};
+
+/*!
+ \brief Bounded pool of free messages that any thread can take from and return to without locking.
+ */
+class MessagePool
+{
+public:
+  explicit MessagePool(size_t size);
+  bool Push(Message *msg);
+  Message *Pop();
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    Message *msg;
+  };
+  std::vector<Cell> m_cells;
+  size_t m_mask;
+  std::atomic<size_t> m_pushPos;
+  std::atomic<size_t> m_popPos;
 };
 
 class Protocol
 {
 public:
-  Protocol(std::string name, CEvent* inEvent, CEvent *outEvent)
-    : portName(name), inDefered(false), outDefered(false) {containerInEvent = inEvent; containerOutEvent = outEvent;};
+  Protocol(std::string name, CEvent* inEvent, CEvent *outEvent);
   virtual ~Protocol();
   Message *GetMessage();
   void ReturnMessage(Message *msg);
@@ -77,12 +131,22 @@ public:
   std::string portName;
 
 protected:
+  // a direction of the protocol, any thread can send, the receiving side is serialised by receiveSection
+  struct Mailbox
+  {
+    MessageQueue messages;
+    std::deque<Message*> kept;  ///< messages taken out of the queue by a purge, they come first
+    CCriticalSection receiveSection;
+  };
+  bool Receive(Mailbox &mailbox, Message **msg);
+  void Purge(Mailbox &mailbox, int signal);
+
   CEvent *containerInEvent, *containerOutEvent;
-  CCriticalSection criticalSection;
-  std::queue<Message*> outMessages;
-  std::queue<Message*> inMessages;
-  std::queue<Message*> freeMessageQueue;
-  bool inDefered, outDefered;
+  CCriticalSection criticalSection;  ///< guards the hand over of the reply to a sync message
+  Mailbox outMessages;
+  Mailbox inMessages;
+  MessagePool freeMessages;
+  std::atomic<bool> inDefered, outDefered;
 };
 
 }
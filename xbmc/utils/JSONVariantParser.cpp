@@ -34,9 +34,10 @@ yajl_callbacks CJSONVariantParser::callbacks = {
   CJSONVariantParser::ParseArrayEnd
 };
 
-CJSONVariantParser::CJSONVariantParser(IParseCallback *callback)
+CJSONVariantParser::CJSONVariantParser(IParseCallback *callback, CVariantArena *arena /* = NULL */)
 {
   m_callback = callback;
+  m_arena = arena;
 
   m_handler = yajl_alloc(&callbacks, NULL, this);
 
@@ -69,7 +70,17 @@ CVariant CJSONVariantParser::Parse(const unsigned char *json, unsigned int lengt
 
   parser.push_buffer(json, length);
 
-  return callback.GetOutput();
+  return std::move(callback.GetOutput());
+}
+
+CVariant CJSONVariantParser::Parse(const unsigned char *json, unsigned int length, CVariantArena &arena)
+{
+  CSimpleParseCallback callback;
+  CJSONVariantParser parser(&callback, &arena);
+
+  parser.push_buffer(json, length);
+
+  return std::move(callback.GetOutput());
 }
 
 int CJSONVariantParser::ParseNull(void * ctx)
@@ -116,7 +127,10 @@ int CJSONVariantParser::ParseString(void * ctx, const unsigned char * stringVal,
 {
   CJSONVariantParser *parser = (CJSONVariantParser *)ctx;
 
-  parser->PushObject(CVariant((const char *)stringVal, stringLen));
+  if (parser->m_arena)
+    parser->PushObject(CVariant((const char *)stringVal, stringLen, *parser->m_arena));
+  else
+    parser->PushObject(CVariant((const char *)stringVal, stringLen));
   parser->PopObject();
 
   return 1;
@@ -126,7 +140,10 @@ int CJSONVariantParser::ParseMapStart(void * ctx)
 {
   CJSONVariantParser *parser = (CJSONVariantParser *)ctx;
 
-  parser->PushObject(CVariant::VariantTypeObject);
+  if (parser->m_arena)
+    parser->PushObject(CVariant(CVariant::VariantTypeObject, *parser->m_arena));
+  else
+    parser->PushObject(CVariant::VariantTypeObject);
 
   return 1;
 }
@@ -135,7 +152,7 @@ int CJSONVariantParser::ParseMapKey(void * ctx, const unsigned char * stringVal,
 {
   CJSONVariantParser *parser = (CJSONVariantParser *)ctx;
 
-  parser->m_key = std::string((const char *)stringVal, 0, stringLen);
+  parser->m_key.assign((const char *)stringVal, stringLen);
 
   return 1;
 }
@@ -153,7 +170,10 @@ int CJSONVariantParser::ParseArrayStart(void * ctx)
 {
   CJSONVariantParser *parser = (CJSONVariantParser *)ctx;
 
-  parser->PushObject(CVariant::VariantTypeArray);
+  if (parser->m_arena)
+    parser->PushObject(CVariant(CVariant::VariantTypeArray, *parser->m_arena));
+  else
+    parser->PushObject(CVariant::VariantTypeArray);
 
   return 1;
 }
@@ -167,27 +187,30 @@ int CJSONVariantParser::ParseArrayEnd(void * ctx)
   return 1;
 }
 
-void CJSONVariantParser::PushObject(CVariant variant)
+void CJSONVariantParser::PushObject(CVariant &&variant)
 {
+  CVariant::VariantType type = variant.type();
+
   if (m_status == ParseObject)
   {
-    (*m_parse[m_parse.size() - 1])[m_key] = variant;
-    m_parse.push_back(&(*m_parse[m_parse.size() - 1])[m_key]);
+    CVariant &value = (*m_parse[m_parse.size() - 1])[m_key];
+    value = std::move(variant);
+    m_parse.push_back(&value);
   }
   else if (m_status == ParseArray)
   {
     CVariant *temp = m_parse[m_parse.size() - 1];
-    temp->push_back(variant);
+    temp->push_back(std::move(variant));
     m_parse.push_back(&(*temp)[temp->size() - 1]);
   }
   else if (m_parse.empty())
   {
-    m_parse.push_back(new CVariant(variant));
+    m_parse.push_back(new CVariant(std::move(variant)));
   }
 
-  if (variant.isObject())
+  if (type == CVariant::VariantTypeObject)
     m_status = ParseObject;
-  else if (variant.isArray())
+  else if (type == CVariant::VariantTypeArray)
     m_status = ParseArray;
   else
     m_status = ParseVariable;
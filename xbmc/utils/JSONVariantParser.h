@@ -20,6 +20,7 @@
  */
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "utils/Variant.h"
@@ -37,7 +38,7 @@ public:
 class CSimpleParseCallback : public IParseCallback
 {
 public:
-  virtual void onParsed(CVariant *variant) { m_parsed = *variant; }
+  virtual void onParsed(CVariant *variant) { m_parsed = std::move(*variant); }
   CVariant &GetOutput() { return m_parsed; }
 
 private:
@@ -47,12 +48,18 @@ private:
 class CJSONVariantParser
 {
 public:
-  CJSONVariantParser(IParseCallback *callback);
+  /*!
+   \brief Create a parser.
+   \param callback gets the parsed values.
+   \param arena if not NULL, the strings and containers of the parsed values are allocated from it.
+   */
+  CJSONVariantParser(IParseCallback *callback, CVariantArena *arena = NULL);
   ~CJSONVariantParser();
 
   void push_buffer(const unsigned char *buffer, unsigned int length);
 
   static CVariant Parse(const unsigned char *json, unsigned int length);
+  static CVariant Parse(const unsigned char *json, unsigned int length, CVariantArena &arena);
 
   static CVariant Parse(const std::string& json);
 
@@ -68,12 +75,13 @@ private:
   static int ParseArrayStart(void * ctx);
   static int ParseArrayEnd(void * ctx);
 
-  void PushObject(CVariant variant);
+  void PushObject(CVariant &&variant);
   void PopObject();
 
   static yajl_callbacks callbacks;
 
   IParseCallback *m_callback;
+  CVariantArena *m_arena;
   yajl_handle m_handler;
 
   CVariant m_parsedObject;
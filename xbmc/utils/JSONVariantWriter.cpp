@@ -21,108 +21,204 @@
 #include <locale>
 
 #include "JSONVariantWriter.h"
-#include "utils/Variant.h"
+
+namespace
+{
+
+// Set locale to classic ("C") to ensure valid JSON numbers
+class CClassicNumericLocale
+{
+public:
+  CClassicNumericLocale()
+  {
+#ifndef TARGET_WINDOWS
+    const char *currentLocale = setlocale(LC_NUMERIC, NULL);
+    if (currentLocale != NULL && (currentLocale[0] != 'C' || currentLocale[1] != 0))
+    {
+      m_backupLocale = currentLocale;
+      setlocale(LC_NUMERIC, "C");
+    }
+#else  // TARGET_WINDOWS
+    const wchar_t* const currentLocale = _wsetlocale(LC_NUMERIC, NULL);
+    if (currentLocale != NULL && (currentLocale[0] != L'C' || currentLocale[1] != 0))
+    {
+      m_backupLocale = currentLocale;
+      _wsetlocale(LC_NUMERIC, L"C");
+    }
+#endif // TARGET_WINDOWS
+  }
+
+  // Re-set locale to what it was before using yajl
+  ~CClassicNumericLocale()
+  {
+#ifndef TARGET_WINDOWS
+    if (!m_backupLocale.empty())
+      setlocale(LC_NUMERIC, m_backupLocale.c_str());
+#else  // TARGET_WINDOWS
+    if (!m_backupLocale.empty())
+      _wsetlocale(LC_NUMERIC, m_backupLocale.c_str());
+#endif // TARGET_WINDOWS
+  }
+
+private:
+#ifndef TARGET_WINDOWS
+  std::string m_backupLocale;
+#else  // TARGET_WINDOWS
+  std::wstring m_backupLocale;
+#endif // TARGET_WINDOWS
+};
+
+}
+
+CJSONVariantWriter::CJSONVariantWriter(const CVariant &value, bool compact)
+  : m_generator(yajl_gen_alloc(NULL)),
+    m_value(&value),
+    m_streamed(NULL),
+    m_finished(false),
+    m_failed(false)
+{
+  yajl_gen_config(m_generator, yajl_gen_beautify, compact ? 0 : 1);
+  yajl_gen_config(m_generator, yajl_gen_indent_string, "\t");
+}
+
+CJSONVariantWriter::~CJSONVariantWriter()
+{
+  yajl_gen_clear(m_generator);
+  yajl_gen_free(m_generator);
+}
+
+void CJSONVariantWriter::StreamArray(const CVariant &array, const ItemSource &source)
+{
+  m_streamed = &array;
+  m_source = source;
+}
 
 std::string CJSONVariantWriter::Write(const CVariant &value, bool compact)
 {
   std::string output;
 
-  yajl_gen g = yajl_gen_alloc(NULL);
-  yajl_gen_config(g, yajl_gen_beautify, compact ? 0 : 1);
-  yajl_gen_config(g, yajl_gen_indent_string, "\t");
+  CJSONVariantWriter writer(value, compact);
+  if (!writer.WriteChunk(output, std::string::npos))
+    output.clear();
 
-  // Set locale to classic ("C") to ensure valid JSON numbers
-#ifndef TARGET_WINDOWS
-  const char *currentLocale = setlocale(LC_NUMERIC, NULL);
-  std::string backupLocale;
-  if (currentLocale != NULL && (currentLocale[0] != 'C' || currentLocale[1] != 0))
+  return output;
+}
+
+bool CJSONVariantWriter::WriteChunk(std::string &output, size_t size)
+{
+  if (m_failed)
+    return false;
+
+  CClassicNumericLocale locale;
+
+  const unsigned char *buffer;
+  size_t length = 0;
+  while (!m_finished && length < size)
   {
-    backupLocale = currentLocale;
-    setlocale(LC_NUMERIC, "C");
+    if (!WriteNext())
+    {
+      m_failed = true;
+      return false;
+    }
+
+    m_finished = m_value == NULL && m_containers.empty();
+    yajl_gen_get_buf(m_generator, &buffer, &length);
   }
-#else  // TARGET_WINDOWS
-  const wchar_t* const currentLocale = _wsetlocale(LC_NUMERIC, NULL);
-  std::wstring backupLocale;
-  if (currentLocale != NULL && (currentLocale[0] != L'C' || currentLocale[1] != 0))
+
+  yajl_gen_get_buf(m_generator, &buffer, &length);
+  output.append((const char *)buffer, length);
+  yajl_gen_clear(m_generator);
+
+  return true;
+}
+
+bool CJSONVariantWriter::WriteNext()
+{
+  if (m_value != NULL)
   {
-    backupLocale = currentLocale;
-    _wsetlocale(LC_NUMERIC, L"C");
+    const CVariant *value = m_value;
+    m_value = NULL;
+    return WriteValue(*value);
   }
-#endif // TARGET_WINDOWS
 
-  if (InternalWrite(g, value))
+  // WriteValue() may add a container, so advance the current one first
+  Container &container = m_containers.back();
+  if (container.value->isArray())
   {
-    const unsigned char * buffer;
+    if (container.array == container.value->end_array())
+    {
+      // the previous item of the source is written completely by now
+      if (container.value == m_streamed)
+      {
+        bool done = false;
+        m_streamedItem = CVariant();
+        if (!m_source(m_streamedItem, done))
+          return false;
+        if (!done)
+          return WriteValue(m_streamedItem);
+
+        m_streamed = NULL;
+        m_source = nullptr;
+      }
+
+      m_containers.pop_back();
+      return yajl_gen_status_ok == yajl_gen_array_close(m_generator);
+    }
 
-    size_t length;
-    yajl_gen_get_buf(g, &buffer, &length);
-    output = std::string((const char *)buffer, length);
+    const CVariant &item = *container.array++;
+    return WriteValue(item);
   }
 
-  // Re-set locale to what it was before using yajl
-#ifndef TARGET_WINDOWS
-  if (!backupLocale.empty())
-    setlocale(LC_NUMERIC, backupLocale.c_str());
-#else  // TARGET_WINDOWS
-  if (!backupLocale.empty())
-    _wsetlocale(LC_NUMERIC, backupLocale.c_str());
-#endif // TARGET_WINDOWS
+  if (container.map == container.value->end_map())
+  {
+    m_containers.pop_back();
+    return yajl_gen_status_ok == yajl_gen_map_close(m_generator);
+  }
 
-  yajl_gen_clear(g);
-  yajl_gen_free(g);
+  const std::string &key = container.map->first;
+  const CVariant &item = container.map->second;
+  ++container.map;
+  if (yajl_gen_status_ok != yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), (size_t)key.length()))
+    return false;
 
-  return output;
+  return WriteValue(item);
 }
 
-bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
+bool CJSONVariantWriter::WriteValue(const CVariant &value)
 {
   bool success = false;
 
   switch (value.type())
   {
   case CVariant::VariantTypeInteger:
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long long int)value.asInteger());
+    success = yajl_gen_status_ok == yajl_gen_integer(m_generator, (long long int)value.asInteger());
     break;
   case CVariant::VariantTypeUnsignedInteger:
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long long int)value.asUnsignedInteger());
+    success = yajl_gen_status_ok == yajl_gen_integer(m_generator, (long long int)value.asUnsignedInteger());
     break;
   case CVariant::VariantTypeDouble:
-    success = yajl_gen_status_ok == yajl_gen_double(g, value.asDouble());
+    success = yajl_gen_status_ok == yajl_gen_double(m_generator, value.asDouble());
     break;
   case CVariant::VariantTypeBoolean:
-    success = yajl_gen_status_ok == yajl_gen_bool(g, value.asBoolean() ? 1 : 0);
+    success = yajl_gen_status_ok == yajl_gen_bool(m_generator, value.asBoolean() ? 1 : 0);
     break;
   case CVariant::VariantTypeString:
-    success = yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)value.c_str(), (size_t)value.size());
+    success = yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)value.c_str(), (size_t)value.size());
     break;
   case CVariant::VariantTypeArray:
-    success = yajl_gen_status_ok == yajl_gen_array_open(g);
-
-    for (CVariant::const_iterator_array itr = value.begin_array(); itr != value.end_array() && success; ++itr)
-      success &= InternalWrite(g, *itr);
-
+    success = yajl_gen_status_ok == yajl_gen_array_open(m_generator);
     if (success)
-      success = yajl_gen_status_ok == yajl_gen_array_close(g);
-
+      m_containers.push_back(Container{ &value, value.begin_array(), CVariant::const_iterator_map() });
     break;
   case CVariant::VariantTypeObject:
-    success = yajl_gen_status_ok == yajl_gen_map_open(g);
-
-    for (CVariant::const_iterator_map itr = value.begin_map(); itr != value.end_map() && success; ++itr)
-    {
-      success &= yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)itr->first.c_str(), (size_t)itr->first.length());
-      if (success)
-        success &= InternalWrite(g, itr->second);
-    }
-
+    success = yajl_gen_status_ok == yajl_gen_map_open(m_generator);
     if (success)
-      success &= yajl_gen_status_ok == yajl_gen_map_close(g);
-
+      m_containers.push_back(Container{ &value, CVariant::const_iterator_array(), value.begin_map() });
     break;
   case CVariant::VariantTypeConstNull:
   case CVariant::VariantTypeNull:
   default:
-    success = yajl_gen_status_ok == yajl_gen_null(g);
+    success = yajl_gen_status_ok == yajl_gen_null(m_generator);
     break;
   }
 
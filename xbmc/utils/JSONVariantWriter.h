@@ -20,14 +20,76 @@
  */
 
 #include <yajl/yajl_gen.h>
+#include <functional>
 #include <string>
+#include <vector>
 
-class CVariant;
+#include "utils/Variant.h"
 
+/*!
+ \brief Serialises a CVariant to JSON.
+
+ Besides serialising a whole value at once, an instance writes a value in
+ chunks of about a given size, so large responses can be sent while they are
+ being serialised. The concatenated chunks are exactly what Write() returns.
+ The value must not change until the writer is finished.
+
+ The items of one array may also be produced while it is written, e.g. read
+ one by one from a database, so a long list is never held as a whole.
+ */
 class CJSONVariantWriter
 {
 public:
+  typedef std::function<bool(CVariant &item, bool &done)> ItemSource;
+
+  CJSONVariantWriter(const CVariant &value, bool compact);
+  ~CJSONVariantWriter();
+
+  /*!
+   \brief Write the items of a source after the items of an array.
+   \param array an array in the value.
+   \param source called whenever the next item is written, sets item or sets
+   done once there are no more items. Returns false if the item couldn't be
+   produced, the value can't be serialised then.
+   */
+  void StreamArray(const CVariant &array, const ItemSource &source);
+
+  /*!
+   \brief Serialise the next part of the value.
+   \param output the JSON is appended to this.
+   \param size number of bytes to write, the last chunk may be shorter and a
+   chunk may be a little longer to finish the current string.
+   \return false if the value couldn't be serialised, true otherwise.
+   */
+  bool WriteChunk(std::string &output, size_t size);
+
+  /*!
+   \brief Whether the whole value has been written.
+   */
+  bool IsFinished() const { return m_finished; }
+
   static std::string Write(const CVariant &value, bool compact);
+
 private:
-  static bool InternalWrite(yajl_gen g, const CVariant &value);
+  CJSONVariantWriter(const CJSONVariantWriter&) = delete;
+  CJSONVariantWriter& operator=(const CJSONVariantWriter&) = delete;
+
+  struct Container
+  {
+    const CVariant *value;
+    CVariant::const_iterator_array array;
+    CVariant::const_iterator_map map;
+  };
+
+  bool WriteNext();
+  bool WriteValue(const CVariant &value);
+
+  yajl_gen m_generator;
+  const CVariant *m_value;            ///< the value until writing has started
+  std::vector<Container> m_containers; ///< the arrays and objects being written, the innermost last
+  const CVariant *m_streamed;          ///< the array that is continued by m_source
+  ItemSource m_source;
+  CVariant m_streamedItem;             ///< the item of m_source being written
+  bool m_finished;
+  bool m_failed;
 };
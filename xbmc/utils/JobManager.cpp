@@ -37,9 +37,10 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+CJobWorker::CJobWorker(CJobManager *manager, int queue) : CThread("JobWorker")
 {
   m_jobManager = manager;
+  m_queue = queue;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -182,6 +183,12 @@ CJobManager &CJobManager::GetInstance()
 CJobManager::CJobManager()
 {
   m_jobCounter = 0;
+  m_processingCount = 0;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    m_queued[priority] = 0;
+  m_nextQueue = 0;
+  m_poolStarted = false;
+  m_sleeping = 0;
   m_running = true;
   m_pauseJobs = false;
 }
@@ -200,71 +207,160 @@ void CJobManager::CancelJobs()
   CSingleLock lock(m_section);
   m_running = false;
 
-  // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  // clear any pending jobs and cancel any callbacks on jobs still processing
+  for (CWorkerQueue &queue : m_queues)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
+    CSingleLock queueLock(queue.m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      for_each(queue.m_lanes[priority].begin(), queue.m_lanes[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+      m_queued[priority] -= queue.m_lanes[priority].size();
+      queue.m_lanes[priority].clear();
+      queue.m_size[priority] = 0;
+    }
+    if (queue.m_busy)
+      queue.m_current.Cancel();
   }
 
-  // cancel any callbacks on jobs still processing
+  for_each(m_jobQueue.begin(), m_jobQueue.end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+  m_jobQueue.clear();
+
   for_each(m_processing.begin(), m_processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
 
   // tell our workers to finish
-  while (m_workers.size())
+  while (m_workers.size() || m_poolWorkers.size())
   {
     lock.Leave();
     m_jobEvent.Set();
+    WakeWorkers(true);
     Sleep(0); // yield after setting the event to give the workers some time to die
     lock.Enter();
   }
+  m_poolStarted = false;
 }
 
 CJobManager::~CJobManager()
 {
 }
 
+unsigned int CJobManager::GetNextJobID()
+{
+  // increment the job counter, ensuring 0 (invalid job) is never hit
+  unsigned int id = ++m_jobCounter;
+  while (id == 0)
+    id = ++m_jobCounter;
+  return id;
+}
+
+int CJobManager::GetWorkerQueue() const
+{
+  CJobWorker *worker = dynamic_cast<CJobWorker*>(CThread::GetCurrentThread());
+  if (worker)
+    return worker->GetQueue();
+  return -1;
+}
+
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
+  if (priority == CJob::PRIORITY_DEDICATED)
+    return AddDedicatedJob(job, callback);
 
   if (!m_running)
     return 0;
 
-  // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
+  StartPool();
 
-  // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
-  m_jobQueue[priority].push_back(work);
+  // keep jobs added by a worker local to it, spread the others over the pool
+  int index = GetWorkerQueue();
+  if (index < 0)
+    index = m_nextQueue++ % POOL_SIZE;
 
-  StartWorkers(priority);
+  CWorkItem work(job, GetNextJobID(), priority, callback);
+  {
+    CWorkerQueue &queue = m_queues[index];
+    CSingleLock lock(queue.m_section);
+    if (!m_running)
+      return 0;
+    queue.m_lanes[priority].push_back(work);
+    queue.m_size[priority]++;
+    m_queued[priority]++;
+  }
+
+  WakeWorkers(false);
   return work.m_id;
 }
 
-void CJobManager::CancelJob(unsigned int jobID)
+unsigned int CJobManager::AddDedicatedJob(CJob *job, IJobCallback *callback)
 {
   CSingleLock lock(m_section);
 
-  // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  if (!m_running)
+    return 0;
+
+  // create a work item for this job
+  CWorkItem work(job, GetNextJobID(), CJob::PRIORITY_DEDICATED, callback);
+  m_jobQueue.push_back(work);
+
+  StartWorkers(CJob::PRIORITY_DEDICATED);
+  return work.m_id;
+}
+
+void CJobManager::CancelJob(unsigned int jobID)
+{
+  // check whether we have this job in one of the pool queues
+  for (CWorkerQueue &queue : m_queues)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    CSingleLock lock(queue.m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      JobQueue::iterator i = find(queue.m_lanes[priority].begin(), queue.m_lanes[priority].end(), jobID);
+      if (i != queue.m_lanes[priority].end())
+      {
+        delete i->m_job;
+        queue.m_lanes[priority].erase(i);
+        queue.m_size[priority]--;
+        m_queued[priority]--;
+        return;
+      }
+    }
+    // or if a pool worker is processing it
+    if (queue.m_busy && queue.m_current == jobID)
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
+      queue.m_current.Cancel(); // job is in progress, so only thing to do is to remove callback
       return;
     }
   }
+
+  CSingleLock lock(m_section);
+
+  // check whether we have this job in the dedicated queue
+  JobQueue::iterator i = find(m_jobQueue.begin(), m_jobQueue.end(), jobID);
+  if (i != m_jobQueue.end())
+  {
+    delete i->m_job;
+    m_jobQueue.erase(i);
+    return;
+  }
   // or if we're processing it
   Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
   if (it != m_processing.end())
     it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
 }
 
+void CJobManager::StartPool()
+{
+  if (m_poolStarted.load(std::memory_order_acquire))
+    return;
+
+  CSingleLock lock(m_section);
+  if (m_poolStarted || !m_running)
+    return;
+
+  for (unsigned int i = 0; i < POOL_SIZE; i++)
+    m_poolWorkers.push_back(new CJobWorker(this, i));
+  m_poolStarted.store(true, std::memory_order_release);
+}
+
 void CJobManager::StartWorkers(CJob::PRIORITY priority)
 {
   CSingleLock lock(m_section);
@@ -284,26 +380,107 @@ void CJobManager::StartWorkers(CJob::PRIORITY priority)
   m_workers.push_back(new CJobWorker(this));
 }
 
+void CJobManager::WakeWorkers(bool all)
+{
+  // sleeping workers register under the wake section before they check for
+  // work a last time, so a job queued before this check can not be missed
+  if (!all && m_sleeping == 0)
+    return;
+
+  CSingleLock lock(m_wakeSection);
+  if (all)
+    m_wakeCond.notifyAll();
+  else
+    m_wakeCond.notify();
+}
+
+bool CJobManager::ReserveSlot(CJob::PRIORITY priority)
+{
+  unsigned int maxWorkers = GetMaxWorkers(priority);
+  unsigned int processing = m_processingCount;
+  while (processing < maxWorkers)
+  {
+    if (m_processingCount.compare_exchange_weak(processing, processing + 1))
+      return true;
+  }
+  return false;
+}
+
+void CJobManager::ReleaseSlot()
+{
+  unsigned int processing = m_processingCount--;
+  // a worker may be waiting for this slot to run a lower priority job
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  {
+    if (m_queued[priority] > 0 && processing >= GetMaxWorkers(CJob::PRIORITY(priority)))
+    {
+      WakeWorkers(false);
+      break;
+    }
+  }
+}
+
 CJob *CJobManager::PopJob()
 {
   CSingleLock lock(m_section);
-  for (int priority = CJob::PRIORITY_DEDICATED; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
+  if (m_jobQueue.size())
+  {
+    // pop the job off the queue
+    CWorkItem job = m_jobQueue.front();
+    m_jobQueue.pop_front();
+
+    // add to the processing vector
+    m_processing.push_back(job);
+    m_processingCount++;
+    job.m_job->m_callback = this;
+    return job.m_job;
+  }
+  return NULL;
+}
+
+CJob *CJobManager::PopPoolJob(int index)
+{
+  CWorkerQueue &own = m_queues[index];
+  for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
   {
     // Check whether we're pausing pausable jobs
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    if (m_queued[priority] == 0 || !ReserveSlot(CJob::PRIORITY(priority)))
+      continue;
+
+    // look at our own lane first, then steal from the others
+    for (unsigned int i = 0; i < POOL_SIZE; i++)
     {
-      // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
-
-      // add to the processing vector
-      m_processing.push_back(job);
-      job.m_job->m_callback = this;
-      return job.m_job;
+      CWorkerQueue &victim = m_queues[(index + i) % POOL_SIZE];
+      if (victim.m_size[priority] == 0)
+        continue;
+
+      // lock both queues in a fixed order so the job is never seen
+      // neither queued nor processing by a concurrent CancelJob
+      CWorkerQueue &first = &victim < &own ? victim : own;
+      CWorkerQueue &second = &victim < &own ? own : victim;
+      CSingleLock lock1(first.m_section);
+      CSingleLock lock2(second.m_section);
+
+      JobQueue &lane = victim.m_lanes[priority];
+      if (lane.empty())
+        continue;
+
+      own.m_current = lane.front();
+      own.m_busy = true;
+      lane.pop_front();
+      victim.m_size[priority]--;
+      m_queued[priority]--;
+
+      own.m_current.m_job->m_callback = this;
+      return own.m_current.m_job;
     }
+    // someone else was faster, give the slot back and wake a sleeping
+    // worker, it may have been turned away while we held the slot
+    m_processingCount--;
+    WakeWorkers(false);
   }
   return NULL;
 }
@@ -318,15 +495,23 @@ void CJobManager::UnPauseJobs()
 {
   CSingleLock lock(m_section);
   m_pauseJobs = false;
+  lock.Leave();
+  WakeWorkers(true);
 }
 
 bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 {
-  CSingleLock lock(m_section);
-
   if (m_pauseJobs)
     return false;
 
+  for (const CWorkerQueue &queue : m_queues)
+  {
+    CSingleLock lock(queue.m_section);
+    if (queue.m_busy && queue.m_current.m_priority == priority)
+      return true;
+  }
+
+  CSingleLock lock(m_section);
   for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
   {
     if (priority == it->m_priority)
@@ -338,11 +523,18 @@ bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 int CJobManager::IsProcessing(const std::string &type) const
 {
   int jobsMatched = 0;
-  CSingleLock lock(m_section);
 
   if (m_pauseJobs)
     return 0;
 
+  for (const CWorkerQueue &queue : m_queues)
+  {
+    CSingleLock lock(queue.m_section);
+    if (queue.m_busy && type == std::string(queue.m_current.m_job->GetType()))
+      jobsMatched++;
+  }
+
+  CSingleLock lock(m_section);
   for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
   {
     if (type == std::string(it->m_job->GetType()))
@@ -353,6 +545,9 @@ int CJobManager::IsProcessing(const std::string &type) const
 
 CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 {
+  if (worker->GetQueue() >= 0)
+    return GetNextPoolJob(worker);
+
   CSingleLock lock(m_section);
   while (m_running)
   {
@@ -377,8 +572,46 @@ CJob *CJobManager::GetNextJob(const CJobWorker *worker)
   return NULL;
 }
 
+CJob *CJobManager::GetNextPoolJob(const CJobWorker *worker)
+{
+  // pool workers live until the manager is cancelled
+  while (m_running)
+  {
+    CJob *job = PopPoolJob(worker->GetQueue());
+    if (job)
+      return job;
+
+    CSingleLock lock(m_wakeSection);
+    m_sleeping++;
+    job = PopPoolJob(worker->GetQueue());
+    if (!job && m_running)
+      m_wakeCond.wait(m_wakeSection, 1000);
+    m_sleeping--;
+    if (job)
+      return job;
+  }
+  RemoveWorker(worker);
+  return NULL;
+}
+
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
+  for (const CWorkerQueue &queue : m_queues)
+  {
+    CSingleLock lock(queue.m_section);
+    if (queue.m_busy && queue.m_current == job)
+    {
+      CWorkItem item(queue.m_current);
+      lock.Leave(); // leave section prior to call
+      if (item.m_callback)
+      {
+        item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+        return false;
+      }
+      return true; // job has been cancelled
+    }
+  }
+
   CSingleLock lock(m_section);
   // find the job in the processing queue, and check whether it's cancelled (no callback)
   Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
@@ -395,8 +628,40 @@ bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const
   return true; // couldn't find the job, or it's been cancelled
 }
 
+bool CJobManager::OnPoolJobComplete(int index, bool success, CJob *job)
+{
+  CWorkerQueue &queue = m_queues[index];
+  CSingleLock lock(queue.m_section);
+  if (!queue.m_busy || !(queue.m_current == job))
+    return false;
+
+  // tell any listeners we're done with the job, then delete it
+  CWorkItem item(queue.m_current);
+  lock.Leave();
+  try
+  {
+    if (item.m_callback)
+      item.m_callback->OnJobComplete(item.m_id, success, item.m_job);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
+  }
+  lock.Enter();
+  queue.m_busy = false;
+  queue.m_current = CWorkItem(NULL, 0, CJob::PRIORITY_LOW, NULL);
+  lock.Leave();
+  item.FreeJob();
+  ReleaseSlot();
+  return true;
+}
+
 void CJobManager::OnJobComplete(bool success, CJob *job)
 {
+  int index = GetWorkerQueue();
+  if (index >= 0 && OnPoolJobComplete(index, success, job))
+    return;
+
   CSingleLock lock(m_section);
   // remove the job from the processing queue
   Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
@@ -417,7 +682,10 @@ void CJobManager::OnJobComplete(bool success, CJob *job)
     lock.Enter();
     Processing::iterator j = find(m_processing.begin(), m_processing.end(), job);
     if (j != m_processing.end())
+    {
       m_processing.erase(j);
+      m_processingCount--;
+    }
     lock.Leave();
     item.FreeJob();
   }
@@ -430,6 +698,9 @@ void CJobManager::RemoveWorker(const CJobWorker *worker)
   Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
   if (i != m_workers.end())
     m_workers.erase(i); // workers auto-delete
+  i = find(m_poolWorkers.begin(), m_poolWorkers.end(), worker);
+  if (i != m_poolWorkers.end())
+    m_poolWorkers.erase(i);
 }
 
 unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
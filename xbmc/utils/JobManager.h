@@ -19,9 +19,11 @@
  *
  */
 
+#include <atomic>
 #include <queue>
 #include <vector>
 #include <string>
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
@@ -31,12 +33,20 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  /*!
+   \brief CJobWorker constructor
+   \param manager the job manager to request jobs from
+   \param queue index of the pool queue owned by this worker, -1 for a worker started for dedicated jobs
+   */
+  CJobWorker(CJobManager *manager, int queue = -1);
   virtual ~CJobWorker();
 
   void Process();
+
+  int GetQueue() const { return m_queue; };
 private:
   CJobManager  *m_jobManager;
+  int           m_queue;
 };
 
 /*!
@@ -170,6 +180,12 @@ private:
  priority levels.  Lower priority jobs are executed only if there are sufficient
  spare worker threads free to allow for higher priority jobs that may arise.
 
+ Jobs are run by a fixed pool of workers, each owning a queue with one lane per
+ priority. Jobs added from a worker go to its own queue, other jobs are spread
+ over the queues. An idle worker takes the highest priority job available,
+ looking at its own lane first and stealing from the other queues otherwise.
+ Dedicated jobs get a worker thread of their own, started on demand.
+
  \sa CJob and IJobCallback
  */
 class CJobManager
@@ -335,27 +351,76 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
-  /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+  typedef std::deque<CWorkItem>    JobQueue;
+  typedef std::vector<CWorkItem>   Processing;
+  typedef std::vector<CJobWorker*> Workers;
+
+  /*!
+   \brief Queue of a pool worker, one lane per priority.
+   The current item is the job the worker is processing, if busy.
+   */
+  class CWorkerQueue
+  {
+  public:
+    CWorkerQueue() : m_current(NULL, 0, CJob::PRIORITY_LOW, NULL), m_busy(false)
+    {
+      for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+        m_size[priority] = 0;
+    };
+
+    JobQueue         m_lanes[CJob::PRIORITY_HIGH + 1];
+    std::atomic<unsigned int> m_size[CJob::PRIORITY_HIGH + 1]; //!< lane sizes, checked by thieves without locking
+    CWorkItem        m_current;
+    bool             m_busy;
+    CCriticalSection m_section;
+  };
+
+  /*! \brief Pop a dedicated job off the job queue and add to the processing queue ready to process
    \return the job to process, NULL if no jobs are available
    */
   CJob *PopJob();
 
+  /*! \brief Take the highest priority job available for a pool worker, stealing from the other queues if needed
+   \param queue index of the queue of the calling worker
+   \return the job to process, NULL if no jobs are available
+   */
+  CJob *PopPoolJob(int queue);
+  CJob *GetNextPoolJob(const CJobWorker *worker);
+  bool  OnPoolJobComplete(int queue, bool success, CJob *job);
+
+  unsigned int AddDedicatedJob(CJob *job, IJobCallback *callback);
+  unsigned int GetNextJobID();
+  int   GetWorkerQueue() const;
+  bool  ReserveSlot(CJob::PRIORITY priority);
+  void  ReleaseSlot();
+  void  WakeWorkers(bool all);
+
+  void StartPool();
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
   static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
 
-  unsigned int m_jobCounter;
+  static const unsigned int POOL_SIZE = 5;
 
-  typedef std::deque<CWorkItem>    JobQueue;
-  typedef std::vector<CWorkItem>   Processing;
-  typedef std::vector<CJobWorker*> Workers;
+  std::atomic<unsigned int> m_jobCounter;
+  std::atomic<unsigned int> m_processingCount; //!< jobs being processed, pool and dedicated
+  std::atomic<unsigned int> m_queued[CJob::PRIORITY_HIGH + 1]; //!< jobs waiting in the pool lanes
+  std::atomic<unsigned int> m_nextQueue;
 
-  JobQueue   m_jobQueue[CJob::PRIORITY_DEDICATED + 1];
-  bool       m_pauseJobs;
-  Processing m_processing;
-  Workers    m_workers;
+  CWorkerQueue m_queues[POOL_SIZE];
+  Workers      m_poolWorkers;
+  std::atomic<bool> m_poolStarted; //!< also read without m_section by StartPool()
+
+  CCriticalSection               m_wakeSection;
+  XbmcThreads::ConditionVariable m_wakeCond;
+  std::atomic<unsigned int>      m_sleeping;
+
+  JobQueue   m_jobQueue; //!< dedicated jobs
+  std::atomic<bool> m_pauseJobs;
+  Processing m_processing; //!< dedicated jobs being processed
+  Workers    m_workers; //!< dedicated workers
 
   CCriticalSection m_section;
   CEvent           m_jobEvent;
-  bool             m_running;
+  std::atomic<bool> m_running;
 };
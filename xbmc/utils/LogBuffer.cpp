@@ -0,0 +1,102 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LogBuffer.h"
+
+#include <string.h>
+
+/* every line starts with its size in the ring, a size of 0 marks the unused
+   end of the ring when a line didn't fit there anymore */
+typedef uint64_t RecordSize;
+
+static inline size_t AlignRecord(size_t size)
+{
+  return (size + sizeof(RecordSize) - 1) & ~(sizeof(RecordSize) - 1);
+}
+
+CLogBuffer::CLogBuffer(size_t size) :
+  m_size(256),
+  m_head(0),
+  m_tail(0),
+  m_dropped(0),
+  m_bAbandoned(false),
+  m_queueing(UINT64_MAX)
+{
+  while (m_size < size)
+    m_size <<= 1;
+  m_mask = m_size - 1;
+  m_data.resize(m_size);
+}
+
+bool CLogBuffer::Write(Header &header, const char *message, size_t length)
+{
+  const size_t record = AlignRecord(sizeof(RecordSize) + sizeof(Header) + length);
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  const size_t tail = m_tail.load(std::memory_order_acquire);
+  size_t offset = head & m_mask;
+  const size_t skip = m_size - offset < record ? m_size - offset : 0;
+
+  if (length > MaxMessageLength() || skip + record > m_size - (head - tail))
+  {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  if (skip > 0)
+  {
+    const RecordSize end = 0;
+    memcpy(&m_data[offset], &end, sizeof(end));
+    offset = 0;
+  }
+
+  const RecordSize size = record;
+  header.length = length;
+  memcpy(&m_data[offset], &size, sizeof(size));
+  memcpy(&m_data[offset + sizeof(size)], &header, sizeof(header));
+  memcpy(&m_data[offset + sizeof(size) + sizeof(header)], message, length);
+
+  m_head.store(head + skip + record, std::memory_order_release);
+  return true;
+}
+
+bool CLogBuffer::Read(Entry &entry)
+{
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  const size_t head = m_head.load(std::memory_order_acquire);
+  if (tail == head)
+    return false;
+
+  size_t offset = tail & m_mask;
+  RecordSize size;
+  memcpy(&size, &m_data[offset], sizeof(size));
+  if (size == 0)
+  {
+    // the line was written to the start of the ring
+    tail += m_size - offset;
+    offset = 0;
+    memcpy(&size, &m_data[offset], sizeof(size));
+  }
+
+  memcpy(&entry.header, &m_data[offset + sizeof(size)], sizeof(entry.header));
+  entry.message.assign(&m_data[offset + sizeof(size) + sizeof(entry.header)], entry.header.length);
+
+  m_tail.store(tail + size, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*!
+ \brief Holds the log lines of one thread until the log writer picks them up.
+
+ The lines are stored one after the other in a fixed size ring, without any
+ locking: only the thread the buffer belongs to may call Write(), and only
+ the log writer may call Read(). A line that doesn't fit is dropped and
+ counted, so a thread that logs faster than the log can be written never
+ waits and never uses more memory.
+ */
+class CLogBuffer
+{
+public:
+  struct Header
+  {
+    uint64_t sequence;  ///< orders the lines of all threads
+    uint64_t threadId;
+    int      level;
+    int      hour;
+    int      minute;
+    int      second;
+    int      millisecond;
+    uint32_t length;    ///< of the message that follows the header
+  };
+
+  struct Entry
+  {
+    Header header;
+    std::string message;
+  };
+
+  /*!
+   \param size The size of the ring in bytes, rounded up to a power of two
+   */
+  explicit CLogBuffer(size_t size);
+
+  /*!
+   \brief Append a line, only called by the thread the buffer belongs to
+   \param header The header of the line, its length is set to the length of the message
+   \return false if the line was dropped because the buffer is full
+   */
+  bool Write(Header &header, const char *message, size_t length);
+
+  /*!
+   \brief Take the oldest line out of the buffer, only called by the log writer
+   \return false if the buffer is empty
+   */
+  bool Read(Entry &entry);
+
+  /*!
+   \brief The longest message that can be written to the buffer
+   */
+  size_t MaxMessageLength() const { return m_size / 4; }
+
+  /*!
+   \brief The bytes that are waiting to be read
+   */
+  size_t Used() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+  size_t Size() const { return m_size; }
+
+  /*!
+   \brief The number of lines that were dropped since the last call
+   */
+  unsigned int TakeDropped() { return m_dropped.exchange(0, std::memory_order_relaxed); }
+
+  /*!
+   \brief Mark the buffer as no longer written to, once its thread is gone
+   */
+  void Abandon() { m_bAbandoned.store(true, std::memory_order_release); }
+  bool IsAbandoned() const { return m_bAbandoned.load(std::memory_order_acquire); }
+
+  /*!
+   \brief Announce that a line is about to be queued by the thread the buffer belongs to
+   \param sequence No higher than the sequence number the line will get
+   */
+  void BeginQueue(uint64_t sequence) { m_queueing.store(sequence); }
+  void EndQueue() { m_queueing.store(UINT64_MAX); }
+
+  /*!
+   \brief The lowest sequence number a line that is being queued may have, UINT64_MAX if none
+   */
+  uint64_t GetQueueing() const { return m_queueing.load(); }
+
+private:
+  CLogBuffer(const CLogBuffer&);
+  CLogBuffer& operator=(const CLogBuffer&);
+
+  std::vector<char> m_data;
+  size_t m_size;
+  size_t m_mask;
+
+  // the positions only ever grow, the offset in the ring is the position & m_mask
+  std::atomic<size_t> m_head;  ///< where the next line is written, only changed by Write()
+  std::atomic<size_t> m_tail;  ///< where the next line is read, only changed by Read()
+  std::atomic<unsigned int> m_dropped;
+  std::atomic<bool> m_bAbandoned;
+  std::atomic<uint64_t> m_queueing;
+};
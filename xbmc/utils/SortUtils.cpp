@@ -23,7 +23,9 @@
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
+#include "threads/Thread.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CPUInfo.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
@@ -416,130 +418,236 @@ std::string ByLastUsed(SortAttribute attributes, const SortItem &values)
   return values.at(FieldLastUsed).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
+// Sort key of a single item, built once before sorting so that comparing two
+// items does not have to look up fields or copy labels any more.
+// The comparison gives exactly the same results as comparing the items
+// themselves on their FieldSort, FieldSortSpecial and FieldFolder values.
+struct SortKey
+{
+  bool hasLabel;      // FieldSort present, items without it go to the end
+  int special;        // SortSpecial of the item
+  int folder;         // -1 if unknown, otherwise whether the item is a folder
+  bool hasNumber;     // the label starts with a digit
+  int64_t number;     // value of the leading digits, as compared by AlphaNumericCompare
+  size_t numberEnd;   // offset of the first label character after the leading digits
+  std::wstring label;
+  size_t index;       // position of the item before sorting
+};
+
+void PrepareSortKey(const SortItem &item, size_t index, SortKey &key)
+{
+  key.index = index;
+  key.special = SortSpecialNone;
+  key.folder = -1;
+  key.hasNumber = false;
+  key.number = 0;
+  key.numberEnd = 0;
+
+  SortItem::const_iterator it = item.find(FieldSort);
+  key.hasLabel = it != item.end();
+  if (key.hasLabel)
+    key.label = it->second.asWideString();
+
+  if ((it = item.find(FieldSortSpecial)) != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+    key.special = (int)it->second.asInteger();
+
+  if ((it = item.find(FieldFolder)) != item.end())
+    key.folder = it->second.asBoolean() ? 1 : 0;
+
+  // same digit handling as StringUtils::AlphaNumericCompare, only up to 15 digits
+  const wchar_t *label = key.label.c_str();
+  size_t pos = 0;
+  while (label[pos] >= L'0' && label[pos] <= L'9' && pos < 15)
+  {
+    key.number = key.number * 10 + (label[pos] - L'0');
+    pos++;
+  }
+  key.hasNumber = pos > 0;
+  key.numberEnd = pos;
+}
+
+// returns true if the order of left and right is decided by anything else
+// than their labels
+bool PreliminaryCompare(const SortKey &left, const SortKey &right, bool handleFolder, bool &result)
 {
   // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
+  if (!left.hasLabel)
   {
     result = false;
     return true;
   }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
+  if (!right.hasLabel)
   {
     result = true;
     return true;
   }
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
   // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
+  if (left.special != right.special)
   {
     // left should be sorted on top
     // or right should be sorted on bottom
     // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
-    {
-      result = true;
-      return true;
-    }
-    
-    // otherwise right is sorted above left
-    result = false;
+    result = left.special == SortSpecialOnTop || right.special == SortSpecialOnBottom;
     return true;
   }
   // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
+  else if (left.special != SortSpecialNone)
   {
     result = false;
     return true;
   }
 
-  if (handleFolder)
+  if (handleFolder && left.folder >= 0 && right.folder >= 0 && left.folder != right.folder)
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
-    {
-      result = itLeft->second.asBoolean();
-      return true;
-    }
+    result = left.folder == 1;
+    return true;
   }
 
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
-
   return false;
 }
 
-bool SorterAscending(const SortItem &left, const SortItem &right)
+int64_t CompareLabels(const SortKey &left, const SortKey &right)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+  // the leading numbers are already known, only look at the rest of the
+  // labels if they are equal
+  if (left.hasNumber && right.hasNumber)
+  {
+    if (left.number != right.number)
+      return left.number - right.number;
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
+    return StringUtils::AlphaNumericCompare(left.label.c_str() + left.numberEnd, right.label.c_str() + right.numberEnd);
+  }
+
+  return StringUtils::AlphaNumericCompare(left.label.c_str(), right.label.c_str());
 }
 
-bool SorterDescending(const SortItem &left, const SortItem &right)
+class SortKeyComparator
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+public:
+  SortKeyComparator(SortOrder sortOrder, SortAttribute attributes)
+    : m_descending(sortOrder == SortOrderDescending),
+      m_handleFolder(!(attributes & SortAttributeIgnoreFolders))
+  { }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+  bool operator()(const SortKey *left, const SortKey *right) const
+  {
+    bool result;
+    if (PreliminaryCompare(*left, *right, m_handleFolder, result))
+      return result;
 
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
+    if (m_descending)
+      return CompareLabels(*left, *right) > 0;
+    return CompareLabels(*left, *right) < 0;
+  }
+
+private:
+  bool m_descending;
+  bool m_handleFolder;
+};
+
+typedef std::vector<SortKey*>::iterator SortKeyIterator;
+
+class SortKeyRange : public IRunnable
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+public:
+  SortKeyRange(SortKeyIterator begin, SortKeyIterator end, const SortKeyComparator &comparator)
+    : m_begin(begin), m_end(end), m_comparator(comparator)
+  { }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+  virtual void Run() override
+  {
+    std::stable_sort(m_begin, m_end, m_comparator);
+  }
+
+private:
+  SortKeyIterator m_begin;
+  SortKeyIterator m_end;
+  SortKeyComparator m_comparator;
+};
 
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
+// Lists with at least this many items per available core are split into
+// ranges which are sorted in parallel and merged afterwards
+#define PARALLEL_SORT_MIN_ITEMS 10000
+
+// Stable sort of the keys, the result is the same as a single std::stable_sort.
+// That only holds as long as the comparison is a strict weak ordering, which is
+// not the case if some items are known to be folders or files and others are
+// not. Those are always sorted by a single thread.
+void SortKeys(std::vector<SortKey*> &keys, const SortKeyComparator &comparator, bool allowParallel)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+  size_t ranges = allowParallel ? std::min<size_t>(g_cpuInfo.getCPUCount(), keys.size() / PARALLEL_SORT_MIN_ITEMS) : 1;
+  if (ranges < 2)
+  {
+    std::stable_sort(keys.begin(), keys.end(), comparator);
+    return;
+  }
+
+  std::vector<SortKeyIterator> bounds;
+  for (size_t range = 0; range < ranges; range++)
+    bounds.push_back(keys.begin() + keys.size() * range / ranges);
+  bounds.push_back(keys.end());
+
+  // the first range is sorted by the calling thread
+  std::vector<std::unique_ptr<SortKeyRange> > runners;
+  std::vector<std::unique_ptr<CThread> > threads;
+  for (size_t range = 1; range < ranges; range++)
+  {
+    runners.emplace_back(new SortKeyRange(bounds[range], bounds[range + 1], comparator));
+    threads.emplace_back(new CThread(runners.back().get(), "SortKeys"));
+    threads.back()->Create();
+  }
+  SortKeyRange(bounds[0], bounds[1], comparator).Run();
+  for (std::vector<std::unique_ptr<CThread> >::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+    (*thread)->StopThread(true);
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
+  // merging keeps items of an earlier range first on equal keys, so the
+  // whole sort stays stable
+  for (size_t range = 1; range < ranges; range++)
+    std::inplace_merge(keys.begin(), bounds[range], bounds[range + 1], comparator);
 }
 
-bool SorterIndirectAscending(const SortItemPtr &left, const SortItemPtr &right)
+const SortItem& GetSortItem(const DatabaseResult &item)
 {
-  return SorterAscending(*left, *right);
+  return item;
 }
 
-bool SorterIndirectDescending(const SortItemPtr &left, const SortItemPtr &right)
+const SortItem& GetSortItem(const SortItemPtr &item)
 {
-  return SorterDescending(*left, *right);
+  return *item;
 }
 
-bool SorterIndirectIgnoreFoldersAscending(const SortItemPtr &left, const SortItemPtr &right)
+template<class T>
+std::vector<size_t> SortOrderFor(const std::vector<T> &items, SortOrder sortOrder, SortAttribute attributes)
 {
-  return SorterIgnoreFoldersAscending(*left, *right);
+  std::vector<SortKey> keys(items.size());
+  std::vector<SortKey*> sortedKeys(items.size());
+  size_t folderKnown = 0;
+  for (size_t index = 0; index < items.size(); index++)
+  {
+    PrepareSortKey(GetSortItem(items[index]), index, keys[index]);
+    sortedKeys[index] = &keys[index];
+    if (keys[index].folder >= 0)
+      folderKnown++;
+  }
+
+  bool mixedFolders = folderKnown > 0 && folderKnown < items.size() && !(attributes & SortAttributeIgnoreFolders);
+  SortKeys(sortedKeys, SortKeyComparator(sortOrder, attributes), !mixedFolders);
+
+  std::vector<size_t> order(items.size());
+  for (size_t index = 0; index < sortedKeys.size(); index++)
+    order[index] = sortedKeys[index]->index;
+  return order;
 }
 
-bool SorterIndirectIgnoreFoldersDescending(const SortItemPtr &left, const SortItemPtr &right)
+template<class T>
+void ApplySortOrder(std::vector<T> &items, const std::vector<size_t> &order)
 {
-  return SorterIgnoreFoldersDescending(*left, *right);
+  std::vector<T> sorted;
+  sorted.reserve(items.size());
+  for (std::vector<size_t>::const_iterator index = order.begin(); index != order.end(); ++index)
+    sorted.push_back(std::move(items[*index]));
+  items.swap(sorted);
 }
 
 std::map<SortBy, SortUtils::SortPreparator> fillPreparators()
@@ -711,11 +819,11 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
 
         std::wstring sortLabel;
         g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        item->insert(std::pair<Field, CVariant>(FieldSort, CVariant(std::move(sortLabel))));
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      ApplySortOrder(items, SortOrderFor(items, sortOrder, attributes));
     }
   }
 
@@ -750,11 +858,11 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
 
         std::wstring sortLabel;
         g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
-        (*item)->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        (*item)->insert(std::pair<Field, CVariant>(FieldSort, CVariant(std::move(sortLabel))));
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
+      ApplySortOrder(items, SortOrderFor(items, sortOrder, attributes));
     }
   }
 
@@ -807,22 +915,6 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
-}
-
-SortUtils::SorterIndirect SortUtils::getSorterIndirect(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIndirectIgnoreFoldersDescending : SorterIndirectIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterIndirectDescending : SorterIndirectAscending;
-}
-
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
 {
   std::map<SortBy, Fields>::const_iterator it = m_sortingFields.find(sortBy);
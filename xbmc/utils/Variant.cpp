@@ -20,9 +20,12 @@
 
 #include "Variant.h"
 
+#include <algorithm>
+#include <new>
 #include <stdlib.h>
 #include <string.h>
 #include <sstream>
+#include <tuple>
 #include <utility>
 
 #ifndef strtoll
@@ -129,6 +132,48 @@ double str2double(const std::wstring &str, double fallback /* = 0.0 */)
   return fallback;
 }
 
+#define VARIANT_ARENA_ALIGNMENT 16
+
+CVariantArena::CVariantArena(size_t blockSize /* = 64 * 1024 */)
+  : m_current(nullptr),
+    m_available(0),
+    m_blockSize(blockSize),
+    m_capacity(0)
+{
+}
+
+CVariantArena::~CVariantArena()
+{
+  for (auto block : m_blocks)
+    ::operator delete(block);
+}
+
+void *CVariantArena::Allocate(size_t size)
+{
+  size = (size + VARIANT_ARENA_ALIGNMENT - 1) & ~(size_t)(VARIANT_ARENA_ALIGNMENT - 1);
+  if (size > m_available)
+  {
+    // large allocations get a block of their own, so the rest of the current block isn't wasted
+    if (size > m_blockSize / 4)
+    {
+      char *block = static_cast<char *>(::operator new(size));
+      m_blocks.push_back(block);
+      m_capacity += size;
+      return block;
+    }
+
+    m_current = static_cast<char *>(::operator new(m_blockSize));
+    m_blocks.push_back(m_current);
+    m_available = m_blockSize;
+    m_capacity += m_blockSize;
+  }
+
+  void *result = m_current;
+  m_current += size;
+  m_available -= size;
+  return result;
+}
+
 CVariant::CVariant()
   : CVariant(VariantTypeNull)
 {
@@ -141,6 +186,7 @@ CVariant::VariantMap CVariant::EMPTY_MAP;
 CVariant::CVariant(VariantType type)
 {
   m_type = type;
+  m_storage = StorageHeap;
 
   switch (type)
   {
@@ -157,7 +203,7 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new std::string();
+      setString("", 0);
       break;
     case VariantTypeWideString:
       m_data.wstring = new std::wstring();
@@ -177,96 +223,104 @@ CVariant::CVariant(VariantType type)
 CVariant::CVariant(int integer)
 {
   m_type = VariantTypeInteger;
+  m_storage = StorageHeap;
   m_data.integer = integer;
 }
 
 CVariant::CVariant(int64_t integer)
 {
   m_type = VariantTypeInteger;
+  m_storage = StorageHeap;
   m_data.integer = integer;
 }
 
 CVariant::CVariant(unsigned int unsignedinteger)
 {
   m_type = VariantTypeUnsignedInteger;
+  m_storage = StorageHeap;
   m_data.unsignedinteger = unsignedinteger;
 }
 
 CVariant::CVariant(uint64_t unsignedinteger)
 {
   m_type = VariantTypeUnsignedInteger;
+  m_storage = StorageHeap;
   m_data.unsignedinteger = unsignedinteger;
 }
 
 CVariant::CVariant(double value)
 {
   m_type = VariantTypeDouble;
+  m_storage = StorageHeap;
   m_data.dvalue = value;
 }
 
 CVariant::CVariant(float value)
 {
   m_type = VariantTypeDouble;
+  m_storage = StorageHeap;
   m_data.dvalue = (double)value;
 }
 
 CVariant::CVariant(bool boolean)
 {
   m_type = VariantTypeBoolean;
+  m_storage = StorageHeap;
   m_data.boolean = boolean;
 }
 
 CVariant::CVariant(const char *str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  setString(str, strlen(str));
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(str, length);
+  setString(str, length);
 }
 
 CVariant::CVariant(const std::string &str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  setString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(std::string &&str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(std::move(str));
+  setString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(const wchar_t *str)
 {
   m_type = VariantTypeWideString;
+  m_storage = StorageHeap;
   m_data.wstring = new std::wstring(str);
 }
 
 CVariant::CVariant(const wchar_t *str, unsigned int length)
 {
   m_type = VariantTypeWideString;
+  m_storage = StorageHeap;
   m_data.wstring = new std::wstring(str, length);
 }
 
 CVariant::CVariant(const std::wstring &str)
 {
   m_type = VariantTypeWideString;
+  m_storage = StorageHeap;
   m_data.wstring = new std::wstring(str);
 }
 
 CVariant::CVariant(std::wstring &&str)
 {
   m_type = VariantTypeWideString;
+  m_storage = StorageHeap;
   m_data.wstring = new std::wstring(std::move(str));
 }
 
 CVariant::CVariant(const std::vector<std::string> &strArray)
 {
   m_type = VariantTypeArray;
+  m_storage = StorageHeap;
   m_data.array = new VariantArray;
   m_data.array->reserve(strArray.size());
   for (const auto& item : strArray)
@@ -276,32 +330,88 @@ CVariant::CVariant(const std::vector<std::string> &strArray)
 CVariant::CVariant(const std::map<std::string, std::string> &strMap)
 {
   m_type = VariantTypeObject;
+  m_storage = StorageHeap;
   m_data.map = new VariantMap;
+  // the map is sorted already
+  m_data.map->reserve(strMap.size());
   for (std::map<std::string, std::string>::const_iterator it = strMap.begin(); it != strMap.end(); ++it)
-    m_data.map->insert(make_pair(it->first, CVariant(it->second)));
+    m_data.map->emplace_back(it->first, CVariant(it->second));
 }
 
 CVariant::CVariant(const std::map<std::string, CVariant> &variantMap)
 {
   m_type = VariantTypeObject;
+  m_storage = StorageHeap;
   m_data.map = new VariantMap(variantMap.begin(), variantMap.end());
 }
 
 CVariant::CVariant(const CVariant &variant)
 {
   m_type = VariantTypeNull;
+  m_storage = StorageHeap;
   *this = variant;
 }
 
-CVariant::CVariant(CVariant&& rhs)
+CVariant::CVariant(CVariant&& rhs) noexcept
 {
   //Set this so that operator= don't try and run cleanup
   //when we're not initialized.
   m_type = VariantTypeNull;
+  m_storage = StorageHeap;
 
   *this = std::move(rhs);
 }
 
+CVariant::CVariant(VariantType type, CVariantArena &arena)
+{
+  m_type = type;
+  m_storage = StorageArena;
+
+  if (type == VariantTypeArray)
+    m_data.array = new (arena.Allocate(sizeof(VariantArray))) VariantArray(VariantArray::allocator_type(&arena));
+  else if (type == VariantTypeObject)
+    m_data.map = new (arena.Allocate(sizeof(VariantMap))) VariantMap(VariantMap::allocator_type(&arena));
+  else
+  {
+    m_type = VariantTypeNull;
+    m_storage = StorageHeap;
+    *this = CVariant(type);
+  }
+}
+
+CVariant::CVariant(const char *str, unsigned int length, CVariantArena &arena)
+{
+  setString(str, length, &arena);
+}
+
+CVariant::CVariant(const CVariant &variant, CVariantArena &arena)
+{
+  m_type = VariantTypeNull;
+  m_storage = StorageHeap;
+
+  switch (variant.m_type)
+  {
+  case VariantTypeString:
+    setString(variant.stringData(), variant.stringLength(), &arena);
+    break;
+  case VariantTypeArray:
+    *this = CVariant(VariantTypeArray, arena);
+    m_data.array->reserve(variant.m_data.array->size());
+    for (const auto &item : *variant.m_data.array)
+      m_data.array->emplace_back(item, arena);
+    break;
+  case VariantTypeObject:
+    *this = CVariant(VariantTypeObject, arena);
+    m_data.map->reserve(variant.m_data.map->size());
+    for (const auto &member : *variant.m_data.map)
+      m_data.map->emplace_back(std::piecewise_construct, std::forward_as_tuple(member.first), std::forward_as_tuple(member.second, arena));
+    break;
+  default:
+    *this = variant;
+    break;
+  }
+}
+
 CVariant::~CVariant()
 {
   cleanup();
@@ -312,7 +422,8 @@ void CVariant::cleanup()
   switch (m_type)
   {
   case VariantTypeString:
-    delete m_data.string;
+    if (m_storage == StorageHeap)
+      ::operator delete(m_data.string);
     m_data.string = nullptr;
     break;
 
@@ -322,18 +433,82 @@ void CVariant::cleanup()
     break;
 
   case VariantTypeArray:
-    delete m_data.array;
+    if (m_storage == StorageArena)
+      m_data.array->~VariantArray();
+    else
+      delete m_data.array;
     m_data.array = nullptr;
     break;
 
   case VariantTypeObject:
-    delete m_data.map;
+    if (m_storage == StorageArena)
+      m_data.map->~VariantMap();
+    else
+      delete m_data.map;
     m_data.map = nullptr;
     break;
   default:
     break;
   }
   m_type = VariantTypeNull;
+  m_storage = StorageHeap;
+}
+
+void CVariant::setString(const char *str, size_t length, CVariantArena *arena /* = nullptr */)
+{
+  m_type = VariantTypeString;
+
+  if (length <= SHORT_STRING_LENGTH)
+  {
+    m_storage = StorageInline;
+    if (length > 0)
+      memcpy(m_data.shortString, str, length);
+    m_data.shortString[length] = '\0';
+    m_data.shortString[SHORT_STRING_LENGTH] = static_cast<char>(SHORT_STRING_LENGTH - length);
+    return;
+  }
+
+  size_t size = offsetof(LongString, data) + length + 1;
+  if (arena)
+  {
+    m_storage = StorageArena;
+    m_data.string = static_cast<LongString *>(arena->Allocate(size));
+  }
+  else
+  {
+    m_storage = StorageHeap;
+    m_data.string = static_cast<LongString *>(::operator new(size));
+  }
+
+  m_data.string->length = length;
+  memcpy(m_data.string->data, str, length);
+  m_data.string->data[length] = '\0';
+}
+
+const char *CVariant::stringData() const
+{
+  if (m_storage == StorageInline)
+    return m_data.shortString;
+  return m_data.string->data;
+}
+
+size_t CVariant::stringLength() const
+{
+  if (m_storage == StorageInline)
+    return SHORT_STRING_LENGTH - static_cast<unsigned char>(m_data.shortString[SHORT_STRING_LENGTH]);
+  return m_data.string->length;
+}
+
+CVariant::VariantMap::iterator CVariant::lowerBound(const std::string &key)
+{
+  return std::lower_bound(m_data.map->begin(), m_data.map->end(), key,
+    [](const VariantMap::value_type &member, const std::string &key) { return member.first < key; });
+}
+
+CVariant::VariantMap::const_iterator CVariant::lowerBound(const std::string &key) const
+{
+  return std::lower_bound(m_data.map->cbegin(), m_data.map->cend(), key,
+    [](const VariantMap::value_type &member, const std::string &key) { return member.first < key; });
 }
 
 bool CVariant::isInteger() const
@@ -397,7 +572,7 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return str2int64(*m_data.wstring, fallback);
     default:
@@ -418,7 +593,7 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return str2uint64(*m_data.wstring, fallback);
     default:
@@ -439,7 +614,7 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return str2double(*m_data.wstring, fallback);
     default:
@@ -460,7 +635,7 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return (float)str2double(*m_data.wstring, fallback);
     default:
@@ -483,9 +658,12 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+    {
+      size_t length = stringLength();
+      if (length == 0 || (length == 1 && memcmp(stringData(), "0", 1) == 0) || (length == 5 && memcmp(stringData(), "false", 5) == 0))
         return false;
       return true;
+    }
     case VariantTypeWideString:
       if (m_data.wstring->empty() || m_data.wstring->compare(L"0") == 0 || m_data.wstring->compare(L"false") == 0)
         return false;
@@ -502,7 +680,7 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+      return std::string(stringData(), stringLength());
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -524,7 +702,6 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   
   return fallback;
 }
-
 std::wstring CVariant::asWideString(const std::wstring &fallback /* = L"" */) const
 {
   switch (m_type)
@@ -562,7 +739,21 @@ CVariant &CVariant::operator[](const std::string &key)
   }
 
   if (m_type == VariantTypeObject)
-    return (*m_data.map)[key];
+  {
+    VariantMap::iterator it = lowerBound(key);
+    if (it != m_data.map->end() && it->first == key)
+      return it->second;
+
+    // the new member is moved into place by swapping, as assigning to a const null variant does nothing
+    size_t position = it - m_data.map->begin();
+    m_data.map->emplace_back(key, CVariant());
+    for (size_t index = m_data.map->size() - 1; index > position; --index)
+    {
+      (*m_data.map)[index].first.swap((*m_data.map)[index - 1].first);
+      (*m_data.map)[index].second.swap((*m_data.map)[index - 1].second);
+    }
+    return (*m_data.map)[position].second;
+  }
   else
     return ConstNullVariant;
 }
@@ -570,7 +761,7 @@ CVariant &CVariant::operator[](const std::string &key)
 const CVariant &CVariant::operator[](const std::string &key) const
 {
   VariantMap::const_iterator it;
-  if (m_type == VariantTypeObject && (it = m_data.map->find(key)) != m_data.map->end())
+  if (m_type == VariantTypeObject && (it = lowerBound(key)) != m_data.map->end() && it->first == key)
     return it->second;
   else
     return ConstNullVariant;
@@ -616,16 +807,16 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new std::string(*rhs.m_data.string);
+    setString(rhs.stringData(), rhs.stringLength());
     break;
   case VariantTypeWideString:
     m_data.wstring = new std::wstring(*rhs.m_data.wstring);
     break;
   case VariantTypeArray:
-    m_data.array = new VariantArray(rhs.m_data.array->begin(), rhs.m_data.array->end());
+    m_data.array = new VariantArray(*rhs.m_data.array);
     break;
   case VariantTypeObject:
-    m_data.map = new VariantMap(rhs.m_data.map->begin(), rhs.m_data.map->end());
+    m_data.map = new VariantMap(*rhs.m_data.map);
     break;
   default:
     break;
@@ -634,7 +825,7 @@ CVariant &CVariant::operator=(const CVariant &rhs)
   return *this;
 }
 
-CVariant& CVariant::operator=(CVariant&& rhs)
+CVariant& CVariant::operator=(CVariant&& rhs) noexcept
 {
   if (m_type == VariantTypeConstNull || this == &rhs)
     return *this;
@@ -644,11 +835,12 @@ CVariant& CVariant::operator=(CVariant&& rhs)
     cleanup();
 
   m_type = rhs.m_type;
-  m_data = std::move(rhs.m_data);
+  m_storage = rhs.m_storage;
+  m_data = rhs.m_data;
 
   //Should be enough to just set m_type here
   //but better safe than sorry, could probably lead to coverity warnings
-  if (rhs.m_type == VariantTypeString)
+  if (rhs.m_type == VariantTypeString && rhs.m_storage != StorageInline)
     rhs.m_data.string = nullptr;
   else if (rhs.m_type == VariantTypeWideString)
     rhs.m_data.wstring = nullptr;
@@ -658,6 +850,7 @@ CVariant& CVariant::operator=(CVariant&& rhs)
     rhs.m_data.map = nullptr;
 
   rhs.m_type = VariantTypeNull;
+  rhs.m_storage = StorageHeap;
 
   return *this;
 }
@@ -677,7 +870,7 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+      return stringLength() == rhs.stringLength() && memcmp(stringData(), rhs.stringData(), stringLength()) == 0;
     case VariantTypeWideString:
       return *m_data.wstring == *rhs.m_data.wstring;
     case VariantTypeArray:
@@ -729,20 +922,23 @@ void CVariant::append(CVariant&& variant)
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return stringData();
   else
     return NULL;
 }
 
 void CVariant::swap(CVariant &rhs)
 {
-  VariantType  temp_type = m_type;
-  VariantUnion temp_data = m_data;
+  VariantType    temp_type = m_type;
+  VariantStorage temp_storage = m_storage;
+  VariantUnion   temp_data = m_data;
 
   m_type = rhs.m_type;
+  m_storage = rhs.m_storage;
   m_data = rhs.m_data;
 
   rhs.m_type = temp_type;
+  rhs.m_storage = temp_storage;
   rhs.m_data = temp_data;
 }
 
@@ -817,7 +1013,7 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return stringLength();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->size();
   else
@@ -831,7 +1027,7 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return stringLength() == 0;
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->empty();
   else if (m_type == VariantTypeNull)
@@ -847,7 +1043,10 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+  {
+    cleanup();
+    setString("", 0);
+  }
   else if (m_type == VariantTypeWideString)
     m_data.wstring->clear();
 }
@@ -860,7 +1059,19 @@ void CVariant::erase(const std::string &key)
     m_data.map = new VariantMap;
   }
   else if (m_type == VariantTypeObject)
-    m_data.map->erase(key);
+  {
+    VariantMap::iterator it = lowerBound(key);
+    if (it == m_data.map->end() || it->first != key)
+      return;
+
+    // move the member to the end by swapping, like operator[] does
+    for (size_t index = it - m_data.map->begin(); index + 1 < m_data.map->size(); ++index)
+    {
+      (*m_data.map)[index].first.swap((*m_data.map)[index + 1].first);
+      (*m_data.map)[index].second.swap((*m_data.map)[index + 1].second);
+    }
+    m_data.map->pop_back();
+  }
 }
 
 void CVariant::erase(unsigned int position)
@@ -878,7 +1089,10 @@ void CVariant::erase(unsigned int position)
 bool CVariant::isMember(const std::string &key) const
 {
   if (m_type == VariantTypeObject)
-    return m_data.map->find(key) != m_data.map->end();
+  {
+    VariantMap::const_iterator it = lowerBound(key);
+    return it != m_data.map->end() && it->first == key;
+  }
 
   return false;
 }
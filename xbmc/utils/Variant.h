@@ -21,6 +21,9 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <stddef.h>
 #include <stdint.h>
 #include <wchar.h>
 
@@ -31,6 +34,38 @@ uint64_t str2uint64(const std::wstring &str, uint64_t fallback = 0);
 double str2double(const std::string &str, double fallback = 0.0);
 double str2double(const std::wstring &str, double fallback = 0.0);
 
+/*!
+ \brief Memory for CVariant trees that are thrown away all at once.
+
+ Strings and containers of variants created with an arena take their memory
+ from it instead of the heap, and it is only released when the arena is
+ destroyed. Such variants must not outlive the arena; copying them (without
+ passing an arena) allocates from the heap again. An arena is not thread safe.
+ */
+class CVariantArena
+{
+public:
+  explicit CVariantArena(size_t blockSize = 64 * 1024);
+  ~CVariantArena();
+
+  void *Allocate(size_t size);
+
+  /*!
+   \brief Number of bytes taken from the heap so far.
+   */
+  size_t Capacity() const { return m_capacity; }
+
+private:
+  CVariantArena(const CVariantArena&) = delete;
+  CVariantArena& operator=(const CVariantArena&) = delete;
+
+  std::vector<char *> m_blocks;
+  char *m_current;
+  size_t m_available;
+  size_t m_blockSize;
+  size_t m_capacity;
+};
+
 class CVariant
 {
 public:
@@ -69,11 +104,20 @@ public:
   CVariant(const std::map<std::string, std::string> &strMap);
   CVariant(const std::map<std::string, CVariant> &variantMap);
   CVariant(const CVariant &variant);
-  CVariant(CVariant &&rhs);
+  CVariant(CVariant &&rhs) noexcept;
   ~CVariant();
 
+  /*!
+   \brief Create an empty string, array or object that allocates from an arena.
+
+   Values added to the array or object later on keep their own storage, only
+   the container itself lives in the arena. Use the copy constructor taking an
+   arena to put a whole tree there.
+   */
+  CVariant(VariantType type, CVariantArena &arena);
+  CVariant(const char *str, unsigned int length, CVariantArena &arena);
+  CVariant(const CVariant &variant, CVariantArena &arena);
 
-  
   bool isInteger() const;
   bool isUnsignedInteger() const;
   bool isBoolean() const;
@@ -100,7 +144,7 @@ public:
   const CVariant &operator[](unsigned int position) const;
 
   CVariant &operator=(const CVariant &rhs);
-  CVariant &operator=(CVariant &&rhs);
+  CVariant &operator=(CVariant &&rhs) noexcept;
   bool operator==(const CVariant &rhs) const;
   bool operator!=(const CVariant &rhs) const { return !(*this == rhs); }
 
@@ -114,8 +158,49 @@ public:
   void swap(CVariant &rhs);
 
 private:
-  typedef std::vector<CVariant> VariantArray;
-  typedef std::map<std::string, CVariant> VariantMap;
+  /*!
+   \brief Allocates from an arena if there is one and from the heap otherwise.
+
+   Copies of a container always allocate from the heap.
+   */
+  template<typename T>
+  class Allocator
+  {
+  public:
+    typedef T value_type;
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    Allocator(CVariantArena *arena = nullptr) : m_arena(arena) { }
+    template<typename U>
+    Allocator(const Allocator<U> &other) : m_arena(other.m_arena) { }
+
+    T *allocate(size_t n)
+    {
+      if (m_arena)
+        return static_cast<T *>(m_arena->Allocate(n * sizeof(T)));
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *p, size_t n)
+    {
+      if (!m_arena)
+        ::operator delete(p);
+    }
+
+    Allocator select_on_container_copy_construction() const { return Allocator(); }
+
+    template<typename U>
+    bool operator==(const Allocator<U> &other) const { return m_arena == other.m_arena; }
+    template<typename U>
+    bool operator!=(const Allocator<U> &other) const { return m_arena != other.m_arena; }
+
+    CVariantArena *m_arena;
+  };
+
+  typedef std::vector<CVariant, Allocator<CVariant> > VariantArray;
+  // the members of an object, sorted by key like a std::map
+  typedef std::vector<std::pair<std::string, CVariant>, Allocator<std::pair<std::string, CVariant> > > VariantMap;
 
 public:
   typedef VariantArray::iterator        iterator_array;
@@ -145,20 +230,47 @@ public:
   static CVariant ConstNullVariant;
 
 private:
+  // strings up to this length are stored in the variant itself
+  static const size_t SHORT_STRING_LENGTH = 15;
+
+  enum VariantStorage : unsigned char
+  {
+    StorageHeap,
+    StorageInline,  ///< a short string
+    StorageArena
+  };
+
+  // a string that doesn't fit in the variant, allocated in one piece
+  struct LongString
+  {
+    size_t length;
+    char data[1];
+  };
+
   void cleanup();
+  void setString(const char *str, size_t length, CVariantArena *arena = nullptr);
+  const char *stringData() const;
+  size_t stringLength() const;
+  // the first member whose key isn't less than the given one
+  VariantMap::iterator lowerBound(const std::string &key);
+  VariantMap::const_iterator lowerBound(const std::string &key) const;
+
   union VariantUnion
   {
     int64_t integer;
     uint64_t unsignedinteger;
     bool boolean;
     double dvalue;
-    std::string *string;
+    // the unused bytes are counted in the last byte, which is the terminator for the longest string
+    char shortString[SHORT_STRING_LENGTH + 1];
+    LongString *string;
     std::wstring *wstring;
     VariantArray *array;
     VariantMap *map;
   };
 
   VariantType m_type;
+  VariantStorage m_storage;
   VariantUnion m_data;
 
   static VariantArray EMPTY_ARRAY;
@@ -25,6 +25,20 @@
 #include "utils/StringUtils.h"
 #include "CompileInfo.h"
 
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+/* the buffer of every thread that logs, its lines are written at least this often */
+#define LOG_BUFFER_SIZE     (64 * 1024)
+#define LOG_WRITE_INTERVAL  100
+
+/* lines that don't fit in the buffer of a thread are queued together, up to this size */
+#define LOG_OVERFLOW_SIZE   (1024 * 1024)
+
+/* most lines are formatted on the stack, longer ones on the heap */
+#define LOG_LINE_SIZE       512
+
 static const char* const levelNames[] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
@@ -35,6 +49,202 @@ static const char* const logLevelNames[] =
 // s_globals is used as static global with CLog global variables
 #define s_globals XBMC_GLOBAL_USE(CLog).m_globalInstance
 
+class CLog::CLogWriter : public CThread
+{
+public:
+  explicit CLogWriter(CLogGlobals& globals) :
+    CThread("LogWriter"),
+    m_globals(globals)
+  { }
+
+  virtual void StopThread(bool bWait = true)
+  {
+    m_bStop = true;
+    m_globals.m_writeEvent.Set();
+    CThread::StopThread(bWait);
+  }
+
+protected:
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      m_globals.m_writeEvent.WaitMSec(LOG_WRITE_INTERVAL);
+      m_globals.WriteBuffers(false);
+    }
+
+    // everything that was logged before the log was closed
+    m_globals.WriteBuffers(true);
+  }
+
+private:
+  CLogGlobals& m_globals;
+};
+
+namespace
+{
+  // the buffer is kept alive by the log until everything in it was written
+  struct CThreadLogBuffer
+  {
+    ~CThreadLogBuffer()
+    {
+      if (buffer)
+        buffer->Abandon();
+    }
+    std::shared_ptr<CLogBuffer> buffer;
+  };
+
+  thread_local CThreadLogBuffer threadLogBuffer;
+
+  CLogBuffer::Header GetHeader(int logLevel)
+  {
+    CLogBuffer::Header header;
+    double millisecond;
+    PlatformInterfaceForCLog::GetCurrentLocalTime(header.hour, header.minute, header.second, millisecond);
+    header.millisecond = static_cast<int>(millisecond);
+    header.sequence = 0;
+    header.threadId = (uint64_t)CThread::GetCurrentThreadId();
+    header.level = logLevel & LOGMASK;
+    header.length = 0;
+    return header;
+  }
+}
+
+CLog::CLogGlobals::CLogGlobals(void) :
+  m_repeatCount(0),
+  m_repeatLogLevel(-1),
+  m_logLevel(LOG_LEVEL_DEBUG),
+  m_extraLogLevels(0),
+  m_bWriting(false),
+  m_sequence(0),
+  m_overflowSize(0),
+  m_overflowDropped(0)
+{ }
+
+CLog::CLogGlobals::~CLogGlobals()
+{
+  if (m_writer)
+  {
+    m_bWriting = false;
+    m_writer->StopThread();
+  }
+}
+
+void CLog::CLogGlobals::WriteBuffers(bool all, CLogBuffer::Entry* severe /* = nullptr */)
+{
+  CSingleLock writeLock(m_writeSection);
+
+  // a line with a lower sequence number than this is either in a buffer or
+  // still being queued, the buffer of its thread was added before it got it
+  uint64_t limit = m_sequence.load();
+  std::vector<std::shared_ptr<CLogBuffer> > buffers;
+  {
+    CSingleLock lock(critSec);
+    buffers = m_buffers;
+  }
+
+  std::vector<CLogBuffer::Entry> entries;
+  entries.swap(m_heldBack);
+  if (severe)
+    entries.push_back(std::move(*severe));
+
+  CLogBuffer::Entry entry;
+  unsigned int dropped = 0;
+  for (const auto& buffer : buffers)
+  {
+    limit = std::min(limit, buffer->GetQueueing());
+    while (buffer->Read(entry))
+      entries.push_back(std::move(entry));
+    dropped += buffer->TakeDropped();
+  }
+
+  {
+    CSingleLock lock(m_overflowSection);
+    std::move(m_overflow.begin(), m_overflow.end(), std::back_inserter(entries));
+    m_overflow.clear();
+    m_overflowSize = 0;
+    dropped += m_overflowDropped;
+    m_overflowDropped = 0;
+  }
+
+  // merge the lines of all threads in the order they were logged in
+  std::sort(entries.begin(), entries.end(), [](const CLogBuffer::Entry& left, const CLogBuffer::Entry& right)
+  {
+    return left.header.sequence < right.header.sequence;
+  });
+
+  // the lines logged after one that isn't in its buffer yet wait for it
+  if (!all)
+  {
+    auto next = std::find_if(entries.begin(), entries.end(), [limit](const CLogBuffer::Entry& queued)
+    {
+      return queued.header.sequence >= limit;
+    });
+    std::move(next, entries.end(), std::back_inserter(m_heldBack));
+    entries.erase(next, entries.end());
+  }
+
+  std::string lines;
+  for (auto& line : entries)
+  {
+    StringUtils::TrimRight(line.message);
+    if (line.message.empty())
+      continue;
+
+    if (m_repeatLogLevel == line.header.level && m_repeatLine == line.message)
+    {
+      m_repeatCount++;
+      continue;
+    }
+    else if (m_repeatCount)
+    {
+      AppendLine(lines, line.header, m_repeatLogLevel, StringUtils::Format("Previous line repeats %d times.", m_repeatCount));
+      m_repeatCount = 0;
+    }
+
+    m_repeatLine = line.message;
+    m_repeatLogLevel = line.header.level;
+    AppendLine(lines, line.header, line.header.level, line.message);
+  }
+
+  if (dropped > 0)
+    AppendLine(lines, GetHeader(LOGWARNING), LOGWARNING, StringUtils::Format("%u lines were dropped, they were logged faster than they could be written.", dropped));
+
+  if (!lines.empty())
+    m_platform.WriteStringToLog(lines);
+
+  // forget the buffers of threads that are gone, once they are written
+  CSingleLock lock(critSec);
+  m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<CLogBuffer>& buffer)
+  {
+    return buffer->IsAbandoned() && buffer->Used() == 0;
+  }), m_buffers.end());
+}
+
+void CLog::CLogGlobals::AppendLine(std::string& lines, const CLogBuffer::Header& header, int logLevel, const std::string& logString)
+{
+  static const char* prefixFormat = "%02d:%02d:%02d.%03d T:%" PRIu64" %7s: ";
+
+#if defined(_DEBUG) || defined(PROFILE)
+  m_platform.PrintDebugString(logString);
+#endif // defined(_DEBUG) || defined(PROFILE)
+
+  std::string strData(logString);
+  /* fixup newline alignment, number of spaces should equal prefix length */
+  StringUtils::Replace(strData, "\n", "\n                                            ");
+
+  if (!lines.empty())
+    lines += '\n';
+  lines += StringUtils::Format(prefixFormat,
+                               header.hour,
+                               header.minute,
+                               header.second,
+                               header.millisecond,
+                               header.threadId,
+                               levelNames[logLevel]);
+  lines += strData;
+}
+
 CLog::CLog()
 {}
 
@@ -43,18 +253,36 @@ CLog::~CLog()
 
 void CLog::Close()
 {
+  std::unique_ptr<CLogWriter> writer;
+  {
+    CSingleLock waitLock(s_globals.critSec);
+    s_globals.m_bWriting = false;
+    writer = std::move(s_globals.m_writer);
+  }
+
+  // the writer thread writes what was logged so far before it ends
+  if (writer)
+    writer->StopThread();
+
+  CSingleLock writeLock(s_globals.m_writeSection);
   CSingleLock waitLock(s_globals.critSec);
   s_globals.m_platform.CloseLogFile();
   s_globals.m_repeatLine.clear();
 }
 
+void CLog::Flush()
+{
+  if (s_globals.m_bWriting)
+    s_globals.WriteBuffers(true);
+}
+
 void CLog::Log(int loglevel, const char *format, ...)
 {
   if (IsLogLevelLogged(loglevel))
   {
     va_list va;
     va_start(va, format);
-    LogString(loglevel, StringUtils::FormatV(format, va));
+    LogFormatted(loglevel, nullptr, format, va);
     va_end(va);
   }
 }
@@ -63,44 +291,119 @@ void CLog::LogFunction(int loglevel, const char* functionName, const char* forma
 {
   if (IsLogLevelLogged(loglevel))
   {
-    std::string fNameStr;
-    if (functionName && functionName[0])
-      fNameStr.assign(functionName).append(": ");
     va_list va;
     va_start(va, format);
-    LogString(loglevel, fNameStr + StringUtils::FormatV(format, va));
+    LogFormatted(loglevel, functionName && functionName[0] ? functionName : nullptr, format, va);
     va_end(va);
   }
 }
 
-void CLog::LogString(int logLevel, const std::string& logString)
+void CLog::LogFormatted(int logLevel, const char* prefix, const char* format, va_list args)
 {
-  CSingleLock waitLock(s_globals.critSec);
-  std::string strData(logString);
-  StringUtils::TrimRight(strData);
-  if (!strData.empty())
+  char line[LOG_LINE_SIZE];
+  size_t length = 0;
+  size_t prefixLength = prefix ? strlen(prefix) : 0;
+  if (prefix && prefixLength + 2 < sizeof(line))
+  {
+    memcpy(line, prefix, prefixLength);
+    line[prefixLength] = ':';
+    line[prefixLength + 1] = ' ';
+    length = prefixLength + 2;
+  }
+
+  // a prefix that doesn't fit on the stack goes straight to the heap
+  if (!prefix || length > 0)
   {
-    if (s_globals.m_repeatLogLevel == logLevel && s_globals.m_repeatLine == strData)
+    va_list copy;
+    va_copy(copy, args);
+    int formatted = vsnprintf(line + length, sizeof(line) - length, format, copy);
+    va_end(copy);
+
+    if (formatted >= 0 && length + formatted < sizeof(line))
     {
-      s_globals.m_repeatCount++;
+      QueueLine(logLevel, line, length + formatted);
       return;
     }
-    else if (s_globals.m_repeatCount)
-    {
-      std::string strData2 = StringUtils::Format("Previous line repeats %d times.",
-                                                s_globals.m_repeatCount);
-      PrintDebugString(strData2);
-      WriteLogString(s_globals.m_repeatLogLevel, strData2);
-      s_globals.m_repeatCount = 0;
-    }
+  }
+
+  std::string strData;
+  if (prefix)
+    strData.assign(prefix).append(": ");
+  strData += StringUtils::FormatV(format, args);
+  QueueLine(logLevel, strData.c_str(), strData.size());
+}
+
+void CLog::LogString(int logLevel, const std::string& logString)
+{
+  QueueLine(logLevel, logString.c_str(), logString.size());
+}
 
-    s_globals.m_repeatLine = strData;
-    s_globals.m_repeatLogLevel = logLevel;
+void CLog::QueueLine(int logLevel, const char* line, size_t length)
+{
+  if (!s_globals.m_bWriting)
+  {
+    // nothing is written before the log is opened
+    PrintDebugString(std::string(line, length));
+    return;
+  }
 
-    PrintDebugString(strData);
+  CLogBuffer::Header header = GetHeader(logLevel);
+  if (header.level == LOGSEVERE || header.level == LOGFATAL)
+  {
+    // written before returning, in case it is the last thing that is logged
+    CLogBuffer::Entry entry;
+    entry.header = header;
+    entry.header.sequence = s_globals.m_sequence.fetch_add(1);
+    entry.header.length = length;
+    entry.message.assign(line, length);
+    s_globals.WriteBuffers(true, &entry);
+    return;
+  }
 
-    WriteLogString(logLevel, strData);
+  // the writer holds back the lines logged after this one until it is queued
+  CLogBuffer* buffer = GetThreadBuffer();
+  buffer->BeginQueue(s_globals.m_sequence.load());
+  header.sequence = s_globals.m_sequence.fetch_add(1);
+
+  if (length <= buffer->MaxMessageLength())
+  {
+    size_t used = buffer->Used();
+    buffer->Write(header, line, length);
+    buffer->EndQueue();
+
+    // errors are written right away, in case they are the last thing that is logged
+    if (header.level >= LOGERROR || (used < buffer->Size() / 2 && buffer->Used() >= buffer->Size() / 2))
+      s_globals.m_writeEvent.Set();
+    return;
+  }
+
+  CSingleLock lock(s_globals.m_overflowSection);
+  if (s_globals.m_overflowSize + length > LOG_OVERFLOW_SIZE)
+  {
+    s_globals.m_overflowDropped++;
+    buffer->EndQueue();
+    return;
+  }
+
+  CLogBuffer::Entry entry;
+  entry.header = header;
+  entry.header.length = length;
+  entry.message.assign(line, length);
+  s_globals.m_overflow.push_back(std::move(entry));
+  s_globals.m_overflowSize += length;
+  buffer->EndQueue();
+  s_globals.m_writeEvent.Set();
+}
+
+CLogBuffer* CLog::GetThreadBuffer()
+{
+  if (!threadLogBuffer.buffer)
+  {
+    threadLogBuffer.buffer = std::make_shared<CLogBuffer>(LOG_BUFFER_SIZE);
+    CSingleLock waitLock(s_globals.critSec);
+    s_globals.m_buffers.push_back(threadLogBuffer.buffer);
   }
+  return threadLogBuffer.buffer.get();
 }
 
 bool CLog::Init(const std::string& path)
@@ -112,7 +415,16 @@ bool CLog::Init(const std::string& path)
 
   std::string appName = CCompileInfo::GetAppName();
   StringUtils::ToLower(appName);
-  return s_globals.m_platform.OpenLogFile(path + appName + ".log", path + appName + ".old.log");
+  if (!s_globals.m_platform.OpenLogFile(path + appName + ".log", path + appName + ".old.log"))
+    return false;
+
+  if (!s_globals.m_writer)
+  {
+    s_globals.m_bWriting = true;
+    s_globals.m_writer.reset(new CLogWriter(s_globals));
+    s_globals.m_writer->Create();
+  }
+  return true;
 }
 
 void CLog::MemDump(char *pData, int length)
@@ -195,26 +507,3 @@ void CLog::PrintDebugString(const std::string& line)
   s_globals.m_platform.PrintDebugString(line);
 #endif // defined(_DEBUG) || defined(PROFILE)
 }
-
-bool CLog::WriteLogString(int logLevel, const std::string& logString)
-{
-  static const char* prefixFormat = "%02d:%02d:%02d.%03d T:%" PRIu64" %7s: ";
-
-  std::string strData(logString);
-  /* fixup newline alignment, number of spaces should equal prefix length */
-  StringUtils::Replace(strData, "\n", "\n                                            ");
-
-  int hour, minute, second;
-  double millisecond;
-  s_globals.m_platform.GetCurrentLocalTime(hour, minute, second, millisecond);
-
-  strData = StringUtils::Format(prefixFormat,
-                                  hour,
-                                  minute,
-                                  second,
-                                  static_cast<int>(millisecond),
-                                  (uint64_t)CThread::GetCurrentThreadId(),
-                                  levelNames[logLevel]) + strData;
-
-  return s_globals.m_platform.WriteStringToLog(strData);
-}
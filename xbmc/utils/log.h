@@ -20,7 +20,12 @@
  *
  */
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <stdarg.h>
 #include <string>
+#include <vector>
 
 #if defined(TARGET_POSIX)
 #include "posix/PosixInterfaceForCLog.h"
@@ -32,16 +37,38 @@ typedef class CWin32InterfaceForCLog PlatformInterfaceForCLog;
 
 #include "commons/ilog.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "utils/GlobalsHandling.h"
+#include "utils/LogBuffer.h"
 
 #include "utils/params_check_macros.h"
 
+/*!
+ \brief The log of the application.
+
+ Logging a line only formats it and appends it to a buffer of the calling
+ thread, without taking any lock, so logging never makes a thread wait for
+ the log file. A writer thread collects the lines of all threads and writes
+ them in batches, at least every 100 ms and right away for errors. When a
+ thread logs faster than that its buffer fills up and further lines are
+ dropped, the number of dropped lines is written to the log.
+
+ The lines are written in the order they were logged in: a line that is
+ still being queued by one thread holds back the lines logged after it by
+ the others until the next batch. Severe and fatal lines are written on the
+ thread that logs them before the call returns, together with everything
+ that was queued before them, as they may be the last thing that is logged.
+ */
 class CLog
 {
 public:
   CLog();
   ~CLog(void);
   static void Close();
+  /*!
+   \brief Write everything that was logged so far, on the calling thread
+   */
+  static void Flush();
   static void Log(int loglevel, PRINTF_FORMAT_STRING const char *format, ...) PARAM2_PRINTF_FORMAT;
   static void LogFunction(int loglevel, IN_OPT_STRING const char* functionName, PRINTF_FORMAT_STRING const char* format, ...) PARAM3_PRINTF_FORMAT;
 #define LogF(loglevel,format,...) LogFunction((loglevel),__FUNCTION__,(format),##__VA_ARGS__)
@@ -54,22 +81,44 @@ public:
   static bool IsLogLevelLogged(int loglevel);
 
 protected:
+  class CLogWriter;
   class CLogGlobals
   {
   public:
-    CLogGlobals(void) : m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0) {}
-    ~CLogGlobals() {}
+    CLogGlobals(void);
+    ~CLogGlobals();
+    void WriteBuffers(bool all, CLogBuffer::Entry* severe = nullptr);
+    void AppendLine(std::string& lines, const CLogBuffer::Header& header, int logLevel, const std::string& logString);
+
     PlatformInterfaceForCLog m_platform;
-    int         m_repeatCount;
-    int         m_repeatLogLevel;
-    std::string m_repeatLine;
+    int         m_repeatCount;     ///< guarded by m_writeSection
+    int         m_repeatLogLevel;  ///< guarded by m_writeSection
+    std::string m_repeatLine;      ///< guarded by m_writeSection
     int         m_logLevel;
     int         m_extraLogLevels;
     CCriticalSection critSec;
+
+    std::atomic<bool> m_bWriting;  ///< lines are only queued while the writer thread runs
+    std::atomic<uint64_t> m_sequence;
+    std::vector<std::shared_ptr<CLogBuffer> > m_buffers;  ///< of every thread that logged, guarded by critSec
+    std::unique_ptr<CLogWriter> m_writer;  ///< guarded by critSec
+    CEvent m_writeEvent;  ///< makes the writer thread write the lines right away
+
+    // the lines are taken out of the buffers and written by one thread at a time
+    std::vector<CLogBuffer::Entry> m_heldBack;  ///< read, but logged after a line that is still being queued
+    CCriticalSection m_writeSection;
+
+    // lines that don't fit in the buffer of a thread at all
+    std::deque<CLogBuffer::Entry> m_overflow;
+    size_t m_overflowSize;
+    unsigned int m_overflowDropped;
+    CCriticalSection m_overflowSection;
   };
   class CLogGlobals m_globalInstance; // used as static global variable
   static void LogString(int logLevel, const std::string& logString);
-  static bool WriteLogString(int logLevel, const std::string& logString);
+  static void LogFormatted(int logLevel, const char* prefix, const char* format, va_list args);
+  static void QueueLine(int logLevel, const char* line, size_t length);
+  static CLogBuffer* GetThreadBuffer();
 };
 
 
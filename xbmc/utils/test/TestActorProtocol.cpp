@@ -0,0 +1,243 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/ActorProtocol.h"
+#include "threads/SystemClock.h"
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Actor;
+
+namespace
+{
+
+const int BENCHMARK_CLIENTS = 4;
+const int BENCHMARK_ROUNDTRIPS = 10000;
+
+// larger than the internal buffer of a message
+struct LargePayload
+{
+  int sequence;
+  char padding[100];
+};
+
+class TestActorProtocol : public testing::Test
+{
+protected:
+  TestActorProtocol() :
+    m_port("test", &m_inEvent, &m_outEvent),
+    m_bStop(false)
+  { }
+
+  ~TestActorProtocol()
+  {
+    StopResponder();
+  }
+
+  // replies to every sync message with the signal + 1 and the payload it got
+  void StartResponder()
+  {
+    m_responder = std::thread([this]()
+    {
+      Message *msg;
+      while (!m_bStop)
+      {
+        m_outEvent.WaitMSec(100);
+        while (m_port.ReceiveOutMessage(&msg))
+        {
+          if (msg->isSync)
+            msg->Reply(msg->signal + 1, msg->data, msg->payloadSize);
+          msg->Release();
+        }
+      }
+    });
+  }
+
+  void StopResponder()
+  {
+    m_bStop = true;
+    m_outEvent.Set();
+    if (m_responder.joinable())
+      m_responder.join();
+  }
+
+  CEvent m_inEvent;
+  CEvent m_outEvent;
+  Protocol m_port;
+  std::atomic<bool> m_bStop;
+  std::thread m_responder;
+};
+
+}
+
+TEST_F(TestActorProtocol, Order)
+{
+  const int senders = 4;
+  const int messages = 10000;
+  std::vector<std::thread> threads;
+  for (int sender = 0; sender < senders; sender++)
+  {
+    threads.push_back(std::thread([this, sender, messages]()
+    {
+      for (int sequence = 0; sequence < messages; sequence++)
+      {
+        if (sequence % 3 == 0)
+        {
+          LargePayload payload = {};
+          payload.sequence = sequence;
+          m_port.SendOutMessage(sender, &payload, sizeof(payload));
+        }
+        else
+          m_port.SendOutMessage(sender, &sequence, sizeof(sequence));
+      }
+    }));
+  }
+
+  // the messages of every sender arrive in the order they were sent
+  std::vector<int> next(senders, 0);
+  int received = 0;
+  Message *msg;
+  while (received < senders * messages)
+  {
+    if (!m_port.ReceiveOutMessage(&msg))
+    {
+      ASSERT_TRUE(m_outEvent.WaitMSec(5000));
+      continue;
+    }
+
+    ASSERT_GE(msg->signal, 0);
+    ASSERT_LT(msg->signal, senders);
+    int sequence = *(int*)msg->data;
+    EXPECT_EQ(next[msg->signal], sequence);
+    EXPECT_EQ(sequence % 3 == 0 ? (int)sizeof(LargePayload) : (int)sizeof(int), msg->payloadSize);
+    next[msg->signal] = sequence + 1;
+    msg->Release();
+    received++;
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_FALSE(m_port.ReceiveOutMessage(&msg));
+}
+
+TEST_F(TestActorProtocol, Sync)
+{
+  StartResponder();
+
+  Message *reply;
+  LargePayload payload = {};
+  for (int sequence = 0; sequence < 100; sequence++)
+  {
+    payload.sequence = sequence;
+    ASSERT_TRUE(m_port.SendOutMessageSync(1, &reply, 1000, &payload, sizeof(payload)));
+    EXPECT_EQ(2, reply->signal);
+    EXPECT_FALSE(reply->isOut);
+    EXPECT_EQ(sequence, ((LargePayload*)reply->data)->sequence);
+    reply->Release();
+  }
+}
+
+TEST_F(TestActorProtocol, SyncTimeout)
+{
+  Message *reply;
+  EXPECT_FALSE(m_port.SendOutMessageSync(1, &reply, 10));
+  EXPECT_TRUE(reply == NULL);
+
+  // a late reply is dropped
+  Message *msg;
+  ASSERT_TRUE(m_port.ReceiveOutMessage(&msg));
+  EXPECT_TRUE(msg->Reply(2));
+  msg->Release();
+  EXPECT_FALSE(m_port.ReceiveInMessage(&msg));
+
+  StartResponder();
+  EXPECT_TRUE(m_port.SendOutMessageSync(1, &reply, 1000));
+  reply->Release();
+}
+
+TEST_F(TestActorProtocol, Purge)
+{
+  m_port.SendOutMessage(1);
+  m_port.SendOutMessage(2);
+  m_port.SendOutMessage(1);
+  m_port.SendOutMessage(3);
+  m_port.PurgeOut(1);
+  m_port.SendOutMessage(4);
+
+  Message *msg;
+  for (int signal = 2; signal <= 4; signal++)
+  {
+    ASSERT_TRUE(m_port.ReceiveOutMessage(&msg));
+    EXPECT_EQ(signal, msg->signal);
+    msg->Release();
+  }
+  EXPECT_FALSE(m_port.ReceiveOutMessage(&msg));
+}
+
+TEST_F(TestActorProtocol, Defer)
+{
+  Message *msg;
+  m_port.SendInMessage(1);
+  m_port.DeferIn(true);
+  EXPECT_FALSE(m_port.ReceiveInMessage(&msg));
+  m_port.DeferIn(false);
+  ASSERT_TRUE(m_port.ReceiveInMessage(&msg));
+  msg->Release();
+}
+
+TEST_F(TestActorProtocol, RoundTrip_Benchmark)
+{
+  StartResponder();
+
+  std::vector<std::thread> clients;
+  std::atomic<int> failed(0);
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int client = 0; client < BENCHMARK_CLIENTS; client++)
+  {
+    clients.push_back(std::thread([this, &failed]()
+    {
+      Message *reply;
+      LargePayload payload = {};
+      for (int i = 0; i < BENCHMARK_ROUNDTRIPS; i++)
+      {
+        payload.sequence = i;
+        if (!m_port.SendOutMessageSync(1, &reply, 1000, &payload, sizeof(payload)))
+        {
+          failed++;
+          continue;
+        }
+        if (((LargePayload*)reply->data)->sequence != i)
+          failed++;
+        reply->Release();
+      }
+    }));
+  }
+  for (auto &client : clients)
+    client.join();
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_CLIENTS << " clients with " << BENCHMARK_ROUNDTRIPS << " sync messages each: " << elapsed
+            << " ms, " << elapsed * 1000.0 / (BENCHMARK_CLIENTS * BENCHMARK_ROUNDTRIPS) << " us per message" << std::endl;
+  EXPECT_EQ(0, failed);
+}
@@ -31,3 +31,81 @@ TEST(TestJSONVariantWriter, Write)
   str = CJSONVariantWriter::Write(variant, false);
   EXPECT_STREQ("null\n", str.c_str());
 }
+
+TEST(TestJSONVariantWriter, WriteChunk)
+{
+  CVariant variant(CVariant::VariantTypeObject);
+  variant["jsonrpc"] = "2.0";
+  variant["id"] = 1;
+  variant["result"]["limits"]["total"] = 3;
+  variant["result"]["empty"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < 3; i++)
+  {
+    CVariant item;
+    item["label"] = "a rather long label that doesn't fit in a chunk";
+    item["rating"] = 7.5;
+    item["watched"] = i % 2 == 0;
+    item["genre"].push_back("Drama");
+    item["genre"].push_back("Comedy");
+    variant["result"]["movies"].push_back(item);
+  }
+
+  for (bool compact : { true, false })
+  {
+    std::string expected = CJSONVariantWriter::Write(variant, compact);
+    for (size_t size = 1; size < 64; size += 7)
+    {
+      CJSONVariantWriter writer(variant, compact);
+      std::string str;
+      while (!writer.IsFinished())
+        ASSERT_TRUE(writer.WriteChunk(str, size));
+      EXPECT_EQ(expected, str);
+    }
+  }
+}
+
+TEST(TestJSONVariantWriter, StreamArray)
+{
+  CVariant variant(CVariant::VariantTypeObject);
+  variant["result"]["limits"]["total"] = 3;
+  variant["result"]["movies"].push_back("first");
+
+  // the same value with all items in it
+  CVariant expectedVariant = variant;
+  for (int i = 0; i < 3; i++)
+  {
+    CVariant item;
+    item["label"] = "a rather long label that doesn't fit in a chunk";
+    item["movieid"] = i;
+    expectedVariant["result"]["movies"].push_back(item);
+  }
+
+  for (bool compact : { true, false })
+  {
+    std::string expected = CJSONVariantWriter::Write(expectedVariant, compact);
+    for (size_t size = 1; size < 64; size += 7)
+    {
+      int next = 0;
+      CJSONVariantWriter writer(variant, compact);
+      writer.StreamArray(variant["result"]["movies"], [&next, &expectedVariant](CVariant &item, bool &done)
+      {
+        if (next == 3)
+          done = true;
+        else
+          item = expectedVariant["result"]["movies"][++next];
+        return true;
+      });
+
+      std::string str;
+      while (!writer.IsFinished())
+        ASSERT_TRUE(writer.WriteChunk(str, size));
+      EXPECT_EQ(expected, str);
+    }
+  }
+
+  // a source that fails fails the writer
+  CJSONVariantWriter writer(variant, true);
+  writer.StreamArray(variant["result"]["movies"], [](CVariant &item, bool &done) { return false; });
+  std::string str;
+  EXPECT_FALSE(writer.WriteChunk(str, std::string::npos));
+}
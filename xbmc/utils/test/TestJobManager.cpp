@@ -20,10 +20,18 @@
 
 #include "utils/JobManager.h"
 #include "settings/Settings.h"
+#include "threads/SystemClock.h"
 #include "utils/SystemInfo.h"
+#ifdef TARGET_POSIX
+#include "linux/XTimeUtils.h"
+#endif
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
 /* CSysInfoJob::GetInternetState() will test for network connectivity. */
 class TestJobManager : public testing::Test
 {
@@ -178,3 +186,332 @@ TEST_F(TestJobManager, IsProcessing)
 
   job->FinishAndStopBlocking();
 }
+
+namespace
+{
+class RecordingJob : public CJob
+{
+public:
+  RecordingJob(const std::string &name, std::vector<std::string> &order, CCriticalSection &section, CEvent &done) :
+    m_name(name), m_order(order), m_section(section), m_done(done)
+  {
+  }
+
+  const char * GetType() const
+  {
+    return "RecordingJob";
+  }
+
+  bool operator==(const CJob* job) const
+  {
+    return this == job;
+  }
+
+  bool DoWork()
+  {
+    CSingleLock lock(m_section);
+    m_order.push_back(m_name);
+    m_done.Set();
+    return true;
+  }
+
+private:
+  std::string m_name;
+  std::vector<std::string> &m_order;
+  CCriticalSection &m_section;
+  CEvent &m_done;
+};
+
+class GatedJob : public CJob
+{
+public:
+  GatedJob(CEvent &gate, bool *destroyed = NULL, CEvent *started = NULL) :
+    m_gate(gate), m_destroyed(destroyed), m_started(started)
+  {
+  }
+
+  ~GatedJob()
+  {
+    if (m_destroyed)
+      *m_destroyed = true;
+  }
+
+  bool operator==(const CJob* job) const
+  {
+    return this == job;
+  }
+
+  bool DoWork()
+  {
+    if (m_started)
+      m_started->Set();
+    m_gate.Wait();
+    return true;
+  }
+
+private:
+  CEvent &m_gate;
+  bool *m_destroyed;
+  CEvent *m_started;
+};
+
+class LifoJobQueue : public CJobQueue
+{
+public:
+  LifoJobQueue() : CJobQueue(true, 1, CJob::PRIORITY_NORMAL), m_completed(0) {}
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    CJobQueue::OnJobComplete(jobID, success, job);
+    CSingleLock lock(m_section);
+    m_completed++;
+    m_event.Set();
+  }
+
+  bool WaitForCompleted(unsigned int count)
+  {
+    CSingleLock lock(m_section);
+    while (m_completed < count)
+    {
+      lock.Leave();
+      if (!m_event.WaitMSec(5000))
+        return false;
+      lock.Enter();
+    }
+    return true;
+  }
+
+private:
+  unsigned int m_completed;
+  CCriticalSection m_section;
+  CEvent m_event;
+};
+
+class CountingJob : public CJob
+{
+public:
+  bool DoWork()
+  {
+    return true;
+  }
+};
+
+class CompletionCounter : public IJobCallback
+{
+public:
+  CompletionCounter(unsigned int expected) : m_expected(expected), m_completed(0) {}
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    if (++m_completed == m_expected)
+      m_done.Set();
+  }
+
+  unsigned int m_expected;
+  std::atomic<unsigned int> m_completed;
+  CEvent m_done;
+};
+
+/* Scheduler as CJobManager used to work: one lock around per priority
+   deques and worker threads started on demand. Only used as a reference
+   for the throughput benchmark. */
+class LockedJobScheduler
+{
+  class Worker : public CThread
+  {
+  public:
+    Worker(LockedJobScheduler &scheduler) : CThread("LockedWorker"), m_scheduler(scheduler)
+    {
+      Create(false);
+    }
+
+    void Process()
+    {
+      CJob *job;
+      while ((job = m_scheduler.GetNextJob()))
+      {
+        bool success = job->DoWork();
+        m_scheduler.OnJobComplete(success, job);
+      }
+    }
+
+  private:
+    LockedJobScheduler &m_scheduler;
+  };
+
+public:
+  LockedJobScheduler(IJobCallback *callback) : m_callback(callback), m_running(true) {}
+
+  ~LockedJobScheduler()
+  {
+    {
+      CSingleLock lock(m_section);
+      m_running = false;
+    }
+    for (Worker *worker : m_workers)
+    {
+      m_event.Set();
+      worker->StopThread();
+      delete worker;
+    }
+  }
+
+  void AddJob(CJob *job, CJob::PRIORITY priority)
+  {
+    CSingleLock lock(m_section);
+    m_queue[priority].push_back(job);
+    if (m_processing.size() < m_workers.size())
+      m_event.Set();
+    else if (m_workers.size() < 5)
+      m_workers.push_back(new Worker(*this));
+  }
+
+  CJob *GetNextJob()
+  {
+    CSingleLock lock(m_section);
+    while (m_running)
+    {
+      for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
+      {
+        if (!m_queue[priority].empty())
+        {
+          CJob *job = m_queue[priority].front();
+          m_queue[priority].pop_front();
+          m_processing.push_back(job);
+          return job;
+        }
+      }
+      lock.Leave();
+      m_event.WaitMSec(100);
+      lock.Enter();
+    }
+    return NULL;
+  }
+
+  void OnJobComplete(bool success, CJob *job)
+  {
+    m_callback->OnJobComplete(0, success, job);
+    CSingleLock lock(m_section);
+    m_processing.erase(std::find(m_processing.begin(), m_processing.end(), job));
+    lock.Leave();
+    delete job;
+  }
+
+private:
+  IJobCallback *m_callback;
+  std::deque<CJob*> m_queue[CJob::PRIORITY_HIGH + 1];
+  std::vector<Worker*> m_workers;
+  std::vector<CJob*> m_processing;
+  bool m_running;
+  CCriticalSection m_section;
+  CEvent m_event;
+};
+
+const unsigned int BENCHMARK_JOBS = 20000;
+}
+
+TEST_F(TestJobManager, RunsHigherPriorityFirst)
+{
+  // occupy all workers, then release them one at a time. Every free worker
+  // has to pick the highest priority job that is allowed to run.
+  CEvent started[5];
+  CEvent gates[5];
+  for (int i = 0; i < 5; i++)
+  {
+    CJobManager::GetInstance().AddJob(new GatedJob(gates[i], NULL, &started[i]), NULL, CJob::PRIORITY_HIGH);
+    ASSERT_TRUE(started[i].WaitMSec(5000));
+  }
+
+  std::vector<std::string> order;
+  CCriticalSection section;
+  CEvent done(false);
+  CJobManager::GetInstance().AddJob(new RecordingJob("low", order, section, done), NULL, CJob::PRIORITY_LOW);
+  CJobManager::GetInstance().AddJob(new RecordingJob("normal", order, section, done), NULL, CJob::PRIORITY_NORMAL);
+  CJobManager::GetInstance().AddJob(new RecordingJob("high", order, section, done), NULL, CJob::PRIORITY_HIGH);
+
+  for (int i = 0; i < 3; i++)
+  {
+    gates[i].Set();
+    ASSERT_TRUE(done.WaitMSec(5000));
+  }
+  for (int i = 3; i < 5; i++)
+    gates[i].Set();
+  while (CJobManager::GetInstance().IsProcessing(CJob::PRIORITY_HIGH))
+    Sleep(1);
+
+  CSingleLock lock(section);
+  ASSERT_EQ(3U, order.size());
+  EXPECT_EQ("high", order[0]);
+  EXPECT_EQ("normal", order[1]);
+  EXPECT_EQ("low", order[2]);
+}
+
+TEST_F(TestJobManager, CancelQueuedJob)
+{
+  CEvent gate(true);
+  bool destroyed = false;
+
+  CJobManager::GetInstance().PauseJobs();
+  unsigned int id = CJobManager::GetInstance().AddJob(new GatedJob(gate, &destroyed), NULL, CJob::PRIORITY_LOW_PAUSABLE);
+  EXPECT_NE(0U, id);
+  EXPECT_FALSE(destroyed);
+
+  // a queued job is deleted straight away
+  CJobManager::GetInstance().CancelJob(id);
+  EXPECT_TRUE(destroyed);
+  CJobManager::GetInstance().UnPauseJobs();
+  gate.Set();
+}
+
+TEST_F(TestJobManager, JobQueueLifo)
+{
+  std::vector<std::string> order;
+  CCriticalSection section;
+  CEvent done(false);
+  CEvent gate(true);
+
+  // the gated job keeps the queue busy until both jobs are queued
+  LifoJobQueue queue;
+  queue.AddJob(new GatedJob(gate));
+  queue.AddJob(new RecordingJob("first", order, section, done));
+  queue.AddJob(new RecordingJob("second", order, section, done));
+  gate.Set();
+
+  ASSERT_TRUE(queue.WaitForCompleted(3));
+
+  CSingleLock lock(section);
+  ASSERT_EQ(2U, order.size());
+  EXPECT_EQ("second", order[0]);
+  EXPECT_EQ("first", order[1]);
+}
+
+TEST_F(TestJobManager, BenchmarkThroughput)
+{
+  unsigned int start, elapsedLocked, elapsedPool;
+
+  {
+    CompletionCounter counter(BENCHMARK_JOBS);
+    LockedJobScheduler scheduler(&counter);
+    start = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < BENCHMARK_JOBS; i++)
+      scheduler.AddJob(new CountingJob, CJob::PRIORITY_LOW);
+    ASSERT_TRUE(counter.m_done.WaitMSec(60000));
+    elapsedLocked = XbmcThreads::SystemClockMillis() - start;
+  }
+
+  {
+    CompletionCounter counter(BENCHMARK_JOBS);
+    start = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < BENCHMARK_JOBS; i++)
+      CJobManager::GetInstance().AddJob(new CountingJob, &counter, CJob::PRIORITY_LOW);
+    ASSERT_TRUE(counter.m_done.WaitMSec(60000));
+    elapsedPool = XbmcThreads::SystemClockMillis() - start;
+
+    // the last callback may still be returning
+    while (CJobManager::GetInstance().IsProcessing(CJob::PRIORITY_LOW))
+      Sleep(1);
+  }
+
+  std::cout << BENCHMARK_JOBS << " jobs, single lock: " << elapsedLocked << " ms, "
+            << "work stealing: " << elapsedPool << " ms" << std::endl;
+}
@@ -0,0 +1,187 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/LogBuffer.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <thread>
+
+namespace
+{
+
+const unsigned int BENCHMARK_LINES = 1000000;
+
+CLogBuffer::Header GetHeader(uint64_t sequence)
+{
+  CLogBuffer::Header header = {};
+  header.sequence = sequence;
+  header.threadId = 1;
+  header.level = 2;
+  return header;
+}
+
+bool WriteLine(CLogBuffer &buffer, uint64_t sequence)
+{
+  CLogBuffer::Header header = GetHeader(sequence);
+  std::string line = StringUtils::Format("line %llu", (unsigned long long)sequence);
+  // lines of different lengths, so they end up everywhere in the ring
+  line.append(sequence % 97, 'x');
+  return buffer.Write(header, line.c_str(), line.size());
+}
+
+void CheckLine(const CLogBuffer::Entry &entry, uint64_t sequence)
+{
+  std::string line = StringUtils::Format("line %llu", (unsigned long long)sequence);
+  line.append(sequence % 97, 'x');
+  EXPECT_EQ(sequence, entry.header.sequence);
+  EXPECT_EQ(2, entry.header.level);
+  EXPECT_EQ(line.size(), entry.header.length);
+  EXPECT_EQ(line, entry.message);
+}
+
+}
+
+TEST(TestLogBuffer, WriteRead)
+{
+  CLogBuffer buffer(4096);
+  CLogBuffer::Entry entry;
+  EXPECT_FALSE(buffer.Read(entry));
+
+  // keep a few lines in the buffer while it wraps around many times
+  uint64_t written = 0;
+  uint64_t read = 0;
+  for (int i = 0; i < 10; i++)
+    ASSERT_TRUE(WriteLine(buffer, written++));
+  while (read < 1000)
+  {
+    for (int i = 0; i < 5; i++)
+      ASSERT_TRUE(WriteLine(buffer, written++));
+    for (int i = 0; i < 5; i++)
+    {
+      ASSERT_TRUE(buffer.Read(entry));
+      CheckLine(entry, read++);
+    }
+  }
+
+  while (buffer.Read(entry))
+    CheckLine(entry, read++);
+  EXPECT_EQ(written, read);
+  EXPECT_EQ(0U, buffer.Used());
+  EXPECT_EQ(0U, buffer.TakeDropped());
+}
+
+TEST(TestLogBuffer, Full)
+{
+  CLogBuffer buffer(4096);
+  uint64_t written = 0;
+  while (WriteLine(buffer, written))
+    written++;
+  EXPECT_LE(buffer.Used(), buffer.Size());
+
+  EXPECT_FALSE(WriteLine(buffer, written));
+  EXPECT_EQ(2U, buffer.TakeDropped());
+  EXPECT_EQ(0U, buffer.TakeDropped());
+
+  // the lines that were written are all there
+  CLogBuffer::Entry entry;
+  for (uint64_t sequence = 0; sequence < written; sequence++)
+  {
+    ASSERT_TRUE(buffer.Read(entry));
+    CheckLine(entry, sequence);
+  }
+  EXPECT_FALSE(buffer.Read(entry));
+  EXPECT_TRUE(WriteLine(buffer, written));
+}
+
+TEST(TestLogBuffer, TooLong)
+{
+  CLogBuffer buffer(4096);
+  CLogBuffer::Header header = GetHeader(0);
+  std::string line(buffer.MaxMessageLength() + 1, 'x');
+  EXPECT_FALSE(buffer.Write(header, line.c_str(), line.size()));
+  EXPECT_EQ(1U, buffer.TakeDropped());
+
+  line.resize(buffer.MaxMessageLength());
+  EXPECT_TRUE(buffer.Write(header, line.c_str(), line.size()));
+}
+
+TEST(TestLogBuffer, Threads)
+{
+  CLogBuffer buffer(16 * 1024);
+  const uint64_t lines = 100000;
+  std::thread writer([&buffer, lines]()
+  {
+    for (uint64_t sequence = 0; sequence < lines; sequence++)
+      WriteLine(buffer, sequence);
+    buffer.Abandon();
+  });
+
+  // every line that wasn't dropped arrives complete and in order
+  CLogBuffer::Entry entry;
+  uint64_t read = 0;
+  int64_t last = -1;
+  while (true)
+  {
+    bool bAbandoned = buffer.IsAbandoned();
+    if (!buffer.Read(entry))
+    {
+      if (bAbandoned)
+        break;
+      std::this_thread::yield();
+      continue;
+    }
+
+    ASSERT_GT((int64_t)entry.header.sequence, last);
+    CheckLine(entry, entry.header.sequence);
+    last = entry.header.sequence;
+    read++;
+  }
+  writer.join();
+
+  EXPECT_EQ(lines, read + buffer.TakeDropped());
+}
+
+TEST(TestLogBuffer, Write_Benchmark)
+{
+  CLogBuffer buffer(64 * 1024);
+  CLogBuffer::Entry entry;
+  const std::string line = "CVideoPlayerAudio::Process - stream stalled pts:123456.789 clock:123450.000";
+
+  // the lines are read again whenever the buffer is full, like the log writer does
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int lines = 0; lines < BENCHMARK_LINES; )
+  {
+    CLogBuffer::Header header = GetHeader(lines);
+    while (lines < BENCHMARK_LINES && buffer.Write(header, line.c_str(), line.size()))
+      header.sequence = ++lines;
+
+    buffer.TakeDropped();
+    while (buffer.Read(entry))
+      ;
+  }
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_LINES << " lines written to the log buffer and read again in " << elapsed
+            << " ms, " << elapsed * 1000000.0 / BENCHMARK_LINES << " ns per line" << std::endl;
+}
@@ -19,10 +19,141 @@
  */
 
 #include "utils/SortUtils.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+
+const size_t BENCHMARK_ITEMS = 100000;
+
+// The comparison SortUtils::Sort did on the items themselves before it used
+// precomputed sort keys. The new sort has to give exactly the same order.
+class LegacySorter
+{
+public:
+  LegacySorter(SortOrder sortOrder, SortAttribute attributes)
+    : m_descending(sortOrder == SortOrderDescending),
+      m_handleFolder(!(attributes & SortAttributeIgnoreFolders))
+  { }
+
+  bool operator()(const SortItem &left, const SortItem &right) const
+  {
+    SortItem::const_iterator itLeftSort, itRightSort;
+    if ((itLeftSort = left.find(FieldSort)) == left.end())
+      return false;
+    if ((itRightSort = right.find(FieldSort)) == right.end())
+      return true;
+
+    SortItem::const_iterator itLeft, itRight;
+    SortSpecial leftSortSpecial = SortSpecialNone;
+    SortSpecial rightSortSpecial = SortSpecialNone;
+    if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+      leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
+    if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+      rightSortSpecial = (SortSpecial)itRight->second.asInteger();
+
+    if (leftSortSpecial != rightSortSpecial)
+      return leftSortSpecial == SortSpecialOnTop || rightSortSpecial == SortSpecialOnBottom;
+    else if (leftSortSpecial != SortSpecialNone)
+      return false;
+
+    if (m_handleFolder)
+    {
+      itLeft = left.find(FieldFolder);
+      itRight = right.find(FieldFolder);
+      if (itLeft != left.end() && itRight != right.end() &&
+          itLeft->second.asBoolean() != itRight->second.asBoolean())
+        return itLeft->second.asBoolean();
+    }
+
+    std::wstring labelLeft = itLeftSort->second.asWideString();
+    std::wstring labelRight = itRightSort->second.asWideString();
+    if (m_descending)
+      return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
+    return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
+  }
+
+private:
+  bool m_descending;
+  bool m_handleFolder;
+};
+
+// Synthetic song results with plenty of equal and numeric sort values
+DatabaseResults GetSongResults(size_t count)
+{
+  static const char *artists[] = { "The Beatles", "ABBA", "a-ha", "10cc", "2Pac", "Björk", "The The", "Zappa" };
+  static const char *albums[] = { "Abbey Road", "The Wall", "1999", "Arrival", "Hunting High and Low", "", "Post" };
+
+  DatabaseResults results;
+  results.reserve(count);
+  unsigned int seed = 1;
+  for (size_t index = 0; index < count; index++)
+  {
+    seed = seed * 1103515245 + 12345;
+    unsigned int random = seed >> 8;
+
+    DatabaseResult result;
+    result[FieldId] = static_cast<int>(index);
+    if (random % 5 == 0)
+    {
+      CVariant artist(CVariant::VariantTypeArray);
+      artist.push_back(artists[random % 8]);
+      artist.push_back(artists[(random / 8) % 8]);
+      result[FieldArtist] = artist;
+    }
+    else
+      result[FieldArtist] = artists[random % 8];
+    result[FieldAlbum] = albums[(random / 3) % 7];
+    if (random % 7 != 0)
+      result[FieldTrackNumber] = static_cast<int>((random / 11) % 20);
+    result[FieldYear] = static_cast<int>(1960 + (random / 13) % 60);
+    result[FieldTitle] = StringUtils::Format("Song %u", (random / 17) % 500);
+    result[FieldLabel] = result[FieldTitle];
+    result[FieldPlaycount] = static_cast<int>((random / 19) % 4);
+    result[FieldRating] = static_cast<double>((random / 23) % 100) / 10;
+    result[FieldDate] = StringUtils::Format("20%02u-%02u-%02u", (random / 29) % 17, 1 + (random / 31) % 12, 1 + (random / 37) % 28);
+    result[FieldFolder] = (random / 41) % 5 == 0;
+    if (random % 97 == 0)
+      result[FieldSortSpecial] = static_cast<int>(1 + (random / 43) % 2);
+    results.push_back(result);
+  }
+
+  return results;
+}
+
+std::vector<int64_t> GetIds(const DatabaseResults &results)
+{
+  std::vector<int64_t> ids;
+  for (DatabaseResults::const_iterator result = results.begin(); result != results.end(); ++result)
+    ids.push_back(result->at(FieldId).asInteger());
+  return ids;
+}
+
+// sorts the results with SortUtils and with the legacy comparison on the
+// sort labels SortUtils prepared, and checks both agree on the order
+void ExpectLegacyOrder(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, size_t count)
+{
+  DatabaseResults results = GetSongResults(count);
+  DatabaseResults sorted = results;
+  SortUtils::Sort(sortBy, sortOrder, attributes, sorted);
+  ASSERT_EQ(results.size(), sorted.size());
+
+  for (DatabaseResults::const_iterator result = sorted.begin(); result != sorted.end(); ++result)
+    results[(size_t)result->at(FieldId).asInteger()][FieldSort] = result->at(FieldSort);
+  std::stable_sort(results.begin(), results.end(), LegacySorter(sortOrder, attributes));
+
+  EXPECT_TRUE(GetIds(results) == GetIds(sorted)) << "sort method " << sortBy << ", order " << sortOrder << ", attributes " << attributes;
+}
+
+}
+
 TEST(TestSortUtils, Sort_SortBy)
 {
   SortItems items;
@@ -131,3 +262,56 @@ TEST(TestSortUtils, GetFieldsForSorting)
   EXPECT_EQ(FieldTrackNumber, *it);
   EXPECT_EQ((unsigned int)4, fields.size());
 }
+
+TEST(TestSortUtils, Sort_KeepsLegacyOrder)
+{
+  const SortBy methods[] = { SortByLabel, SortByDate, SortByTitle, SortByTrackNumber, SortByArtist,
+                             SortByArtistThenYear, SortByAlbum, SortByYear, SortByRating, SortByPlaycount };
+  const SortAttribute attributes[] = { SortAttributeNone, SortAttributeIgnoreArticle, SortAttributeIgnoreFolders };
+
+  for (size_t method = 0; method < sizeof(methods) / sizeof(methods[0]); method++)
+  {
+    for (size_t attribute = 0; attribute < sizeof(attributes) / sizeof(attributes[0]); attribute++)
+    {
+      ExpectLegacyOrder(methods[method], SortOrderAscending, attributes[attribute], 1000);
+      ExpectLegacyOrder(methods[method], SortOrderDescending, attributes[attribute], 1000);
+    }
+  }
+}
+
+TEST(TestSortUtils, Sort_LargeListKeepsLegacyOrder)
+{
+  // large enough to be sorted in parallel on multi core systems
+  ExpectLegacyOrder(SortByArtist, SortOrderAscending, SortAttributeNone, 40000);
+  ExpectLegacyOrder(SortByYear, SortOrderDescending, SortAttributeIgnoreArticle, 40000);
+}
+
+TEST(TestSortUtils, Sort_Limits)
+{
+  DatabaseResults results = GetSongResults(100);
+  SortUtils::Sort(SortByTrackNumber, SortOrderAscending, SortAttributeIgnoreFolders, results, 30, 10);
+  ASSERT_EQ((size_t)20, results.size());
+  for (size_t index = 1; index < results.size(); index++)
+    EXPECT_LE(results[index - 1].at(FieldTrackNumber).asInteger(), results[index].at(FieldTrackNumber).asInteger());
+}
+
+TEST(TestSortUtils, Sort_Benchmark)
+{
+  DatabaseResults results = GetSongResults(BENCHMARK_ITEMS);
+
+  DatabaseResults sorted = results;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  SortUtils::Sort(SortByArtist, SortOrderAscending, SortAttributeIgnoreArticle, sorted);
+  unsigned int elapsedSort = XbmcThreads::SystemClockMillis() - start;
+
+  // the legacy sort compared the items on their labels, without building them
+  for (DatabaseResults::const_iterator result = sorted.begin(); result != sorted.end(); ++result)
+    results[(size_t)result->at(FieldId).asInteger()][FieldSort] = result->at(FieldSort);
+  start = XbmcThreads::SystemClockMillis();
+  std::stable_sort(results.begin(), results.end(), LegacySorter(SortOrderAscending, SortAttributeIgnoreArticle));
+  unsigned int elapsedLegacy = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_ITEMS << " songs by artist, legacy compare only: " << elapsedLegacy
+            << " ms, sort keys including label preparation: " << elapsedSort << " ms" << std::endl;
+  EXPECT_TRUE(GetIds(results) == GetIds(sorted));
+}
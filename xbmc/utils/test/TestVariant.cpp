@@ -18,10 +18,57 @@
  *
  */
 
+#include "threads/SystemClock.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
 
+#include <iostream>
+
+namespace
+{
+
+const size_t BENCHMARK_ITEMS = 20000;
+
+// a response to VideoLibrary.GetMovies with the usual properties
+CVariant GetMovies(size_t items)
+{
+  CVariant response;
+  response["id"] = 1;
+  response["jsonrpc"] = "2.0";
+
+  CVariant &result = response["result"];
+  result["limits"]["start"] = 0;
+  result["limits"]["end"] = (int)items;
+  result["limits"]["total"] = (int)items;
+  result["movies"] = CVariant(CVariant::VariantTypeArray);
+  for (size_t i = 0; i < items; i++)
+  {
+    CVariant movie;
+    movie["movieid"] = (int)i;
+    movie["label"] = StringUtils::Format("Movie %u", (unsigned int)i);
+    movie["title"] = movie["label"].asString();
+    movie["year"] = 1950 + (int)(i % 50);
+    movie["rating"] = (double)(i % 100) / 10.0;
+    movie["playcount"] = (int)(i % 3);
+    movie["runtime"] = 5400 + (int)(i % 3600);
+    movie["genre"].push_back("Drama");
+    movie["genre"].push_back(i % 2 ? "Comedy" : "Thriller");
+    movie["plot"] = "A story about someone who goes somewhere and finds something unexpected.";
+    movie["file"] = StringUtils::Format("smb://server/movies/Movie %u (%u)/movie.mkv", (unsigned int)i, (unsigned int)(1950 + i % 50));
+    movie["art"]["poster"] = StringUtils::Format("image://smb%%3a%%2f%%2fserver%%2fmovies%%2f%u%%2fposter.jpg/", (unsigned int)i);
+    movie["art"]["fanart"] = StringUtils::Format("image://smb%%3a%%2f%%2fserver%%2fmovies%%2f%u%%2ffanart.jpg/", (unsigned int)i);
+    result["movies"].push_back(std::move(movie));
+  }
+
+  return response;
+}
+
+}
+
 TEST(TestVariant, VariantTypeInteger)
 {
   CVariant a((int)0), b((int64_t)1);
@@ -348,3 +395,143 @@ TEST(TestVariant, isMember)
   EXPECT_TRUE(a.isMember("key1"));
   EXPECT_FALSE(a.isMember("key2"));
 }
+
+TEST(TestVariant, iterator_map_sorted)
+{
+  CVariant a;
+  a["key3"] = 3;
+  a["key1"] = 1;
+  a["key4"] = 4;
+  a["key2"] = 2;
+  a.erase("key3");
+
+  int expected = 1;
+  for (CVariant::const_iterator_map it = a.begin_map(); it != a.end_map(); ++it)
+  {
+    EXPECT_EQ(StringUtils::Format("key%d", expected), it->first);
+    EXPECT_EQ(expected, it->second.asInteger());
+    expected += expected == 2 ? 2 : 1;
+  }
+  EXPECT_EQ(5, expected);
+}
+
+TEST(TestVariant, strings)
+{
+  std::string shortString("123456789012345");
+  std::string longString("1234567890123456");
+  std::string zeroes("a\0b\0c", 5);
+  CVariant a(shortString), b(longString), c(zeroes);
+
+  EXPECT_EQ(shortString, a.asString());
+  EXPECT_EQ(longString, b.asString());
+  EXPECT_EQ(zeroes, c.asString());
+  EXPECT_EQ(15U, a.size());
+  EXPECT_EQ(16U, b.size());
+  EXPECT_EQ(5U, c.size());
+  EXPECT_EQ(123456789012345, a.asInteger());
+  EXPECT_STREQ("1234567890123456", b.c_str());
+  EXPECT_FALSE(a == b);
+
+  b.clear();
+  EXPECT_TRUE(b.empty());
+  EXPECT_STREQ("", b.c_str());
+}
+
+TEST(TestVariant, arena)
+{
+  CVariant original = GetMovies(10);
+  CVariant copy;
+  {
+    CVariantArena arena(1024);
+    CVariant inArena(original, arena);
+    EXPECT_TRUE(original == inArena);
+    EXPECT_LT(0U, arena.Capacity());
+
+    inArena["result"]["movies"][0]["title"] = "A title that is too long to fit";
+    inArena["result"]["movies"].push_back(CVariant("Another movie"));
+    copy = inArena;
+  }
+
+  EXPECT_STREQ("A title that is too long to fit", copy["result"]["movies"][0]["title"].c_str());
+  EXPECT_EQ(11U, copy["result"]["movies"].size());
+  EXPECT_STREQ("Movie 1", copy["result"]["movies"][1]["label"].c_str());
+}
+
+TEST(TestVariant, Build_Benchmark)
+{
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CVariant movies = GetMovies(BENCHMARK_ITEMS);
+  unsigned int elapsedBuild = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  CVariant copy = movies;
+  unsigned int elapsedCopy = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  size_t found = 0;
+  for (CVariant::const_iterator_array it = copy["result"]["movies"].begin_array(); it != copy["result"]["movies"].end_array(); ++it)
+  {
+    if ((*it)["year"].asInteger() == 1990 && (*it).isMember("art"))
+      found++;
+  }
+  unsigned int elapsedLookup = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_ITEMS << " movies, build: " << elapsedBuild << " ms, copy: " << elapsedCopy
+            << " ms, lookup: " << elapsedLookup << " ms" << std::endl;
+  EXPECT_TRUE(movies == copy);
+  EXPECT_EQ(BENCHMARK_ITEMS / 50, found);
+}
+
+TEST(TestVariant, Parse_Benchmark)
+{
+  std::string json = CJSONVariantWriter::Write(GetMovies(BENCHMARK_ITEMS), true);
+  const unsigned char *data = reinterpret_cast<const unsigned char*>(json.c_str());
+
+  {
+    CVariantArena arena;
+    EXPECT_TRUE(CJSONVariantParser::Parse(json) == CJSONVariantParser::Parse(data, json.size(), arena));
+  }
+
+  // a request is parsed and thrown away again
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  {
+    CVariant parsed = CJSONVariantParser::Parse(json);
+    EXPECT_EQ(BENCHMARK_ITEMS, parsed["result"]["movies"].size());
+  }
+  unsigned int elapsedParse = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  {
+    CVariantArena arena;
+    CVariant parsed = CJSONVariantParser::Parse(data, json.size(), arena);
+    EXPECT_EQ(BENCHMARK_ITEMS, parsed["result"]["movies"].size());
+  }
+  unsigned int elapsedParseArena = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_ITEMS << " movies (" << json.size() << " bytes), parse and release: " << elapsedParse
+            << " ms, using an arena: " << elapsedParseArena << " ms" << std::endl;
+}
+
+TEST(TestVariant, Write_Benchmark)
+{
+  CVariant movies = GetMovies(BENCHMARK_ITEMS);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  std::string json = CJSONVariantWriter::Write(movies, true);
+  unsigned int elapsedWrite = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  CJSONVariantWriter writer(movies, true);
+  std::string chunk;
+  size_t length = 0;
+  while (!writer.IsFinished() && writer.WriteChunk(chunk, 16384))
+  {
+    length += chunk.size();
+    chunk.clear();
+  }
+  unsigned int elapsedChunked = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << BENCHMARK_ITEMS << " movies (" << json.size() << " bytes), serialise: " << elapsedWrite
+            << " ms, in 16k chunks: " << elapsedChunked << " ms" << std::endl;
+  EXPECT_EQ(json.size(), length);
+}
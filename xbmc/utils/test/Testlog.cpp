@@ -151,3 +151,71 @@ TEST_F(Testlog, SetLogLevel)
   CLog::Close();
   EXPECT_TRUE(XFILE::CFile::Delete(logfile));
 }
+
+TEST_F(Testlog, SevereWrittenRightAway)
+{
+  std::string logfile, logstring;
+  char buf[100];
+  unsigned int bytesread;
+  XFILE::CFile file;
+
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + appName + ".log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+
+  // written together with the severe line, before the log is closed
+  CLog::Log(LOGINFO, "info before severe");
+  CLog::Log(LOGSEVERE, "severe log message");
+
+  EXPECT_TRUE(file.Open(logfile));
+  while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+  {
+    buf[bytesread] = '\0';
+    logstring.append(buf);
+  }
+  file.Close();
+  CLog::Close();
+
+  size_t info = logstring.find("INFO: info before severe");
+  size_t severe = logstring.find("SEVERE: severe log message");
+  ASSERT_NE(std::string::npos, info);
+  ASSERT_NE(std::string::npos, severe);
+  EXPECT_LT(info, severe);
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+TEST_F(Testlog, LongPrefix)
+{
+  std::string logfile, logstring;
+  char buf[100];
+  unsigned int bytesread;
+  XFILE::CFile file;
+
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + appName + ".log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+
+  // prefixes around the size of a line on the stack
+  for (size_t length = 505; length < 515; length++)
+  {
+    std::string prefix(length, 'p');
+    CLog::LogFunction(LOGNOTICE, prefix.c_str(), "message %u", static_cast<unsigned int>(length));
+  }
+  CLog::Close();
+
+  EXPECT_TRUE(file.Open(logfile));
+  while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+  {
+    buf[bytesread] = '\0';
+    logstring.append(buf);
+  }
+  file.Close();
+
+  for (size_t length = 505; length < 515; length++)
+    EXPECT_NE(std::string::npos, logstring.find(std::string(length, 'p') + ": message " + StringUtils::Format("%u", static_cast<unsigned int>(length))));
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
@@ -879,9 +879,12 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
+    dbiplus::StatementPtr stmt = m_pDB->get_statement("select idFile from files where strFileName=? and idPath=?");
+    stmt->bind_string(1, strFileName);
+    stmt->bind_int(2, idPath);
+    strSQL = stmt->get_sql();
 
-    m_pDS->query(strSQL);
+    m_pDS->query(*stmt);
     if (m_pDS->num_rows() > 0)
     {
       idFile = m_pDS->fv("idFile").get_asInt() ;
@@ -890,8 +893,11 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     }
     m_pDS->close();
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL);
+    stmt = m_pDB->get_statement("insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)");
+    stmt->bind_int(1, idPath);
+    stmt->bind_string(2, strFileName);
+    strSQL = stmt->get_sql();
+    m_pDS->exec(*stmt);
     idFile = (int)m_pDS->lastinsertid();
     return idFile;
   }
@@ -6610,6 +6616,28 @@ bool CVideoDatabase::GetMoviesNav(const std::string& strBaseDir, CFileItemList&
 }
 
 bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filter &filter, CFileItemList& items, const SortDescription &sortDescription /* = SortDescription() */, int getDetails /* = VideoDbDetailsNone */)
+{
+  CItemsCursor cursor;
+  if (!OpenMoviesByWhere(strBaseDir, filter, cursor, sortDescription, getDetails))
+    return false;
+
+  // store the total value of items as a property
+  if (cursor.total >= 0)
+    items.SetProperty("total", cursor.total);
+
+  items.Reserve(cursor.results.size());
+  CFileItemPtr pItem;
+  while (GetNextMovie(cursor, pItem))
+  {
+    if (pItem == NULL)
+      return true;
+    items.Add(pItem);
+  }
+
+  return false;
+}
+
+bool CVideoDatabase::OpenMoviesByWhere(const std::string& strBaseDir, const Filter &filter, CItemsCursor &cursor, const SortDescription &sortDescription /* = SortDescription() */, int getDetails /* = VideoDbDetailsNone */)
 {
   try
   {
@@ -6620,7 +6648,7 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     if (NULL == m_pDS.get()) return false;
 
     // parse the base path to get additional filters
-    CVideoDbUrl videoUrl;
+    CVideoDbUrl &videoUrl = cursor.url;
     Filter extFilter = filter;
     SortDescription sorting = sortDescription;
     if (!videoUrl.FromString(strBaseDir) || !GetFilter(videoUrl, extFilter, sorting))
@@ -6648,39 +6676,52 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
-    // store the total value of items as a property
     if (total < iRowsFound)
       total = iRowsFound;
-    items.SetProperty("total", total);
-    
-    DatabaseResults results;
-    results.reserve(iRowsFound);
+    cursor.total = total;
+    cursor.getDetails = getDetails;
 
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
+    cursor.results.reserve(iRowsFound);
+    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, cursor.results))
       return false;
 
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+bool CVideoDatabase::GetNextMovie(CItemsCursor &cursor, CFileItemPtr &item)
+{
+  item.reset();
+  try
+  {
+    if (NULL == m_pDS.get()) return false;
+
     // get data from returned rows
-    items.Reserve(results.size());
     const query_data &data = m_pDS->get_result_set().records;
-    for (const auto &i : results)
+    while (cursor.position < cursor.results.size())
     {
-      unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)cursor.results[cursor.position++].at(FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
 
-      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
+      CVideoInfoTag movie = GetDetailsForMovie(record, cursor.getDetails);
       if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
           g_passwordManager.bMasterUser                                   ||
           g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
       {
-        CFileItemPtr pItem(new CFileItem(movie));
+        item.reset(new CFileItem(movie));
 
-        CVideoDbUrl itemUrl = videoUrl;
+        CVideoDbUrl itemUrl = cursor.url;
         std::string path = StringUtils::Format("%i", movie.m_iDbId);
         itemUrl.AppendPath(path);
-        pItem->SetPath(itemUrl.ToString());
+        item->SetPath(itemUrl.ToString());
 
-        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
-        items.Add(pItem);
+        item->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
+        return true;
       }
     }
 
@@ -9501,7 +9542,11 @@ void CVideoDatabase::InvalidatePathHash(const std::string& strPath)
 bool CVideoDatabase::CommitTransaction()
 {
   if (CDatabase::CommitTransaction())
-  { // number of items in the db has likely changed, so recalculate
+  {
+    if (InBatch()) // recalculated once the whole batch is committed
+      return true;
+
+    // number of items in the db has likely changed, so recalculate
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MOVIES, HasContent(VIDEODB_CONTENT_MOVIES));
     g_infoManager.SetLibraryBool(LIBRARY_HAS_TVSHOWS, HasContent(VIDEODB_CONTENT_TVSHOWS));
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSICVIDEOS, HasContent(VIDEODB_CONTENT_MUSICVIDEOS));
@@ -421,6 +421,16 @@ public:
     DatabaseResults results;
   };
 
+  class CItemsCursor  // the rows of a query that are turned into items one at a time
+  {
+  public:
+    CVideoDbUrl url;
+    DatabaseResults results;
+    size_t position = 0;
+    int getDetails = VideoDbDetailsNone;
+    int total = -1;
+  };
+
   CVideoDatabase(void);
   virtual ~CVideoDatabase(void);
 
@@ -779,6 +789,13 @@ public:
 
   // smart playlists and main retrieval work in these functions
   bool GetMoviesByWhere(const std::string& strBaseDir, const Filter &filter, CFileItemList& items, const SortDescription &sortDescription = SortDescription(), int getDetails = VideoDbDetailsNone);
+  /*! \brief Run the query of GetMoviesByWhere() without creating the items yet
+   The rows stay in the dataset until GetNextMovie() has read the last one, no
+   other query may be run on this database in between.
+   */
+  bool OpenMoviesByWhere(const std::string& strBaseDir, const Filter &filter, CItemsCursor &cursor, const SortDescription &sortDescription = SortDescription(), int getDetails = VideoDbDetailsNone);
+  /*! \brief Create the item of the next movie of a query, item is empty once all movies are read */
+  bool GetNextMovie(CItemsCursor &cursor, std::shared_ptr<CFileItem> &item);
   bool GetSetsByWhere(const std::string& strBaseDir, const Filter &filter, CFileItemList& items, bool ignoreSingleMovieSets = false);
   bool GetTvShowsByWhere(const std::string& strBaseDir, const Filter &filter, CFileItemList& items, const SortDescription &sortDescription = SortDescription(), int getDetails = VideoDbDetailsNone);
   bool GetSeasonsByWhere(const std::string& strBaseDir, const Filter &filter, CFileItemList& items, bool appendFullShowPath = true, const SortDescription &sortDescription = SortDescription());
@@ -55,6 +55,7 @@
 #include "video/VideoLibraryQueue.h"
 #include "video/VideoThumbLoader.h"
 #include "VideoInfoDownloader.h"
+#include "VideoIngestQueue.h"
 
 using namespace XFILE;
 using namespace ADDON;
@@ -115,6 +116,18 @@ namespace VIDEO
 
       m_database.Open();
 
+      // scraped items are written in batches by the ingest queue
+      if (g_advancedSettings.m_iVideoScannerIngestBatchSize > 0)
+      {
+        m_ingest.reset(new CVideoIngestQueue(g_advancedSettings.m_iVideoScannerIngestBatchSize,
+                                             g_advancedSettings.m_iVideoScannerIngestQueueSize, m_handle));
+        if (!m_ingest->Start())
+          m_ingest.reset();
+      }
+
+      // folders are fetched ahead of the scan
+      m_prefetcher.SetConnections(g_advancedSettings.m_iVideoLibraryScanConnections);
+
       m_bCanInterrupt = true;
 
       CLog::Log(LOGNOTICE, "VideoInfoScanner: Starting scan ..");
@@ -157,6 +170,10 @@ namespace VIDEO
           bCancelled = true;
       }
 
+      // everything scraped so far has to be in the database before cleaning up
+      m_ingest.reset();
+      m_prefetcher.Reset();
+
       if (!bCancelled)
       {
         if (m_bClean)
@@ -179,6 +196,8 @@ namespace VIDEO
     {
       CLog::Log(LOGERROR, "VideoInfoScanner: Exception while scanning.");
     }
+    m_ingest.reset();
+    m_prefetcher.Reset();
     
     m_bRunning = false;
     ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanFinished");
@@ -269,12 +288,12 @@ namespace VIDEO
     const std::vector<std::string> &regexps = content == CONTENT_TVSHOWS ? g_advancedSettings.m_tvshowExcludeFromScanRegExps
                                                          : g_advancedSettings.m_moviesExcludeFromScanRegExps;
 
-    if (IsExcluded(strDirectory, regexps))
-      return true;
-
     bool ignoreFolder = !m_scanAll && settings.noupdate;
-    if (content == CONTENT_NONE || ignoreFolder)
+    if (IsExcluded(strDirectory, regexps) || content == CONTENT_NONE || ignoreFolder)
+    {
+      m_prefetcher.Discard(strDirectory);
       return true;
+    }
 
     std::string hash, dbHash;
     if (content == CONTENT_MOVIES ||content == CONTENT_MUSICVIDEOS)
@@ -295,7 +314,7 @@ namespace VIDEO
       }
       else
       { // need to fetch the folder
-        CDirectory::GetDirectory(strDirectory, items, g_advancedSettings.m_videoExtensions);
+        m_prefetcher.GetDirectory(strDirectory, items, g_advancedSettings.m_videoExtensions);
         items.Stack();
 
         // check whether to re-use previously computed fast hash
@@ -333,7 +352,7 @@ namespace VIDEO
 
       if (foundDirectly && !settings.parent_name_root)
       {
-        CDirectory::GetDirectory(strDirectory, items, g_advancedSettings.m_videoExtensions);
+        m_prefetcher.GetDirectory(strDirectory, items, g_advancedSettings.m_videoExtensions);
         items.SetPath(strDirectory);
         GetPathHash(items, hash);
         bSkip = true;
@@ -358,9 +377,12 @@ namespace VIDEO
       {
         if (!m_bStop && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
         {
-          m_database.SetPathHash(strDirectory, hash);
+          SetPathHash(strDirectory, hash);
           if (m_bClean)
+          { // the path may only be added with the queued items
+            FlushIngest();
             m_pathsToClean.insert(m_database.GetPathId(strDirectory));
+          }
           CLog::Log(LOGDEBUG, "VideoInfoScanner: Finished adding information from dir %s", CURL::GetRedacted(strDirectory).c_str());
         }
       }
@@ -373,27 +395,40 @@ namespace VIDEO
     }
     else if (hash != dbHash && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
     { // update the hash either way - we may have changed the hash to a fast version
-      m_database.SetPathHash(strDirectory, hash);
+      SetPathHash(strDirectory, hash);
     }
 
     if (m_handle)
       OnDirectoryScanned(strDirectory);
 
+    std::vector<std::string> folders;
     for (int i = 0; i < items.Size(); ++i)
     {
       CFileItemPtr pItem = items[i];
 
-      if (m_bStop)
-        break;
-
       // if we have a directory item (non-playlist) we then recurse into that folder
       // do not recurse for tv shows - we have already looked recursively for episodes
       if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList() && settings.recurse > 0 && content != CONTENT_TVSHOWS)
+        folders.push_back(pItem->GetPath());
+    }
+
+    for (size_t i = 0; i < folders.size(); ++i)
+    {
+      if (m_bStop)
+        break;
+
+      // with fast hashes, unchanged folders don't need to be listed
+      if (g_advancedSettings.m_bVideoLibraryUseFastHash)
       {
-        if (!DoScan(pItem->GetPath()))
-        {
-          m_bStop = true;
-        }
+        PrefetchFolders(folders, i, "");
+        m_prefetcher.PrefetchStats(folders, i);
+      }
+      else
+        PrefetchFolders(folders, i, g_advancedSettings.m_videoExtensions);
+
+      if (!DoScan(folders[i]))
+      {
+        m_bStop = true;
       }
     }
     return !m_bStop;
@@ -416,6 +451,18 @@ namespace VIDEO
 
     m_database.Open();
 
+    // the shows are checked for changes one after the other, fetch their folders ahead
+    std::vector<std::string> showFolders;
+    if (content == CONTENT_TVSHOWS)
+    {
+      for (int i = 0; i < items.Size(); ++i)
+      {
+        if (items[i]->m_bIsFolder)
+          showFolders.push_back(items[i]->GetPath());
+      }
+    }
+    size_t showFolder = 0;
+
     bool FoundSomeInfo = false;
     std::vector<int> seenPaths;
     for (int i = 0; i < (int)items.Size(); ++i)
@@ -423,6 +470,17 @@ namespace VIDEO
       m_nfoReader.Close();
       CFileItemPtr pItem = items[i];
 
+      if (showFolder < showFolders.size() && showFolders[showFolder] == pItem->GetPath())
+      {
+        PrefetchFolders(showFolders, showFolder, "");
+        if (g_advancedSettings.m_bVideoLibraryUseFastHash)
+        {
+          m_prefetcher.PrefetchDirectories(showFolders, showFolder, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO);
+          m_prefetcher.PrefetchStats(showFolders, showFolder);
+        }
+        showFolder++;
+      }
+
       // we do this since we may have a override per dir
       ScraperPtr info2 = m_database.GetScraperForPath(pItem->m_bIsFolder ? pItem->GetPath() : items.GetPath());
       if (!info2) // skip
@@ -519,7 +577,7 @@ namespace VIDEO
     {
       INFO_RET ret = RetrieveInfoForEpisodes(pItem, idTvShow, info2, useLocal, pDlgProgress);
       if (ret == INFO_ADDED)
-        m_database.SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
+        SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
       return ret;
     }
 
@@ -546,7 +604,7 @@ namespace VIDEO
       {
         INFO_RET ret = RetrieveInfoForEpisodes(pItem, lResult, info2, useLocal, pDlgProgress);
         if (ret == INFO_ADDED)
-          m_database.SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
+          SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
         return ret;
       }
       return INFO_ADDED;
@@ -579,7 +637,7 @@ namespace VIDEO
     {
       INFO_RET ret = RetrieveInfoForEpisodes(pItem, lResult, info2, useLocal, pDlgProgress);
       if (ret == INFO_ADDED)
-        m_database.SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
+        SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
     }
     return INFO_ADDED;
   }
@@ -714,6 +772,10 @@ namespace VIDEO
     m_database.GetTvShowInfo("", showInfo, showID);
     INFO_RET ret = OnProcessSeriesFolder(files, scraper, useLocal, showInfo, progress);
 
+    // the seasons are added with the episodes
+    if (ret == INFO_ADDED && !FlushIngest())
+      ret = INFO_ERROR;
+
     if (ret == INFO_ADDED)
     {
       std::map<int, std::map<std::string, std::string>> seasonArt;
@@ -1174,6 +1236,15 @@ namespace VIDEO
     return episodeInfo.cDate.IsValid();
   }
 
+  static void AnnounceUpdate(const CFileItem &item, bool transaction)
+  {
+    CFileItemPtr itemCopy = CFileItemPtr(new CFileItem(item));
+    CVariant data;
+    if (transaction)
+      data["transaction"] = true;
+    ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", itemCopy, data);
+  }
+
   long CVideoInfoScanner::AddVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder /* = false */, bool useLocal /* = true */, const CVideoInfoTag *showInfo /* = NULL */, bool libraryImport /* = false */)
   {
     // ensure our database is open (this can get called via other classes)
@@ -1191,7 +1262,6 @@ namespace VIDEO
     CVideoInfoTag &movieDetails = *pItem->GetVideoInfoTag();
     if (movieDetails.m_basePath.empty())
       movieDetails.m_basePath = pItem->GetBaseMoviePath(videoFolder);
-    movieDetails.m_parentPathID = m_database.AddPath(URIUtils::GetParentPath(movieDetails.m_basePath));
 
     movieDetails.m_strFileNameAndPath = pItem->GetPath();
 
@@ -1208,16 +1278,64 @@ namespace VIDEO
     std::string redactPath(CURL::GetRedacted(CURL::Decode(pItem->GetPath())));
 
     CLog::Log(LOGDEBUG, "VideoInfoScanner: Adding new item to %s:%s", TranslateContent(content).c_str(), redactPath.c_str());
-    long lResult = -1;
 
+    std::map<int, std::map<std::string, std::string> > seasonArt;
     if (content == CONTENT_MOVIES)
     {
       // find local trailer first
       std::string strTrailer = pItem->FindTrailer();
       if (!strTrailer.empty())
         movieDetails.m_strTrailer = strTrailer;
+    }
+    else if (content == CONTENT_TVSHOWS && pItem->m_bIsFolder && !libraryImport)
+      GetSeasonThumbs(movieDetails, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
 
-      lResult = m_database.SetDetailsForMovie(pItem->GetPath(), movieDetails, art);
+    // shows are written right away, their episodes need the id of the show
+    if (m_ingest && !(content == CONTENT_TVSHOWS && pItem->m_bIsFolder))
+    {
+      m_database.Close();
+
+      CFileItemPtr item(new CFileItem(*pItem));
+      std::shared_ptr<CVideoInfoTag> show(showInfo ? new CVideoInfoTag(*showInfo) : NULL);
+      CONTENT_TYPE type = content;
+      bool queued = m_ingest->Add(
+        [item, type, videoFolder, art, show, libraryImport](CVideoDatabase &database)
+        {
+          std::map<int, std::map<std::string, std::string> > noSeasonArt;
+          return WriteVideo(database, *item, type, videoFolder, art, noSeasonArt, show.get(), libraryImport) >= 0;
+        },
+        [item, redactPath](bool written)
+        {
+          if (written)
+            AnnounceUpdate(*item, true);
+          else
+            CLog::Log(LOGERROR, "VideoInfoScanner: Failed to add %s to the library", redactPath.c_str());
+        });
+      return queued ? 0 : -1;
+    }
+
+    FlushIngest();
+    long lResult = WriteVideo(m_database, *pItem, content, videoFolder, art, seasonArt, showInfo, libraryImport);
+
+    m_database.Close();
+
+    AnnounceUpdate(*pItem, m_bRunning);
+    return lResult;
+  }
+
+  long CVideoInfoScanner::WriteVideo(CVideoDatabase &database, CFileItem &item, const CONTENT_TYPE &content, bool videoFolder,
+                                     const std::map<std::string, std::string> &art,
+                                     const std::map<int, std::map<std::string, std::string> > &seasonArt,
+                                     const CVideoInfoTag *showInfo, bool libraryImport)
+  {
+    CVideoInfoTag &movieDetails = *item.GetVideoInfoTag();
+    movieDetails.m_parentPathID = database.AddPath(URIUtils::GetParentPath(movieDetails.m_basePath));
+
+    long lResult = -1;
+
+    if (content == CONTENT_MOVIES)
+    {
+      lResult = database.SetDetailsForMovie(item.GetPath(), movieDetails, art);
       movieDetails.m_iDbId = lResult;
       movieDetails.m_type = MediaTypeMovie;
 
@@ -1225,34 +1343,29 @@ namespace VIDEO
       for (unsigned int i=0; i < movieDetails.m_showLink.size(); ++i)
       {
         CFileItemList items;
-        m_database.GetTvShowsByName(movieDetails.m_showLink[i], items);
+        database.GetTvShowsByName(movieDetails.m_showLink[i], items);
         if (items.Size())
-          m_database.LinkMovieToTvshow(lResult, items[0]->GetVideoInfoTag()->m_iDbId, false);
+          database.LinkMovieToTvshow(lResult, items[0]->GetVideoInfoTag()->m_iDbId, false);
         else
           CLog::Log(LOGDEBUG, "VideoInfoScanner: Failed to link movie %s to show %s", movieDetails.m_strTitle.c_str(), movieDetails.m_showLink[i].c_str());
       }
     }
     else if (content == CONTENT_TVSHOWS)
     {
-      if (pItem->m_bIsFolder)
+      if (item.m_bIsFolder)
       {
         /*
          multipaths are not stored in the database, so in the case we have one,
          we split the paths, and compute the parent paths in each case.
          */
         std::vector<std::string> multipath;
-        if (!URIUtils::IsMultiPath(pItem->GetPath()) || !CMultiPathDirectory::GetPaths(pItem->GetPath(), multipath))
-          multipath.push_back(pItem->GetPath());
+        if (!URIUtils::IsMultiPath(item.GetPath()) || !CMultiPathDirectory::GetPaths(item.GetPath(), multipath))
+          multipath.push_back(item.GetPath());
         std::vector<std::pair<std::string, std::string> > paths;
         for (std::vector<std::string>::const_iterator i = multipath.begin(); i != multipath.end(); ++i)
           paths.push_back(std::make_pair(*i, URIUtils::GetParentPath(*i)));
 
-        std::map<int, std::map<std::string, std::string> > seasonArt;
-
-        if (!libraryImport)
-          GetSeasonThumbs(movieDetails, seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), useLocal);
-
-        lResult = m_database.SetDetailsForTvShow(paths, movieDetails, art, seasonArt);
+        lResult = database.SetDetailsForTvShow(paths, movieDetails, art, seasonArt);
         movieDetails.m_iDbId = lResult;
         movieDetails.m_type = MediaTypeTvShow;
       }
@@ -1261,44 +1374,51 @@ namespace VIDEO
         // we add episode then set details, as otherwise set details will delete the
         // episode then add, which breaks multi-episode files.
         int idShow = showInfo ? showInfo->m_iDbId : -1;
-        int idEpisode = m_database.AddEpisode(idShow, pItem->GetPath());
-        lResult = m_database.SetDetailsForEpisode(pItem->GetPath(), movieDetails, art, idShow, idEpisode);
+        int idEpisode = database.AddEpisode(idShow, item.GetPath());
+        lResult = database.SetDetailsForEpisode(item.GetPath(), movieDetails, art, idShow, idEpisode);
         movieDetails.m_iDbId = lResult;
         movieDetails.m_type = MediaTypeEpisode;
         movieDetails.m_strShowTitle = showInfo ? showInfo->m_strTitle : "";
         if (movieDetails.m_EpBookmark.timeInSeconds > 0)
         {
-          movieDetails.m_strFileNameAndPath = pItem->GetPath();
+          movieDetails.m_strFileNameAndPath = item.GetPath();
           movieDetails.m_EpBookmark.seasonNumber = movieDetails.m_iSeason;
           movieDetails.m_EpBookmark.episodeNumber = movieDetails.m_iEpisode;
-          m_database.AddBookMarkForEpisode(movieDetails, movieDetails.m_EpBookmark);
+          database.AddBookMarkForEpisode(movieDetails, movieDetails.m_EpBookmark);
         }
       }
     }
     else if (content == CONTENT_MUSICVIDEOS)
     {
-      lResult = m_database.SetDetailsForMusicVideo(pItem->GetPath(), movieDetails, art);
+      lResult = database.SetDetailsForMusicVideo(item.GetPath(), movieDetails, art);
       movieDetails.m_iDbId = lResult;
       movieDetails.m_type = MediaTypeMusicVideo;
     }
 
     if (g_advancedSettings.m_bVideoLibraryImportWatchedState || libraryImport)
-      m_database.SetPlayCount(*pItem, movieDetails.m_playCount, movieDetails.m_lastPlayed);
+      database.SetPlayCount(item, movieDetails.m_playCount, movieDetails.m_lastPlayed);
 
     if ((g_advancedSettings.m_bVideoLibraryImportResumePoint || libraryImport) &&
         movieDetails.m_resumePoint.IsSet())
-      m_database.AddBookMarkToFile(pItem->GetPath(), movieDetails.m_resumePoint, CBookmark::RESUME);
+      database.AddBookMarkToFile(item.GetPath(), movieDetails.m_resumePoint, CBookmark::RESUME);
 
-    m_database.Close();
-
-    CFileItemPtr itemCopy = CFileItemPtr(new CFileItem(*pItem));
-    CVariant data;
-    if (m_bRunning)
-      data["transaction"] = true;
-    ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", itemCopy, data);
     return lResult;
   }
 
+  void CVideoInfoScanner::SetPathHash(const std::string &path, const std::string &hash)
+  {
+    // with queued writes the hash must only be stored once all items of the path are
+    if (m_ingest)
+      m_ingest->AddCheckpoint([path, hash](CVideoDatabase &database) { return database.SetPathHash(path, hash); });
+    else
+      m_database.SetPathHash(path, hash);
+  }
+
+  bool CVideoInfoScanner::FlushIngest()
+  {
+    return !m_ingest || m_ingest->Flush();
+  }
+
   std::string ContentToMediaType(CONTENT_TYPE content, bool folder)
   {
     switch (content)
@@ -1828,7 +1948,7 @@ namespace VIDEO
   }
 
   std::string CVideoInfoScanner::GetFastHash(const std::string &directory,
-      const std::vector<std::string> &excludes) const
+      const std::vector<std::string> &excludes)
   {
     XBMC::XBMC_MD5 md5state;
 
@@ -1836,7 +1956,7 @@ namespace VIDEO
       md5state.append(StringUtils::Join(excludes, "|"));
 
     struct __stat64 buffer;
-    if (XFILE::CFile::Stat(directory, &buffer) == 0)
+    if (m_prefetcher.Stat(directory, &buffer) == 0)
     {
       int64_t time = buffer.st_mtime;
       if (!time)
@@ -1851,11 +1971,15 @@ namespace VIDEO
   }
 
   std::string CVideoInfoScanner::GetRecursiveFastHash(const std::string &directory,
-      const std::vector<std::string> &excludes) const
+      const std::vector<std::string> &excludes)
   {
     CFileItemList items;
     items.Add(CFileItemPtr(new CFileItem(directory, true)));
-    CUtil::GetRecursiveDirsListing(directory, items, DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO);
+    m_prefetcher.GetRecursiveDirsListing(directory, items, DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO);
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < items.Size(); ++i)
+      paths.push_back(items[i]->GetPath());
 
     XBMC::XBMC_MD5 md5state;
 
@@ -1863,11 +1987,13 @@ namespace VIDEO
       md5state.append(StringUtils::Join(excludes, "|"));
 
     int64_t time = 0;
-    for (int i=0; i < items.Size(); ++i)
+    for (size_t i = 0; i < paths.size(); ++i)
     {
+      m_prefetcher.PrefetchStats(paths, i);
+
       int64_t stat_time = 0;
       struct __stat64 buffer;
-      if (XFILE::CFile::Stat(items[i]->GetPath(), &buffer) == 0)
+      if (m_prefetcher.Stat(paths[i], &buffer) == 0)
       {
         //! @todo some filesystems may return the mtime/ctime inline, in which case this is
         //! unnecessarily expensive. Consider supporting Stat() in our directory cache?
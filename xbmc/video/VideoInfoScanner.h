@@ -19,6 +19,8 @@
  *
  */
 
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -34,6 +36,8 @@ class CFileItemList;
 
 namespace VIDEO
 {
+  class CVideoIngestQueue;
+
   typedef struct SScanSettings
   {
     SScanSettings() { parent_name = parent_name_root = noupdate = exclude = false; recurse = 1;}
@@ -77,7 +81,7 @@ namespace VIDEO
      \param useLocal whether to use local information for artwork etc.
      \param showInfo pointer to CVideoInfoTag details for the show if this is an episode. Defaults to NULL.
      \param libraryImport Whether this call belongs to a full library import or not. Defaults to false.
-     \return database id of the added item, or -1 on failure.
+     \return database id of the added item, 0 if it was queued to be written by the running scan, or -1 on failure.
      */
     long AddVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder = false, bool useLocal = true, const CVideoInfoTag *showInfo = NULL, bool libraryImport = false);
 
@@ -197,7 +201,7 @@ namespace VIDEO
      \param excludes string array of exclude expressions
      \return the md5 hash of the folder"
      */
-    std::string GetFastHash(const std::string &directory, const std::vector<std::string> &excludes) const;
+    std::string GetFastHash(const std::string &directory, const std::vector<std::string> &excludes);
 
     /*! \brief Retrieve a "fast" hash of the given directory recursively (if available)
      Performs a stat() on the directory, and uses modified time to create a "fast"
@@ -209,7 +213,7 @@ namespace VIDEO
      \param excludes string array of exclude expressions
      \return the md5 hash of the folder
      */
-    std::string GetRecursiveFastHash(const std::string &directory, const std::vector<std::string> &excludes) const;
+    std::string GetRecursiveFastHash(const std::string &directory, const std::vector<std::string> &excludes);
 
     /*! \brief Decide whether a folder listing could use the "fast" hash
      Fast hashing can be done whenever the folder contains no scannable subfolders, as the
@@ -239,6 +243,27 @@ namespace VIDEO
 
     std::string GetnfoFile(CFileItem *item, bool bGrabAny=false) const;
 
+    /*! \brief Write an item prepared by AddVideo() to the database.
+     \param database database to write to.
+     \param item item to write, its video info tag is updated with the database ids.
+     \param seasonArt season art of a tvshow.
+     \return database id of the item, or -1 on failure.
+     \sa AddVideo
+     */
+    static long WriteVideo(CVideoDatabase &database, CFileItem &item, const CONTENT_TYPE &content, bool videoFolder,
+                           const std::map<std::string, std::string> &art,
+                           const std::map<int, std::map<std::string, std::string> > &seasonArt,
+                           const CVideoInfoTag *showInfo, bool libraryImport);
+
+    /*! \brief Store the hash of a scanned path, after the items of the path if they are queued.
+     */
+    void SetPathHash(const std::string &path, const std::string &hash);
+
+    /*! \brief Wait until the queued items are written to the database.
+     \return false if writing any of them failed.
+     */
+    bool FlushIngest();
+
     bool m_showDialog;
     CGUIDialogProgressBarHandle* m_handle;
     int m_currentItem;
@@ -250,6 +275,7 @@ namespace VIDEO
     bool m_scanAll;
     std::string m_strStartDir;
     CVideoDatabase m_database;
+    std::unique_ptr<CVideoIngestQueue> m_ingest;
     std::set<std::string> m_pathsToScan;
     std::set<std::string> m_pathsToCount;
     std::set<int> m_pathsToClean;
@@ -0,0 +1,281 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoIngestQueue.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "dialogs/GUIDialogExtendedProgressBar.h"
+#include "guilib/LocalizeStrings.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+
+namespace VIDEO
+{
+  CVideoIngestQueue::CVideoIngestQueue(unsigned int batchSize, unsigned int queueSize, CGUIDialogProgressBarHandle *handle)
+    : CThread("VideoIngestQueue")
+    , m_handle(handle)
+    , m_batchSize(std::max(batchSize, 1u))
+    , m_queueSize(std::max(queueSize, m_batchSize))
+    , m_pending(0)
+    , m_flushes(0)
+    , m_stopping(false)
+    , m_generation(0)
+    , m_checkpointFailed(false)
+    , m_firstQueued(0)
+    , m_written(0)
+    , m_batches(0)
+    , m_startTime(0)
+  {
+  }
+
+  CVideoIngestQueue::~CVideoIngestQueue()
+  {
+    Stop();
+  }
+
+  bool CVideoIngestQueue::Start()
+  {
+    if (!m_database.Open())
+      return false;
+
+    m_startTime = XbmcThreads::SystemClockMillis();
+    Create();
+    return true;
+  }
+
+  bool CVideoIngestQueue::Start(const DatabaseSettings &settings)
+  {
+    if (!m_database.Connect(settings.name, settings, true))
+      return false;
+
+    m_startTime = XbmcThreads::SystemClockMillis();
+    Create();
+    return true;
+  }
+
+  void CVideoIngestQueue::Stop()
+  {
+    {
+      CSingleLock lock(m_critSection);
+      if (m_stopping)
+        return;
+      m_stopping = true;
+    }
+    m_queueChanged.notifyAll();
+
+    if (IsRunning())
+    {
+      // the writer drains the queue before it exits
+      StopThread(true);
+      m_database.Close();
+
+      CLog::Log(LOGNOTICE, "VideoInfoScanner: Wrote %u items in %u batches (%.1f items/s)",
+                m_written, m_batches, GetItemsPerSecond());
+    }
+  }
+
+  bool CVideoIngestQueue::Add(const Write &write, const Done &done)
+  {
+    return Queue(SWrite{ write, done, false, 0 });
+  }
+
+  bool CVideoIngestQueue::AddCheckpoint(const Write &write)
+  {
+    return Queue(SWrite{ write, Done(), true, 0 });
+  }
+
+  bool CVideoIngestQueue::Queue(SWrite &&write)
+  {
+    {
+      CSingleLock lock(m_critSection);
+      while (m_queue.size() >= m_queueSize && !m_stopping)
+        m_queueChanged.wait(lock);
+      if (m_stopping)
+        return false;
+
+      if (m_queue.empty())
+        m_firstQueued = XbmcThreads::SystemClockMillis();
+      write.generation = m_generation;
+      m_queue.push_back(std::move(write));
+      m_pending++;
+    }
+    m_queueChanged.notifyAll();
+    return true;
+  }
+
+  bool CVideoIngestQueue::Flush()
+  {
+    CSingleLock lock(m_critSection);
+    // writes queued from now on are reported by the next flush
+    unsigned int generation = m_generation++;
+
+    m_flushes++;
+    m_queueChanged.notifyAll();
+    while (m_pending > 0)
+      m_queueChanged.wait(lock);
+    m_flushes--;
+
+    std::map<unsigned int, unsigned int>::iterator end = m_failures.upper_bound(generation);
+    bool ok = end == m_failures.begin();
+    m_failures.erase(m_failures.begin(), end);
+    return ok;
+  }
+
+  unsigned int CVideoIngestQueue::GetWritten() const
+  {
+    return m_written;
+  }
+
+  float CVideoIngestQueue::GetItemsPerSecond() const
+  {
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - m_startTime;
+    return elapsed > 0 ? m_written * 1000.0f / elapsed : 0.0f;
+  }
+
+  void CVideoIngestQueue::Process()
+  {
+    std::vector<SWrite> batch;
+    batch.reserve(m_batchSize);
+
+    while (true)
+    {
+      {
+        CSingleLock lock(m_critSection);
+
+        // wait for a full batch, but don't hold back the oldest write for too long
+        while (!m_stopping)
+        {
+          if (m_queue.empty())
+            m_queueChanged.wait(lock);
+          else if (m_flushes > 0 || m_queue.size() >= m_batchSize)
+            break;
+          else
+          {
+            unsigned int waited = XbmcThreads::SystemClockMillis() - m_firstQueued;
+            if (waited >= BATCH_DELAY)
+              break;
+            m_queueChanged.wait(lock, BATCH_DELAY - waited);
+          }
+        }
+
+        if (m_queue.empty()) // stopping
+          break;
+
+        size_t count = std::min<size_t>(m_queue.size(), m_batchSize);
+        std::move(m_queue.begin(), m_queue.begin() + count, std::back_inserter(batch));
+        m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+      }
+      // there is room in the queue again
+      m_queueChanged.notifyAll();
+
+      WriteBatch(batch);
+
+      {
+        CSingleLock lock(m_critSection);
+        m_pending -= batch.size();
+      }
+      m_queueChanged.notifyAll();
+      batch.clear();
+    }
+  }
+
+  void CVideoIngestQueue::WriteBatch(std::vector<SWrite> &batch)
+  {
+    std::vector<SWrite*> written;
+    std::vector<SWrite*> failed;
+
+    m_database.BeginBatch();
+    for (std::vector<SWrite>::iterator it = batch.begin(); it != batch.end(); ++it)
+    {
+      if (it->checkpoint && m_checkpointFailed)
+      { // some of the writes this one depends on failed
+        m_checkpointFailed = false;
+        continue;
+      }
+
+      // put every write into a savepoint of its own, so whatever it left
+      // behind can be rolled back if it fails half way or throws
+      unsigned int savepoints = m_database.GetSavepoints();
+      m_database.BeginTransaction();
+
+      bool ok = false;
+      try
+      {
+        ok = it->write(m_database);
+      }
+      catch (...)
+      {
+        CLog::Log(LOGERROR, "%s - exception while writing to the video database", __FUNCTION__);
+      }
+
+      if (ok)
+        m_database.CommitTransaction();
+      else
+        m_database.RollbackSavepoints(savepoints);
+
+      if (it->checkpoint)
+        continue;
+
+      if (!ok)
+      {
+        m_checkpointFailed = true;
+        failed.push_back(&*it);
+        continue;
+      }
+
+      written.push_back(&*it);
+    }
+
+    if (!m_database.CommitBatch())
+    {
+      CLog::Log(LOGERROR, "%s - failed to commit %u items", __FUNCTION__, (unsigned int)batch.size());
+      failed.insert(failed.end(), written.begin(), written.end());
+      written.clear();
+      m_checkpointFailed = true;
+    }
+
+    for (std::vector<SWrite*>::iterator it = written.begin(); it != written.end(); ++it)
+    {
+      if ((*it)->done)
+        (*it)->done(true);
+    }
+    for (std::vector<SWrite*>::iterator it = failed.begin(); it != failed.end(); ++it)
+    {
+      if ((*it)->done)
+        (*it)->done(false);
+    }
+
+    {
+      CSingleLock lock(m_critSection);
+      m_written += written.size();
+      m_batches++;
+      for (std::vector<SWrite*>::iterator it = failed.begin(); it != failed.end(); ++it)
+        m_failures[(*it)->generation]++;
+    }
+
+    if (m_handle)
+      m_handle->SetText(StringUtils::Format(g_localizeStrings.Get(20472).c_str(), m_written, GetItemsPerSecond()));
+  }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "VideoDatabase.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+class CGUIDialogProgressBarHandle;
+
+namespace VIDEO
+{
+  /*!
+   * \brief Writes the results of a scan to the video database on a thread of its own.
+   *
+   * The scanner queues the writes for the items it has scraped and carries on
+   * with the next one. Writes are grouped into batches of up to batchSize items
+   * per transaction, each of them in a savepoint of its own so a failing item
+   * doesn't take the rest of the batch with it. A batch is committed once it is
+   * full, when the oldest write waited for BATCH_DELAY ms or when Flush() is
+   * called. The queue is bounded, Add() blocks while it is full.
+   */
+  class CVideoIngestQueue : protected CThread
+  {
+  public:
+    typedef std::function<bool(CVideoDatabase &database)> Write;
+    typedef std::function<void(bool written)> Done;
+
+    CVideoIngestQueue(unsigned int batchSize, unsigned int queueSize, CGUIDialogProgressBarHandle *handle = NULL);
+    virtual ~CVideoIngestQueue();
+
+    /*! \brief Open the database and start writing
+     \return false if the database can't be opened
+     */
+    bool Start();
+
+    /*! \brief Connect to the given database instead of the video database and start writing
+     */
+    bool Start(const DatabaseSettings &settings);
+
+    /*! \brief Write everything still queued and stop the thread
+     */
+    void Stop();
+
+    /*! \brief Queue a write
+     \param write function doing the write, returning false on failure. Everything it
+     wrote is rolled back if it fails or throws.
+     \param done called on the writer thread with true once the write is committed,
+     or with false if it failed, e.g. to announce the new item.
+     \return false if the queue is stopped.
+     */
+    bool Add(const Write &write, const Done &done = Done());
+
+    /*! \brief Queue a write that is only done if all writes queued since the
+     previous checkpoint succeeded, e.g. to store the hash of a scanned path.
+     */
+    bool AddCheckpoint(const Write &write);
+
+    /*! \brief Wait until all queued writes are committed
+     \return false if any write queued before this call and after the previous
+     Flush() failed.
+     */
+    bool Flush();
+
+    unsigned int GetWritten() const;
+    float GetItemsPerSecond() const;
+
+    static const unsigned int BATCH_DELAY = 5000;
+
+  protected:
+    virtual void Process() override;
+
+  private:
+    struct SWrite
+    {
+      Write write;
+      Done done;
+      bool checkpoint;
+      unsigned int generation;   ///< number of Flush() calls before the write was queued
+    };
+
+    bool Queue(SWrite &&write);
+    void WriteBatch(std::vector<SWrite> &batch);
+
+    CVideoDatabase m_database;
+    CGUIDialogProgressBarHandle *m_handle;
+    const unsigned int m_batchSize;
+    const unsigned int m_queueSize;
+
+    CCriticalSection m_critSection;
+    XbmcThreads::ConditionVariable m_queueChanged;
+    std::deque<SWrite> m_queue;
+    unsigned int m_pending;       ///< queued writes and the ones of the batch being written
+    unsigned int m_flushes;       ///< number of threads waiting in Flush()
+    bool m_stopping;
+    unsigned int m_generation;    ///< number of Flush() calls so far
+    std::map<unsigned int, unsigned int> m_failures; ///< failed writes by generation, not yet reported by Flush()
+    bool m_checkpointFailed;      ///< a write failed since the last checkpoint, writer thread only
+    unsigned int m_firstQueued;   ///< time the oldest queued write was added
+
+    unsigned int m_written;
+    unsigned int m_batches;
+    unsigned int m_startTime;
+  };
+}
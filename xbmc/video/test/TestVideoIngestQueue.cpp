@@ -0,0 +1,154 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "video/VideoIngestQueue.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace VIDEO;
+
+class TestVideoIngestQueue : public ::testing::Test
+{
+protected:
+  DatabaseSettings settings;
+  CVideoDatabase database; // reads back what the queue wrote
+  CCriticalSection critSection;
+  std::vector<std::pair<int, bool> > done;
+
+  void SetUp() override
+  {
+    settings.type = "sqlite3";
+    settings.name = "ingesttest";
+    settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    XFILE::CFile::Delete(settings.host + settings.name + ".db");
+
+    ASSERT_TRUE(database.Connect(settings.name, settings, true));
+  }
+
+  void TearDown() override
+  {
+    database.Close();
+    XFILE::CFile::Delete(settings.host + settings.name + ".db");
+  }
+
+  CVideoIngestQueue::Write AddPath(const std::string &path)
+  {
+    return [path](CVideoDatabase &db) { return db.AddPath(path) >= 0; };
+  }
+
+  CVideoIngestQueue::Done Record(int index)
+  {
+    return [this, index](bool written)
+    {
+      CSingleLock lock(critSection);
+      done.push_back(std::make_pair(index, written));
+    };
+  }
+};
+
+TEST_F(TestVideoIngestQueue, DoneInOrder)
+{
+  CVideoIngestQueue queue(4, 8);
+  ASSERT_TRUE(queue.Start(settings));
+
+  for (int i = 0; i < 10; i++)
+    EXPECT_TRUE(queue.Add(AddPath(StringUtils::Format("/ingest/%i/", i)), Record(i)));
+  EXPECT_TRUE(queue.Flush());
+
+  ASSERT_EQ(10u, done.size());
+  for (int i = 0; i < 10; i++)
+  {
+    EXPECT_EQ(i, done[i].first);
+    EXPECT_TRUE(done[i].second);
+  }
+  EXPECT_EQ(10u, queue.GetWritten());
+  EXPECT_GE(database.GetPathId("/ingest/9/"), 0);
+}
+
+TEST_F(TestVideoIngestQueue, FailedWriteReportedToItsOwnCallback)
+{
+  CVideoIngestQueue queue(4, 8);
+  ASSERT_TRUE(queue.Start(settings));
+
+  EXPECT_TRUE(queue.Add(AddPath("/ingest/a/"), Record(0)));
+  EXPECT_TRUE(queue.Add([](CVideoDatabase &db) { return false; }, Record(1)));
+  // a failed write doesn't fail the writes queued after it
+  EXPECT_TRUE(queue.Add(AddPath("/ingest/b/"), Record(2)));
+
+  // the failure is reported by the first flush only
+  EXPECT_FALSE(queue.Flush());
+  EXPECT_TRUE(queue.Flush());
+
+  ASSERT_EQ(3u, done.size());
+  for (std::vector<std::pair<int, bool> >::const_iterator it = done.begin(); it != done.end(); ++it)
+    EXPECT_EQ(it->first != 1, it->second);
+  EXPECT_GE(database.GetPathId("/ingest/a/"), 0);
+  EXPECT_GE(database.GetPathId("/ingest/b/"), 0);
+
+  EXPECT_TRUE(queue.Add(AddPath("/ingest/c/"), Record(3)));
+  EXPECT_TRUE(queue.Flush());
+}
+
+TEST_F(TestVideoIngestQueue, ThrowingWriteIsRolledBack)
+{
+  CVideoIngestQueue queue(4, 8);
+  ASSERT_TRUE(queue.Start(settings));
+
+  EXPECT_TRUE(queue.Add(AddPath("/ingest/before/"), Record(0)));
+  EXPECT_TRUE(queue.Add([](CVideoDatabase &db) -> bool
+  {
+    db.AddPath("/ingest/throw/");
+    throw std::runtime_error("write failed");
+  }, Record(1)));
+  EXPECT_TRUE(queue.Add(AddPath("/ingest/after/"), Record(2)));
+  EXPECT_FALSE(queue.Flush());
+
+  EXPECT_EQ(-1, database.GetPathId("/ingest/throw/"));
+  EXPECT_GE(database.GetPathId("/ingest/before/"), 0);
+  EXPECT_GE(database.GetPathId("/ingest/after/"), 0);
+  ASSERT_EQ(3u, done.size());
+}
+
+TEST_F(TestVideoIngestQueue, CheckpointSkippedAfterFailure)
+{
+  CVideoIngestQueue queue(4, 8);
+  ASSERT_TRUE(queue.Start(settings));
+
+  std::string hash;
+  EXPECT_TRUE(queue.Add([](CVideoDatabase &db) { return false; }));
+  EXPECT_TRUE(queue.AddCheckpoint([](CVideoDatabase &db) { return db.SetPathHash("/ingest/skipped/", "hash"); }));
+  EXPECT_FALSE(queue.Flush());
+  EXPECT_FALSE(database.GetPathHash("/ingest/skipped/", hash));
+
+  EXPECT_TRUE(queue.Add(AddPath("/ingest/written/")));
+  EXPECT_TRUE(queue.AddCheckpoint([](CVideoDatabase &db) { return db.SetPathHash("/ingest/written/", "hash"); }));
+  EXPECT_TRUE(queue.Flush());
+  EXPECT_TRUE(database.GetPathHash("/ingest/written/", hash));
+  EXPECT_EQ("hash", hash);
+}